@@ -14,8 +14,8 @@
 ; will be the unit used for now. This defines that the second stage Loader
 ; can't be bigger than 5*512 bytes (which ought to be enough for now)
 Loader.File.NumberOfBlocks   equ   5
-Kernel.File.NumberOfBlocks   equ   152 ; Make it 4KB aligned
-UserProg.File.NumberOfBlocks   	 equ   20
+Kernel.File.NumberOfBlocks   equ   384 ; Make it 4KB aligned
+Initramfs.File.NumberOfBlocks  equ   248 ; cpio archive, up to the EBDA (0x80000 -> 0x9f000)
 BIOS.DiskExt.MaxBlocksPerOp  equ   127 ; (some BIOSes are limited to 127 sectors)
 
 ;===============================================================================
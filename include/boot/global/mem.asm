@@ -28,9 +28,12 @@
 ;
 ;   Second Loader   = 0x07e00 -> 0x8800        (assuming 5 IO blocks)
 ;   E820 memory map = 0x08800 -> 0x9000        (assuming 2048 bytes which is enough space for 102 entries)
-;   Kernel          = 0x09000 -> 0x1bc00       (assuming 150 IO blocks)
-;   (guard hole)    = 0x1bc00 -> 0xfffff       (room to increase any of the above [+- 912 Kb] - hard limit given A20)
-;   Early Paging    = 0x20000 -> 0x28000       (early 10-MiB identity paging)
+;   Kernel          = 0x09000 -> 0x39000       (assuming 384 IO blocks)
+;   (guard hole)    = 0x39000 -> 0x3c000       (room to increase the kernel)
+;   Early Paging    = 0x3c000 -> 0x7e000       (early 64-GiB identity paging, 2MiB pages)
+;   (guard hole)    = 0x7e000 -> 0x80000
+;   Initramfs       = 0x80000 -> 0x9f000       (assuming 248 IO blocks, page aligned as file pages are mapped as is)
+;   (guard hole)    = 0x9f000 -> 0x9fbff       (EBDA sits right after it)
 ;												 - Kernel is moved to another location before early paging is setup
 ;======================================================================================================================
 
@@ -50,19 +53,20 @@ Loader.Kernel.End.Address         equ (Loader.Kernel.Start.Address + Kernel.File
 Kernel.New.Start.PhysicalAddress  equ 0x00200000
 Kernel.New.ELFTextHeader.Offset   equ 0x00001000 ; .text starts <p> + 0x1000
 
-; User code:
-; 		-> this should be 0x1c000 assuming kernel occupies 152 IO blocks
-Loader.UserProg.Start.Address		equ Loader.Kernel.End.Address
-Loader.UserProg.End.Address			equ Loader.Kernel.End.Address + UserProg.File.NumberOfBlocks * 512
-
 ; Early paging
-Paging.Start.Address  equ   0x20000
+Paging.Start.Address  equ   0x3c000
 Paging.Table.Size     equ   0x1000									  		; 0x1000 = 4kb = 512 entries of 64 bits
 Mem.PML4.Address      equ   Paging.Start.Address                      		; PML4
-Mem.PDPE.Address      equ   Mem.PML4.Address + Paging.Table.Size      		; 0x20000 + PML4 (512 entries of 64 bits)
-Mem.PDE.Address       equ   Mem.PDPE.Address + Paging.Table.Size      		; 0x21000 + PDPE (512 entries of 64 bits)
-Paging.End.Address    equ   Mem.PDE.Address  + (64 * Paging.Table.Size)     ; 0x22000 + 64x PDE (512 entries of 64 bits)
+Mem.PDPE.Address      equ   Mem.PML4.Address + Paging.Table.Size      		; 0x3c000 + PML4 (512 entries of 64 bits)
+Mem.PDE.Address       equ   Mem.PDPE.Address + Paging.Table.Size      		; 0x3d000 + PDPE (512 entries of 64 bits)
+Paging.End.Address    equ   Mem.PDE.Address  + (64 * Paging.Table.Size)     ; 0x3e000 + 64x PDE (512 entries of 64 bits)
 
+; Initramfs (cpio newc archive):
+; 		-> the kernel's ramfs references file contents in place and maps program pages straight into every
+; 		   process, so it has to stay page aligned (the archive itself pads file data to page boundaries).
+; 		   Growing it past the EBDA would mean loading it above 1MiB, which needs unreal mode first
+Loader.Initramfs.Start.Address		equ 0x80000
+Loader.Initramfs.End.Address		equ Loader.Initramfs.Start.Address + Initramfs.File.NumberOfBlocks * 512
 
 ;======================================================================================================================
 ; Virtual Memory utilisation layout:
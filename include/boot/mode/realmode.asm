@@ -95,12 +95,15 @@ bios_extended_read_sectors_from_drive:
   ;   buffer to which sectors will be transferred (note that x86 is
   ;   little-endian: if declaring the segment and offset separately,
   ;   the offset must be declared before the segment)
+  ;   The offset is kept below 16 so a run of up to 127 sectors never wraps
+  ;   around the end of its segment, no matter where the destination starts
+  push eax
+  and ax, 0xf
   mov word[si+4], ax ; offset
+  pop eax
 
-  ; obtain upper half of the eax register
-  shr eax, 16
-  ; adjust result to fit the segment:offset schema
-  shl eax, 12
+  ; the rest of the linear address becomes the segment
+  shr eax, 4
 
   mov word[si+6], ax ; segment
   ; offset: 08h..0Fh  | range size: 8 byte | absolute number of the start of the
@@ -15,7 +15,7 @@ Realmode.SecondStage.Booting.Msg            db 'Booting Second Stage Loader',CR,
 Realmode.SecondStage.A20Enabled.Msg         db 'A20 enabled successfully',CR,LF,0
 Realmode.SecondStage.A20EnablingError.Msg   db 'A20 could not be enabled. Aborting',CR,LF,0
 Realmode.SecondStage.KernelLoaded.Msg  		db 'Kernel loaded into memory',CR,LF,0
-Realmode.SecondStage.UserLoaded.Msg			db 'User progam loaded into memory',CR,LF,0
+Realmode.SecondStage.InitramfsLoaded.Msg	db 'Initramfs loaded into memory',CR,LF,0
 Realmode.SecondStage.CPUIDNotSupported.Msg  db 'CPUID instruction is not available. Aborting',CR,LF,0
 Realmode.SecondStage.64BitNotSupported.Msg  db '64-bit mode is not available. Aborting',CR,LF,0
 Realmode.SecondStage.64BitSupported.Msg     db '64-bit mode is available',CR,LF,0
@@ -267,17 +267,17 @@ read_kernel_from_disk:
   popa
   ret
 
-read_userprog_from_disk:
+read_initramfs_from_disk:
   ; preserve all registers
   pusha
 
-  ; Read the user file from the disk.
+  ; Read the cpio archive from the disk (a single contiguous run of blocks)
   xor edx, edx
 
-  ; Set destination address where kernel will be loaded
-  mov eax, Loader.UserProg.Start.Address
-  mov edx, UserProg.File.NumberOfBlocks
-  mov ecx, 158
+  ; Set destination address where the archive will be loaded
+  mov eax, Loader.Initramfs.Start.Address
+  mov edx, Initramfs.File.NumberOfBlocks
+  mov ecx, 6 + Kernel.File.NumberOfBlocks
 
   .read_run:
   	cmp edx, BIOS.DiskExt.MaxBlocksPerOp
@@ -307,7 +307,7 @@ read_userprog_from_disk:
   	call bios_extended_read_sectors_from_drive
 
   ; status message
-  mov si, Realmode.SecondStage.UserLoaded.Msg
+  mov si, Realmode.SecondStage.InitramfsLoaded.Msg
   call display_string
 
   ; restore registers
@@ -0,0 +1,33 @@
+/*
+ * acpi.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_ARCH_ACPI_H_
+#define INCLUDE_KERNEL_ARCH_ACPI_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/compiler/macro.h"
+
+/* common header of every System Description Table - ACPI spec 5.2.6 */
+typedef struct {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __packed acpi_sdt_header_t;
+
+/* locate the RSDP and the root table (XSDT or RSDT), returns false if there is no ACPI */
+bool acpi_init(void);
+
+/* e.g. "APIC" for the MADT, returns NULL if the firmware doesn't provide it */
+const acpi_sdt_header_t* acpi_find_table(const char *signature);
+
+#endif /* INCLUDE_KERNEL_ARCH_ACPI_H_ */
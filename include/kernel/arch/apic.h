@@ -0,0 +1,42 @@
+/*
+ * apic.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_ARCH_APIC_H_
+#define INCLUDE_KERNEL_ARCH_APIC_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* max amount of CPUs taken from the MADT */
+#define APIC_MAX_CPUS           16
+
+/*
+ * raised by the local APIC for interrupts that vanished before being delivered. Bits 0-3 must be set on P6 family
+ * and 0xff is already taken by fatal()
+ */
+#define APIC_SPURIOUS_VECTOR    0xef
+
+/* parse the MADT, enable the local APIC (x2APIC mode when available) and hand IRQs over to the IO-APIC */
+bool apic_init(void);
+
+/* whether the local APIC is up, which is all MSIs need */
+bool lapic_enabled(void);
+
+void lapic_eoi(void);
+uint32_t lapic_id(void);
+
+/* fixed delivery of vector to a single CPU */
+void lapic_send_ipi(uint32_t apic_id, uint8_t vector);
+
+/* CPUs as listed by the firmware, cpu 0 is the boot CPU */
+uint32_t apic_nr_cpus(void);
+uint32_t apic_cpu_apic_id(uint32_t cpu);
+bool apic_cpu_online(uint32_t cpu);
+
+/* index (not APIC ID) of the CPU running this */
+uint32_t apic_this_cpu(void);
+
+#endif /* INCLUDE_KERNEL_ARCH_APIC_H_ */
@@ -30,4 +30,7 @@
 void cpu_init();
 void enable_intel_faststring();
 
+/* whether page table entries can have the no-execute bit set (EFER.NXE) */
+bool cpu_nx_enabled(void);
+
 #endif /* INCLUDE_KERNEL_ARCH_CPU_H_ */
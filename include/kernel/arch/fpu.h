@@ -0,0 +1,23 @@
+/*
+ * fpu.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_ARCH_FPU_H_
+#define INCLUDE_KERNEL_ARCH_FPU_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/task/process.h"
+
+/* enable x87/SSE (and AVX through XSAVE when available) for user space */
+void fpu_init(void);
+
+/* called on every context switch, arms the #NM trap unless next already owns the FPU registers */
+void fpu_switch(task_struct_t *next);
+
+/* forget about task's FPU state (e.g. the task is going away) */
+void fpu_release(task_struct_t *task);
+
+#endif /* INCLUDE_KERNEL_ARCH_FPU_H_ */
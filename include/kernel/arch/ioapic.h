@@ -0,0 +1,26 @@
+/*
+ * ioapic.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_ARCH_IOAPIC_H_
+#define INCLUDE_KERNEL_ARCH_IOAPIC_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* MADT Interrupt Source Override flags - ACPI spec 5.2.12.5 */
+#define IOAPIC_MPS_POLARITY_MASK        0x3
+#define IOAPIC_MPS_POLARITY_LOW         0x3
+#define IOAPIC_MPS_TRIGGER_MASK         0xc
+#define IOAPIC_MPS_TRIGGER_LEVEL        0xc
+
+/* called while the MADT is parsed */
+void ioapic_add(uint64_t phys_addr, uint32_t gsi_base);
+void ioapic_isa_override(uint8_t isa_irq, uint32_t gsi, uint16_t flags);
+
+/* program every pin masked and take over from the PIC, returns false if there is no IO-APIC */
+bool ioapic_init(void);
+
+#endif /* INCLUDE_KERNEL_ARCH_IOAPIC_H_ */
@@ -12,6 +12,7 @@
 #include "kernel/compiler/macro.h"
 
 /* MSR Addresses */
+#define MSR_IA32_APIC_BASE   0x1B
 #define MSR_IA32_MISC_ENABLE 0x1A0
 
 /* Model-specific registers used to set up system calls. */
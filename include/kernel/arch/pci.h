@@ -0,0 +1,70 @@
+/*
+ * pci.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_ARCH_PCI_H_
+#define INCLUDE_KERNEL_ARCH_PCI_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* configuration space header (type 0, type 1 where noted) */
+#define PCI_VENDOR_ID           0x00
+#define PCI_DEVICE_ID           0x02
+#define PCI_COMMAND             0x04
+#define PCI_STATUS              0x06
+#define PCI_REVISION_ID         0x08
+#define PCI_PROG_IF             0x09
+#define PCI_SUBCLASS            0x0a
+#define PCI_CLASS               0x0b
+#define PCI_HEADER_TYPE         0x0e
+#define PCI_BAR0                0x10
+#define PCI_SECONDARY_BUS       0x19    /* type 1 */
+#define PCI_CAPABILITY_LIST     0x34
+#define PCI_INTERRUPT_LINE      0x3c
+#define PCI_INTERRUPT_PIN       0x3d
+
+#define PCI_COMMAND_IO          (1 << 0)
+#define PCI_COMMAND_MEMORY      (1 << 1)
+#define PCI_COMMAND_MASTER      (1 << 2)
+#define PCI_COMMAND_INTX_OFF    (1 << 10)
+
+#define PCI_STATUS_CAP_LIST     (1 << 4)
+
+#define PCI_HEADER_TYPE_MASK    0x7f
+#define PCI_HEADER_TYPE_BRIDGE  0x01
+#define PCI_HEADER_MULTIFUNC    0x80
+
+#define PCI_BAR_IO              0x1
+#define PCI_BAR_MEM_TYPE_MASK   0x6
+#define PCI_BAR_MEM_TYPE_64     0x4
+#define PCI_BAR_MEM_PREFETCH    0x8
+#define PCI_BAR_IO_MASK         (~0x3U)
+#define PCI_BAR_MEM_MASK        (~0xfU)
+
+/* a vendor id nobody can have, reads of absent functions return all 1s */
+#define PCI_VENDOR_NONE         0xffff
+
+#define PCI_MAX_BUSES           256
+#define PCI_MAX_DEVICES         32
+#define PCI_MAX_FUNCTIONS       8
+
+typedef struct {
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+} pci_addr_t;
+
+/* use ECAM (memory mapped, 4 KiB per function) if the firmware has an MCFG table, port I/O (256 bytes) otherwise */
+void pci_config_init(void);
+
+uint32_t pci_config_read32(pci_addr_t addr, uint16_t offset);
+uint16_t pci_config_read16(pci_addr_t addr, uint16_t offset);
+uint8_t pci_config_read8(pci_addr_t addr, uint16_t offset);
+void pci_config_write32(pci_addr_t addr, uint16_t offset, uint32_t value);
+void pci_config_write16(pci_addr_t addr, uint16_t offset, uint16_t value);
+void pci_config_write8(pci_addr_t addr, uint16_t offset, uint8_t value);
+
+#endif /* INCLUDE_KERNEL_ARCH_PCI_H_ */
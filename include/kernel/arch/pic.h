@@ -9,6 +9,7 @@
 #define INCLUDE_KERNEL_ARCH_PIC_H_
 
 #include "kernel/compiler/freestanding.h"
+#include "kernel/interrupt/irq.h"
 
 /*  General IBM-PC Compatible Interrupt Information - Standard ISA IRQs  */
 #define PIC_PROG_INT_TIMER_INTERRUPT        0
@@ -31,6 +32,9 @@ void pic_mask_irq(uint8_t isa_irq);
 uint16_t pic_read_isr(void);
 void pic_disable_all_irq(void);
 
+/* default irq chip until (and unless) the IO-APIC takes over */
+extern const irq_chip_t pic_chip;
+
 void enable_keyboard_irq(void);
 
 #endif /* INCLUDE_KERNEL_ARCH_PIC_H_ */
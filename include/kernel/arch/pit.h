@@ -12,6 +12,5 @@
 
 void pit_init(uint32_t freq_hz);
 void pit_enable(void);
-void pit_timer_handle_irq(void);
 
 #endif /* INCLUDE_KERNEL_ARCH_PIT_H_ */
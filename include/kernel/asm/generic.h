@@ -29,27 +29,117 @@ __force_inline void outb(uint64_t port, uint8_t value) {
     );
 }
 
+__force_inline uint16_t inw(uint64_t port) {
+    uint16_t value = 0;
+    asm volatile (
+            "in  %[v],  %w[p]"
+            : [v] "=a" (value)
+            : [p] "Nd" (port)
+    );
+    return value;
+}
+
+__force_inline void outw(uint64_t port, uint16_t value) {
+    asm volatile (
+            "out  %w[p],  %[v]"
+            :
+            : [p] "Nd" (port), [v] "a" (value)
+    );
+}
+
+__force_inline uint32_t inl(uint64_t port) {
+    uint32_t value = 0;
+    asm volatile (
+            "in  %[v],  %w[p]"
+            : [v] "=a" (value)
+            : [p] "Nd" (port)
+    );
+    return value;
+}
+
+__force_inline void outl(uint64_t port, uint32_t value) {
+    asm volatile (
+            "out  %w[p],  %[v]"
+            :
+            : [p] "Nd" (port), [v] "a" (value)
+    );
+}
+
+/* read count words from port into buf in one go */
+__force_inline void insw(uint64_t port, void *buf, size_t count) {
+    asm volatile (
+            "rep insw"
+            : "+D" (buf), "+c" (count)
+            : "d" (port)
+            : "memory"
+    );
+}
+
+__force_inline void outsw(uint64_t port, const void *buf, size_t count) {
+    asm volatile (
+            "rep outsw"
+            : "+S" (buf), "+c" (count)
+            : "d" (port)
+            : "memory"
+    );
+}
+
+/* eax selects the leaf and ecx the sub-leaf (leaves that don't have any ignore it) */
 __force_inline void cpuid(uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
     asm volatile (
             "cpuid \n"
             : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
-            : "a" (*eax)
+            : "a" (*eax), "c" (*ecx)
             : "memory"
     );
 }
 
 __force_inline void enable_interrupts() {
-    asm volatile ("sti");
+    asm volatile ("sti" ::: "memory");
 }
 
 __force_inline void disable_interrupts() {
-    asm volatile ("cli");
+    asm volatile ("cli" ::: "memory");
+}
+
+/* disable interrupts and return the previous RFLAGS so they can be restored (nesting-safe) */
+__force_inline uint64_t local_irq_save() {
+    uint64_t flags;
+    asm volatile (
+            "pushfq \n"
+            "pop %0 \n"
+            "cli \n"
+            : "=r" (flags)
+            :
+            : "memory"
+    );
+    return flags;
+}
+
+__force_inline void local_irq_restore(uint64_t flags) {
+    asm volatile (
+            "push %0 \n"
+            "popfq \n"
+            :
+            : "r" (flags)
+            : "memory", "cc"
+    );
+}
+
+/* spin-wait hint, saves power and avoids the memory order mis-speculation penalty on the way out */
+__force_inline void cpu_relax() {
+    asm volatile ("pause" ::: "memory");
 }
 
 __force_inline void halt() {
     asm volatile ("hlt");
 }
 
+/* sti only takes effect after the next instruction, so no interrupt can slip in between and be missed by hlt */
+__force_inline void safe_halt() {
+    asm volatile ("sti \n hlt" ::: "memory");
+}
+
 __force_inline void fatal() {
     asm volatile ("int 0xff");
 }
@@ -63,6 +153,46 @@ __force_inline void load_cr3(uint64_t addr) {
     );
 }
 
+__force_inline uint64_t read_cr0(void) {
+    uint64_t value;
+    asm volatile ("mov %0, cr0" : "=r" (value));
+    return value;
+}
+
+__force_inline void write_cr0(uint64_t value) {
+    asm volatile ("mov cr0, %0" :: "r" (value) : "memory");
+}
+
+/* unlike writing it, reading CR3 isn't serialising */
+__force_inline uint64_t read_cr3(void) {
+    uint64_t value;
+    asm volatile ("mov %0, cr3" : "=r" (value));
+    return value;
+}
+
+__force_inline uint64_t read_cr4(void) {
+    uint64_t value;
+    asm volatile ("mov %0, cr4" : "=r" (value));
+    return value;
+}
+
+__force_inline void write_cr4(uint64_t value) {
+    asm volatile ("mov cr4, %0" :: "r" (value) : "memory");
+}
+
+/* lfence keeps rdtsc from being executed ahead of the code being measured */
+__force_inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile (
+            "lfence \n"
+            "rdtsc \n"
+            : "=a" (lo), "=d" (hi)
+            :
+            : "memory"
+    );
+    return ((uint64_t) hi << 32) | lo;
+}
+
 __force_inline void invalidate_page(uint64_t v_addr) {
     asm volatile(
             "invlpg [%[addr]] \n"
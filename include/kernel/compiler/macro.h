@@ -29,6 +29,12 @@
  */
 #define __aligned(x)        __attribute__((aligned(x)))
 
+/*
+ * This attribute tells the compiler that a function never returns to its caller.
+ * More: https://gcc.gnu.org/onlinedocs/gcc/Common-Function-Attributes.html
+ */
+#define __noreturn          __attribute__((noreturn))
+
 /* calculate the length of the array - and avoid tendinitis ;) */
 #define ARR_SIZE(arr)		sizeof(arr)/sizeof(arr[0])
 
@@ -0,0 +1,20 @@
+/*
+ * bench.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEBUG_BENCH_H_
+#define INCLUDE_KERNEL_DEBUG_BENCH_H_
+
+/* cycles spent entering and leaving the kernel through the fast (IRQ) and slow (exception) interrupt paths */
+void bench_interrupt_entry(void);
+
+/* switch_to ping-pong between two kernel contexts, with and without an address space change */
+void bench_context_switch(void);
+
+/* sequential reads from a block device, sector by sector and with many requests in flight */
+void bench_block_read(const char *name);
+
+#endif /* INCLUDE_KERNEL_DEBUG_BENCH_H_ */
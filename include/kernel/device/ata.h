@@ -0,0 +1,16 @@
+/*
+ * ata.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEVICE_ATA_H_
+#define INCLUDE_KERNEL_DEVICE_ATA_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* probe both legacy IDE channels and register every ATA disk found as hda..hdd */
+void ata_init(void);
+
+#endif /* INCLUDE_KERNEL_DEVICE_ATA_H_ */
@@ -0,0 +1,71 @@
+/*
+ * block.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEVICE_BLOCK_H_
+#define INCLUDE_KERNEL_DEVICE_BLOCK_H_
+
+#include "kernel/compiler/freestanding.h"
+
+#define BLOCK_SECTOR_SIZE       512
+
+struct block_device;
+
+typedef struct block_request {
+    struct block_device *dev;
+    /* first sector and how many of them */
+    uint64_t sector;
+    uint32_t count;
+    /* kernel (direct-mapped) buffer, it has to be physically contiguous as devices may DMA into it */
+    void *buf;
+    bool write;
+    /* 0 or -errno, only valid once done is set */
+    int status;
+    bool done;
+    /* called from the completion path (usually IRQ context) once done is set, may be NULL */
+    void (*end_io)(struct block_request *req);
+    void *private;
+    /* used by whoever holds the request, the driver while it's in flight */
+    struct block_request *next;
+} block_request_t;
+
+typedef struct block_device {
+    const char *name;
+    uint64_t nr_sectors;
+    /* queue the request, completion is reported through block_end_request */
+    void (*submit)(struct block_device *dev, block_request_t *req);
+    /* hand whatever submit queued over to the hardware, NULL if submit does it right away */
+    void (*commit)(struct block_device *dev);
+    /* run the completion path by hand, for callers that wait with interrupts disabled */
+    void (*poll)(struct block_device *dev);
+    void *private;
+    struct block_device *next;
+} block_device_t;
+
+void block_register_device(block_device_t *dev);
+
+/* NULL if there is no such device */
+block_device_t* block_get_device(const char *name);
+
+/* head of the list of registered devices (most recent first), walked through next */
+block_device_t* block_first_device(void);
+
+/* asynchronous, req->end_io is called once it's done */
+void block_submit(block_request_t *req);
+
+/* same as block_submit for nr requests to the same device, but the hardware is only notified once */
+void block_submit_batch(block_request_t **reqs, size_t nr);
+
+/* for drivers, reports the outcome of a request submitted to them */
+void block_end_request(block_request_t *req, int status);
+
+/* wait for a submitted request to complete, returns its status */
+int block_wait(block_request_t *req);
+
+/* submit and wait for completion, returns 0 or -errno */
+int block_rw(block_device_t *dev, uint64_t sector, uint32_t count, void *buf, bool write);
+
+#endif /* INCLUDE_KERNEL_DEVICE_BLOCK_H_ */
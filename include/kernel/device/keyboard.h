@@ -8,7 +8,46 @@
 #ifndef INCLUDE_KERNEL_DEVICE_KEYBOARD_H_
 #define INCLUDE_KERNEL_DEVICE_KEYBOARD_H_
 
+#include "kernel/compiler/freestanding.h"
+
+/*
+ * Keycodes are independent of the scancode set the controller speaks. For the main block they happen to match the
+ * scancode set 1 make codes, everything behind the 0xE0 prefix gets a code of its own (same numbering as Linux).
+ */
+#define KEY_RESERVED        0
+#define KEY_ESC             1
+#define KEY_BACKSPACE       14
+#define KEY_TAB             15
+#define KEY_ENTER           28
+#define KEY_LEFTCTRL        29
+#define KEY_LEFTSHIFT       42
+#define KEY_RIGHTSHIFT      54
+#define KEY_LEFTALT         56
+#define KEY_SPACE           57
+#define KEY_CAPSLOCK        58
+#define KEY_F12             88
+#define KEY_KPENTER         96
+#define KEY_RIGHTCTRL       97
+#define KEY_KPSLASH         98
+#define KEY_RIGHTALT        100
+#define KEY_HOME            102
+#define KEY_UP              103
+#define KEY_PAGEUP          104
+#define KEY_LEFT            105
+#define KEY_RIGHT           106
+#define KEY_END             107
+#define KEY_DOWN            108
+#define KEY_PAGEDOWN        109
+#define KEY_INSERT          110
+#define KEY_DELETE          111
+#define KEY_MAX             128
+
+typedef struct {
+    uint8_t keycode;
+    bool released;
+} keyboard_event_t;
+
 void keyboard_enable(void);
-void keyboard_handle_irq(void);
+bool keyboard_read_event(keyboard_event_t *event);
 
 #endif /* INCLUDE_KERNEL_DEVICE_KEYBOARD_H_ */
@@ -0,0 +1,108 @@
+/*
+ * pci.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEVICE_PCI_H_
+#define INCLUDE_KERNEL_DEVICE_PCI_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/arch/pci.h"
+#include "kernel/interrupt/irq.h"
+
+#define PCI_NR_BARS             6
+
+#define PCI_CAP_ID_MSI          0x05
+#define PCI_CAP_ID_MSIX         0x11
+
+/* matches any vendor/device/class in a pci_device_id_t */
+#define PCI_ANY_ID              0xffff
+
+#define PCI_DEVICE(v, d)        { .vendor = (v), .device = (d), .class = PCI_ANY_ID, .subclass = PCI_ANY_ID }
+#define PCI_DEVICE_CLASS(c, s)  { .vendor = PCI_ANY_ID, .device = PCI_ANY_ID, .class = (c), .subclass = (s) }
+
+typedef struct {
+    /* I/O port or physical address, 0 if the BAR isn't implemented */
+    uint64_t base;
+    uint64_t size;
+    bool io;
+    bool prefetch;
+} pci_bar_t;
+
+struct pci_driver;
+
+typedef struct pci_dev {
+    pci_addr_t addr;
+    uint16_t vendor;
+    uint16_t device;
+    uint8_t class;
+    uint8_t subclass;
+    uint8_t prog_if;
+    uint8_t revision;
+    /* legacy INTx, as set up by the firmware */
+    uint8_t irq_line;
+    uint8_t irq_pin;
+    pci_bar_t bars[PCI_NR_BARS];
+
+    /* offsets of the capabilities in the configuration space, 0 if absent */
+    uint16_t msi_cap;
+    uint16_t msix_cap;
+
+    /* MSI-X table, mapped by pci_msix_enable */
+    volatile uint32_t *msix_table;
+    uint16_t msix_size;
+
+    struct pci_driver *driver;
+    void *driver_data;
+    struct pci_dev *next;
+} pci_dev_t;
+
+/* an id table ends with an all-zero entry */
+typedef struct {
+    uint16_t vendor;
+    uint16_t device;
+    uint16_t class;
+    uint16_t subclass;
+} pci_device_id_t;
+
+typedef struct pci_driver {
+    const char *name;
+    const pci_device_id_t *ids;
+    /* returns false if the device can't be driven after all, so someone else may have a go */
+    bool (*probe)(pci_dev_t *dev);
+    struct pci_driver *next;
+} pci_driver_t;
+
+/* walk the buses from bus 0 and size every BAR, must run after acpi_init */
+void pci_init(void);
+
+/* probe calls for every matching device happen before this returns */
+void pci_register_driver(pci_driver_t *driver);
+
+/* enumerated devices, in the order they were found */
+pci_dev_t* pci_first_device(void);
+
+void pci_enable_device(pci_dev_t *dev);
+void pci_set_master(pci_dev_t *dev);
+void pci_clear_master(pci_dev_t *dev);
+
+/* mapped memory BAR (uncached) or NULL if bar isn't a memory BAR */
+volatile void* pci_iomap_bar(pci_dev_t *dev, int bar);
+
+/* MSI/MSI-X need the local APIC, so both return false/0 without it and INTx is what's left */
+
+/* single MSI message delivered to the boot CPU, INTx is turned off */
+bool pci_msi_request(pci_dev_t *dev, irq_handler_t handler, void *ctx);
+
+/* map the table and enable MSI-X with every entry masked, returns the number of entries (0 if unsupported) */
+uint16_t pci_msix_enable(pci_dev_t *dev);
+
+/* route entry to a freshly allocated vector aimed at cpu and unmask it, returns the vector or -1 */
+int pci_msix_request(pci_dev_t *dev, uint16_t entry, uint32_t cpu, irq_handler_t handler, void *ctx);
+
+/* mask every entry and free the vectors routed to them, then turn MSI-X off and INTx back on */
+void pci_msix_disable(pci_dev_t *dev);
+
+#endif /* INCLUDE_KERNEL_DEVICE_PCI_H_ */
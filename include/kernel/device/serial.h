@@ -10,8 +10,15 @@
 
 #include "kernel/compiler/freestanding.h"
 
+#define SERIAL_DEFAULT_BAUD     115200
+
 void init_serial(void);
+void serial_enable(void);
+bool serial_set_baud(uint32_t baud);
+void serial_flush(void);
+size_t serial_read(char *buf, size_t length);
 void write_char_serial(char a);
 void write_string_serial(char* arr, size_t length);
+size_t serial_write(const char *buf, size_t length);
 
 #endif /* INCLUDE_KERNEL_DEVICE_SERIAL_H_ */
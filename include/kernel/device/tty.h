@@ -0,0 +1,26 @@
+/*
+ * tty.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEVICE_TTY_H_
+#define INCLUDE_KERNEL_DEVICE_TTY_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* line discipline flags */
+#define TTY_CANONICAL   (1 << 0)    /* input is handed out a line at a time, with line editing */
+#define TTY_ECHO        (1 << 1)    /* echo input characters back to the console */
+
+void tty_init(void);
+void tty_set_flags(uint32_t flags);
+
+/* bottom half: drains keyboard events into the line discipline */
+void tty_process_input(void);
+
+/* puts the caller to sleep until there is something to read */
+long tty_read(char *buf, size_t length);
+
+#endif /* INCLUDE_KERNEL_DEVICE_TTY_H_ */
@@ -0,0 +1,139 @@
+/*
+ * virtio.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEVICE_VIRTIO_H_
+#define INCLUDE_KERNEL_DEVICE_VIRTIO_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/arch/pci.h"
+
+#define VIRTIO_PCI_VENDOR               0x1af4
+
+/* legacy (virtio 0.9.5) PCI registers - offsets from BAR0, which is an I/O BAR */
+#define VIRTIO_PCI_HOST_FEATURES        0
+#define VIRTIO_PCI_GUEST_FEATURES       4
+#define VIRTIO_PCI_QUEUE_PFN            8
+#define VIRTIO_PCI_QUEUE_NUM            12
+#define VIRTIO_PCI_QUEUE_SEL            14
+#define VIRTIO_PCI_QUEUE_NOTIFY         16
+#define VIRTIO_PCI_STATUS               18
+#define VIRTIO_PCI_ISR                  19
+/* only there while MSI-X is enabled, which pushes the device specific configuration 4 bytes further */
+#define VIRTIO_MSI_CONFIG_VECTOR        20
+#define VIRTIO_MSI_QUEUE_VECTOR         22
+/* device specific configuration */
+#define VIRTIO_PCI_CONFIG               20
+#define VIRTIO_PCI_CONFIG_MSIX          24
+
+/* not routed to any MSI-X entry */
+#define VIRTIO_MSI_NO_VECTOR            0xffff
+
+#define VIRTIO_PCI_QUEUE_ADDR_SHIFT     12
+#define VIRTIO_PCI_VRING_ALIGN          4096
+
+#define VIRTIO_STATUS_ACKNOWLEDGE       (1 << 0)
+#define VIRTIO_STATUS_DRIVER            (1 << 1)
+#define VIRTIO_STATUS_DRIVER_OK         (1 << 2)
+#define VIRTIO_STATUS_FAILED            (1 << 7)
+
+#define VIRTIO_ISR_QUEUE                (1 << 0)
+
+#define VIRTIO_RING_F_INDIRECT_DESC     (1U << 28)
+#define VIRTIO_RING_F_EVENT_IDX         (1U << 29)
+
+#define VRING_DESC_F_NEXT               (1 << 0)
+#define VRING_DESC_F_WRITE              (1 << 1)
+#define VRING_DESC_F_INDIRECT           (1 << 2)
+
+#define VRING_AVAIL_F_NO_INTERRUPT      (1 << 0)
+#define VRING_USED_F_NO_NOTIFY          (1 << 0)
+
+typedef struct {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} vring_desc_t;
+
+typedef struct {
+    uint16_t flags;
+    uint16_t idx;
+    /* followed by used_event when VIRTIO_RING_F_EVENT_IDX is negotiated */
+    uint16_t ring[];
+} vring_avail_t;
+
+typedef struct {
+    uint32_t id;
+    uint32_t len;
+} vring_used_elem_t;
+
+typedef struct {
+    uint16_t flags;
+    uint16_t idx;
+    /* followed by avail_event when VIRTIO_RING_F_EVENT_IDX is negotiated */
+    vring_used_elem_t ring[];
+} vring_used_t;
+
+/* split virtqueue, as laid out by a legacy device */
+typedef struct {
+    uint16_t io;
+    uint16_t index;
+    uint16_t num;
+
+    vring_desc_t *desc;
+    vring_avail_t *avail;
+    vring_used_t *used;
+
+    bool indirect;
+    bool event_idx;
+
+    /* free descriptors are chained through their next field */
+    uint16_t free_head;
+    uint16_t num_free;
+
+    /* buffers handed to the device and not given back yet */
+    uint16_t in_flight;
+
+    /* avail->idx at the last notification and the next used entry to look at */
+    uint16_t kicked_avail;
+    uint16_t last_used;
+
+    /* what virtqueue_add was given for each head descriptor */
+    void **tokens;
+} virtqueue_t;
+
+/* reset the device and acknowledge it, returns the features both sides support out of wanted */
+uint32_t virtio_pci_negotiate(uint16_t io, uint32_t wanted);
+void virtio_pci_driver_ok(uint16_t io);
+void virtio_pci_failed(uint16_t io);
+
+/* set up queue index of the device at io, returns false if it doesn't exist or memory can't be found */
+bool virtqueue_init(virtqueue_t *vq, uint16_t io, uint16_t index, uint32_t features);
+
+/* detach the ring from the device and free it, only for queues virtqueue_init set up */
+void virtqueue_free(virtqueue_t *vq);
+
+/*
+ * expose a buffer made of n descriptors (table) to the device, token is handed back once it's used. With indirect
+ * descriptors table is referenced rather than copied, so it must stay put until then. Returns false if the ring is
+ * full. The device isn't notified until virtqueue_kick
+ */
+bool virtqueue_add(virtqueue_t *vq, vring_desc_t *table, uint16_t n, void *token);
+
+/* notify the device about everything added since the last kick, unless it said it doesn't need to be told */
+void virtqueue_kick(virtqueue_t *vq);
+
+/* next buffer the device is done with (and how many bytes it wrote) or NULL if there is none */
+void* virtqueue_get_used(virtqueue_t *vq, uint32_t *len);
+
+/*
+ * ask for an interrupt only once most of the buffers in flight are used rather than on the next one. Returns false
+ * if enough of them are used already, the caller has to drain the queue again as the interrupt may never come
+ */
+bool virtqueue_enable_cb_delayed(virtqueue_t *vq);
+
+#endif /* INCLUDE_KERNEL_DEVICE_VIRTIO_H_ */
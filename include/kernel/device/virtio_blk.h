@@ -0,0 +1,16 @@
+/*
+ * virtio_blk.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_DEVICE_VIRTIO_BLK_H_
+#define INCLUDE_KERNEL_DEVICE_VIRTIO_BLK_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* register the driver, every legacy virtio-blk PCI device becomes vda, vdb... */
+void virtio_blk_init(void);
+
+#endif /* INCLUDE_KERNEL_DEVICE_VIRTIO_BLK_H_ */
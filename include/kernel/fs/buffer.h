@@ -0,0 +1,47 @@
+/*
+ * buffer.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_FS_BUFFER_H_
+#define INCLUDE_KERNEL_FS_BUFFER_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/device/block.h"
+
+/* cached pages, 8 MiB */
+#define BUFFER_CACHE_PAGES      2048
+
+struct buffer_page;
+
+/* a block of a device as seen through the cache, valid until brelse */
+typedef struct {
+    struct buffer_page *page;
+    block_device_t *dev;
+    uint64_t block;
+    uint32_t size;
+    void *data;
+} buffer_head_t;
+
+/* allocate the cache and start the flusher thread, the scheduler must be initialised already */
+void buffer_init(void);
+
+/*
+ * fill bh with block (of size bytes, a power of two between a sector and a page) of dev, reading it in if it
+ * isn't cached yet. Returns 0 or -errno
+ */
+int bread(block_device_t *dev, uint64_t block, uint32_t size, buffer_head_t *bh);
+void brelse(buffer_head_t *bh);
+
+/* bh's data was changed, the flusher writes it back later on */
+void mark_buffer_dirty(buffer_head_t *bh);
+
+/* write back everything that's dirty and wait for it, returns -EIO if any write failed since the last sync */
+int buffer_sync(void);
+
+/* called every tick, wakes the flusher up when there are dirty buffers */
+void buffer_timer_tick(void);
+
+#endif /* INCLUDE_KERNEL_FS_BUFFER_H_ */
@@ -0,0 +1,30 @@
+/*
+ * devfs.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_FS_DEVFS_H_
+#define INCLUDE_KERNEL_FS_DEVFS_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/fs/vfs.h"
+
+/* a device node under /dev, drivers own these (they're usually static) */
+typedef struct devfs_node {
+    const char *name;
+    uint32_t mode;
+    const file_ops_t *fops;
+    /* driver's own context, reachable through inode->private */
+    void *private;
+    struct devfs_node *next;
+} devfs_node_t;
+
+/* can be called before the VFS is up, nodes show up once /dev is mounted */
+void devfs_register(devfs_node_t *node);
+
+/* root inode to be mounted on /dev */
+inode_t* devfs_mount(void);
+
+#endif /* INCLUDE_KERNEL_FS_DEVFS_H_ */
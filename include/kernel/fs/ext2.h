@@ -0,0 +1,241 @@
+/*
+ * ext2.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_FS_EXT2_H_
+#define INCLUDE_KERNEL_FS_EXT2_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/device/block.h"
+#include "kernel/fs/vfs.h"
+
+#define EXT2_SUPER_MAGIC            0xef53
+/* the superblock always sits 1024 bytes into the device, whatever the block size */
+#define EXT2_SUPER_OFFSET           1024
+#define EXT2_SUPER_SIZE             1024
+
+#define EXT2_ROOT_INO               2
+#define EXT2_GOOD_OLD_FIRST_INO     11
+#define EXT2_GOOD_OLD_INODE_SIZE    128
+#define EXT2_GOOD_OLD_REV           0
+
+#define EXT2_NDIR_BLOCKS            12
+#define EXT2_IND_BLOCK              12
+#define EXT2_DIND_BLOCK             13
+#define EXT2_TIND_BLOCK             14
+#define EXT2_N_BLOCKS               15
+
+/* features this driver knows about, anything else in incompat means hands off */
+#define EXT2_FEATURE_COMPAT_DIR_INDEX       0x0020
+#define EXT2_FEATURE_INCOMPAT_FILETYPE      0x0002
+#define EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER 0x0001
+#define EXT2_FEATURE_RO_COMPAT_LARGE_FILE   0x0002
+
+#define EXT2_FEATURE_INCOMPAT_SUPP      EXT2_FEATURE_INCOMPAT_FILETYPE
+#define EXT2_FEATURE_RO_COMPAT_SUPP     (EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER | EXT2_FEATURE_RO_COMPAT_LARGE_FILE)
+
+/* s_flags */
+#define EXT2_FLAGS_SIGNED_HASH      0x0001
+#define EXT2_FLAGS_UNSIGNED_HASH    0x0002
+
+/* i_flags */
+#define EXT2_INDEX_FL               0x00001000
+
+/* directory entry file types */
+#define EXT2_FT_UNKNOWN             0
+#define EXT2_FT_REG_FILE            1
+#define EXT2_FT_DIR                 2
+#define EXT2_FT_CHRDEV              3
+#define EXT2_FT_SYMLINK             7
+
+/* htree hash versions */
+#define DX_HASH_LEGACY              0
+#define DX_HASH_HALF_MD4            1
+#define DX_HASH_TEA                 2
+#define DX_HASH_LEGACY_UNSIGNED     3
+#define DX_HASH_HALF_MD4_UNSIGNED   4
+#define DX_HASH_TEA_UNSIGNED        5
+
+typedef struct {
+    uint32_t s_inodes_count;
+    uint32_t s_blocks_count;
+    uint32_t s_r_blocks_count;
+    uint32_t s_free_blocks_count;
+    uint32_t s_free_inodes_count;
+    uint32_t s_first_data_block;
+    uint32_t s_log_block_size;
+    uint32_t s_log_frag_size;
+    uint32_t s_blocks_per_group;
+    uint32_t s_frags_per_group;
+    uint32_t s_inodes_per_group;
+    uint32_t s_mtime;
+    uint32_t s_wtime;
+    uint16_t s_mnt_count;
+    uint16_t s_max_mnt_count;
+    uint16_t s_magic;
+    uint16_t s_state;
+    uint16_t s_errors;
+    uint16_t s_minor_rev_level;
+    uint32_t s_lastcheck;
+    uint32_t s_checkinterval;
+    uint32_t s_creator_os;
+    uint32_t s_rev_level;
+    uint16_t s_def_resuid;
+    uint16_t s_def_resgid;
+    /* EXT2_DYNAMIC_REV onwards */
+    uint32_t s_first_ino;
+    uint16_t s_inode_size;
+    uint16_t s_block_group_nr;
+    uint32_t s_feature_compat;
+    uint32_t s_feature_incompat;
+    uint32_t s_feature_ro_compat;
+    uint8_t s_uuid[16];
+    char s_volume_name[16];
+    char s_last_mounted[64];
+    uint32_t s_algorithm_usage_bitmap;
+    uint8_t s_prealloc_blocks;
+    uint8_t s_prealloc_dir_blocks;
+    uint16_t s_padding1;
+    uint8_t s_journal_uuid[16];
+    uint32_t s_journal_inum;
+    uint32_t s_journal_dev;
+    uint32_t s_last_orphan;
+    uint32_t s_hash_seed[4];
+    uint8_t s_def_hash_version;
+    uint8_t s_reserved_char_pad;
+    uint16_t s_reserved_word_pad;
+    uint32_t s_default_mount_opts;
+    uint32_t s_first_meta_bg;
+    /* ext3/4 fields nobody here cares about, up to s_flags */
+    uint8_t s_reserved1[88];
+    uint32_t s_flags;
+    uint8_t s_reserved2[668];
+} __packed ext2_super_block_t;
+
+typedef struct {
+    uint32_t bg_block_bitmap;
+    uint32_t bg_inode_bitmap;
+    uint32_t bg_inode_table;
+    uint16_t bg_free_blocks_count;
+    uint16_t bg_free_inodes_count;
+    uint16_t bg_used_dirs_count;
+    uint16_t bg_pad;
+    uint32_t bg_reserved[3];
+} __packed ext2_group_desc_t;
+
+typedef struct {
+    uint16_t i_mode;
+    uint16_t i_uid;
+    uint32_t i_size;
+    uint32_t i_atime;
+    uint32_t i_ctime;
+    uint32_t i_mtime;
+    uint32_t i_dtime;
+    uint16_t i_gid;
+    uint16_t i_links_count;
+    /* in 512-byte units, indirect blocks included */
+    uint32_t i_blocks;
+    uint32_t i_flags;
+    uint32_t i_osd1;
+    uint32_t i_block[EXT2_N_BLOCKS];
+    uint32_t i_generation;
+    uint32_t i_file_acl;
+    /* upper 32 bits of the size of regular files (EXT2_FEATURE_RO_COMPAT_LARGE_FILE) */
+    uint32_t i_size_high;
+    uint32_t i_faddr;
+    uint8_t i_osd2[12];
+} __packed ext2_inode_t;
+
+typedef struct {
+    uint32_t inode;
+    uint16_t rec_len;
+    uint8_t name_len;
+    uint8_t file_type;
+    char name[];
+} __packed ext2_dir_entry_t;
+
+/* space a directory entry with a name of len bytes takes up */
+#define EXT2_DIR_REC_LEN(len)       (((len) + 8 + 3) & ~3)
+
+/* htree: block 0 of an indexed directory starts with "." and ".." followed by this */
+typedef struct {
+    uint32_t reserved_zero;
+    uint8_t hash_version;
+    uint8_t info_length;
+    uint8_t indirect_levels;
+    uint8_t unused_flags;
+} __packed dx_root_info_t;
+
+/* the first entry of every index node holds limit/count in place of the hash */
+typedef struct {
+    uint32_t hash;
+    uint32_t block;
+} __packed dx_entry_t;
+
+typedef struct {
+    uint16_t limit;
+    uint16_t count;
+} __packed dx_countlimit_t;
+
+/* a mounted ext2 file system */
+typedef struct {
+    block_device_t *dev;
+    uint32_t vfs_dev;
+    bool read_only;
+
+    ext2_super_block_t sb;
+    ext2_group_desc_t *groups;
+
+    uint32_t block_size;
+    uint32_t addr_per_block;
+    uint32_t groups_count;
+    uint32_t desc_per_block;
+    uint32_t inode_size;
+    uint32_t first_ino;
+
+    /* htree hash parameters */
+    uint32_t hash_seed[4];
+    bool unsigned_hash;
+} ext2_fs_t;
+
+/* what the VFS inode points at, ext2's in-core copy of an inode */
+typedef struct ext2_inode_info {
+    ext2_fs_t *fs;
+    uint32_t ino;
+    ext2_inode_t raw;
+
+    /* allocation goal: where the block following the last one allocated should go */
+    uint32_t next_alloc_lblock;
+    uint32_t next_alloc_pblock;
+
+    struct ext2_inode_info *next_free;
+} ext2_inode_info_t;
+
+/* root inode of the ext2 file system on dev, NULL if there is none (or it can't be handled) */
+inode_t* ext2_mount(block_device_t *dev);
+
+/* fs/ext2.c */
+uint64_t ext2_i_size(const ext2_inode_info_t *ei);
+int ext2_write_inode(ext2_inode_info_t *ei);
+int ext2_bmap(ext2_inode_info_t *ei, uint32_t lblock, bool create, uint32_t *pblock);
+int ext2_bunmap(ext2_inode_info_t *ei, uint32_t lblock);
+inode_t* ext2_iget(ext2_fs_t *fs, uint32_t ino);
+
+/* fs/ext2_alloc.c */
+int ext2_new_block(ext2_fs_t *fs, uint32_t goal, uint32_t *block);
+int ext2_free_block(ext2_fs_t *fs, uint32_t block);
+int ext2_new_inode(ext2_fs_t *fs, uint32_t dir_ino, bool is_dir, uint32_t *ino);
+int ext2_free_inode(ext2_fs_t *fs, uint32_t ino, bool is_dir);
+int ext2_write_super(ext2_fs_t *fs);
+int ext2_write_group_desc(ext2_fs_t *fs, uint32_t group);
+
+/* fs/ext2_dir.c */
+uint32_t ext2_dir_lookup(ext2_inode_info_t *dir, const char *name, size_t len);
+int ext2_add_entry(ext2_inode_info_t *dir, const char *name, size_t len, uint32_t ino, uint32_t mode);
+uint32_t ext2_dx_hash(ext2_fs_t *fs, int version, const char *name, size_t len);
+
+#endif /* INCLUDE_KERNEL_FS_EXT2_H_ */
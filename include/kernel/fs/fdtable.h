@@ -0,0 +1,28 @@
+/*
+ * fdtable.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_FS_FDTABLE_H_
+#define INCLUDE_KERNEL_FS_FDTABLE_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/fs/vfs.h"
+#include "kernel/task/process.h"
+
+#define STDIN_FILENO    0
+#define STDOUT_FILENO   1
+#define STDERR_FILENO   2
+
+/* stdin, stdout and stderr of a new task all go to the console */
+void files_init(task_struct_t *task);
+void files_close_all(task_struct_t *task);
+
+/* these work on the current task's table */
+int fd_install(file_t *file);
+file_t* fd_get(int fd);
+int fd_close(int fd);
+
+#endif /* INCLUDE_KERNEL_FS_FDTABLE_H_ */
@@ -0,0 +1,45 @@
+/*
+ * ramfs.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_FS_RAMFS_H_
+#define INCLUDE_KERNEL_FS_RAMFS_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/fs/vfs.h"
+
+/* where the boot loader leaves the initramfs (Loader.Initramfs.Start.Address) and how much room it has there */
+#define INITRAMFS_PHYS_ADDR     0x80000
+#define INITRAMFS_MAX_SIZE      (248 * 512)
+
+typedef struct ramfs_node {
+    /* last path component, points into the archive */
+    const char *name;
+    uint32_t mode;
+    /* contents (target for symlinks) as they sit in the archive */
+    uint64_t data_phys;
+    uint64_t size;
+
+    struct ramfs_node *parent;
+    struct ramfs_node *children;
+    struct ramfs_node *next;
+} ramfs_node_t;
+
+/* build the tree out of the archive at phys, the archive has to stay where it is. Returns false if it's bogus */
+bool initramfs_init(uint64_t phys, size_t size);
+
+ramfs_node_t* ramfs_root(void);
+
+/* child of dir called name (len bytes, not necessarily nul-terminated) or NULL */
+ramfs_node_t* ramfs_lookup_child(ramfs_node_t *dir, const char *name, size_t len);
+
+/* absolute path, NULL if it doesn't exist */
+ramfs_node_t* ramfs_lookup(const char *path);
+
+/* root inode of the unpacked archive, to be mounted through the VFS */
+inode_t* ramfs_mount(void);
+
+#endif /* INCLUDE_KERNEL_FS_RAMFS_H_ */
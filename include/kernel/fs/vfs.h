@@ -0,0 +1,146 @@
+/*
+ * vfs.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_FS_VFS_H_
+#define INCLUDE_KERNEL_FS_VFS_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/sys/stat.h"
+#include "kernel/fs/buffer.h"
+
+/* longest path accepted from user space (nul included) and longest path component */
+#define VFS_PATH_MAX        256
+#define VFS_NAME_MAX        55
+
+/* objects are preallocated, these are hard limits (like Linux's file-max) */
+#define VFS_MAX_INODES      1024
+#define VFS_MAX_DENTRIES    1024
+#define VFS_MAX_FILES       256
+
+/* lseek whence */
+#define SEEK_SET            0
+#define SEEK_CUR            1
+#define SEEK_END            2
+
+struct inode;
+struct file;
+
+typedef struct {
+    /* child of dir called name (len bytes, not nul-terminated), NULL if there is none */
+    struct inode* (*lookup)(struct inode *dir, const char *name, size_t len);
+    /* optional, new file called name in dir (which doesn't have one yet). Returns 0 or -errno */
+    int (*create)(struct inode *dir, const char *name, size_t len, uint32_t mode, struct inode **result);
+} inode_ops_t;
+
+typedef struct {
+    /* optional, returns 0 or -errno. Meant for checks like a write on a read-only file system */
+    int (*open)(struct inode *inode, struct file *file);
+    /* both advance *pos by what they've transferred and return that, or -errno */
+    long (*read)(struct file *file, char *buf, size_t length, uint64_t *pos);
+    long (*write)(struct file *file, const char *buf, size_t length, uint64_t *pos);
+    /* optional, called when the last reference to the file goes away */
+    void (*release)(struct inode *inode, struct file *file);
+    /*
+     * optional, pins the page of the buffer cache holding page index (whole pages into the file) in bh, so it can
+     * be mapped as it is. Returns 0, -EINVAL if that part of the file isn't a single page of the cache, or -errno
+     */
+    int (*map_page)(struct file *file, uint64_t index, buffer_head_t *bh);
+} file_ops_t;
+
+typedef struct inode {
+    /* file system instance (mount id) and inode number within it */
+    uint32_t dev;
+    uint64_t ino;
+    uint32_t mode;
+    uint32_t nlink;
+    uint64_t size;
+
+    const inode_ops_t *i_op;
+    const file_ops_t *f_op;
+
+    /* whatever the file system needs to find its own representation of this inode */
+    void *private;
+
+    /* optional, called right before the inode goes back to the pool */
+    void (*evict)(struct inode *inode);
+
+    uint32_t refcount;
+    struct inode *next_free;
+} inode_t;
+
+typedef struct dentry {
+    char name[VFS_NAME_MAX + 1];
+    uint8_t len;
+    uint32_t hash;
+
+    struct dentry *parent;
+    /* NULL for negative entries - names known not to exist */
+    inode_t *inode;
+
+    /* root of whatever is mounted on top of this dentry, and the way back from a mounted root */
+    struct dentry *mounted;
+    struct dentry *mountpoint;
+
+    uint32_t refcount;
+    struct dentry *hash_next;
+    /* unused dentries (refcount 0) in least recently used order, or the free list */
+    struct dentry *lru_prev;
+    struct dentry *lru_next;
+} dentry_t;
+
+typedef struct file {
+    dentry_t *dentry;
+    inode_t *inode;
+    const file_ops_t *f_op;
+    uint64_t pos;
+    int flags;
+    uint32_t refcount;
+    struct file *next_free;
+} file_t;
+
+void vfs_init(void);
+
+/* inodes are handed out with one reference, iget/iput take and drop more */
+inode_t* new_inode(void);
+inode_t* iget(inode_t *inode);
+void iput(inode_t *inode);
+
+/* new id for a file system instance, stored in every inode's dev */
+uint32_t vfs_new_dev(void);
+
+/* dentry cache, see fs/dcache.c */
+void dcache_init(void);
+dentry_t* d_lookup(dentry_t *parent, const char *name, size_t len);
+dentry_t* d_alloc(dentry_t *parent, const char *name, size_t len, inode_t *inode);
+dentry_t* d_alloc_root(inode_t *inode);
+dentry_t* dget(dentry_t *dentry);
+void dput(dentry_t *dentry);
+/* recycles the least recently used unused dentry, false if there is none */
+bool dcache_shrink(void);
+
+/* root is the file system everything else is mounted on */
+void vfs_mount_root(inode_t *root);
+int vfs_mount(const char *path, inode_t *root);
+
+/* copies a path from user space into a VFS_PATH_MAX buffer, returns 0 or -errno */
+int getname(const char *user_path, char *path);
+
+/* walks path (always absolute for now) through the dentry cache, returns 0 or -errno */
+int vfs_lookup(const char *path, dentry_t **result);
+
+/* new regular file at path, the parent has to exist. Returns 0 or -errno */
+int vfs_create(const char *path, uint32_t mode, dentry_t **result);
+
+int vfs_open(const char *path, int flags, file_t **result);
+file_t* fget(file_t *file);
+void fput(file_t *file);
+long vfs_read(file_t *file, char *buf, size_t length);
+long vfs_write(file_t *file, const char *buf, size_t length);
+long vfs_lseek(file_t *file, long offset, int whence);
+void vfs_stat(inode_t *inode, struct stat *st);
+
+#endif /* INCLUDE_KERNEL_FS_VFS_H_ */
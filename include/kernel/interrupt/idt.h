@@ -12,8 +12,11 @@
 #include "kernel/compiler/macro.h"
 #include "kernel/arch/cpu_registers.h"
 
+/* vectors below this one are CPU exceptions and take the slow entry path (see vectors.asm) */
+#define IDT_FIRST_NON_EXCEPTION_VECTOR  32
+
 typedef struct {
-    /* 64-bits general purpose registers*/
+    /* System control registers - only captured for CPU exceptions (vectors 0-31) */
     sys_ctrl_regs_t sys_ctrl_regs;
 
     /* 64-bits general purpose registers*/
@@ -32,6 +35,14 @@ typedef struct {
 
 } __packed interrupt_stack_frame_t;
 
+typedef void (*exception_handler_t)(interrupt_stack_frame_t *int_frame);
+
 void idt_init(void);
 
+/* take over a CPU exception (or software interrupt) vector, by default they hang the system */
+void register_exception_handler(uint8_t vector, exception_handler_t handler);
+
+/* report the exception and hang the system, for handlers that can only deal with some of the cases */
+void unhandled_exception(interrupt_stack_frame_t *int_frame) __noreturn;
+
 #endif /* INCLUDE_KERNEL_ARCH_INTERRUPT_H_ */
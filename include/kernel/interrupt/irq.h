@@ -0,0 +1,55 @@
+/*
+ * irq.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_INTERRUPT_IRQ_H_
+#define INCLUDE_KERNEL_INTERRUPT_IRQ_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/interrupt/idt.h"
+
+/* hardware IRQs are remapped right after the exceptions reserved by Intel */
+#define IRQ_VECTOR_BASE     32
+#define NR_IRQS             16
+
+/* vectors handed out to message signalled interrupts (MSI/MSI-X), those bypass the irq chip altogether */
+#define MSI_VECTOR_BASE     0x50
+#define NR_MSI_VECTORS      0x80
+
+/* dev is whatever was handed to request_irq, EOI is sent by the irq chip once the handler returns */
+typedef void (*irq_handler_t)(void *dev);
+
+/* interrupt controller the IRQ lines are wired to (8259 PIC or IO-APIC) */
+typedef struct {
+    const char *name;
+    void (*mask)(uint8_t irq);
+    void (*unmask)(uint8_t irq);
+    void (*eoi)(uint8_t irq);
+    /* NULL if the controller can only deliver to the boot CPU */
+    void (*set_affinity)(uint8_t irq, uint32_t cpu);
+} irq_chip_t;
+
+/* hand every IRQ line over to another controller, lines that were claimed stay unmasked */
+void irq_set_chip(const irq_chip_t *chip);
+
+/* deliver irq to cpu from now on, returns false if the controller or the cpu can't take it */
+bool irq_set_affinity(uint8_t irq, uint32_t cpu);
+
+/* claim an IRQ line and unmask it, returns false if someone else owns it already */
+bool request_irq(uint8_t irq, irq_handler_t handler, void *dev);
+void free_irq(uint8_t irq);
+
+/* claim a free MSI vector for handler, returns -1 if they're all taken */
+int request_msi_vector(irq_handler_t handler, void *dev);
+void free_msi_vector(int vector);
+
+/* called by interrupt_handler for vectors in the IRQ range */
+void handle_irq(interrupt_stack_frame_t *int_frame);
+
+/* same for vectors in the MSI range */
+void handle_msi(interrupt_stack_frame_t *int_frame);
+
+#endif /* INCLUDE_KERNEL_INTERRUPT_IRQ_H_ */
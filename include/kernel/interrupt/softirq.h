@@ -0,0 +1,48 @@
+/*
+ * softirq.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_INTERRUPT_SOFTIRQ_H_
+#define INCLUDE_KERNEL_INTERRUPT_SOFTIRQ_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* lower number runs first */
+enum {
+    HI_SOFTIRQ,         /* high priority tasklets */
+    TIMER_SOFTIRQ,      /* periodic housekeeping raised by the timer tick */
+    TASKLET_SOFTIRQ,    /* regular tasklets */
+    NR_SOFTIRQS
+};
+
+typedef void (*softirq_action_t)(void);
+
+typedef struct tasklet {
+    struct tasklet *next;
+    /* already queued, scheduling it again is a no-op */
+    bool scheduled;
+    void (*func)(unsigned long data);
+    unsigned long data;
+} tasklet_t;
+
+#define DECLARE_TASKLET(name, fn, arg) \
+    tasklet_t name = { .next = NULL, .scheduled = false, .func = fn, .data = arg }
+
+void softirq_init(void);
+void open_softirq(unsigned int nr, softirq_action_t action);
+void raise_softirq(unsigned int nr);
+
+/* bracket the hard-IRQ part of every interrupt handler */
+void irq_enter(void);
+void irq_exit(void);
+
+/* true while servicing a hard IRQ or running softirqs */
+bool in_interrupt(void);
+
+void tasklet_schedule(tasklet_t *t);
+void tasklet_hi_schedule(tasklet_t *t);
+
+#endif /* INCLUDE_KERNEL_INTERRUPT_SOFTIRQ_H_ */
@@ -9,6 +9,5 @@
 #define INCLUDE_KERNEL_INTERRUPT_SPURIOUS_H_
 
 void spurious_irq_enable(void);
-void spurious_handle_irq(void);
 
 #endif /* INCLUDE_KERNEL_INTERRUPT_SPURIOUS_H_ */
@@ -0,0 +1,44 @@
+/*
+ * logbuf.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_LIB_LOGBUF_H_
+#define INCLUDE_KERNEL_LIB_LOGBUF_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/*
+ * Notes to myself:
+ *
+ * This is a multi-producer/single-consumer ring of log records. Producers
+ * (printk callers, which can be anything from kmain to an IRQ handler) only
+ * do an atomic increment to reserve a slot, format into it and publish it by
+ * storing the sequence number. The consumer (console flusher) is the only one
+ * who touches port I/O.
+ *
+ * When producers lap the consumer the oldest records are overwritten and the
+ * consumer accounts for them as dropped rather than blocking anyone.
+ *
+ * Both sizes must be a power of 2.
+ */
+#define LOGBUF_RECORDS          128
+#define LOGBUF_TEXT_SIZE        256
+
+typedef struct {
+    /* pos + 1 once the record is published, 0 while it's being written */
+    uint64_t seq;
+    /* jiffies at the time the record was produced */
+    uint64_t timestamp;
+    /* text length without the NUL-terminator */
+    uint16_t length;
+    char text[LOGBUF_TEXT_SIZE];
+} logbuf_record_t;
+
+logbuf_record_t* logbuf_reserve(uint64_t *pos);
+void logbuf_commit(logbuf_record_t *rec, uint64_t pos);
+bool logbuf_read(logbuf_record_t *dst, uint64_t *dropped);
+
+#endif /* INCLUDE_KERNEL_LIB_LOGBUF_H_ */
@@ -13,6 +13,11 @@
 void printk_init(const uint8_t level);
 void printk(const uint8_t level, const char *format, ...);
 
+/* records are queued by printk and written to console/serial by these */
+void printk_set_deferred(bool enabled);
+void printk_flush(void);
+void printk_flush_deferred(void);
+
 #define PRINTK_DEBUG_LEVEL  3
 #define PRINTK_FINE_LEVEL   2
 #define PRINTK_INFO_LEVEL   1
@@ -14,7 +14,9 @@
 void* memcpy(void *dst, const void *src, size_t size);
 void* memset(void *buf, char value, size_t size);
 void* memmove(void *dst, void *src, size_t size);
+int memcmp(const void *s1, const void *s2, size_t size);
 size_t strlen(const char *buf);
+int strcmp(const char *s1, const char *s2);
 
 /* non-standard functions (although commonly used by other compilers) */
 void* memzero(void *dst, size_t size);
@@ -0,0 +1,26 @@
+/*
+ * fault.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_FAULT_H_
+#define INCLUDE_KERNEL_MM_FAULT_H_
+
+#include "kernel/compiler/freestanding.h"
+
+#define PAGE_FAULT_VECTOR       14
+
+/* #PF error code bits */
+#define PF_ERR_PRESENT          (1 << 0)
+#define PF_ERR_WRITE            (1 << 1)
+#define PF_ERR_USER             (1 << 2)
+#define PF_ERR_INSTR            (1 << 4)
+
+void page_fault_init(void);
+
+/* physical address of the page every bss page is mapped to until it's first written */
+uint64_t cow_zero_page(void);
+
+#endif /* INCLUDE_KERNEL_MM_FAULT_H_ */
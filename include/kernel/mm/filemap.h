@@ -0,0 +1,53 @@
+/*
+ * filemap.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_FILEMAP_H_
+#define INCLUDE_KERNEL_MM_FILEMAP_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/fs/vfs.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/mm/tlb.h"
+
+/* file pages mapped at any one time, across every process */
+#define FILEMAP_MAX_PAGES       512
+#define FILEMAP_HASH_SIZE       64
+
+/* a page of a file that every mapping of that file (and offset) points at */
+typedef struct filemap_page {
+    /* the file, not the inode_t: every hard link to a file gets an inode_t of its own */
+    uint32_t dev;
+    uint64_t ino;
+    /* offset in the file, in pages */
+    uint64_t index;
+    uint64_t phys_addr;
+
+    /* the buffer cache page it is, pinned. bh.page is NULL if the page is a copy of its own */
+    buffer_head_t bh;
+
+    /* what the page is read and written back through */
+    file_t *file;
+
+    /* page-table entries pointing at it */
+    uint32_t refcount;
+    bool dirty;
+
+    struct filemap_page *next;
+} filemap_page_t;
+
+void filemap_init(void);
+
+/* reads page index of file into page, zeroes whatever is past the end of it. Returns 0 or -errno */
+int filemap_read_page(file_t *file, uint64_t index, void *page);
+
+/* physical address of the page at index of file with one more reference, 0 if it can't be read in */
+uint64_t filemap_get(file_t *file, uint64_t index);
+
+/* drops a reference, the last one writes the page back if it's dirty and lets the frame go (through tlb) */
+void filemap_put(file_t *file, uint64_t index, bool dirty, mmu_gather_t *tlb);
+
+#endif /* INCLUDE_KERNEL_MM_FILEMAP_H_ */
@@ -0,0 +1,19 @@
+/*
+ * ioremap.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_IOREMAP_H_
+#define INCLUDE_KERNEL_MM_IOREMAP_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* map device registers (uncached) into the kernel address space, returns its virtual address */
+void* ioremap(uint64_t phys_addr, uint64_t length);
+
+/* same thing for memory that isn't covered by the buddy allocator, e.g. firmware tables */
+void* memremap(uint64_t phys_addr, uint64_t length);
+
+#endif /* INCLUDE_KERNEL_MM_IOREMAP_H_ */
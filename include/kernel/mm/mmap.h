@@ -0,0 +1,62 @@
+/*
+ * mmap.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_MMAP_H_
+#define INCLUDE_KERNEL_MM_MMAP_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/task/process.h"
+#include "kernel/fs/vfs.h"
+#include "kernel/mm/tlb.h"
+
+/* mappings are placed from here up, what is below belongs to the executable, its stack and heap */
+#define USER_MMAP_BASE          0x100000000
+
+/* vm areas across every process, like the VFS pools it's a hard limit */
+#define MMAP_MAX_AREAS          512
+
+/* a range of a process' address space mapped by mmap, pages show up as they're touched (see mm/mmap.c) */
+typedef struct vma {
+    /* [start, end), page aligned */
+    uint64_t start;
+    uint64_t end;
+
+    /* PROT_* and MAP_* */
+    int prot;
+    int flags;
+
+    /* NULL for anonymous memory, otherwise start maps offset of file */
+    file_t *file;
+    uint64_t offset;
+
+    /* sorted by address */
+    struct vma *next;
+} vma_t;
+
+void mmap_init(void);
+
+/* these work on the current task's address space. They return 0 (or the address for do_mmap) or -errno */
+long do_mmap(uint64_t addr, size_t length, int prot, int flags, file_t *file, uint64_t offset);
+long do_munmap(uint64_t addr, size_t length);
+long do_mprotect(uint64_t addr, size_t length, int prot);
+
+/* moves the program break, returns where it is afterwards */
+long do_brk(uint64_t brk);
+
+/* true if fault_addr is in one of task's areas and the access was allowed, now backed by a page */
+bool mmap_fault(task_struct_t *task, uint64_t fault_addr, uint64_t error_code);
+
+/* v_addr of task was COW and just got a copy of its own, lets go of whatever page it was mapping (through tlb) */
+void mmap_cow_copied(task_struct_t *task, uint64_t v_addr, mmu_gather_t *tlb);
+
+/* false if fault_addr is in one of task's areas but it can't be written to */
+bool mmap_write_allowed(task_struct_t *task, uint64_t fault_addr);
+
+/* unmaps every area of task, dirty shared file pages are written back */
+void mmap_exit(task_struct_t *task);
+
+#endif /* INCLUDE_KERNEL_MM_MMAP_H_ */
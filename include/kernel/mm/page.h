@@ -12,6 +12,7 @@
 #include "kernel/compiler/macro.h"
 #include "kernel/arch/mem.h"
 #include "kernel/mm/pagetable.h"
+#include "kernel/mm/tlb.h"
 
 /*
  * Notes to myself:
@@ -31,6 +32,19 @@
 #define PAGE_PAGESIZE_BIT           (1 << 7)
 #define PAGE_GLOBAL_BIT             (1 << 8)
 
+/* available to software (bits 9-11): frame is a kmalloc'd page that belongs to the mapping and dies with it */
+#define PAGE_OWNED_BIT              (1 << 9)
+/* available to software: read-only for now, gets a private copy on the first write (see mm/fault.c) */
+#define PAGE_COW_BIT                (1 << 10)
+/*
+ * not a hardware bit, page_alloc turns it into the NX bit of the leaf entry (when EFER.NXE is on).
+ * It sits on the last software bit so it can travel in the same 'flags' argument
+ */
+#define PAGE_NO_EXEC_BIT            (1 << 11)
+
+#define PAGE_SHIFT                  12
+#define PREP_BASE_ADDR(addr)        (((addr) >> PAGE_SHIFT) & (UINT64_MAX >> (sizeof(uint64_t) * CHAR_BIT - (64-36))))
+
 #define PAGE_STD_BITS               PAGE_PRESENT_BIT | PAGE_READ_WRITE_BIT
 
 typedef struct {
@@ -63,12 +77,25 @@ typedef struct {
 
 uint64_t paging_calc_space_needed(uint64_t bytes);
 void paging_init(pagetable_t *pgtable, mem_map_region_t k_pages_struct_rg, mem_map_region_t k_pfdb_struct_rg);
+
+/* give every kernel-half PML4 entry its PDPT, so they never change once processes copy them */
+void paging_populate_kernel_half(pagetable_t *pgtable);
 void paging_contiguous_map(pagetable_t *pgtable, uint64_t p_start_addr,
         uint64_t p_end_addr, uint64_t v_base_start_addr, uint16_t flags);
+void paging_contiguous_unmap(pagetable_t *pgtable, uint64_t v_start_addr, uint64_t v_end_addr);
 
 void page_alloc(pagetable_t *pgtable, uint64_t v_addr, uint64_t p_dest_addr, uint16_t flags);
 void page_free(pagetable_t *pgtable, uint64_t v_addr);
 
+/* leaf entry mapping v_addr or NULL if there is none */
+pte_t* page_lookup(pagetable_t *pgtable, uint64_t v_addr);
+
+/* unmap v_addr but leave the TLB invalidation to whoever owns the gather */
+void page_unmap(mmu_gather_t *tlb, uint64_t v_addr);
+
+/* free the user half of a page table created by pagetable_create(), root included, in a single walk */
+void paging_teardown(pagetable_t *pgtable);
+
 void paging_reload_cr3(pagetable_t *pgtable);
 
 #endif /* INCLUDE_KERNEL_MM_PAGE_H_ */
@@ -11,12 +11,33 @@
 #include "kernel/compiler/freestanding.h"
 #include "kernel/mm/pageframe.h"
 
+/* PML4 entries 256-511 map the kernel half, the same PDPTs are referenced by every address space */
+#define PML4_ENTRIES                512
+#define PML4_KERNEL_FIRST_ENTRY     256
+
+/* first address past the user half (canonical lower half) */
+#define USER_SPACE_END_ADDR         0x0000800000000000ULL
+
 typedef struct {
     uint64_t phys_root;             /* Physical address of root page table (PML4T) entry */
     uint64_t virt_root;             /* Virtual address of root page table (PML4T) entry  */
-    pageframe_database_t pfdb;      /* Pageframe database reference  */
+    pageframe_database_t pfdb;      /* Pageframe database reference (kernel page table only) */
+    uint16_t pcid;                  /* TLB tag (process-context identifier), see mm/pcid.c */
+    uint64_t pcid_gen;              /* generation pcid was handed out in, 0 if it has none */
+    uint64_t cpumask;               /* CPUs that have it loaded in CR3, see mm/tlb.c */
 } pagetable_t;
 
 pagetable_t* kernel_pagetable(void);
 
+/* zeroed page-table pages for user address spaces */
+uint64_t pgtable_page_alloc(void);
+void pgtable_page_free(uint64_t phys_addr);
+
+/* page-table pages for any level below the root of pgtable, allocated as the tree grows */
+uint64_t pagetable_alloc_table(pagetable_t *pgtable);
+void pagetable_free_table(pagetable_t *pgtable, uint64_t phys_addr);
+
+/* new root with an empty user half and the kernel half shared with kernel_pagetable() */
+void pagetable_create(pagetable_t *pgtable);
+
 #endif /* INCLUDE_KERNEL_MM_PAGETABLE_H_ */
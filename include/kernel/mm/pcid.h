@@ -0,0 +1,29 @@
+/*
+ * pcid.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_PCID_H_
+#define INCLUDE_KERNEL_MM_PCID_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/mm/pagetable.h"
+
+/* enable CR4.PCIDE if the CPU supports it */
+void pcid_init(void);
+
+/* load pgtable into CR3, keeping its TLB entries from last time whenever it's safe to do so */
+void pcid_load_cr3(pagetable_t *pgtable);
+
+/* drop the TLB entry of v_addr for pgtable, whether it's loaded or not */
+void pcid_invalidate_page(pagetable_t *pgtable, uint64_t v_addr);
+
+/* drop every TLB entry of pgtable (global ones too for the kernel page table) */
+void pcid_flush(pagetable_t *pgtable);
+
+/* pgtable is about to be freed: stop using it (the kernel page table takes over) and forget its PCID */
+void pcid_release(pagetable_t *pgtable);
+
+#endif /* INCLUDE_KERNEL_MM_PCID_H_ */
@@ -0,0 +1,25 @@
+/*
+ * shrinker.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_SHRINKER_H_
+#define INCLUDE_KERNEL_MM_SHRINKER_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* a cache that can hand memory back when kmalloc runs out */
+typedef struct shrinker {
+    /* free about bytes (more or less is fine) and return how much was freed, it may be called from kmalloc */
+    uint64_t (*shrink)(struct shrinker *shrinker, uint64_t bytes);
+    struct shrinker *next;
+} shrinker_t;
+
+void register_shrinker(shrinker_t *shrinker);
+
+/* go through every shrinker until bytes are freed, returns how much was */
+uint64_t shrink_memory(uint64_t bytes);
+
+#endif /* INCLUDE_KERNEL_MM_SHRINKER_H_ */
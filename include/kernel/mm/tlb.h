@@ -0,0 +1,54 @@
+/*
+ * tlb.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_TLB_H_
+#define INCLUDE_KERNEL_MM_TLB_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/mm/pagetable.h"
+
+/* asks other CPUs to drop TLB entries of an address space they have loaded */
+#define TLB_SHOOTDOWN_VECTOR    0xee
+
+/* past this many pages, flushing the whole address space is cheaper than one invlpg per page */
+#define TLB_GATHER_PAGES        32
+
+/* page-table frames that can be held back before the gather has to be flushed early */
+#define TLB_GATHER_TABLES       32
+
+/* same for pages that belonged to the mapping (PAGE_OWNED_BIT) and go back to kfree */
+#define TLB_GATHER_FRAMES       32
+
+/*
+ * Collects what's unmapped from an address space so the TLB (of every CPU using it) is
+ * invalidated once per batch rather than once per page
+ */
+typedef struct {
+    pagetable_t *pgtable;
+    uint64_t pages[TLB_GATHER_PAGES];
+    size_t nr_pages;
+    bool full_flush;
+    /* page-table frames can't be reused while a stale paging-structure cache entry may still point at them */
+    uint64_t tables[TLB_GATHER_TABLES];
+    size_t nr_tables;
+    /* user pages, same reason: another CPU could still be writing to them through a stale TLB entry */
+    uint64_t frames[TLB_GATHER_FRAMES];
+    size_t nr_frames;
+} mmu_gather_t;
+
+void tlb_init(void);
+
+void tlb_gather_mmu(mmu_gather_t *tlb, pagetable_t *pgtable);
+void tlb_remove_page(mmu_gather_t *tlb, uint64_t v_addr);
+void tlb_remove_table(mmu_gather_t *tlb, uint64_t phys_addr);
+void tlb_remove_frame(mmu_gather_t *tlb, uint64_t phys_addr);
+
+/* invalidate everything gathered so far and free the page-table and page frames held back */
+void tlb_flush_mmu(mmu_gather_t *tlb);
+void tlb_finish_mmu(mmu_gather_t *tlb);
+
+#endif /* INCLUDE_KERNEL_MM_TLB_H_ */
@@ -0,0 +1,16 @@
+/*
+ * uaccess.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_MM_UACCESS_H_
+#define INCLUDE_KERNEL_MM_UACCESS_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* whether [ptr, ptr + length) is all in the user half, without overflowing */
+bool access_ok(const void *ptr, size_t length);
+
+#endif /* INCLUDE_KERNEL_MM_UACCESS_H_ */
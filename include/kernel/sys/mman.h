@@ -0,0 +1,23 @@
+/*
+ * mman.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYS_MMAN_H_
+#define INCLUDE_KERNEL_SYS_MMAN_H_
+
+/* mmap/mprotect protection (same numbering as Linux) */
+#define PROT_NONE       0x0
+#define PROT_READ       0x1
+#define PROT_WRITE      0x2
+#define PROT_EXEC       0x4
+
+/* mmap flags, exactly one of MAP_SHARED and MAP_PRIVATE */
+#define MAP_SHARED      0x01
+#define MAP_PRIVATE     0x02
+#define MAP_FIXED       0x10
+#define MAP_ANONYMOUS   0x20
+
+#endif /* INCLUDE_KERNEL_SYS_MMAN_H_ */
@@ -0,0 +1,15 @@
+/*
+ * close.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_CLOSE_H_
+#define INCLUDE_KERNEL_SYSCALL_CLOSE_H_
+
+#include "kernel/compiler/freestanding.h"
+
+long sys_close(int fd);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_CLOSE_H_ */
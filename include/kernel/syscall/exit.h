@@ -0,0 +1,16 @@
+/*
+ * exit.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_EXIT_H_
+#define INCLUDE_KERNEL_SYSCALL_EXIT_H_
+
+#include "kernel/compiler/freestanding.h"
+
+/* terminates the current process, never returns */
+long sys_exit(int code);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_EXIT_H_ */
@@ -16,7 +16,18 @@ void syscall_init(void);
 /* syscall IDs */
 #define __NR_read     0
 #define __NR_write    1
+#define __NR_open     2
+#define __NR_close    3
+#define __NR_stat     4
+#define __NR_fstat    5
+#define __NR_lseek    8
+#define __NR_mmap     9
+#define __NR_mprotect 10
+#define __NR_munmap   11
+#define __NR_brk      12
 #define __NR_getpid   39
+#define __NR_exit     60
+#define __NR_wait4    61
 #define __NR_time     201
 
 
@@ -0,0 +1,15 @@
+/*
+ * lseek.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_LSEEK_H_
+#define INCLUDE_KERNEL_SYSCALL_LSEEK_H_
+
+#include "kernel/compiler/freestanding.h"
+
+long sys_lseek(int fd, long offset, int whence);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_LSEEK_H_ */
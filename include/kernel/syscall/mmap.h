@@ -0,0 +1,18 @@
+/*
+ * mmap.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_MMAP_H_
+#define INCLUDE_KERNEL_SYSCALL_MMAP_H_
+
+#include "kernel/compiler/freestanding.h"
+
+long sys_mmap(uint64_t addr, size_t length, int prot, int flags, int fd, uint64_t offset);
+long sys_munmap(uint64_t addr, size_t length);
+long sys_mprotect(uint64_t addr, size_t length, int prot);
+long sys_brk(uint64_t brk);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_MMAP_H_ */
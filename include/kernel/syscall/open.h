@@ -0,0 +1,15 @@
+/*
+ * open.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_OPEN_H_
+#define INCLUDE_KERNEL_SYSCALL_OPEN_H_
+
+#include "kernel/compiler/freestanding.h"
+
+long sys_open(const char *path, int flags);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_OPEN_H_ */
@@ -0,0 +1,15 @@
+/*
+ * read.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_READ_H_
+#define INCLUDE_KERNEL_SYSCALL_READ_H_
+
+#include "kernel/compiler/freestanding.h"
+
+long sys_read(int fd, char *buf, size_t length);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_READ_H_ */
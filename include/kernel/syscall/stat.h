@@ -0,0 +1,17 @@
+/*
+ * stat.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_STAT_H_
+#define INCLUDE_KERNEL_SYSCALL_STAT_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/sys/stat.h"
+
+long sys_stat(const char *path, struct stat *st);
+long sys_fstat(int fd, struct stat *st);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_STAT_H_ */
@@ -0,0 +1,17 @@
+/*
+ * wait.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_SYSCALL_WAIT_H_
+#define INCLUDE_KERNEL_SYSCALL_WAIT_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/sys/types.h"
+
+/* waits for a child process (any of them if pid is -1) to exit, status receives its exit code */
+long sys_wait4(pid_t pid, int *status);
+
+#endif /* INCLUDE_KERNEL_SYSCALL_WAIT_H_ */
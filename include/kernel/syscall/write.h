@@ -10,6 +10,6 @@
 
 #include "kernel/compiler/freestanding.h"
 
-size_t sys_write(const char *string, size_t length);
+long sys_write(int fd, const char *buf, size_t length);
 
 #endif /* INCLUDE_KERNEL_SYSCALL_WRITE_H_ */
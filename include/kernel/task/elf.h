@@ -0,0 +1,68 @@
+/*
+ * elf.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_TASK_ELF_H_
+#define INCLUDE_KERNEL_TASK_ELF_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/mm/pagetable.h"
+
+/* e_ident */
+#define ELF_MAG0            0x7f
+#define ELF_MAG1            'E'
+#define ELF_MAG2            'L'
+#define ELF_MAG3            'F'
+#define ELF_CLASS64         2
+#define ELF_DATA2LSB        1
+
+#define ELF_ET_EXEC         2
+#define ELF_EM_X86_64       62
+
+#define ELF_PT_LOAD         1
+
+/* p_flags */
+#define ELF_PF_X            (1 << 0)
+#define ELF_PF_W            (1 << 1)
+#define ELF_PF_R            (1 << 2)
+
+typedef struct {
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} __packed elf64_ehdr_t;
+
+typedef struct {
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} __packed elf64_phdr_t;
+
+/*
+ * map the PT_LOAD segments of the executable sitting at image_phys into pgtable and store its entry point, as well
+ * as the first page past the highest segment (where the heap goes). The image has to be page aligned and stay put
+ * for as long as any process maps it, pages are shared with it.
+ */
+bool elf_load(pagetable_t *pgtable, uint64_t image_phys, size_t image_size, uint64_t *entry, uint64_t *image_end);
+
+#endif /* INCLUDE_KERNEL_TASK_ELF_H_ */
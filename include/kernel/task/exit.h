@@ -0,0 +1,24 @@
+/*
+ * exit.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_TASK_EXIT_H_
+#define INCLUDE_KERNEL_TASK_EXIT_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/sys/types.h"
+
+/* tear the current task down and switch away from it for good, what's left is reaped by wait */
+void do_exit(int code) __noreturn;
+
+/*
+ * reap an exited child of the current task (any child if pid is -1) and store its exit code in status, sleeping
+ * until one exits. Returns the child's pid or -ECHILD if there is nothing to wait for
+ */
+long do_wait(pid_t pid, int *status);
+
+#endif /* INCLUDE_KERNEL_TASK_EXIT_H_ */
@@ -12,5 +12,6 @@
 #include "kernel/sys/types.h"
 
 pid_t find_free_pid(void);
+void release_pid(pid_t pid);
 
 #endif /* INCLUDE_KERNEL_TASK_PID_H_ */
@@ -22,6 +22,9 @@
 #define TASK_ZOMBIE             3
 #define TASK_STOPPED            4
 
+/* open file descriptors per task */
+#define TASK_MAX_FILES          16
+
 typedef struct {
 
     /* intial virtual address */
@@ -33,6 +36,13 @@ typedef struct {
     /* reference to process' page table */
     pagetable_t pgtable;
 
+    /* areas mapped with mmap, sorted by address (see mm/mmap.c) */
+    struct vma *mmap;
+
+    /* heap: from right after the executable up to the program break, moved with brk */
+    uint64_t brk_start;
+    uint64_t brk;
+
 } mm_vm_area_t;
 
 typedef struct {
@@ -48,14 +58,20 @@ typedef struct {
 
 } stack_area_t;
 
-typedef struct {
+typedef struct task_struct {
 
     /* process identification */
     pid_t pid;
 
+    /* parent's process identification, 0 if it was created by the kernel (or its parent is gone) */
+    pid_t ppid;
+
     /* process scheduling state */
     int state;
 
+    /* what the task passed to exit, collected by its parent through wait */
+    int exit_code;
+
     /* virtual memory related info */
     mm_vm_area_t vm_area;
 
@@ -65,18 +81,32 @@ typedef struct {
     /* address of the stack used by kernel */
     stack_area_t kernel_stack_area;
 
-    /* save/restore data to return from a context switch*/
-    registers_64_t regs;
-    uint64_t rip;
-    uint64_t cs;
-    uint64_t rflags;
-    uint64_t rsp;
-    uint64_t ss;
+    /*
+     * kernel stack pointer saved by switch_to. Everything else (callee-saved registers, the interrupt frame with
+     * user registers) lives on the task's kernel stack
+     */
+    uint64_t kernel_rsp;
+
+    /* FXSAVE/XSAVE area, NULL until the task touches the FPU for the first time */
+    void *fpu_state;
+
+    /* file descriptor table, indexed by fd (see fs/fdtable.c) */
+    struct file *files[TASK_MAX_FILES];
+
+    /* next task sleeping on the same wait queue (see task/wait.c) */
+    struct task_struct *wait_next;
+
+    /* next exited task waiting for its parent to collect it (see task/exit.c) */
+    struct task_struct *zombie_next;
 
 } task_struct_t;
 
-task_struct_t* create_process(uint64_t text_phy_addr);
+task_struct_t* create_process(uint64_t elf_phy_addr, size_t elf_size);
+task_struct_t* create_kthread(void (*fn)(void));
 void launch_process(task_struct_t *task);
-void process_context_swtich(interrupt_stack_frame_t *int_frame, task_struct_t *curr, task_struct_t *next);
+void process_context_swtich(task_struct_t *curr, task_struct_t *next);
+
+/* saves callee-saved registers and rsp into *prev_rsp, then resumes whatever next_rsp was saved from (switch_to.asm) */
+void switch_to(uint64_t *prev_rsp, uint64_t next_rsp);
 
 #endif /* INCLUDE_KERNEL_TASK_PROCESS_H_ */
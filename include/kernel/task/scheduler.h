@@ -45,7 +45,10 @@ void scheduler_init(task_struct_t *init_proc);
 /* add new process to the scheduler */
 void scheduler_add(task_struct_t *task);
 
-/* choose which process to run next */
-void schedule(interrupt_stack_frame_t *int_frame);
+/* take a task off the run queue for good (it's exiting) */
+void scheduler_remove(task_struct_t *task);
+
+/* choose which process to run next, must be called with interrupts disabled */
+void schedule(void);
 
 #endif /* INCLUDE_KERNEL_TASK_SCHEDULER_H_ */
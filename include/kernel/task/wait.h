@@ -0,0 +1,25 @@
+/*
+ * wait.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_TASK_WAIT_H_
+#define INCLUDE_KERNEL_TASK_WAIT_H_
+
+#include "kernel/compiler/freestanding.h"
+#include "kernel/task/scheduler.h"
+
+typedef struct {
+    /* tasks sleeping on this queue, chained through wait_next */
+    task_struct_t *tasks;
+} wait_queue_head_t;
+
+/* put the current task to sleep until the queue is woken up, returns once it is running again */
+void wait_queue_sleep(wait_queue_head_t *wq);
+
+/* make every task sleeping on the queue runnable again */
+void wait_queue_wake_all(wait_queue_head_t *wq);
+
+#endif /* INCLUDE_KERNEL_TASK_WAIT_H_ */
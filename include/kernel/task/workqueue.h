@@ -0,0 +1,32 @@
+/*
+ * workqueue.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_KERNEL_TASK_WORKQUEUE_H_
+#define INCLUDE_KERNEL_TASK_WORKQUEUE_H_
+
+#include "kernel/compiler/freestanding.h"
+
+typedef struct work_struct {
+    struct work_struct *next;
+    /* already queued, scheduling it again is a no-op */
+    bool pending;
+    void (*func)(struct work_struct *work);
+} work_struct_t;
+
+#define DECLARE_WORK(name, fn) \
+    work_struct_t name = { .next = NULL, .pending = false, .func = fn }
+
+/* starts the worker kernel thread, the scheduler must be initialised already */
+void workqueue_init(void);
+
+/* whether there is a worker to run the work yet */
+bool workqueue_ready(void);
+
+/* safe to call from any context, returns false if the work was already queued */
+bool schedule_work(work_struct_t *work);
+
+#endif /* INCLUDE_KERNEL_TASK_WORKQUEUE_H_ */
@@ -13,5 +13,6 @@
 void vga_console_init();
 void clear_console();
 void write_console(const char* buf, size_t buf_size);
+void echo_console(const char* buf, size_t length);
 
 #endif /* _KERNEL_LIB_DISPLAY_CONSOLE_H */
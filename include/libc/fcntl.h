@@ -0,0 +1,19 @@
+/*
+ * fcntl.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_LIBC_FCNTL_H_
+#define INCLUDE_LIBC_FCNTL_H_
+
+/* open flags (same numbering as Linux) */
+#define O_RDONLY    00
+#define O_WRONLY    01
+#define O_RDWR      02
+#define O_ACCMODE   03
+#define O_CREAT     0100
+#define O_APPEND    02000
+
+#endif /* INCLUDE_LIBC_FCNTL_H_ */
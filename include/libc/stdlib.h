@@ -18,5 +18,11 @@ char* ltoa(long value, char *str, int radix);
 
 int abs(int value);
 
+/* heap, see stdlib/malloc.c */
+void* malloc(size_t size);
+void free(void *ptr);
+void* calloc(size_t nmemb, size_t size);
+void* realloc(void *ptr, size_t size);
+
 
 #endif /* INCLUDE_LIBC_STDLIB_H_ */
@@ -0,0 +1,33 @@
+/*
+ * errno.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_LIBC_SYS_ERRNO_H_
+#define INCLUDE_LIBC_SYS_ERRNO_H_
+
+/* syscalls return the negated value of these (same numbering as Linux) */
+#define ENOENT      2       /* No such file or directory */
+#define EIO         5       /* I/O error */
+#define EBADF       9       /* Bad file number */
+#define ECHILD      10      /* No child processes */
+#define EAGAIN      11      /* Try again */
+#define ENOMEM      12      /* Out of memory */
+#define EACCES      13      /* Permission denied */
+#define EFAULT      14      /* Bad address */
+#define EEXIST      17      /* File exists */
+#define ENODEV      19      /* No such device */
+#define ENOTDIR     20      /* Not a directory */
+#define EISDIR      21      /* Is a directory */
+#define EINVAL      22      /* Invalid argument */
+#define ENFILE      23      /* File table overflow */
+#define EMFILE      24      /* Too many open files */
+#define EFBIG       27      /* File too large */
+#define ENOSPC      28      /* No space left on device */
+#define ESPIPE      29      /* Illegal seek */
+#define EROFS       30      /* Read-only file system */
+#define ENAMETOOLONG 36     /* File name too long */
+
+#endif /* INCLUDE_LIBC_SYS_ERRNO_H_ */
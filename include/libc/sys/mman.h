@@ -0,0 +1,32 @@
+/*
+ * mman.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_LIBC_SYS_MMAN_H_
+#define INCLUDE_LIBC_SYS_MMAN_H_
+
+#include "libc/compiler/freestanding.h"
+
+/* protection (same numbering as Linux) */
+#define PROT_NONE       0x0
+#define PROT_READ       0x1
+#define PROT_WRITE      0x2
+#define PROT_EXEC       0x4
+
+/* flags, exactly one of MAP_SHARED and MAP_PRIVATE */
+#define MAP_SHARED      0x01
+#define MAP_PRIVATE     0x02
+#define MAP_FIXED       0x10
+#define MAP_ANONYMOUS   0x20
+
+/* what mmap returns when it fails, there is no errno to tell why */
+#define MAP_FAILED      ((void*) -1)
+
+void* mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+int munmap(void *addr, size_t length);
+int mprotect(void *addr, size_t length, int prot);
+
+#endif /* INCLUDE_LIBC_SYS_MMAN_H_ */
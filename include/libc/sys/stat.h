@@ -0,0 +1,38 @@
+/*
+ * stat.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_LIBC_SYS_STAT_H_
+#define INCLUDE_LIBC_SYS_STAT_H_
+
+#include "libc/compiler/freestanding.h"
+
+#define S_IFMT      0170000
+#define S_IFDIR     0040000
+#define S_IFCHR     0020000
+#define S_IFREG     0100000
+#define S_IFLNK     0120000
+
+#define S_ISDIR(m)  (((m) & S_IFMT) == S_IFDIR)
+#define S_ISCHR(m)  (((m) & S_IFMT) == S_IFCHR)
+#define S_ISREG(m)  (((m) & S_IFMT) == S_IFREG)
+#define S_ISLNK(m)  (((m) & S_IFMT) == S_IFLNK)
+
+/* same layout as the kernel's (kernel/sys/stat.h) */
+struct stat {
+    uint64_t st_dev;
+    uint64_t st_ino;
+    uint32_t st_mode;
+    uint32_t st_nlink;
+    uint64_t st_size;
+    uint64_t st_blksize;
+    uint64_t st_blocks;
+};
+
+int stat(const char *path, struct stat *st);
+int fstat(int fd, struct stat *st);
+
+#endif /* INCLUDE_LIBC_SYS_STAT_H_ */
@@ -11,8 +11,27 @@
 #include "libc/compiler/freestanding.h"
 #include "libc/sys/types.h"
 
-long write(const char* string, size_t length);
+#define STDIN_FILENO    0
+#define STDOUT_FILENO   1
+#define STDERR_FILENO   2
+
+#define SEEK_SET        0
+#define SEEK_CUR        1
+#define SEEK_END        2
+
+long read(int fd, char* buf, size_t length);
+long write(int fd, const char* buf, size_t length);
+int open(const char *path, int flags);
+int close(int fd);
+long lseek(int fd, long offset, int whence);
 pid_t getpid(void);
 time_t time(void);
+void exit(int code);
+pid_t wait(int *status);
+pid_t waitpid(pid_t pid, int *status);
+
+/* heap right after the program, both fail with -1 (sbrk returns the old break otherwise) */
+int brk(void *addr);
+void* sbrk(intptr_t increment);
 
 #endif /* INCLUDE_LIBC_UNISTD_H_ */
@@ -0,0 +1,14 @@
+/*
+ * bench.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#ifndef INCLUDE_USER_BENCH_H_
+#define INCLUDE_USER_BENCH_H_
+
+/* malloc/free/realloc on the fast path, in batches and for direct mappings, results go to stdout */
+void bench_malloc(void);
+
+#endif /* INCLUDE_USER_BENCH_H_ */
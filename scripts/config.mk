@@ -11,6 +11,7 @@ DIR_INCLUDE	:= $(DIR_ROOT)/include
 # Key files
 #--------------------
 OUTPUT_RAW_DISK := $(DIR_BUILD)/disk.img
+OUTPUT_DATA_DISK := $(DIR_BUILD)/data.img
 
 #-------------------
 # Tool configuration
@@ -26,6 +27,11 @@ CCFLAGS     := -std=gnu99 -I$(DIR_INCLUDE) -Qn -g \
                -ffreestanding -fno-asynchronous-unwind-tables \
                -Wall -Wextra -Wpedantic -mcmodel=large -fno-builtin
 
+# Notes:
+# 	- the kernel must never touch x87/SSE/AVX registers, those belong to user
+# 	  tasks and are only saved/restored lazily (see kernel/arch/fpu.c)
+KERNEL_CCFLAGS := $(CCFLAGS) -mgeneral-regs-only
+
 AS          := nasm
 
 ASFLAGS     := -f bin
@@ -0,0 +1,81 @@
+#!/bin/bash -e
+
+#----------------------------------------------------------------------------
+# Builds the initramfs (cpio "newc" archive) that the boot loader loads and
+# the kernel mounts as its root filesystem.
+#
+# usage: mkinitramfs.sh <output> <path in archive>=<file> | <directory>/ ...
+#
+# The contents of every file start on a page boundary (names are padded with
+# extra nuls, like gen_init_cpio -a does), which is what lets the kernel map
+# programs straight out of the archive rather than copying them first.
+# It's all done with printf as cpio isn't necessarily in the build image.
+#----------------------------------------------------------------------------
+
+PAGE_SIZE=4096
+
+output=$1
+shift
+
+offset=0
+ino=1
+declare -A dirs
+
+# pad the archive with zeros up to the next multiple of $1
+pad_to() {
+    local padding=$(( (($1 - offset % $1)) % $1 ))
+    if (( padding > 0 )); then
+        head -c $padding /dev/zero >> "$output"
+        offset=$(( offset + padding ))
+    fi
+}
+
+# entry <name> <mode> <size> <namesize>
+entry() {
+    printf "070701%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X" \
+        $ino $2 0 0 1 0 $3 0 0 0 0 $4 0 >> "$output"
+    printf "%s" "$1" >> "$output"
+    head -c $(( $4 - ${#1} )) /dev/zero >> "$output"
+    offset=$(( offset + 110 + $4 ))
+    ino=$(( ino + 1 ))
+    pad_to 4
+}
+
+directory() {
+    [[ -n "${dirs[$1]}" ]] && return
+    dirs[$1]=1
+    entry "$1" $(( 0040755 )) 0 $(( ${#1} + 1 ))
+}
+
+rm -f "$output"
+touch "$output"
+
+for spec in "$@"; do
+    name=${spec%%=*}
+    file=${spec#*=}
+
+    # parent directories first (or the directory itself, for an empty one)
+    parent=$(dirname "$name")
+    [[ "$spec" == */ ]] && parent=${spec%/}
+    path=""
+    for component in ${parent//\// }; do
+        [[ "$component" == "." ]] && continue
+        path=${path:+$path/}$component
+        directory "$path"
+    done
+
+    [[ "$spec" == */ ]] && continue
+    size=$(stat -c%s "$file")
+
+    # stretch the name so that the data that follows lands on a page boundary
+    namesize=$(( ${#name} + 1 ))
+    end=$(( offset + 110 + namesize ))
+    namesize=$(( namesize + (PAGE_SIZE - end % PAGE_SIZE) % PAGE_SIZE ))
+
+    entry "$name" $(( 0100755 )) $size $namesize
+    cat "$file" >> "$output"
+    offset=$(( offset + size ))
+    pad_to 4
+done
+
+entry "TRAILER!!!" 0 0 11
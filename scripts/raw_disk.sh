@@ -7,27 +7,39 @@
 # check if kernel size is bigger then the number of blocks allocated 
 # I will have to use this until I either implement a HD driver and implement a filesystem
 kernel_size=$(stat -c%s /code/build/kernel/kernel)
-if (( kernel_size > 77824 )); then
+if (( kernel_size > 196608 )); then
     echo "[ERROR] :: raw_disk.sh :: Kernel excceded the blocks allocated. Exiting..."
     exit 1
 fi
 
-# check if user progrm size is bigger then the number of blocks allocated 
-# I will have to use this until I either implement a HD driver and implement a filesystem
-user_size=$(stat -c%s /code/build/user/user)
-if (( user_size > 10240 )); then
-    echo "[ERROR] :: raw_disk.sh :: User program excceded the blocks allocated. Exiting..."
+# user programs (and anything else the root fs needs) are shipped in the initramfs.
+# Adding another one is a matter of appending "<path>=<file>" here
+$(dirname "$0")/mkinitramfs.sh /code/build/initramfs.cpio \
+    dev/ \
+    mnt/ \
+    bin/init=/code/build/user/user
+
+# check if the initramfs is bigger then the number of blocks allocated (Initramfs.File.NumberOfBlocks)
+initramfs_size=$(stat -c%s /code/build/initramfs.cpio)
+if (( initramfs_size > 126976 )); then
+    echo "[ERROR] :: raw_disk.sh :: Initramfs excceded the blocks allocated. Exiting..."
     exit 1
 fi
 
 rm -f /code/build/disk.img
 dd if=/code/build/boot/mbr.bin of=/code/build/disk.img bs=512 count=1 conv=notrunc
 dd if=/code/build/boot/loader.bin of=/code/build/disk.img bs=512 count=5 seek=1 conv=notrunc
-dd if=/code/build/kernel/kernel of=/code/build/disk.img bs=512 count=152 seek=6 conv=notrunc
-dd if=/code/build/user/user of=/code/build/disk.img bs=512 count=20 seek=158 conv=notrunc
+dd if=/code/build/kernel/kernel of=/code/build/disk.img bs=512 count=384 seek=6 conv=notrunc
+dd if=/code/build/initramfs.cpio of=/code/build/disk.img bs=512 count=248 seek=390 conv=notrunc
 
 # this addresses a bug in the qemu that fails to read data out of the disk.img
 # if that terminates prematurely. In a real computer, this wouldn't be likely to
 # happen as (assuming that the usb stick used has a bigger capacity then the file copied),
 # BIOS would read garbage from whatever happens to be on the subsequent blocks.
-truncate -s $(expr 512 \* 178) /code/build/disk.img
+truncate -s $(expr 512 \* 638) /code/build/disk.img
+
+# data disk (virtio, mounted on /mnt): a plain ext2 file system, anything under /code/build/data ends up in it
+mkdir -p /code/build/data/bin
+cp /code/build/user/user /code/build/data/bin/user
+rm -f /code/build/data.img
+mke2fs -q -F -t ext2 -b 1024 -O dir_index -d /code/build/data /code/build/data.img 16M
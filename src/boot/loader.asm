@@ -76,8 +76,8 @@ boot:
   ; read kernel from disk and move it to memory
   call read_kernel_from_disk
 
-  ; read user prog from disk and move it to memory
-  call read_userprog_from_disk
+  ; read the initramfs (programs and whatever else the root fs has) from disk
+  call read_initramfs_from_disk
 
   ; Check whether we are running on a 64-bit processor
   call cpu_supports_64_bit_mode
@@ -0,0 +1,125 @@
+/*
+ * acpi.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/arch/acpi.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/mm/ioremap.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * I only need ACPI to find out how interrupts are wired (MADT) for now, so there is no AML interpreter or anything
+ * fancy here. The RSDP lives either in the first KB of the EBDA or in the BIOS ROM area (0xe0000 - 0xfffff) on a 16
+ * byte boundary (ACPI spec 5.2.5.1). Both are below the kernel, so they're mapped already.
+ */
+
+#define ACPI_RSDP_SIGNATURE     "RSD PTR "
+#define ACPI_EBDA_PTR_ADDR      0x40e
+#define ACPI_BIOS_ROM_START     0xe0000
+#define ACPI_BIOS_ROM_LENGTH    0x20000
+
+typedef struct {
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_addr;
+
+    /* ACPI 2.0+ */
+    uint32_t length;
+    uint64_t xsdt_addr;
+    uint8_t ext_checksum;
+    uint8_t reserved[3];
+} __packed acpi_rsdp_t;
+
+/* size of the ACPI 1.0 part of the RSDP, covered by 'checksum' */
+#define ACPI_RSDP_V1_LENGTH     20
+
+/* RSDT (32-bit entries) or XSDT (64-bit entries) */
+static const acpi_sdt_header_t *root_table;
+static bool xsdt;
+
+static bool checksum_ok(const void *ptr, size_t length) {
+    const uint8_t *bytes = ptr;
+    uint8_t sum = 0;
+
+    for (size_t i = 0; i < length; i++)
+        sum += bytes[i];
+
+    return sum == 0;
+}
+
+static const acpi_rsdp_t* scan_rsdp(uint64_t phys_addr, uint64_t length) {
+    for (uint64_t addr = phys_addr; addr < phys_addr + length; addr += 16) {
+        const acpi_rsdp_t *rsdp = (const acpi_rsdp_t*) va(addr);
+
+        if (memcmp(rsdp->signature, ACPI_RSDP_SIGNATURE, sizeof(rsdp->signature)) == 0
+                && checksum_ok(rsdp, ACPI_RSDP_V1_LENGTH))
+            return rsdp;
+    }
+
+    return NULL;
+}
+
+static const acpi_sdt_header_t* map_table(uint64_t phys_addr) {
+    /* we don't know how big it is until the header is mapped */
+    const acpi_sdt_header_t *header = memremap(phys_addr, sizeof(acpi_sdt_header_t));
+    header = memremap(phys_addr, header->length);
+
+    if (!checksum_ok(header, header->length)) {
+        printk_error("ACPI: table at 0x%llx has a bad checksum", phys_addr);
+        return NULL;
+    }
+
+    return header;
+}
+
+bool acpi_init(void) {
+    uint64_t ebda = (uint64_t) (*(uint16_t*) va(ACPI_EBDA_PTR_ADDR)) << 4;
+
+    const acpi_rsdp_t *rsdp = scan_rsdp(ebda, 1024);
+    if (rsdp == NULL)
+        rsdp = scan_rsdp(ACPI_BIOS_ROM_START, ACPI_BIOS_ROM_LENGTH);
+
+    if (rsdp == NULL) {
+        printk_info("ACPI: RSDP not found");
+        return false;
+    }
+
+    /* prefer the XSDT whenever the firmware is ACPI 2.0+ */
+    xsdt = rsdp->revision >= 2 && rsdp->xsdt_addr != 0 && checksum_ok(rsdp, rsdp->length);
+    root_table = map_table(xsdt ? rsdp->xsdt_addr : rsdp->rsdt_addr);
+
+    if (root_table == NULL)
+        return false;
+
+    printk_info("ACPI: revision %u, %s at 0x%llx", rsdp->revision, xsdt ? "XSDT" : "RSDT", pa((uint64_t) root_table));
+    return true;
+}
+
+const acpi_sdt_header_t* acpi_find_table(const char *signature) {
+    if (root_table == NULL)
+        return NULL;
+
+    size_t entry_size = xsdt ? sizeof(uint64_t) : sizeof(uint32_t);
+    size_t entries = (root_table->length - sizeof(acpi_sdt_header_t)) / entry_size;
+    const uint8_t *entry = (const uint8_t*) (root_table + 1);
+
+    for (size_t i = 0; i < entries; i++, entry += entry_size) {
+        /* entries aren't necessarily aligned */
+        uint64_t phys_addr = 0;
+        memcpy(&phys_addr, entry, entry_size);
+
+        const acpi_sdt_header_t *header = memremap(phys_addr, sizeof(acpi_sdt_header_t));
+        if (memcmp(header->signature, signature, sizeof(header->signature)) == 0)
+            return map_table(phys_addr);
+    }
+
+    return NULL;
+}
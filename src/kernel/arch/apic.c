@@ -0,0 +1,283 @@
+/*
+ * apic.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/arch/apic.h"
+#include "kernel/arch/ioapic.h"
+#include "kernel/arch/acpi.h"
+#include "kernel/arch/msr.h"
+#include "kernel/asm/generic.h"
+#include "kernel/interrupt/idt.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/mm/ioremap.h"
+#include "kernel/mm/init.h"
+#include "kernel/lib/bit.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * Intel SDM Vol 3 - Chapter 10 (APIC). In xAPIC mode the local APIC registers are MMIO (0xfee00000 by default), in
+ * x2APIC mode the very same registers become MSRs at 0x800 + (offset >> 4). The main win for me is EOI: one wrmsr
+ * instead of an uncached store that has to go all the way out to the APIC page, and no page table entry for it.
+ *
+ * The MADT ("APIC" table) tells me where the local APIC and the IO-APICs are, which CPUs exist and how ISA IRQs are
+ * wired to the IO-APIC pins. I don't boot the other CPUs (yet), they are recorded so IRQ affinity has something to
+ * talk about.
+ */
+
+#define MSR_IA32_APIC_BASE_EXTD     (1ULL << 10)
+#define MSR_IA32_APIC_BASE_EN       (1ULL << 11)
+#define MSR_IA32_APIC_BASE_ADDR     0xffffff000ULL
+
+#define CPUID_01_ECX_X2APIC         21
+
+#define X2APIC_MSR_BASE             0x800
+
+#define LAPIC_REG_ID                0x020
+#define LAPIC_REG_TPR               0x080
+#define LAPIC_REG_EOI               0x0b0
+#define LAPIC_REG_SVR               0x0f0
+#define LAPIC_REG_ICR_LOW           0x300
+#define LAPIC_REG_ICR_HIGH          0x310
+#define LAPIC_REG_LVT_LINT0         0x350
+
+#define LAPIC_SVR_ENABLE            (1U << 8)
+#define LAPIC_LVT_MASKED            (1U << 16)
+#define LAPIC_ICR_SEND_PENDING      (1U << 12)
+
+/* MADT - ACPI spec 5.2.12 */
+#define MADT_TYPE_LAPIC             0
+#define MADT_TYPE_IOAPIC            1
+#define MADT_TYPE_ISA_OVERRIDE      2
+#define MADT_TYPE_LAPIC_ADDR        5
+#define MADT_TYPE_X2APIC            9
+
+#define MADT_LAPIC_ENABLED          (1U << 0)
+#define MADT_LAPIC_ONLINE_CAPABLE   (1U << 1)
+
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t lapic_addr;
+    uint32_t flags;
+} __packed madt_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t length;
+    union {
+        struct {
+            uint8_t acpi_id;
+            uint8_t apic_id;
+            uint32_t flags;
+        } __packed lapic;
+        struct {
+            uint8_t id;
+            uint8_t reserved;
+            uint32_t addr;
+            uint32_t gsi_base;
+        } __packed ioapic;
+        struct {
+            uint8_t bus;
+            uint8_t source;
+            uint32_t gsi;
+            uint16_t flags;
+        } __packed isa_override;
+        struct {
+            uint16_t reserved;
+            uint64_t addr;
+        } __packed lapic_addr;
+        struct {
+            uint16_t reserved;
+            uint32_t apic_id;
+            uint32_t flags;
+            uint32_t acpi_uid;
+        } __packed x2apic;
+    } data;
+} __packed madt_entry_t;
+
+static bool x2apic;
+static bool lapic_on;
+static volatile uint32_t *lapic_base;
+
+static uint32_t cpu_apic_ids[APIC_MAX_CPUS];
+static uint32_t nr_cpus;
+
+static uint32_t lapic_read(uint32_t reg) {
+    if (x2apic)
+        return (uint32_t) rdmsr(X2APIC_MSR_BASE + (reg >> 4));
+    return lapic_base[reg / sizeof(uint32_t)];
+}
+
+static void lapic_write(uint32_t reg, uint32_t value) {
+    if (x2apic)
+        wrmsr(X2APIC_MSR_BASE + (reg >> 4), value);
+    else
+        lapic_base[reg / sizeof(uint32_t)] = value;
+}
+
+void lapic_eoi(void) {
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+uint32_t lapic_id(void) {
+    /* xAPIC keeps the 8-bit ID in the top byte, x2APIC uses the whole register */
+    uint32_t id = lapic_read(LAPIC_REG_ID);
+    return x2apic ? id : id >> 24;
+}
+
+void lapic_send_ipi(uint32_t apic_id, uint8_t vector) {
+    /* x2APIC has a single 64-bit ICR, writing it is what sends the IPI */
+    if (x2apic) {
+        wrmsr(X2APIC_MSR_BASE + (LAPIC_REG_ICR_LOW >> 4), ((uint64_t) apic_id << 32) | vector);
+        return;
+    }
+
+    /* xAPIC: destination first, the low half triggers the delivery */
+    lapic_write(LAPIC_REG_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, vector);
+
+    while (lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_SEND_PENDING)
+        cpu_relax();
+}
+
+uint32_t apic_nr_cpus(void) {
+    return nr_cpus;
+}
+
+uint32_t apic_cpu_apic_id(uint32_t cpu) {
+    return cpu < nr_cpus ? cpu_apic_ids[cpu] : UINT32_MAX;
+}
+
+bool apic_cpu_online(uint32_t cpu) {
+    /* only the boot CPU runs for now */
+    return cpu == 0 && nr_cpus > 0;
+}
+
+uint32_t apic_this_cpu(void) {
+    /* no APs yet, so it can't be anyone but the boot CPU */
+    return 0;
+}
+
+static void add_cpu(uint32_t apic_id, uint32_t flags) {
+    if (!(flags & (MADT_LAPIC_ENABLED | MADT_LAPIC_ONLINE_CAPABLE)))
+        return;
+
+    if (nr_cpus == APIC_MAX_CPUS) {
+        printk_error("APIC: ignoring CPU with APIC ID %u, too many of them", apic_id);
+        return;
+    }
+
+    cpu_apic_ids[nr_cpus++] = apic_id;
+}
+
+static uint64_t parse_madt(const madt_t *madt) {
+    uint64_t lapic_phys = madt->lapic_addr;
+
+    const uint8_t *ptr = (const uint8_t*) (madt + 1);
+    const uint8_t *end = (const uint8_t*) madt + madt->header.length;
+
+    while (ptr + 2 <= end) {
+        const madt_entry_t *entry = (const madt_entry_t*) ptr;
+
+        /* a broken entry would send us looping forever */
+        if (entry->length < 2)
+            break;
+
+        switch (entry->type) {
+        case MADT_TYPE_LAPIC:
+            add_cpu(entry->data.lapic.apic_id, entry->data.lapic.flags);
+            break;
+        case MADT_TYPE_X2APIC:
+            add_cpu(entry->data.x2apic.apic_id, entry->data.x2apic.flags);
+            break;
+        case MADT_TYPE_IOAPIC:
+            ioapic_add(entry->data.ioapic.addr, entry->data.ioapic.gsi_base);
+            break;
+        case MADT_TYPE_ISA_OVERRIDE:
+            ioapic_isa_override(entry->data.isa_override.source, entry->data.isa_override.gsi, entry->data.isa_override.flags);
+            break;
+        case MADT_TYPE_LAPIC_ADDR:
+            lapic_phys = entry->data.lapic_addr.addr;
+            break;
+        }
+
+        ptr += entry->length;
+    }
+
+    return lapic_phys;
+}
+
+static void apic_spurious_handler(interrupt_stack_frame_t *int_frame) {
+    /* nothing was put in service, so there must be no EOI either */
+    (void) int_frame;
+}
+
+static void lapic_enable(uint64_t lapic_phys) {
+    uint32_t eax = 0x1, ebx = 0, ecx = 0, edx = 0;
+    cpuid(&eax, &ebx, &ecx, &edx);
+
+    uint64_t apic_base = rdmsr(MSR_IA32_APIC_BASE);
+
+    /* the firmware leaves it on, but it costs nothing to be sure. EXTD can only be set once EN is */
+    if (!(apic_base & MSR_IA32_APIC_BASE_EN)) {
+        apic_base |= MSR_IA32_APIC_BASE_EN;
+        wrmsr(MSR_IA32_APIC_BASE, apic_base);
+    }
+
+    if (test_bit(CPUID_01_ECX_X2APIC, ecx)) {
+        wrmsr(MSR_IA32_APIC_BASE, apic_base | MSR_IA32_APIC_BASE_EXTD);
+        x2apic = true;
+    } else {
+        /* MSR is what the CPU actually uses if the MADT and the MSR disagree */
+        if ((apic_base & MSR_IA32_APIC_BASE_ADDR) != lapic_phys)
+            lapic_phys = apic_base & MSR_IA32_APIC_BASE_ADDR;
+        lapic_base = ioremap(lapic_phys, PAGE_SIZE);
+    }
+
+    register_exception_handler(APIC_SPURIOUS_VECTOR, apic_spurious_handler);
+
+    /* accept every priority class */
+    lapic_write(LAPIC_REG_TPR, 0);
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | APIC_SPURIOUS_VECTOR);
+    lapic_on = true;
+}
+
+bool lapic_enabled(void) {
+    return lapic_on;
+}
+
+bool apic_init(void) {
+    const madt_t *madt = (const madt_t*) acpi_find_table("APIC");
+    if (madt == NULL) {
+        printk_info("APIC: no MADT, sticking with the PIC");
+        return false;
+    }
+
+    uint64_t lapic_phys = parse_madt(madt);
+    lapic_enable(lapic_phys);
+
+    /* the boot CPU goes first so cpu 0 is always us */
+    uint32_t bsp = lapic_id();
+    for (uint32_t cpu = 1; cpu < nr_cpus; cpu++) {
+        if (cpu_apic_ids[cpu] == bsp) {
+            cpu_apic_ids[cpu] = cpu_apic_ids[0];
+            cpu_apic_ids[0] = bsp;
+        }
+    }
+    if (nr_cpus == 0)
+        cpu_apic_ids[nr_cpus++] = bsp;
+
+    printk_info("APIC: %s mode, boot APIC ID %u, %u CPU(s)", x2apic ? "x2APIC" : "xAPIC", bsp, nr_cpus);
+
+    if (!ioapic_init())
+        return false;
+
+    /* LINT0 carried the PIC (ExtINT) in virtual wire mode, it has nothing to say anymore */
+    lapic_write(LAPIC_REG_LVT_LINT0, LAPIC_LVT_MASKED);
+
+    return true;
+}
@@ -10,6 +10,7 @@
 #include "kernel/compiler/macro.h"
 #include "kernel/asm/generic.h"
 #include "kernel/arch/msr.h"
+#include "kernel/arch/fpu.h"
 #include "kernel/lib/bit.h"
 #include "kernel/lib/printk.h"
 
@@ -30,6 +31,33 @@ typedef struct cpu_version_info cpu_version_info;
 
 static cpu_version_info cpu_ver_info = { 0 };
 
+#define CR0_WP                      (1ULL << 16)
+#define EFER_NXE                    (1ULL << 11)
+#define CPUID_80000001_EDX_NX       20
+
+static bool nx_enabled = false;
+
+static void enable_memory_protection(void) {
+    /*
+     * WP: supervisor writes honour read-only pages too, otherwise the kernel would write straight through
+     * copy-on-write mappings (e.g. sys_read into a buffer that lives in .data)
+     */
+    write_cr0(read_cr0() | CR0_WP);
+
+    /* NX: data and stacks don't have to be executable */
+    uint32_t eax = 0x80000001, ebx = 0, ecx = 0, edx = 0;
+    cpuid(&eax, &ebx, &ecx, &edx);
+
+    if (test_bit(CPUID_80000001_EDX_NX, edx)) {
+        wrmsr(MSR_IA32_EFER, rdmsr(MSR_IA32_EFER) | EFER_NXE);
+        nx_enabled = true;
+    }
+}
+
+bool cpu_nx_enabled(void) {
+    return nx_enabled;
+}
+
 //TODO Notes for myself: you should fiddle with qemu cpu options. I'm still not convinced that you got this logic right
 void cpu_init() {
     /* CPUID.01H:EAX -> Returns Model, Family, Stepping Information */
@@ -61,6 +89,12 @@ void cpu_init() {
 
     // early intel cpu
     enable_intel_faststring();
+
+    /* x87/SSE/AVX for user space, switched lazily */
+    fpu_init();
+
+    /* write-protect and no-execute for the page tables */
+    enable_memory_protection();
 }
 
 void enable_intel_faststring() {
@@ -0,0 +1,203 @@
+/*
+ * fpu.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/arch/fpu.h"
+#include "kernel/asm/generic.h"
+#include "kernel/arch/gdt_segments.h"
+#include "kernel/interrupt/idt.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/task/exit.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/lib/bit.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Lazy FPU switching (Intel SDM Vol 3 - 13.6). The kernel is built with -mgeneral-regs-only, so only user tasks ever
+ * touch x87/SSE/AVX registers. Those registers are left alone on context switch, CR0.TS is set instead and the first
+ * FPU instruction of a task that doesn't own them raises #NM. Only then the owner's state is saved (XSAVEOPT skips
+ * components that weren't modified) and the task's state is loaded. Integer-only tasks never pay for any of this.
+ *
+ * If SMP ever happens, fpu_owner has to become per-CPU and a migrating task must have its state saved first.
+ */
+
+#define CR0_MP                      (1ULL << 1)
+#define CR0_EM                      (1ULL << 2)
+#define CR0_TS                      (1ULL << 3)
+
+#define CR4_OSFXSR                  (1ULL << 9)
+#define CR4_OSXMMEXCPT              (1ULL << 10)
+#define CR4_OSXSAVE                 (1ULL << 18)
+
+#define CPUID_01_EDX_FXSR           24
+#define CPUID_01_ECX_XSAVE          26
+#define CPUID_01_ECX_AVX            28
+#define CPUID_0D_1_EAX_XSAVEOPT     0
+
+#define XCR0_X87                    (1ULL << 0)
+#define XCR0_SSE                    (1ULL << 1)
+#define XCR0_AVX                    (1ULL << 2)
+
+#define FPU_NM_VECTOR               7
+
+/* legacy region layout, shared by FXSAVE and XSAVE */
+#define FXSAVE_AREA_SIZE            512
+#define FXSAVE_FCW_OFFSET           0
+#define FXSAVE_MXCSR_OFFSET         24
+#define FPU_FCW_DEFAULT             0x037f
+#define FPU_MXCSR_DEFAULT           0x1f80
+
+static bool use_xsave;
+static bool use_xsaveopt;
+static uint64_t xfeatures;
+static uint32_t state_size = FXSAVE_AREA_SIZE;
+
+/* task whose state is currently loaded in the FPU registers */
+static task_struct_t *fpu_owner;
+
+static bool ts_armed;
+
+static void xsetbv(uint32_t index, uint64_t value) {
+    asm volatile ("xsetbv" :: "c" (index), "a" ((uint32_t) value), "d" ((uint32_t) (value >> 32)) : "memory");
+}
+
+static void clts(void) {
+    asm volatile ("clts" ::: "memory");
+}
+
+static void fpu_save(void *area) {
+    uint32_t lo = (uint32_t) xfeatures, hi = (uint32_t) (xfeatures >> 32);
+
+    if (use_xsaveopt)
+        asm volatile ("xsaveopt64 [%0]" :: "r" (area), "a" (lo), "d" (hi) : "memory");
+    else if (use_xsave)
+        asm volatile ("xsave64 [%0]" :: "r" (area), "a" (lo), "d" (hi) : "memory");
+    else
+        asm volatile ("fxsave64 [%0]" :: "r" (area) : "memory");
+}
+
+static void fpu_restore(void *area) {
+    uint32_t lo = (uint32_t) xfeatures, hi = (uint32_t) (xfeatures >> 32);
+
+    if (use_xsave)
+        asm volatile ("xrstor64 [%0]" :: "r" (area), "a" (lo), "d" (hi) : "memory");
+    else
+        asm volatile ("fxrstor64 [%0]" :: "r" (area) : "memory");
+}
+
+static void* fpu_alloc_state(void) {
+    /* buddy blocks are naturally aligned, which covers the 64-byte alignment XSAVE wants */
+    uint8_t *area = kmalloc(state_size, KMEM_DEFAULT | KMEM_ZERO);
+    if (area == NULL)
+        return NULL;
+
+    /*
+     * a zeroed XSAVE header puts every component in its init state, but FCW/MXCSR come from the legacy region
+     * regardless, so they need the power-on defaults (all exceptions masked)
+     */
+    *(uint16_t*) (area + FXSAVE_FCW_OFFSET) = FPU_FCW_DEFAULT;
+    *(uint32_t*) (area + FXSAVE_MXCSR_OFFSET) = FPU_MXCSR_DEFAULT;
+
+    return area;
+}
+
+static void fpu_nm_handler(interrupt_stack_frame_t *int_frame) {
+    /* sanity check - the kernel is compiled not to use the FPU */
+    BUG_ON((int_frame->cs & ~3ULL) == GDT64_SEGMENT_SELECTOR_KERNEL_CODE);
+
+    task_struct_t *curr = this_rq()->curr;
+
+    /* first FPU instruction of the task, without a place to keep its state it can't go on (TS is still armed) */
+    if (fpu_owner != curr && curr->fpu_state == NULL) {
+        curr->fpu_state = fpu_alloc_state();
+        if (curr->fpu_state == NULL) {
+            printk_error("pid %d: out of memory for the FPU state", curr->pid);
+            do_exit(-ENOMEM);
+        }
+    }
+
+    clts();
+    ts_armed = false;
+
+    if (fpu_owner == curr)
+        return;
+
+    if (fpu_owner != NULL)
+        fpu_save(fpu_owner->fpu_state);
+
+    fpu_restore(curr->fpu_state);
+    fpu_owner = curr;
+}
+
+void fpu_switch(task_struct_t *next) {
+    bool arm = next != fpu_owner;
+
+    /* writing CR0 is serialising, only do it when TS has to change */
+    if (arm == ts_armed)
+        return;
+
+    uint64_t cr0 = read_cr0();
+    write_cr0(arm ? cr0 | CR0_TS : cr0 & ~CR0_TS);
+    ts_armed = arm;
+}
+
+void fpu_release(task_struct_t *task) {
+    if (fpu_owner == task)
+        fpu_owner = NULL;
+
+    if (task->fpu_state != NULL) {
+        kfree(task->fpu_state);
+        task->fpu_state = NULL;
+    }
+}
+
+void fpu_init(void) {
+    uint32_t eax = 0x1, ebx = 0, ecx = 0, edx = 0;
+    cpuid(&eax, &ebx, &ecx, &edx);
+
+    /* every x86-64 CPU has FXSR, but being wrong about it here would be rather confusing later on */
+    BUG_ON(!test_bit(CPUID_01_EDX_FXSR, edx));
+
+    bool has_avx = test_bit(CPUID_01_ECX_AVX, ecx);
+    use_xsave = test_bit(CPUID_01_ECX_XSAVE, ecx);
+
+    /* native x87 error reporting off the table, WAIT/FWAIT honour TS and the first FPU use traps */
+    uint64_t cr0 = read_cr0();
+    cr0 &= ~CR0_EM;
+    cr0 |= CR0_MP | CR0_TS;
+    write_cr0(cr0);
+    ts_armed = true;
+
+    uint64_t cr4 = read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT;
+    if (use_xsave)
+        cr4 |= CR4_OSXSAVE;
+    write_cr4(cr4);
+
+    if (use_xsave) {
+        xfeatures = XCR0_X87 | XCR0_SSE;
+        if (has_avx)
+            xfeatures |= XCR0_AVX;
+        xsetbv(0, xfeatures);
+
+        /* CPUID.(EAX=0DH,ECX=0):EBX -> size of the XSAVE area for what is enabled in XCR0 */
+        eax = 0xd, ecx = 0;
+        cpuid(&eax, &ebx, &ecx, &edx);
+        state_size = ebx;
+
+        eax = 0xd, ecx = 1;
+        cpuid(&eax, &ebx, &ecx, &edx);
+        use_xsaveopt = test_bit(CPUID_0D_1_EAX_XSAVEOPT, eax);
+    }
+
+    register_exception_handler(FPU_NM_VECTOR, fpu_nm_handler);
+
+    printk_info("FPU: %s, state size %u bytes%s", use_xsaveopt ? "XSAVEOPT" : (use_xsave ? "XSAVE" : "FXSAVE"),
+            state_size, has_avx && use_xsave ? ", AVX enabled" : "");
+}
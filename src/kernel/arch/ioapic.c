@@ -0,0 +1,193 @@
+/*
+ * ioapic.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/arch/ioapic.h"
+#include "kernel/arch/apic.h"
+#include "kernel/arch/pic.h"
+#include "kernel/interrupt/irq.h"
+#include "kernel/mm/ioremap.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * IO-APIC datasheet (82093AA): registers are reached indirectly, write the register index into IOREGSEL and then
+ * read/write IOWIN. Each pin has a 64-bit redirection entry: vector, polarity, trigger mode, mask and destination
+ * APIC ID (bits 56-63).
+ *
+ * ISA IRQs are identity mapped to GSIs unless the MADT says otherwise (QEMU/most PCs wire the PIT to GSI 2). I keep
+ * the vector as IRQ_VECTOR_BASE + isa_irq, so interrupt_handler and the drivers don't notice the switch.
+ */
+
+#define IOAPIC_MAX              4
+
+#define IOAPIC_IOREGSEL         0x00
+#define IOAPIC_IOWIN            0x10
+
+#define IOAPIC_REG_VER          0x01
+#define IOAPIC_REG_REDTBL(pin)  (0x10 + 2 * (pin))
+
+#define IOAPIC_RTE_ACTIVE_LOW   (1U << 13)
+#define IOAPIC_RTE_LEVEL        (1U << 15)
+#define IOAPIC_RTE_MASKED       (1U << 16)
+#define IOAPIC_RTE_DEST_SHIFT   24      /* within the high dword */
+
+typedef struct {
+    volatile uint32_t *base;
+    uint32_t gsi_base;
+    uint32_t nr_pins;
+} ioapic_t;
+
+static ioapic_t ioapics[IOAPIC_MAX];
+static size_t nr_ioapics;
+
+/* routing of each ISA IRQ, identity unless overridden by the MADT */
+static uint32_t isa_gsi[NR_IRQS];
+static uint32_t isa_rte_flags[NR_IRQS];
+static bool isa_overridden[NR_IRQS];
+
+static uint32_t ioapic_read(ioapic_t *ioapic, uint8_t reg) {
+    ioapic->base[IOAPIC_IOREGSEL / sizeof(uint32_t)] = reg;
+    return ioapic->base[IOAPIC_IOWIN / sizeof(uint32_t)];
+}
+
+static void ioapic_write(ioapic_t *ioapic, uint8_t reg, uint32_t value) {
+    ioapic->base[IOAPIC_IOREGSEL / sizeof(uint32_t)] = reg;
+    ioapic->base[IOAPIC_IOWIN / sizeof(uint32_t)] = value;
+}
+
+static ioapic_t* gsi_to_ioapic(uint32_t gsi, uint32_t *pin) {
+    for (size_t i = 0; i < nr_ioapics; i++) {
+        if (gsi >= ioapics[i].gsi_base && gsi < ioapics[i].gsi_base + ioapics[i].nr_pins) {
+            *pin = gsi - ioapics[i].gsi_base;
+            return &ioapics[i];
+        }
+    }
+    return NULL;
+}
+
+void ioapic_add(uint64_t phys_addr, uint32_t gsi_base) {
+    if (nr_ioapics == IOAPIC_MAX) {
+        printk_error("IOAPIC: ignoring IO-APIC at 0x%llx, too many of them", phys_addr);
+        return;
+    }
+
+    ioapic_t *ioapic = &ioapics[nr_ioapics++];
+    ioapic->base = ioremap(phys_addr, IOAPIC_IOWIN + sizeof(uint32_t));
+    ioapic->gsi_base = gsi_base;
+    /* bits 16-23 hold the index of the last redirection entry */
+    ioapic->nr_pins = ((ioapic_read(ioapic, IOAPIC_REG_VER) >> 16) & 0xff) + 1;
+
+    printk_info("IOAPIC: at 0x%llx GSIs %u-%u", phys_addr, gsi_base, gsi_base + ioapic->nr_pins - 1);
+}
+
+void ioapic_isa_override(uint8_t isa_irq, uint32_t gsi, uint16_t flags) {
+    if (isa_irq >= NR_IRQS)
+        return;
+
+    isa_gsi[isa_irq] = gsi;
+    isa_overridden[isa_irq] = true;
+
+    /* "conforms to bus" means active high + edge for ISA, which is what a zeroed entry is */
+    uint32_t rte_flags = 0;
+    if ((flags & IOAPIC_MPS_POLARITY_MASK) == IOAPIC_MPS_POLARITY_LOW)
+        rte_flags |= IOAPIC_RTE_ACTIVE_LOW;
+    if ((flags & IOAPIC_MPS_TRIGGER_MASK) == IOAPIC_MPS_TRIGGER_LEVEL)
+        rte_flags |= IOAPIC_RTE_LEVEL;
+    isa_rte_flags[isa_irq] = rte_flags;
+}
+
+static void ioapic_mask_irq(uint8_t isa_irq) {
+    uint32_t pin;
+    ioapic_t *ioapic = gsi_to_ioapic(isa_gsi[isa_irq], &pin);
+    if (ioapic == NULL)
+        return;
+
+    uint32_t low = ioapic_read(ioapic, IOAPIC_REG_REDTBL(pin));
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin), low | IOAPIC_RTE_MASKED);
+}
+
+static void ioapic_unmask_irq(uint8_t isa_irq) {
+    uint32_t pin;
+    ioapic_t *ioapic = gsi_to_ioapic(isa_gsi[isa_irq], &pin);
+    if (ioapic == NULL) {
+        printk_error("IOAPIC: ISA IRQ %u isn't wired to any pin", isa_irq);
+        return;
+    }
+
+    uint32_t low = ioapic_read(ioapic, IOAPIC_REG_REDTBL(pin));
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin), low & ~IOAPIC_RTE_MASKED);
+}
+
+static void ioapic_eoi(uint8_t isa_irq) {
+    /* the local APIC broadcasts the EOI to the IO-APIC for level triggered entries */
+    (void) isa_irq;
+    lapic_eoi();
+}
+
+static void ioapic_set_affinity(uint8_t isa_irq, uint32_t cpu) {
+    uint32_t pin;
+    ioapic_t *ioapic = gsi_to_ioapic(isa_gsi[isa_irq], &pin);
+    if (ioapic == NULL)
+        return;
+
+    /* physical destination mode, the entry only has room for 8-bit APIC IDs */
+    ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin) + 1, apic_cpu_apic_id(cpu) << IOAPIC_RTE_DEST_SHIFT);
+}
+
+static const irq_chip_t ioapic_chip = {
+    .name = "IO-APIC",
+    .mask = ioapic_mask_irq,
+    .unmask = ioapic_unmask_irq,
+    .eoi = ioapic_eoi,
+    .set_affinity = ioapic_set_affinity,
+};
+
+bool ioapic_init(void) {
+    if (nr_ioapics == 0)
+        return false;
+
+    /* make sure nothing fires through a pin we don't know about */
+    for (size_t i = 0; i < nr_ioapics; i++) {
+        for (uint32_t pin = 0; pin < ioapics[i].nr_pins; pin++)
+            ioapic_write(&ioapics[i], IOAPIC_REG_REDTBL(pin), IOAPIC_RTE_MASKED);
+    }
+
+    for (uint8_t isa_irq = 0; isa_irq < NR_IRQS; isa_irq++) {
+        if (!isa_overridden[isa_irq])
+            isa_gsi[isa_irq] = isa_irq;
+
+        /* the pin was handed to another ISA IRQ (e.g. GSI 2 is the PIT, not the cascade) */
+        for (uint8_t other = 0; other < NR_IRQS && !isa_overridden[isa_irq]; other++) {
+            if (other != isa_irq && isa_overridden[other] && isa_gsi[other] == isa_irq)
+                isa_gsi[isa_irq] = UINT32_MAX;
+        }
+
+        uint32_t pin;
+        ioapic_t *ioapic = gsi_to_ioapic(isa_gsi[isa_irq], &pin);
+        if (ioapic == NULL)
+            continue;
+
+        /* everything goes to the boot CPU until someone asks otherwise */
+        ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin) + 1, lapic_id() << IOAPIC_RTE_DEST_SHIFT);
+        ioapic_write(ioapic, IOAPIC_REG_REDTBL(pin),
+                IOAPIC_RTE_MASKED | isa_rte_flags[isa_irq] | (IRQ_VECTOR_BASE + isa_irq));
+    }
+
+    /* without the timer there is no scheduling, better stick with the PIC */
+    uint32_t pin;
+    if (gsi_to_ioapic(isa_gsi[PIC_PROG_INT_TIMER_INTERRUPT], &pin) == NULL) {
+        printk_error("IOAPIC: timer isn't wired to any pin, keeping the PIC");
+        return false;
+    }
+
+    /* the PIC stays remapped and fully masked, it never gets a say again */
+    irq_set_chip(&ioapic_chip);
+    pic_disable_all_irq();
+
+    return true;
+}
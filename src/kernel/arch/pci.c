@@ -0,0 +1,191 @@
+/*
+ * pci.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/arch/pci.h"
+#include "kernel/arch/acpi.h"
+#include "kernel/mm/ioremap.h"
+#include "kernel/asm/generic.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * Two ways of reaching the configuration space:
+ *
+ *  - Configuration mechanism #1: the dword to access is selected through CONFIG_ADDRESS and then read/written
+ *    through CONFIG_DATA. That's two port accesses that must not be split by someone else doing the same, hence
+ *    interrupts are disabled around them. Only the first 256 bytes can be reached and narrower accesses are done
+ *    on the dword that contains them.
+ *
+ *  - ECAM (PCIe): the whole 4 KiB of every function is memory mapped, found through the ACPI MCFG table. A single
+ *    load/store of any width and no locking. A bus takes 1 MiB, so buses are only mapped once something on them
+ *    is accessed.
+ *
+ * Only PCI segment group 0 is handled.
+ */
+
+#define PCI_CONFIG_ADDRESS      0xcf8
+#define PCI_CONFIG_DATA         0xcfc
+
+#define PCI_CONFIG_ENABLE       (1U << 31)
+
+/* legacy mechanism's reach */
+#define PCI_CONFIG_LEGACY_SIZE  256
+
+#define ECAM_BUS_SHIFT          20
+#define ECAM_DEVICE_SHIFT       15
+#define ECAM_FUNCTION_SHIFT     12
+#define ECAM_BUS_SIZE           (1ULL << ECAM_BUS_SHIFT)
+
+typedef struct {
+    acpi_sdt_header_t header;
+    uint64_t reserved;
+} __packed mcfg_t;
+
+typedef struct {
+    uint64_t base_addr;
+    uint16_t segment;
+    uint8_t start_bus;
+    uint8_t end_bus;
+    uint32_t reserved;
+} __packed mcfg_entry_t;
+
+static struct {
+    bool enabled;
+    uint64_t base_addr;
+    uint8_t start_bus;
+    uint8_t end_bus;
+    /* virtual address of each bus once mapped, 0 until then */
+    uint64_t bus_virt[PCI_MAX_BUSES];
+} ecam;
+
+void pci_config_init(void) {
+    const mcfg_t *mcfg = (const mcfg_t*) acpi_find_table("MCFG");
+    if (mcfg == NULL) {
+        printk_info("PCI: configuration mechanism #1");
+        return;
+    }
+
+    size_t entries = (mcfg->header.length - sizeof(mcfg_t)) / sizeof(mcfg_entry_t);
+    const mcfg_entry_t *entry = (const mcfg_entry_t*) (mcfg + 1);
+
+    for (size_t i = 0; i < entries; i++) {
+        if (entry[i].segment != 0)
+            continue;
+
+        ecam.base_addr = entry[i].base_addr;
+        ecam.start_bus = entry[i].start_bus;
+        ecam.end_bus = entry[i].end_bus;
+        ecam.enabled = true;
+
+        printk_info("PCI: ECAM at 0x%llx, buses %u-%u", ecam.base_addr, ecam.start_bus, ecam.end_bus);
+        return;
+    }
+
+    printk_info("PCI: MCFG has no segment 0, configuration mechanism #1");
+}
+
+/* NULL if the bus (or the offset) can't be reached through ECAM */
+static volatile void* ecam_address(pci_addr_t addr, uint16_t offset) {
+    if (!ecam.enabled || addr.bus < ecam.start_bus || addr.bus > ecam.end_bus)
+        return NULL;
+
+    if (ecam.bus_virt[addr.bus] == 0) {
+        uint64_t bus_phys = ecam.base_addr + ((uint64_t) (addr.bus - ecam.start_bus) << ECAM_BUS_SHIFT);
+        ecam.bus_virt[addr.bus] = (uint64_t) ioremap(bus_phys, ECAM_BUS_SIZE);
+    }
+
+    return (volatile void*) (ecam.bus_virt[addr.bus] + ((uint64_t) addr.device << ECAM_DEVICE_SHIFT)
+            + ((uint64_t) addr.function << ECAM_FUNCTION_SHIFT) + offset);
+}
+
+static uint32_t legacy_address(pci_addr_t addr, uint16_t offset) {
+    return PCI_CONFIG_ENABLE | ((uint32_t) addr.bus << 16) | ((uint32_t) addr.device << 11)
+            | ((uint32_t) addr.function << 8) | (offset & 0xfc);
+}
+
+uint32_t pci_config_read32(pci_addr_t addr, uint16_t offset) {
+    volatile void *ptr = ecam_address(addr, offset);
+    if (ptr != NULL)
+        return *(volatile uint32_t*) ptr;
+
+    if (offset >= PCI_CONFIG_LEGACY_SIZE)
+        return UINT32_MAX;
+
+    uint64_t flags = local_irq_save();
+    outl(PCI_CONFIG_ADDRESS, legacy_address(addr, offset));
+    uint32_t value = inl(PCI_CONFIG_DATA);
+    local_irq_restore(flags);
+    return value;
+}
+
+uint16_t pci_config_read16(pci_addr_t addr, uint16_t offset) {
+    volatile void *ptr = ecam_address(addr, offset);
+    if (ptr != NULL)
+        return *(volatile uint16_t*) ptr;
+
+    return (uint16_t) (pci_config_read32(addr, offset) >> ((offset & 2) * 8));
+}
+
+uint8_t pci_config_read8(pci_addr_t addr, uint16_t offset) {
+    volatile void *ptr = ecam_address(addr, offset);
+    if (ptr != NULL)
+        return *(volatile uint8_t*) ptr;
+
+    return (uint8_t) (pci_config_read32(addr, offset) >> ((offset & 3) * 8));
+}
+
+void pci_config_write32(pci_addr_t addr, uint16_t offset, uint32_t value) {
+    volatile void *ptr = ecam_address(addr, offset);
+    if (ptr != NULL) {
+        *(volatile uint32_t*) ptr = value;
+        return;
+    }
+
+    if (offset >= PCI_CONFIG_LEGACY_SIZE)
+        return;
+
+    uint64_t flags = local_irq_save();
+    outl(PCI_CONFIG_ADDRESS, legacy_address(addr, offset));
+    outl(PCI_CONFIG_DATA, value);
+    local_irq_restore(flags);
+}
+
+/* read-modify-write of the dword holding the field, interrupts stay off for the whole of it */
+static void legacy_write_partial(pci_addr_t addr, uint16_t offset, uint32_t value, uint32_t mask) {
+    if (offset >= PCI_CONFIG_LEGACY_SIZE)
+        return;
+
+    uint32_t shift = (offset & 3) * 8;
+
+    uint64_t flags = local_irq_save();
+    outl(PCI_CONFIG_ADDRESS, legacy_address(addr, offset));
+    uint32_t dword = inl(PCI_CONFIG_DATA);
+    dword = (dword & ~(mask << shift)) | ((value & mask) << shift);
+    outl(PCI_CONFIG_DATA, dword);
+    local_irq_restore(flags);
+}
+
+void pci_config_write16(pci_addr_t addr, uint16_t offset, uint16_t value) {
+    volatile void *ptr = ecam_address(addr, offset);
+    if (ptr != NULL) {
+        *(volatile uint16_t*) ptr = value;
+        return;
+    }
+
+    legacy_write_partial(addr, offset, value, 0xffff);
+}
+
+void pci_config_write8(pci_addr_t addr, uint16_t offset, uint8_t value) {
+    volatile void *ptr = ecam_address(addr, offset);
+    if (ptr != NULL) {
+        *(volatile uint8_t*) ptr = value;
+        return;
+    }
+
+    legacy_write_partial(addr, offset, value, 0xff);
+}
@@ -129,3 +129,26 @@ void pic_disable_all_irq(void) {
     outb(PIC1_DATA, 0xff);
     outb(PIC2_DATA, 0xff);
 }
+
+static void pic_chip_eoi(uint8_t isa_irq) {
+    /*
+     * IRQ 7 and 15 are also what the PICs raise for interrupts that went away before being acknowledged. Those are
+     * not in service, so they must not get an EOI - except that a spurious IRQ 15 still went through the cascade.
+     */
+    if ((isa_irq == PIC_LPT1_OR_SPURIOUS_INTERRUPT || isa_irq == PIC_SECONDARY_ATA_HD_INTERRUPT)
+            && !test_bit(isa_irq, pic_read_isr())) {
+        if (isa_irq == PIC_SECONDARY_ATA_HD_INTERRUPT)
+            outb(PIC1_COMMAND, PIC_EOI);
+        return;
+    }
+
+    pic_send_eoi(isa_irq);
+}
+
+const irq_chip_t pic_chip = {
+    .name = "8259 PIC",
+    .mask = pic_mask_irq,
+    .unmask = pic_unmask_irq,
+    .eoi = pic_chip_eoi,
+    .set_affinity = NULL,
+};
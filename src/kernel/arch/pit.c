@@ -12,6 +12,10 @@
 #include "kernel/time/jiffies.h"
 #include "kernel/time/rtc.h"
 #include "kernel/task/scheduler.h"
+#include "kernel/interrupt/softirq.h"
+#include "kernel/interrupt/irq.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/compiler/bug.h"
 
 /*
  * Notes for myself:
@@ -71,6 +75,18 @@
 #define PIT_ACCESS_MODE_LO_HI   3 << 4      /* Access mode: lobyte/hibyte */
 #define PIT_ACCESS_MODE_LO      2 << 4      /* Access mode: lobyte */
 
+/* bottom half of the timer interrupt, runs with interrupts enabled */
+static void pit_timer_softirq(void) {
+    if (jiffies % 1000 == 0)
+        printk_fine("pit_timer_handle_irq: %llu", jiffies);
+
+    /* push queued log records out to console/serial */
+    printk_flush_deferred();
+
+    /* dirty blocks are written back by the flusher, which only checks the clock once woken up */
+    buffer_timer_tick();
+}
+
 void pit_init(uint32_t freq_hz) {
     /* configure PIT chip */
     outb(PIT_MODE_CMD_REG, (uint8_t) (PIT_ACCESS_MODE_LO_HI | PIT_OP_MODE_2 | PIT_BINARY_MODE));
@@ -92,28 +108,15 @@ void pit_init(uint32_t freq_hz) {
     /* values but put passed one byte at the time - interrupts must be disabled*/
     outb(PIT_CHANNEL_0_DATA_PORT, (uint8_t) (divider & 0xFF));
     outb(PIT_CHANNEL_0_DATA_PORT, (uint8_t) ((divider & 0xFF00) >> 8));
+
+    open_softirq(TIMER_SOFTIRQ, pit_timer_softirq);
     printk_info("PIT initiated");
 }
 
-void pit_enable(void) {
-    /*
-     * PIC unmask is a critical path, interrupts must be disabled to avoid stack pointer
-     * data corruption. This becomes more evident when using smaller freq divider such as
-     *  	outb(PIT_CHANNEL_0_DATA_PORT, 0xf);
-     */
-
-    disable_interrupts();
-    /* unmask timer interrupt so we can start processing it */
-    pic_unmask_irq(PIC_PROG_INT_TIMER_INTERRUPT);
-    printk_info("PIT IRQ enabled");
-    enable_interrupts();
-
-}
+static void pit_timer_handle_irq(void *dev) {
+    (void) dev;
 
-void pit_timer_handle_irq(void) {
     ++jiffies;
-    if (jiffies % 1000 == 0)
-        printk_fine("pit_timer_handle_irq: %llu", jiffies);
 
     /* increment current time counter */
     ++rtc_curr_unixtime;
@@ -121,6 +124,18 @@ void pit_timer_handle_irq(void) {
     /* give scheduler a change to change its mind */
     scheduler_tick();
 
-    /* acknowlodge the interrupt back to PIT */
-    pic_send_eoi(PIC_PROG_INT_TIMER_INTERRUPT);
+    /* everything else can wait until interrupts are enabled again */
+    raise_softirq(TIMER_SOFTIRQ);
+}
+
+void pit_enable(void) {
+    /*
+     * PIC unmask is a critical path, interrupts must be disabled to avoid stack pointer
+     * data corruption. This becomes more evident when using smaller freq divider such as
+     *  	outb(PIT_CHANNEL_0_DATA_PORT, 0xf);
+     *
+     * request_irq takes care of that.
+     */
+    BUG_ON(!request_irq(PIC_PROG_INT_TIMER_INTERRUPT, pit_timer_handle_irq, NULL));
+    printk_info("PIT IRQ enabled");
 }
@@ -0,0 +1,166 @@
+/*
+ * bench.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/debug/bench.h"
+#include "kernel/interrupt/idt.h"
+#include "kernel/asm/generic.h"
+#include "kernel/lib/printk.h"
+#include "kernel/arch/tss.h"
+#include "kernel/task/process.h"
+#include "kernel/task/pid.h"
+#include "kernel/mm/pagetable.h"
+#include "kernel/mm/page.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/init.h"
+#include "kernel/device/block.h"
+
+/*
+ * Notes to myself:
+ *
+ * rdtsc based microbenchmarks, results are in TSC ticks (not core cycles) so they're only meaningful compared to
+ * one another on the same machine. Interrupts are disabled while measuring so the timer doesn't get in the way.
+ */
+
+#define BENCH_ITERATIONS        1024
+
+/* block reads: 32 requests of 64 KiB each in flight vs the same sectors one by one */
+#define BENCH_BLOCK_REQUESTS    32
+#define BENCH_BLOCK_SECTORS     128
+
+extern tss_t TSS64_Segment;
+
+/* ping stands in for whoever runs the benchmark, pong is a kernel thread bouncing straight back */
+static task_struct_t bench_ping;
+static task_struct_t *bench_pong;
+
+/* unused software vector (fast path) and #BP (slow path) */
+#define BENCH_FAST_VECTOR       0xf0
+#define BENCH_SLOW_VECTOR       3
+
+static void bench_nop_handler(interrupt_stack_frame_t *int_frame) {
+    (void) int_frame;
+}
+
+/* 'int' takes an immediate, so each vector gets a loop of its own */
+#define DEFINE_BENCH_INT_LOOP(name, vector)                         \
+    static uint64_t name(void) {                                    \
+        uint64_t start = rdtsc();                                   \
+        for (size_t i = 0; i < BENCH_ITERATIONS; i++)               \
+            asm volatile ("int %0" :: "i" (vector) : "memory");     \
+        return (rdtsc() - start) / BENCH_ITERATIONS;                \
+    }
+
+DEFINE_BENCH_INT_LOOP(bench_fast_path, BENCH_FAST_VECTOR)
+DEFINE_BENCH_INT_LOOP(bench_slow_path, BENCH_SLOW_VECTOR)
+
+void bench_interrupt_entry(void) {
+    uint64_t flags = local_irq_save();
+
+    register_exception_handler(BENCH_FAST_VECTOR, bench_nop_handler);
+    register_exception_handler(BENCH_SLOW_VECTOR, bench_nop_handler);
+
+    /* warm up caches and branch predictors */
+    bench_fast_path();
+    bench_slow_path();
+
+    uint64_t fast = bench_fast_path();
+    uint64_t slow = bench_slow_path();
+
+    register_exception_handler(BENCH_FAST_VECTOR, NULL);
+    register_exception_handler(BENCH_SLOW_VECTOR, NULL);
+
+    local_irq_restore(flags);
+
+    printk_info("bench: interrupt entry/exit %llu ticks (GPRs only), %llu ticks (with control registers)", fast, slow);
+}
+
+static void bench_pong_thread(void) {
+    /* iretq brought interrupts back on */
+    disable_interrupts();
+
+    for (;;)
+        process_context_swtich(bench_pong, &bench_ping);
+}
+
+static uint64_t bench_ping_pong(void) {
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++)
+        process_context_swtich(&bench_ping, bench_pong);
+
+    /* two switches per round trip */
+    return (rdtsc() - start) / (2 * BENCH_ITERATIONS);
+}
+
+void bench_context_switch(void) {
+    uint64_t flags = local_irq_save();
+
+    /* same kernel stack as the caller as far as the TSS is concerned */
+    bench_ping.kernel_stack_area.virt_addr = TSS64_Segment.rsp0 - STACK_SIZE;
+    bench_ping.vm_area.pgtable = *kernel_pagetable();
+    bench_pong = create_kthread(bench_pong_thread);
+
+    /* warm up, then kernel threads: no CR3 reload */
+    bench_ping_pong();
+    uint64_t same_mm = bench_ping_pong();
+
+    /* two distinct address spaces that map the same kernel half: CR3 reload every switch */
+    pagetable_create(&bench_ping.vm_area.pgtable);
+    pagetable_create(&bench_pong->vm_area.pgtable);
+    uint64_t cross_mm = bench_ping_pong();
+
+    paging_reload_cr3(kernel_pagetable());
+    pgtable_page_free(bench_ping.vm_area.pgtable.phys_root);
+    pgtable_page_free(bench_pong->vm_area.pgtable.phys_root);
+
+    /* pong is parked inside process_context_swtich for good, nobody will resume it. Its pid goes back too, init is 1 */
+    release_pid(bench_pong->pid);
+    kfree((void*) bench_pong->kernel_stack_area.virt_addr);
+    kfree(bench_pong);
+    bench_pong = NULL;
+
+    local_irq_restore(flags);
+
+    printk_info("bench: context switch %llu ticks (same mm), %llu ticks (CR3 reload)", same_mm, cross_mm);
+}
+
+void bench_block_read(const char *name) {
+    block_device_t *dev = block_get_device(name);
+    if (dev == NULL || dev->nr_sectors < BENCH_BLOCK_REQUESTS * BENCH_BLOCK_SECTORS)
+        return;
+
+    uint8_t *buf = kmalloc(BENCH_BLOCK_REQUESTS * BENCH_BLOCK_SECTORS * BLOCK_SECTOR_SIZE, KMEM_DEFAULT);
+    block_request_t *reqs = kmalloc(sizeof(block_request_t) * BENCH_BLOCK_REQUESTS, KMEM_DEFAULT | KMEM_ZERO);
+    block_request_t **batch = kmalloc(sizeof(block_request_t*) * BENCH_BLOCK_REQUESTS, KMEM_DEFAULT);
+
+    /* what the boot loader does: a sector at a time, waiting for each */
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < BENCH_BLOCK_SECTORS; i++)
+        block_rw(dev, i, 1, buf + i * BLOCK_SECTOR_SIZE, false);
+    uint64_t single = (rdtsc() - start) / BENCH_BLOCK_SECTORS;
+
+    for (size_t i = 0; i < BENCH_BLOCK_REQUESTS; i++) {
+        reqs[i].dev = dev;
+        reqs[i].sector = i * BENCH_BLOCK_SECTORS;
+        reqs[i].count = BENCH_BLOCK_SECTORS;
+        reqs[i].buf = buf + i * BENCH_BLOCK_SECTORS * BLOCK_SECTOR_SIZE;
+        reqs[i].write = false;
+        batch[i] = &reqs[i];
+    }
+
+    start = rdtsc();
+    block_submit_batch(batch, BENCH_BLOCK_REQUESTS);
+    for (size_t i = 0; i < BENCH_BLOCK_REQUESTS; i++)
+        block_wait(&reqs[i]);
+    uint64_t batched = (rdtsc() - start) / (BENCH_BLOCK_REQUESTS * BENCH_BLOCK_SECTORS);
+
+    kfree(batch);
+    kfree(reqs);
+    kfree(buf);
+
+    printk_info("bench: %s reads %llu ticks/sector (one at a time), %llu ticks/sector (%u x %u KiB in flight)", name,
+            single, batched, BENCH_BLOCK_REQUESTS, BENCH_BLOCK_SECTORS * BLOCK_SECTOR_SIZE / 1024);
+}
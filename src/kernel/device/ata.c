@@ -0,0 +1,574 @@
+/*
+ * ata.c
+ *
+ * Adapted from https://wiki.osdev.org/ATA_PIO_Mode and https://wiki.osdev.org/ATA/ATAPI_using_DMA
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/ata.h"
+#include "kernel/device/block.h"
+#include "kernel/device/pci.h"
+#include "kernel/interrupt/irq.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Only the legacy (compatibility mode) channels are handled: 0x1f0/IRQ14 and 0x170/IRQ15, which is what QEMU's
+ * PIIX IDE controller looks like. If the controller is found on PCI and has a bus master BAR, transfers use DMA
+ * and the drive raises a single IRQ per command. Otherwise (or if the buffer sits above 4 GiB, PRDs are 32-bit)
+ * it's PIO with an IRQ per sector.
+ *
+ * Each channel runs one command at a time, the two drives on it share the registers. Requests are queued per
+ * channel and split into commands of at most ATA_MAX_SECTORS, the IRQ handler issues the next command (or
+ * request) as soon as the previous one is done so the channel never idles while there's work.
+ *
+ * LBA48 commands take twice as many port writes, so they're only used when the sectors can't be reached with LBA28.
+ */
+
+#define ATA_PRIMARY_IO          0x1f0
+#define ATA_PRIMARY_CTRL        0x3f6
+#define ATA_PRIMARY_IRQ         14
+#define ATA_SECONDARY_IO        0x170
+#define ATA_SECONDARY_CTRL      0x376
+#define ATA_SECONDARY_IRQ       15
+
+/* task file - offsets from the io base */
+#define ATA_REG_DATA            0
+#define ATA_REG_ERROR           1
+#define ATA_REG_FEATURES        1
+#define ATA_REG_SECCOUNT        2
+#define ATA_REG_LBA_LO          3
+#define ATA_REG_LBA_MID         4
+#define ATA_REG_LBA_HI          5
+#define ATA_REG_DRIVE           6
+#define ATA_REG_STATUS          7
+#define ATA_REG_COMMAND         7
+
+/* control block - alternate status (read) / device control (write) */
+#define ATA_CTRL_NIEN           (1 << 1)
+
+#define ATA_SR_ERR              (1 << 0)
+#define ATA_SR_DRQ              (1 << 3)
+#define ATA_SR_DF               (1 << 5)
+#define ATA_SR_BSY              (1 << 7)
+
+#define ATA_DRIVE_LBA           0x40
+#define ATA_DRIVE_LEGACY        0xa0
+#define ATA_DRIVE_SLAVE         (1 << 4)
+
+#define ATA_CMD_READ_PIO        0x20
+#define ATA_CMD_READ_PIO_EXT    0x24
+#define ATA_CMD_READ_DMA        0xc8
+#define ATA_CMD_READ_DMA_EXT    0x25
+#define ATA_CMD_WRITE_PIO       0x30
+#define ATA_CMD_WRITE_PIO_EXT   0x34
+#define ATA_CMD_WRITE_DMA       0xca
+#define ATA_CMD_WRITE_DMA_EXT   0x35
+#define ATA_CMD_IDENTIFY        0xec
+
+/* IDENTIFY words */
+#define ATA_ID_MODEL            27
+#define ATA_ID_MODEL_WORDS      20
+#define ATA_ID_CAPABILITIES     49
+#define ATA_ID_LBA28_SECTORS    60
+#define ATA_ID_COMMAND_SETS     83
+#define ATA_ID_LBA48_SECTORS    100
+
+#define ATA_CAP_LBA             (1 << 9)
+#define ATA_CMDSET_LBA48        (1 << 10)
+
+/* bus master IDE - offsets from BAR4, the secondary channel's registers start at +8 */
+#define BM_REG_COMMAND          0
+#define BM_REG_STATUS           2
+#define BM_REG_PRDT             4
+#define BM_SECONDARY_OFFSET     8
+
+#define BM_CMD_START            (1 << 0)
+#define BM_CMD_READ             (1 << 3)    /* device to memory */
+#define BM_SR_ACTIVE            (1 << 0)
+#define BM_SR_ERR               (1 << 1)
+#define BM_SR_IRQ               (1 << 2)
+
+#define PCI_CLASS_STORAGE       0x01
+#define PCI_SUBCLASS_IDE        0x01
+#define PCI_IDE_BAR_BM          4       /* BAR index */
+/* prog-if: channel in native mode (bit 0 primary, bit 2 secondary) and bus mastering support */
+#define PCI_IDE_NATIVE(ch)      (1 << ((ch) * 2))
+#define PCI_IDE_BUS_MASTER      (1 << 7)
+
+#define PRD_EOT                 (1 << 15)
+#define PRD_MAX_BYTES           0x10000
+
+/* per command, 128 KiB needs 3 PRDs at most however the buffer is aligned */
+#define ATA_MAX_SECTORS         256
+#define ATA_LBA28_LIMIT         (1ULL << 28)
+
+#define ATA_CHANNELS            2
+#define ATA_DRIVES_PER_CHANNEL  2
+
+/* how many times the status is polled before a drive is considered absent/dead (probe, first sector of a write) */
+#define ATA_PROBE_SPINS         100000
+
+typedef struct {
+    uint32_t phys_addr;
+    uint16_t byte_count;    /* 0 means 64 KiB */
+    uint16_t flags;
+} __packed ata_prd_t;
+
+struct ata_channel;
+
+typedef struct {
+    block_device_t blk;
+    struct ata_channel *channel;
+    bool present;
+    bool slave;
+    bool lba48;
+    char name[4];
+    char model[ATA_ID_MODEL_WORDS * 2 + 1];
+} ata_drive_t;
+
+typedef struct ata_channel {
+    uint16_t io;
+    uint16_t ctrl;
+    uint16_t bmide;         /* 0 if there is no bus master */
+    uint8_t irq;
+    ata_prd_t *prdt;
+
+    /* requests waiting for the channel */
+    block_request_t *queue_head;
+    block_request_t *queue_tail;
+
+    /* request in flight and where it's at */
+    block_request_t *req;
+    uint64_t lba;
+    uint32_t remaining;
+    uint8_t *buf;
+    /* sectors in the current command and, for PIO, how many of them are still to be transferred */
+    uint32_t chunk;
+    uint32_t chunk_left;
+    bool dma;
+
+    ata_drive_t drives[ATA_DRIVES_PER_CHANNEL];
+} ata_channel_t;
+
+static ata_channel_t channels[ATA_CHANNELS];
+
+/* reading the alternate status takes ~100ns, 4 of them give the drive the time it needs to update its status */
+static void ata_delay400(ata_channel_t *ch) {
+    for (int i = 0; i < 4; i++)
+        inb(ch->ctrl);
+}
+
+static void ata_select(ata_channel_t *ch, ata_drive_t *drive, uint8_t bits) {
+    outb(ch->io + ATA_REG_DRIVE, bits | (drive->slave ? ATA_DRIVE_SLAVE : 0));
+    ata_delay400(ch);
+}
+
+static bool ata_wait_not_busy(ata_channel_t *ch) {
+    for (size_t i = 0; i < ATA_PROBE_SPINS; i++) {
+        if (!(inb(ch->ctrl) & ATA_SR_BSY))
+            return true;
+        cpu_relax();
+    }
+    return false;
+}
+
+/* move a sector through the data port, BSY only shows up some time after the last word */
+static void ata_pio_transfer(ata_channel_t *ch, uint8_t *sector, bool write) {
+    if (write)
+        outsw(ch->io + ATA_REG_DATA, sector, BLOCK_SECTOR_SIZE / sizeof(uint16_t));
+    else
+        insw(ch->io + ATA_REG_DATA, sector, BLOCK_SECTOR_SIZE / sizeof(uint16_t));
+
+    ata_delay400(ch);
+}
+
+static bool ata_dma_possible(ata_channel_t *ch, const uint8_t *buf, uint32_t sectors) {
+    if (ch->bmide == 0)
+        return false;
+
+    /* PRDs are 32-bit and word aligned */
+    uint64_t phys = pa((uint64_t) buf);
+    return (phys & 1) == 0 && phys + (uint64_t) sectors * BLOCK_SECTOR_SIZE <= UINT32_MAX;
+}
+
+static void ata_dma_setup(ata_channel_t *ch, bool write) {
+    uint64_t phys = pa((uint64_t) ch->buf);
+    uint64_t left = (uint64_t) ch->chunk * BLOCK_SECTOR_SIZE;
+    size_t nr = 0;
+
+    /* a PRD can't cross a 64 KiB boundary */
+    while (left > 0) {
+        uint64_t len = MIN(left, PRD_MAX_BYTES - (phys & (PRD_MAX_BYTES - 1)));
+        ch->prdt[nr].phys_addr = (uint32_t) phys;
+        ch->prdt[nr].byte_count = (uint16_t) len;
+        ch->prdt[nr].flags = 0;
+        nr++;
+        phys += len;
+        left -= len;
+    }
+    ch->prdt[nr - 1].flags = PRD_EOT;
+
+    outl(ch->bmide + BM_REG_PRDT, (uint32_t) pa((uint64_t) ch->prdt));
+    outb(ch->bmide + BM_REG_COMMAND, write ? 0 : BM_CMD_READ);
+    /* error and interrupt bits are write-1-to-clear */
+    outb(ch->bmide + BM_REG_STATUS, BM_SR_ERR | BM_SR_IRQ);
+}
+
+static uint8_t ata_command(bool write, bool dma, bool lba48) {
+    if (write)
+        return dma ? (lba48 ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_WRITE_DMA)
+                : (lba48 ? ATA_CMD_WRITE_PIO_EXT : ATA_CMD_WRITE_PIO);
+
+    return dma ? (lba48 ? ATA_CMD_READ_DMA_EXT : ATA_CMD_READ_DMA) : (lba48 ? ATA_CMD_READ_PIO_EXT : ATA_CMD_READ_PIO);
+}
+
+/* issue the next command of the request in flight */
+/* false if the drive never got ready for the first sector of a PIO write, the request has to fail then */
+static bool ata_issue(ata_channel_t *ch) {
+    block_request_t *req = ch->req;
+    ata_drive_t *drive = req->dev->private;
+
+    ch->chunk = MIN(ch->remaining, ATA_MAX_SECTORS);
+    ch->chunk_left = ch->chunk;
+    ch->dma = ata_dma_possible(ch, ch->buf, ch->chunk);
+
+    bool lba48 = ch->lba + ch->chunk > ATA_LBA28_LIMIT;
+
+    if (ch->dma)
+        ata_dma_setup(ch, req->write);
+
+    if (lba48) {
+        ata_select(ch, drive, ATA_DRIVE_LBA);
+        /* high order bytes go first, the registers are 2-deep FIFOs */
+        outb(ch->io + ATA_REG_SECCOUNT, (uint8_t) (ch->chunk >> 8));
+        outb(ch->io + ATA_REG_LBA_LO, (uint8_t) (ch->lba >> 24));
+        outb(ch->io + ATA_REG_LBA_MID, (uint8_t) (ch->lba >> 32));
+        outb(ch->io + ATA_REG_LBA_HI, (uint8_t) (ch->lba >> 40));
+    } else {
+        ata_select(ch, drive, ATA_DRIVE_LEGACY | ATA_DRIVE_LBA | ((ch->lba >> 24) & 0x0f));
+    }
+
+    /* a count of 0 stands for 256 sectors (LBA28) */
+    outb(ch->io + ATA_REG_SECCOUNT, (uint8_t) ch->chunk);
+    outb(ch->io + ATA_REG_LBA_LO, (uint8_t) ch->lba);
+    outb(ch->io + ATA_REG_LBA_MID, (uint8_t) (ch->lba >> 8));
+    outb(ch->io + ATA_REG_LBA_HI, (uint8_t) (ch->lba >> 16));
+    outb(ch->io + ATA_REG_COMMAND, ata_command(req->write, ch->dma, lba48));
+
+    if (ch->dma) {
+        outb(ch->bmide + BM_REG_COMMAND, inb(ch->bmide + BM_REG_COMMAND) | BM_CMD_START);
+        return true;
+    }
+
+    ata_delay400(ch);
+
+    /* the drive only interrupts once it wants the *next* sector, the first one has to be pushed right away */
+    if (req->write) {
+        /* this runs from the IRQ handler too, a wedged drive can't be waited on forever with interrupts off */
+        if (!ata_wait_not_busy(ch))
+            return false;
+
+        /* an error gets reported through the IRQ */
+        if (inb(ch->ctrl) & ATA_SR_DRQ)
+            ata_pio_transfer(ch, ch->buf, true);
+    }
+
+    return true;
+}
+
+static void ata_start_next(ata_channel_t *ch) {
+    block_request_t *req;
+
+    while ((req = ch->queue_head) != NULL) {
+        ch->queue_head = req->next;
+        if (ch->queue_head == NULL)
+            ch->queue_tail = NULL;
+
+        ch->req = req;
+        ch->lba = req->sector;
+        ch->remaining = req->count;
+        ch->buf = req->buf;
+
+        if (ata_issue(ch))
+            return;
+
+        /* the IRQ it would wait for isn't coming, the completion may submit (and start) another one */
+        ch->req = NULL;
+        block_end_request(req, -EIO);
+        if (ch->req != NULL)
+            return;
+    }
+
+    ch->req = NULL;
+}
+
+static void ata_finish(ata_channel_t *ch, int status) {
+    block_request_t *req = ch->req;
+
+    /* start the next one first, so the drive works while the completion runs */
+    ata_start_next(ch);
+    block_end_request(req, status);
+}
+
+/* the current command is over, either carry on with the request or complete it */
+static void ata_command_done(ata_channel_t *ch) {
+    ch->lba += ch->chunk;
+    ch->remaining -= ch->chunk;
+    ch->buf += (uint64_t) ch->chunk * BLOCK_SECTOR_SIZE;
+
+    if (ch->remaining == 0)
+        ata_finish(ch, 0);
+    else if (!ata_issue(ch))
+        ata_finish(ch, -EIO);
+}
+
+static void ata_service(ata_channel_t *ch) {
+    if (ch->req == NULL) {
+        /* nothing in flight, just acknowledge the drive */
+        inb(ch->io + ATA_REG_STATUS);
+        return;
+    }
+
+    if (ch->dma) {
+        uint8_t bm_status = inb(ch->bmide + BM_REG_STATUS);
+        if (!(bm_status & BM_SR_IRQ))
+            return;
+
+        outb(ch->bmide + BM_REG_COMMAND, inb(ch->bmide + BM_REG_COMMAND) & ~BM_CMD_START);
+        outb(ch->bmide + BM_REG_STATUS, BM_SR_ERR | BM_SR_IRQ);
+
+        /* reading the status register is what acknowledges the drive's IRQ */
+        uint8_t status = inb(ch->io + ATA_REG_STATUS);
+        if ((status & (ATA_SR_ERR | ATA_SR_DF)) || (bm_status & BM_SR_ERR)) {
+            ata_finish(ch, -EIO);
+            return;
+        }
+
+        ata_command_done(ch);
+        return;
+    }
+
+    if (inb(ch->ctrl) & ATA_SR_BSY)
+        return;
+
+    uint8_t status = inb(ch->io + ATA_REG_STATUS);
+    if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+        ata_finish(ch, -EIO);
+        return;
+    }
+
+    if (ch->req->write) {
+        /* the sector pushed last has been written */
+        ch->chunk_left--;
+        if (ch->chunk_left == 0) {
+            ata_command_done(ch);
+            return;
+        }
+
+        ata_pio_transfer(ch, ch->buf + (uint64_t) (ch->chunk - ch->chunk_left) * BLOCK_SECTOR_SIZE, true);
+        return;
+    }
+
+    if (!(status & ATA_SR_DRQ))
+        return;
+
+    ata_pio_transfer(ch, ch->buf + (uint64_t) (ch->chunk - ch->chunk_left) * BLOCK_SECTOR_SIZE, false);
+
+    if (--ch->chunk_left == 0)
+        ata_command_done(ch);
+}
+
+static void ata_irq_handler(void *dev) {
+    ata_service(dev);
+}
+
+static void ata_submit(block_device_t *dev, block_request_t *req) {
+    ata_drive_t *drive = dev->private;
+    ata_channel_t *ch = drive->channel;
+
+    uint64_t flags = local_irq_save();
+
+    req->next = NULL;
+    if (ch->queue_tail != NULL)
+        ch->queue_tail->next = req;
+    else
+        ch->queue_head = req;
+    ch->queue_tail = req;
+
+    if (ch->req == NULL)
+        ata_start_next(ch);
+
+    local_irq_restore(flags);
+}
+
+static void ata_poll(block_device_t *dev) {
+    ata_drive_t *drive = dev->private;
+    ata_service(drive->channel);
+}
+
+static void ata_identify(ata_channel_t *ch, ata_drive_t *drive) {
+    ata_select(ch, drive, ATA_DRIVE_LEGACY);
+
+    outb(ch->io + ATA_REG_SECCOUNT, 0);
+    outb(ch->io + ATA_REG_LBA_LO, 0);
+    outb(ch->io + ATA_REG_LBA_MID, 0);
+    outb(ch->io + ATA_REG_LBA_HI, 0);
+    outb(ch->io + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+    ata_delay400(ch);
+
+    /* floating bus or no drive */
+    uint8_t status = inb(ch->io + ATA_REG_STATUS);
+    if (status == 0 || status == 0xff || !ata_wait_not_busy(ch))
+        return;
+
+    /* ATAPI and SATA signatures, those aren't ATA disks */
+    if (inb(ch->io + ATA_REG_LBA_MID) != 0 || inb(ch->io + ATA_REG_LBA_HI) != 0)
+        return;
+
+    for (size_t i = 0; i < ATA_PROBE_SPINS; i++) {
+        status = inb(ch->io + ATA_REG_STATUS);
+        if (status & (ATA_SR_ERR | ATA_SR_DRQ))
+            break;
+        cpu_relax();
+    }
+
+    if (!(status & ATA_SR_DRQ))
+        return;
+
+    uint16_t id[256];
+    insw(ch->io + ATA_REG_DATA, id, ARR_SIZE(id));
+
+    if (!(id[ATA_ID_CAPABILITIES] & ATA_CAP_LBA))
+        return;
+
+    drive->lba48 = id[ATA_ID_COMMAND_SETS] & ATA_CMDSET_LBA48;
+    if (drive->lba48) {
+        drive->blk.nr_sectors = (uint64_t) id[ATA_ID_LBA48_SECTORS] | ((uint64_t) id[ATA_ID_LBA48_SECTORS + 1] << 16)
+                | ((uint64_t) id[ATA_ID_LBA48_SECTORS + 2] << 32) | ((uint64_t) id[ATA_ID_LBA48_SECTORS + 3] << 48);
+    } else {
+        drive->blk.nr_sectors = (uint64_t) id[ATA_ID_LBA28_SECTORS] | ((uint64_t) id[ATA_ID_LBA28_SECTORS + 1] << 16);
+    }
+
+    /* model string is stored as big-endian words, padded with spaces */
+    for (size_t i = 0; i < ATA_ID_MODEL_WORDS; i++) {
+        drive->model[i * 2] = (char) (id[ATA_ID_MODEL + i] >> 8);
+        drive->model[i * 2 + 1] = (char) id[ATA_ID_MODEL + i];
+    }
+    for (int i = ATA_ID_MODEL_WORDS * 2 - 1; i >= 0 && drive->model[i] == ' '; i--)
+        drive->model[i] = '\0';
+
+    drive->present = drive->blk.nr_sectors > 0;
+}
+
+/* bus master IDE registers of the controller, 0 if there's none we can use */
+static uint16_t bus_master_io;
+
+static bool ata_pci_probe(pci_dev_t *dev) {
+    /* native mode channels live wherever their BARs say, only the legacy ports are probed here */
+    if ((dev->prog_if & (PCI_IDE_NATIVE(0) | PCI_IDE_NATIVE(1))) || !(dev->prog_if & PCI_IDE_BUS_MASTER))
+        return false;
+
+    pci_bar_t *bar = &dev->bars[PCI_IDE_BAR_BM];
+    if (!bar->io || bar->base == 0)
+        return false;
+
+    pci_enable_device(dev);
+    pci_set_master(dev);
+
+    bus_master_io = (uint16_t) bar->base;
+    return true;
+}
+
+static const pci_device_id_t ata_pci_ids[] = {
+    PCI_DEVICE_CLASS(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE),
+    { 0 }
+};
+
+static pci_driver_t ata_pci_driver = {
+    .name = "ata",
+    .ids = ata_pci_ids,
+    .probe = ata_pci_probe,
+};
+
+void ata_init(void) {
+    static const uint16_t io_ports[ATA_CHANNELS] = { ATA_PRIMARY_IO, ATA_SECONDARY_IO };
+    static const uint16_t ctrl_ports[ATA_CHANNELS] = { ATA_PRIMARY_CTRL, ATA_SECONDARY_CTRL };
+    static const uint8_t irqs[ATA_CHANNELS] = { ATA_PRIMARY_IRQ, ATA_SECONDARY_IRQ };
+
+    /* the controller, if it's PCI at all, is already enumerated so its probe is done by the time this returns */
+    pci_register_driver(&ata_pci_driver);
+
+    for (size_t c = 0; c < ATA_CHANNELS; c++) {
+        ata_channel_t *ch = &channels[c];
+        ch->io = io_ports[c];
+        ch->ctrl = ctrl_ports[c];
+        ch->irq = irqs[c];
+
+        /* floating bus, no drives on this channel */
+        if (inb(ch->io + ATA_REG_STATUS) == 0xff)
+            continue;
+
+        /* keep the drives quiet while they're probed */
+        outb(ch->ctrl, ATA_CTRL_NIEN);
+
+        bool found = false;
+        for (size_t d = 0; d < ATA_DRIVES_PER_CHANNEL; d++) {
+            ata_drive_t *drive = &ch->drives[d];
+            drive->channel = ch;
+            drive->slave = d == 1;
+            ata_identify(ch, drive);
+            found |= drive->present;
+        }
+
+        if (!found)
+            continue;
+
+        if (bus_master_io != 0) {
+            /* one page is plenty for ATA_MAX_SECTORS and it never crosses a 64 KiB boundary */
+            ch->prdt = kmalloc(PAGE_SIZE, KMEM_DEFAULT | KMEM_ZERO);
+            if (pa((uint64_t) ch->prdt) < UINT32_MAX)
+                ch->bmide = bus_master_io + c * BM_SECONDARY_OFFSET;
+        }
+
+        if (!request_irq(ch->irq, ata_irq_handler, ch)) {
+            printk_error("ata: IRQ %u is taken, channel %llu disabled", ch->irq, (uint64_t) c);
+            continue;
+        }
+
+        /* acknowledge whatever probing left pending and let the drives interrupt from now on */
+        inb(ch->io + ATA_REG_STATUS);
+        outb(ch->ctrl, 0);
+
+        for (size_t d = 0; d < ATA_DRIVES_PER_CHANNEL; d++) {
+            ata_drive_t *drive = &ch->drives[d];
+            if (!drive->present)
+                continue;
+
+            drive->name[0] = 'h';
+            drive->name[1] = 'd';
+            drive->name[2] = (char) ('a' + c * ATA_DRIVES_PER_CHANNEL + d);
+            drive->name[3] = '\0';
+
+            drive->blk.name = drive->name;
+            drive->blk.submit = ata_submit;
+            drive->blk.commit = NULL;
+            drive->blk.poll = ata_poll;
+            drive->blk.private = drive;
+
+            printk_info("ata: %s is %s (%s, %s)", drive->name, drive->model, drive->lba48 ? "LBA48" : "LBA28",
+                    ch->bmide != 0 ? "DMA" : "PIO");
+            block_register_device(&drive->blk);
+        }
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * block.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/block.h"
+#include "kernel/arch/cpu.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Requests are asynchronous all the way down: drivers queue them and report back from their IRQ handler. Nothing
+ * in the kernel can sleep halfway through (syscalls included, see task/wait.c), so block_rw waits for its request
+ * by halting until the next interrupt. When it's called with interrupts disabled, as it is from the syscall path,
+ * the driver is polled instead. It's polled after every wake-up too, drivers may hold their IRQ back until a few
+ * requests have completed.
+ *
+ * Notifying a device can be expensive (a VM exit for virtio), so drivers may split queueing (submit) from telling
+ * the hardware about it (commit). block_submit_batch makes the most of that.
+ */
+
+static block_device_t *devices;
+
+void block_register_device(block_device_t *dev) {
+    BUG_ON(dev->submit == NULL || dev->poll == NULL);
+
+    dev->next = devices;
+    devices = dev;
+
+    printk_info("block: %s, %llu sectors (%llu MiB)", dev->name, dev->nr_sectors,
+            dev->nr_sectors * BLOCK_SECTOR_SIZE / (1024 * 1024));
+}
+
+block_device_t* block_get_device(const char *name) {
+    for (block_device_t *dev = devices; dev != NULL; dev = dev->next) {
+        if (strcmp(dev->name, name) == 0)
+            return dev;
+    }
+    return NULL;
+}
+
+block_device_t* block_first_device(void) {
+    return devices;
+}
+
+void block_end_request(block_request_t *req, int status) {
+    req->status = status;
+    __atomic_store_n(&req->done, true, __ATOMIC_RELEASE);
+
+    if (req->end_io != NULL)
+        req->end_io(req);
+}
+
+static void block_queue(block_request_t *req) {
+    block_device_t *dev = req->dev;
+
+    req->status = 0;
+    req->done = false;
+
+    if (req->count == 0 || req->sector >= dev->nr_sectors || req->count > dev->nr_sectors - req->sector) {
+        block_end_request(req, -EINVAL);
+        return;
+    }
+
+    dev->submit(dev, req);
+}
+
+void block_submit(block_request_t *req) {
+    block_queue(req);
+
+    if (req->dev->commit != NULL)
+        req->dev->commit(req->dev);
+}
+
+void block_submit_batch(block_request_t **reqs, size_t nr) {
+    if (nr == 0)
+        return;
+
+    for (size_t i = 0; i < nr; i++) {
+        /* sanity check */
+        BUG_ON(reqs[i]->dev != reqs[0]->dev);
+        block_queue(reqs[i]);
+    }
+
+    if (reqs[0]->dev->commit != NULL)
+        reqs[0]->dev->commit(reqs[0]->dev);
+}
+
+int block_wait(block_request_t *req) {
+    uint64_t flags = local_irq_save();
+
+    for (;;) {
+        req->dev->poll(req->dev);
+        if (__atomic_load_n(&req->done, __ATOMIC_ACQUIRE))
+            break;
+
+        if (flags & RFLAGS_IF) {
+            safe_halt();
+            disable_interrupts();
+        }
+    }
+
+    local_irq_restore(flags);
+
+    return req->status;
+}
+
+int block_rw(block_device_t *dev, uint64_t sector, uint32_t count, void *buf, bool write) {
+    block_request_t req = {
+            .dev = dev,
+            .sector = sector,
+            .count = count,
+            .buf = buf,
+            .write = write,
+            .end_io = NULL,
+            .private = NULL,
+            .next = NULL
+    };
+
+    block_submit(&req);
+    return block_wait(&req);
+}
@@ -10,6 +10,10 @@
 #include "kernel/lib/printk.h"
 #include "kernel/lib/bit.h"
 #include "kernel/asm/generic.h"
+#include "kernel/interrupt/softirq.h"
+#include "kernel/interrupt/irq.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/device/tty.h"
 
 /*
  * Things To Do:
@@ -24,28 +28,110 @@
  *
  *      I could of course implement something quick and dirty but I wouldn't be able to rip the results of this effort
  *      When I'm ready to take on this, I have to read again: http://www.linusakesson.net/programming/tty/index.php
+ *
+ * On 19/10/2026:
+ *
+ *  Userspace and syscalls are there now. The IRQ handler only translates the scancode into a keycode and pushes the
+ *  event into a ring, everything else (modifiers, keymaps, line editing, echo) is done by the TTY bottom half
+ *  (kernel/device/tty.c), run from a tasklet, which is the only consumer of that ring. Single producer and single consumer means that
+ *  the ring doesn't need locks, just the right memory ordering on the indexes.
  */
 
-void keyboard_enable(void) {
-    /* PIC unmask is a critical path, interrupts must be disabled to avoid stack pointer data corruption */
-    disable_interrupts();
-    pic_unmask_irq(PIC_KEYBOARD_INTERRUPT);
-    enable_interrupts();
-    printk_info("Keyboard IRQ enabled");
+#define KEYBOARD_DATA_PORT      0x60
+
+/* scancode set 1 */
+#define SCANCODE_EXTENDED       0xE0
+#define SCANCODE_RELEASED_BIT   7
+
+/* size must be a power of 2 */
+#define KEYBOARD_RING_SIZE      128
+
+static keyboard_event_t ring[KEYBOARD_RING_SIZE];
+static size_t ring_head; /* written by the IRQ handler only */
+static size_t ring_tail; /* written by the consumer only */
+
+/* events lost because the bottom half didn't keep up */
+static uint64_t dropped;
+
+/* last byte was the 0xE0 prefix */
+static bool extended;
+
+/* keys behind the 0xE0 prefix, the rest are ignored (fake shifts and friends) */
+static const uint8_t extended_keycodes[KEY_MAX] = {
+        [0x1C] = KEY_KPENTER,
+        [0x1D] = KEY_RIGHTCTRL,
+        [0x35] = KEY_KPSLASH,
+        [0x38] = KEY_RIGHTALT,
+        [0x47] = KEY_HOME,
+        [0x48] = KEY_UP,
+        [0x49] = KEY_PAGEUP,
+        [0x4B] = KEY_LEFT,
+        [0x4D] = KEY_RIGHT,
+        [0x4F] = KEY_END,
+        [0x50] = KEY_DOWN,
+        [0x51] = KEY_PAGEDOWN,
+        [0x52] = KEY_INSERT,
+        [0x53] = KEY_DELETE,
+};
+
+/* runs the TTY line discipline outside of the hard IRQ */
+static void keyboard_tasklet_fn(unsigned long data) {
+    (void) data;
+    tty_process_input();
+}
+
+static DECLARE_TASKLET(keyboard_tasklet, keyboard_tasklet_fn, 0);
+
+static uint8_t scancode_to_keycode(uint8_t scan_code) {
+    uint8_t code = extract_bit_chunk(0, 6, scan_code);
+
+    if (extended)
+        return extended_keycodes[code];
+
+    /* main block: make codes and keycodes are the same thing */
+    return code <= KEY_F12 ? code : KEY_RESERVED;
 }
 
-void keyboard_handle_irq(void) {
+bool keyboard_read_event(keyboard_event_t *event) {
+    size_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+
+    if (ring_tail == head)
+        return false;
+
+    *event = ring[ring_tail & (KEYBOARD_RING_SIZE - 1)];
+
+    /* hand the slot back to the IRQ handler */
+    __atomic_store_n(&ring_tail, ring_tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
 
-    /* bit 7 is high when key is released */
-    char* event;
-    uint8_t scan_code = inb(0x60);
-    if (!test_bit(7, scan_code)) {
-        event = "pressed";
+static void keyboard_handle_irq(void *dev) {
+    (void) dev;
+    uint8_t scan_code = inb(KEYBOARD_DATA_PORT);
+
+    if (scan_code == SCANCODE_EXTENDED) {
+        extended = true;
     } else {
-        event = "released";
+        uint8_t keycode = scancode_to_keycode(scan_code);
+        extended = false;
+
+        if (keycode != KEY_RESERVED) {
+            if (ring_head - __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE) == KEYBOARD_RING_SIZE) {
+                dropped++;
+            } else {
+                keyboard_event_t *event = &ring[ring_head & (KEYBOARD_RING_SIZE - 1)];
+                event->keycode = keycode;
+                /* bit 7 is high when key is released */
+                event->released = test_bit(SCANCODE_RELEASED_BIT, scan_code);
+                __atomic_store_n(&ring_head, ring_head + 1, __ATOMIC_RELEASE);
+            }
+
+            tasklet_schedule(&keyboard_tasklet);
+        }
     }
-    printk_info("Keyboard %s %u", event, scan_code);
+}
 
-    /* Acknowledge that we've received the interrupt */
-    pic_send_eoi(PIC_KEYBOARD_INTERRUPT);
+void keyboard_enable(void) {
+    BUG_ON(!request_irq(PIC_KEYBOARD_INTERRUPT, keyboard_handle_irq, NULL));
+    printk_info("Keyboard IRQ enabled");
 }
@@ -0,0 +1,243 @@
+/*
+ * pci.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/pci.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/ioremap.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * Devices are found once, at boot, by walking the hierarchy from bus 0: every PCI-to-PCI bridge leads to its
+ * secondary bus, as programmed by the firmware (nothing is re-assigned here). A multi-function host bridge means
+ * there are several host buses, function n being bus n.
+ *
+ * Each device gets its BARs sized (write all 1s, see which bits stick, put the original back) with decoding turned
+ * off meanwhile, so the BAR doesn't briefly claim the whole address space. The capability list is walked once to
+ * remember where MSI and MSI-X live.
+ *
+ * Drivers list what they handle (vendor/device or class/subclass) and are bound in whichever order things happen:
+ * registering a driver probes the devices already found and enumerating a device tries the drivers registered
+ * so far.
+ */
+
+#define PCI_CAP_POINTER_MASK    0xfc
+/* a looping capability list would otherwise hang us */
+#define PCI_CAP_MAX             48
+
+static pci_dev_t *devices;
+static pci_dev_t *devices_tail;
+static pci_driver_t *drivers;
+
+static uint32_t nr_devices;
+
+pci_dev_t* pci_first_device(void) {
+    return devices;
+}
+
+static bool pci_id_match(const pci_device_id_t *id, const pci_dev_t *dev) {
+    return (id->vendor == PCI_ANY_ID || id->vendor == dev->vendor)
+            && (id->device == PCI_ANY_ID || id->device == dev->device)
+            && (id->class == PCI_ANY_ID || id->class == dev->class)
+            && (id->subclass == PCI_ANY_ID || id->subclass == dev->subclass);
+}
+
+static void pci_try_bind(pci_driver_t *driver, pci_dev_t *dev) {
+    if (dev->driver != NULL)
+        return;
+
+    for (const pci_device_id_t *id = driver->ids; id->vendor != 0 || id->class != 0; id++) {
+        if (!pci_id_match(id, dev))
+            continue;
+
+        dev->driver = driver;
+        if (!driver->probe(dev))
+            dev->driver = NULL;
+        return;
+    }
+}
+
+void pci_register_driver(pci_driver_t *driver) {
+    driver->next = drivers;
+    drivers = driver;
+
+    for (pci_dev_t *dev = devices; dev != NULL; dev = dev->next)
+        pci_try_bind(driver, dev);
+}
+
+static void pci_size_bars(pci_dev_t *dev, uint8_t nr_bars) {
+    uint16_t command = pci_config_read16(dev->addr, PCI_COMMAND);
+    pci_config_write16(dev->addr, PCI_COMMAND, command & ~(PCI_COMMAND_IO | PCI_COMMAND_MEMORY));
+
+    for (uint8_t i = 0; i < nr_bars; i++) {
+        uint16_t offset = PCI_BAR0 + i * 4;
+        uint32_t bar = pci_config_read32(dev->addr, offset);
+
+        pci_config_write32(dev->addr, offset, UINT32_MAX);
+        uint32_t mask = pci_config_read32(dev->addr, offset);
+        pci_config_write32(dev->addr, offset, bar);
+
+        if (mask == 0)
+            continue;
+
+        pci_bar_t *b = &dev->bars[i];
+
+        if (bar & PCI_BAR_IO) {
+            b->io = true;
+            b->base = bar & PCI_BAR_IO_MASK;
+            /* the upper 16 bits may not be implemented for I/O */
+            b->size = (uint16_t) ~(mask & PCI_BAR_IO_MASK) + 1;
+            continue;
+        }
+
+        b->prefetch = bar & PCI_BAR_MEM_PREFETCH;
+        b->base = bar & PCI_BAR_MEM_MASK;
+        uint64_t size_mask = 0xffffffff00000000ULL | (mask & PCI_BAR_MEM_MASK);
+
+        if ((bar & PCI_BAR_MEM_TYPE_MASK) == PCI_BAR_MEM_TYPE_64 && i + 1 < nr_bars) {
+            uint32_t upper = pci_config_read32(dev->addr, offset + 4);
+
+            pci_config_write32(dev->addr, offset + 4, UINT32_MAX);
+            uint32_t upper_mask = pci_config_read32(dev->addr, offset + 4);
+            pci_config_write32(dev->addr, offset + 4, upper);
+
+            b->base |= (uint64_t) upper << 32;
+            size_mask = ((uint64_t) upper_mask << 32) | (mask & PCI_BAR_MEM_MASK);
+            /* the upper half isn't a BAR of its own */
+            i++;
+        }
+
+        b->size = ~size_mask + 1;
+    }
+
+    pci_config_write16(dev->addr, PCI_COMMAND, command);
+}
+
+static void pci_read_capabilities(pci_dev_t *dev) {
+    if (!(pci_config_read16(dev->addr, PCI_STATUS) & PCI_STATUS_CAP_LIST))
+        return;
+
+    uint8_t pos = pci_config_read8(dev->addr, PCI_CAPABILITY_LIST) & PCI_CAP_POINTER_MASK;
+
+    for (int i = 0; i < PCI_CAP_MAX && pos != 0; i++) {
+        uint8_t id = pci_config_read8(dev->addr, pos);
+
+        if (id == PCI_CAP_ID_MSI)
+            dev->msi_cap = pos;
+        else if (id == PCI_CAP_ID_MSIX)
+            dev->msix_cap = pos;
+
+        pos = pci_config_read8(dev->addr, pos + 1) & PCI_CAP_POINTER_MASK;
+    }
+}
+
+static void pci_add_device(pci_addr_t addr, uint8_t header_type) {
+    pci_dev_t *dev = kmalloc(sizeof(pci_dev_t), KMEM_DEFAULT | KMEM_ZERO);
+    dev->addr = addr;
+    dev->vendor = pci_config_read16(addr, PCI_VENDOR_ID);
+    dev->device = pci_config_read16(addr, PCI_DEVICE_ID);
+    dev->class = pci_config_read8(addr, PCI_CLASS);
+    dev->subclass = pci_config_read8(addr, PCI_SUBCLASS);
+    dev->prog_if = pci_config_read8(addr, PCI_PROG_IF);
+    dev->revision = pci_config_read8(addr, PCI_REVISION_ID);
+    dev->irq_line = pci_config_read8(addr, PCI_INTERRUPT_LINE);
+    dev->irq_pin = pci_config_read8(addr, PCI_INTERRUPT_PIN);
+
+    /* bridges only have two BARs, the rest of their header is about the bus behind them */
+    pci_size_bars(dev, header_type == PCI_HEADER_TYPE_BRIDGE ? 2 : PCI_NR_BARS);
+    pci_read_capabilities(dev);
+
+    if (devices_tail != NULL)
+        devices_tail->next = dev;
+    else
+        devices = dev;
+    devices_tail = dev;
+    nr_devices++;
+
+    printk_debug("PCI: %u:%u.%u %x:%x class %x:%x", addr.bus, addr.device, addr.function, dev->vendor,
+            dev->device, dev->class, dev->subclass);
+
+    for (pci_driver_t *driver = drivers; driver != NULL && dev->driver == NULL; driver = driver->next)
+        pci_try_bind(driver, dev);
+}
+
+static void pci_scan_bus(uint8_t bus);
+
+static void pci_scan_function(pci_addr_t addr) {
+    uint8_t header_type = pci_config_read8(addr, PCI_HEADER_TYPE) & PCI_HEADER_TYPE_MASK;
+
+    pci_add_device(addr, header_type);
+
+    if (header_type == PCI_HEADER_TYPE_BRIDGE) {
+        uint8_t secondary = pci_config_read8(addr, PCI_SECONDARY_BUS);
+        /* a bridge the firmware didn't configure (or a bogus loop back) */
+        if (secondary > addr.bus)
+            pci_scan_bus(secondary);
+    }
+}
+
+static void pci_scan_bus(uint8_t bus) {
+    for (uint8_t device = 0; device < PCI_MAX_DEVICES; device++) {
+        pci_addr_t addr = { .bus = bus, .device = device, .function = 0 };
+        if (pci_config_read16(addr, PCI_VENDOR_ID) == PCI_VENDOR_NONE)
+            continue;
+
+        uint8_t functions = (pci_config_read8(addr, PCI_HEADER_TYPE) & PCI_HEADER_MULTIFUNC) ? PCI_MAX_FUNCTIONS : 1;
+
+        for (addr.function = 0; addr.function < functions; addr.function++) {
+            if (pci_config_read16(addr, PCI_VENDOR_ID) != PCI_VENDOR_NONE)
+                pci_scan_function(addr);
+        }
+    }
+}
+
+void pci_init(void) {
+    pci_config_init();
+
+    pci_addr_t host = { .bus = 0, .device = 0, .function = 0 };
+
+    if (!(pci_config_read8(host, PCI_HEADER_TYPE) & PCI_HEADER_MULTIFUNC)) {
+        pci_scan_bus(0);
+    } else {
+        /* one host controller per function */
+        for (host.function = 0; host.function < PCI_MAX_FUNCTIONS; host.function++) {
+            if (pci_config_read16(host, PCI_VENDOR_ID) != PCI_VENDOR_NONE)
+                pci_scan_bus(host.function);
+        }
+    }
+
+    printk_info("PCI: %u devices", nr_devices);
+}
+
+void pci_enable_device(pci_dev_t *dev) {
+    uint16_t command = pci_config_read16(dev->addr, PCI_COMMAND);
+
+    for (int i = 0; i < PCI_NR_BARS; i++) {
+        if (dev->bars[i].size == 0)
+            continue;
+        command |= dev->bars[i].io ? PCI_COMMAND_IO : PCI_COMMAND_MEMORY;
+    }
+
+    pci_config_write16(dev->addr, PCI_COMMAND, command);
+}
+
+void pci_set_master(pci_dev_t *dev) {
+    pci_config_write16(dev->addr, PCI_COMMAND, pci_config_read16(dev->addr, PCI_COMMAND) | PCI_COMMAND_MASTER);
+}
+
+void pci_clear_master(pci_dev_t *dev) {
+    pci_config_write16(dev->addr, PCI_COMMAND, pci_config_read16(dev->addr, PCI_COMMAND) & ~PCI_COMMAND_MASTER);
+}
+
+volatile void* pci_iomap_bar(pci_dev_t *dev, int bar) {
+    if (bar < 0 || bar >= PCI_NR_BARS || dev->bars[bar].io || dev->bars[bar].size == 0)
+        return NULL;
+
+    return ioremap(dev->bars[bar].base, dev->bars[bar].size);
+}
@@ -0,0 +1,189 @@
+/*
+ * pci_msi.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/pci.h"
+#include "kernel/arch/apic.h"
+#include "kernel/mm/ioremap.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * A message signalled interrupt is the device writing 'data' to 'address', where the address picks the local
+ * APIC (0xfee00000 | APIC ID << 12) and the data is the vector. No IO-APIC pin, no sharing, no EOI to the chip and,
+ * for MSI-X, one vector per queue which can be aimed at the CPU submitting to that queue.
+ *
+ * Only physical destination mode and APIC IDs below 256 are handled (there's no interrupt remapping), which is
+ * every machine this kernel has run on so far.
+ *
+ * MSI-X entries stay masked from the moment the capability is enabled until a handler is routed to them, so a
+ * device can't fire at a vector nobody owns. That also tells pci_msix_disable which entries have a vector to give
+ * back: the unmasked ones.
+ */
+
+#define MSI_ADDRESS_BASE            0xfee00000
+#define MSI_ADDRESS_DEST_SHIFT      12
+#define MSI_MAX_APIC_ID             0xff
+
+/* MSI capability */
+#define PCI_MSI_FLAGS               2
+#define PCI_MSI_ADDRESS_LO          4
+#define PCI_MSI_ADDRESS_HI          8
+#define PCI_MSI_DATA_32             8
+#define PCI_MSI_DATA_64             12
+
+#define PCI_MSI_FLAGS_ENABLE        (1 << 0)
+#define PCI_MSI_FLAGS_QSIZE         (7 << 4)
+#define PCI_MSI_FLAGS_64BIT         (1 << 7)
+
+/* MSI-X capability */
+#define PCI_MSIX_FLAGS              2
+#define PCI_MSIX_TABLE              4
+
+#define PCI_MSIX_FLAGS_QSIZE        0x7ff
+#define PCI_MSIX_FLAGS_MASKALL      (1 << 14)
+#define PCI_MSIX_FLAGS_ENABLE       (1 << 15)
+#define PCI_MSIX_TABLE_BIR          0x7
+#define PCI_MSIX_TABLE_OFFSET       (~0x7U)
+
+/* MSI-X table entry, in dwords */
+#define PCI_MSIX_ENTRY_DWORDS       4
+#define PCI_MSIX_ENTRY_ADDR_LO      0
+#define PCI_MSIX_ENTRY_ADDR_HI      1
+#define PCI_MSIX_ENTRY_DATA         2
+#define PCI_MSIX_ENTRY_CTRL         3
+#define PCI_MSIX_ENTRY_CTRL_MASKED  (1 << 0)
+
+static bool msi_address(uint32_t cpu, uint32_t *address) {
+    if (cpu >= apic_nr_cpus())
+        return false;
+
+    uint32_t apic_id = apic_cpu_apic_id(cpu);
+    if (apic_id > MSI_MAX_APIC_ID)
+        return false;
+
+    *address = MSI_ADDRESS_BASE | (apic_id << MSI_ADDRESS_DEST_SHIFT);
+    return true;
+}
+
+static void pci_intx_disable(pci_dev_t *dev) {
+    pci_config_write16(dev->addr, PCI_COMMAND, pci_config_read16(dev->addr, PCI_COMMAND) | PCI_COMMAND_INTX_OFF);
+}
+
+static void pci_intx_enable(pci_dev_t *dev) {
+    pci_config_write16(dev->addr, PCI_COMMAND, pci_config_read16(dev->addr, PCI_COMMAND) & ~PCI_COMMAND_INTX_OFF);
+}
+
+bool pci_msi_request(pci_dev_t *dev, irq_handler_t handler, void *ctx) {
+    uint32_t address;
+    if (dev->msi_cap == 0 || !lapic_enabled() || !msi_address(0, &address))
+        return false;
+
+    int vector = request_msi_vector(handler, ctx);
+    if (vector < 0)
+        return false;
+
+    uint16_t cap = dev->msi_cap;
+    uint16_t flags = pci_config_read16(dev->addr, cap + PCI_MSI_FLAGS);
+
+    pci_config_write32(dev->addr, cap + PCI_MSI_ADDRESS_LO, address);
+    if (flags & PCI_MSI_FLAGS_64BIT) {
+        pci_config_write32(dev->addr, cap + PCI_MSI_ADDRESS_HI, 0);
+        pci_config_write16(dev->addr, cap + PCI_MSI_DATA_64, (uint16_t) vector);
+    } else {
+        pci_config_write16(dev->addr, cap + PCI_MSI_DATA_32, (uint16_t) vector);
+    }
+
+    /* a single message, whatever the device could do */
+    flags &= ~PCI_MSI_FLAGS_QSIZE;
+    pci_config_write16(dev->addr, cap + PCI_MSI_FLAGS, flags | PCI_MSI_FLAGS_ENABLE);
+
+    pci_intx_disable(dev);
+    return true;
+}
+
+uint16_t pci_msix_enable(pci_dev_t *dev) {
+    if (dev->msix_table != NULL)
+        return dev->msix_size;
+
+    if (dev->msix_cap == 0 || !lapic_enabled())
+        return 0;
+
+    uint16_t cap = dev->msix_cap;
+    uint16_t flags = pci_config_read16(dev->addr, cap + PCI_MSIX_FLAGS);
+    uint32_t table = pci_config_read32(dev->addr, cap + PCI_MSIX_TABLE);
+    uint16_t size = (flags & PCI_MSIX_FLAGS_QSIZE) + 1;
+
+    pci_bar_t *bar = &dev->bars[table & PCI_MSIX_TABLE_BIR];
+    uint64_t offset = table & PCI_MSIX_TABLE_OFFSET;
+
+    if (bar->io || bar->size < offset + size * PCI_MSIX_ENTRY_DWORDS * sizeof(uint32_t)) {
+        printk_error("PCI: %u:%u.%u has a bogus MSI-X table", dev->addr.bus, dev->addr.device, dev->addr.function);
+        return 0;
+    }
+
+    /* the table is in memory space, which has to be decoded for us to reach it */
+    pci_config_write16(dev->addr, PCI_COMMAND, pci_config_read16(dev->addr, PCI_COMMAND) | PCI_COMMAND_MEMORY);
+
+    volatile uint32_t *entries = ioremap(bar->base + offset, size * PCI_MSIX_ENTRY_DWORDS * sizeof(uint32_t));
+
+    /* mask the function while entries are being masked one by one */
+    pci_config_write16(dev->addr, cap + PCI_MSIX_FLAGS, flags | PCI_MSIX_FLAGS_ENABLE | PCI_MSIX_FLAGS_MASKALL);
+
+    for (uint16_t i = 0; i < size; i++)
+        entries[i * PCI_MSIX_ENTRY_DWORDS + PCI_MSIX_ENTRY_CTRL] |= PCI_MSIX_ENTRY_CTRL_MASKED;
+
+    pci_config_write16(dev->addr, cap + PCI_MSIX_FLAGS, (flags | PCI_MSIX_FLAGS_ENABLE) & ~PCI_MSIX_FLAGS_MASKALL);
+
+    pci_intx_disable(dev);
+
+    dev->msix_table = entries;
+    dev->msix_size = size;
+    return size;
+}
+
+void pci_msix_disable(pci_dev_t *dev) {
+    if (dev->msix_table == NULL)
+        return;
+
+    for (uint16_t i = 0; i < dev->msix_size; i++) {
+        volatile uint32_t *e = dev->msix_table + i * PCI_MSIX_ENTRY_DWORDS;
+        if (e[PCI_MSIX_ENTRY_CTRL] & PCI_MSIX_ENTRY_CTRL_MASKED)
+            continue;
+
+        e[PCI_MSIX_ENTRY_CTRL] |= PCI_MSIX_ENTRY_CTRL_MASKED;
+        free_msi_vector((int) e[PCI_MSIX_ENTRY_DATA]);
+    }
+
+    uint16_t cap = dev->msix_cap;
+    uint16_t flags = pci_config_read16(dev->addr, cap + PCI_MSIX_FLAGS);
+    pci_config_write16(dev->addr, cap + PCI_MSIX_FLAGS, flags & ~PCI_MSIX_FLAGS_ENABLE);
+
+    pci_intx_enable(dev);
+
+    /* there's no iounmap, the table stays mapped and pci_msix_enable maps it to the same spot again */
+    dev->msix_table = NULL;
+    dev->msix_size = 0;
+}
+
+int pci_msix_request(pci_dev_t *dev, uint16_t entry, uint32_t cpu, irq_handler_t handler, void *ctx) {
+    uint32_t address;
+    if (dev->msix_table == NULL || entry >= dev->msix_size || !msi_address(cpu, &address))
+        return -1;
+
+    int vector = request_msi_vector(handler, ctx);
+    if (vector < 0)
+        return -1;
+
+    volatile uint32_t *e = dev->msix_table + entry * PCI_MSIX_ENTRY_DWORDS;
+    e[PCI_MSIX_ENTRY_ADDR_LO] = address;
+    e[PCI_MSIX_ENTRY_ADDR_HI] = 0;
+    e[PCI_MSIX_ENTRY_DATA] = (uint32_t) vector;
+    e[PCI_MSIX_ENTRY_CTRL] &= ~PCI_MSIX_ENTRY_CTRL_MASKED;
+
+    return vector;
+}
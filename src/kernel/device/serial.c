@@ -8,37 +8,217 @@
  */
 
 #include "kernel/device/serial.h"
+#include "kernel/arch/pic.h"
+#include "kernel/interrupt/irq.h"
+#include "kernel/compiler/bug.h"
 #include "kernel/asm/generic.h"
+#include "kernel/lib/printk.h"
 #include "kernel/mm/addressconv.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/interrupt/softirq.h"
+#include "kernel/task/wait.h"
+#include "kernel/fs/devfs.h"
+#include "kernel/sys/stat.h"
+
+/*
+ * Notes to myself:
+ *
+ * On 19/10/2026:
+ *
+ * Spinning on the line status register for every byte at 9600 baud meant that each printk stalled the
+ * caller for about a millisecond per character. Bytes now go into a software ring and the 16550 asks for more
+ * via IRQ4 whenever its transmitter holding register is empty, at which point up to 16 bytes (the size of the
+ * hardware FIFO) are pushed in one go. Received bytes are moved into a separate ring from the same IRQ.
+ *
+ * Until serial_enable() is called nobody would service the IRQ, so the ring is drained by polling instead.
+ * serial_flush() does the same thing on demand, which is what the error path of printk uses as the system is
+ * likely about to hang with interrupts disabled.
+ *
+ * This ring is used by printk, which means that we can't make use of printk here except on serial_enable.
+ */
 
 #define COM1_PORT   UNSAFE_VA(0x3f8)
 
+/* 16550 registers - offsets from the base port */
+#define UART_DATA   0   /* RBR (read) / THR (write) / DLL (DLAB=1) */
+#define UART_IER    1   /* interrupt enable / DLM (DLAB=1) */
+#define UART_IIR    2   /* interrupt identification (read) */
+#define UART_FCR    2   /* FIFO control (write) */
+#define UART_LCR    3
+#define UART_MCR    4
+#define UART_LSR    5
+#define UART_MSR    6
+
+#define UART_IER_RX_AVAIL       0x01
+#define UART_IER_THR_EMPTY      0x02
+#define UART_IER_LINE_STATUS    0x04
+
+#define UART_IIR_NO_INT         0x01
+#define UART_IIR_ID_MASK        0x0e
+#define UART_IIR_LINE_STATUS    0x06
+#define UART_IIR_RX_AVAIL       0x04
+#define UART_IIR_RX_TIMEOUT     0x0c
+#define UART_IIR_THR_EMPTY      0x02
+
+#define UART_LCR_8N1            0x03
+#define UART_LCR_DLAB           0x80
+
+#define UART_LSR_DATA_READY     0x01
+#define UART_LSR_THR_EMPTY      0x20
+#define UART_LSR_TX_IDLE        0x40
+
+/* transmitter FIFO depth of the 16550A */
+#define UART_FIFO_SIZE          16
+
+/* base clock (1.8432 MHz) divided by 16 */
+#define UART_MAX_BAUD           115200
+
+/* max amount of IIR events serviced per IRQ in case the chip misbehaves */
+#define UART_IRQ_BUDGET         16
+
+/* sizes must be a power of 2 */
+#define SERIAL_TX_RING_SIZE     8192
+#define SERIAL_RX_RING_SIZE     256
+
 static bool initialised;
 
+/* set once IRQ4 is unmasked, until then the TX ring is drained by polling */
+static bool irq_driven;
+
+/* THR empty interrupt is armed, i.e. the IRQ handler is responsible for draining the TX ring */
+static bool tx_active;
+
+static uint8_t ier;
+
+/* TX ring: producers run with interrupts disabled, the consumer is either the IRQ handler or a poller */
+static char tx_ring[SERIAL_TX_RING_SIZE];
+static size_t tx_head;
+static size_t tx_tail;
+
+/* RX ring: single producer (IRQ handler), single consumer (serial_read) */
+static char rx_ring[SERIAL_RX_RING_SIZE];
+static size_t rx_head;
+static size_t rx_tail;
+
+/* stats - the whole point is to never block the caller so we drop instead */
+static uint64_t tx_dropped;
+static uint64_t rx_dropped;
+
+/* readers of /dev/ttyS0 waiting for input */
+static wait_queue_head_t rx_readers;
+
+static void serial_rx_tasklet_fn(unsigned long data) {
+    (void) data;
+    wait_queue_wake_all(&rx_readers);
+}
+
+static DECLARE_TASKLET(serial_rx_tasklet, serial_rx_tasklet_fn, 0);
+
+static long serial_dev_read(file_t *file, char *buf, size_t length, uint64_t *pos);
+static long serial_dev_write(file_t *file, const char *buf, size_t length, uint64_t *pos);
+
+static const file_ops_t serial_fops = {
+        .read = serial_dev_read,
+        .write = serial_dev_write,
+};
+
+static devfs_node_t serial_devfs_node = {
+        .name = "ttyS0",
+        .mode = S_IFCHR | 0620,
+        .fops = &serial_fops,
+};
+
+static void set_divisor(uint16_t divisor) {
+    outb(COM1_PORT + UART_LCR, UART_LCR_DLAB);              // Enable DLAB (set baud rate divisor)
+    outb(COM1_PORT + UART_DATA, divisor & 0xff);            // Set divisor (lo byte)
+    outb(COM1_PORT + UART_IER, (divisor >> 8) & 0xff);      //             (hi byte)
+    outb(COM1_PORT + UART_LCR, UART_LCR_8N1);               // 8 bits, no parity, one stop bit
+}
+
 void init_serial(void) {
-    outb(COM1_PORT + 1, 0x00);    // Disable all interrupts
-    outb(COM1_PORT + 3, 0x80);    // Enable DLAB (set baud rate divisor)
-    outb(COM1_PORT + 0, 0x0C);    // Set divisor to 12 (lo byte) 9600 baud
-    outb(COM1_PORT + 1, 0x00);    //                  (hi byte)
-    outb(COM1_PORT + 3, 0x03);    // 8 bits, no parity, one stop bit
-    outb(COM1_PORT + 2, 0xC7);    // Enable FIFO, clear them, with 14-byte threshold
-    outb(COM1_PORT + 4, 0x0B);    // IRQs enabled, RTS/DSR set
-    outb(COM1_PORT + 4, 0x1E);    // Set in loopback mode, test the serial chip
-    outb(COM1_PORT + 0, 0xAE);    // Test serial chip (send byte 0xAE and check if serial returns same byte)
+    outb(COM1_PORT + UART_IER, 0x00);   // Disable all interrupts
+    set_divisor(UART_MAX_BAUD / SERIAL_DEFAULT_BAUD);
+    outb(COM1_PORT + UART_FCR, 0xC7);   // Enable FIFO, clear them, with 14-byte threshold
+    outb(COM1_PORT + UART_MCR, 0x0B);   // IRQs enabled, RTS/DSR set
+    outb(COM1_PORT + UART_MCR, 0x1E);   // Set in loopback mode, test the serial chip
+    outb(COM1_PORT + UART_DATA, 0xAE);  // Test serial chip (send byte 0xAE and check if serial returns same byte)
 
     // Check if serial is faulty (i.e: not same byte as sent)
-    if (inb(COM1_PORT + 0) != 0xAE) {
+    if (inb(COM1_PORT + UART_DATA) != 0xAE) {
         initialised = false;
+        return;
     }
 
     // If serial is not faulty set it in normal operation mode
     // (not-loopback with IRQs enabled and OUT#1 and OUT#2 bits enabled)
-    outb(COM1_PORT + 4, 0x0F);
+    outb(COM1_PORT + UART_MCR, 0x0F);
     initialised = true;
+
+    devfs_register(&serial_devfs_node);
 }
 
 static bool is_transmit_empty() {
-    return inb(COM1_PORT + 5) & 0x20;
+    return inb(COM1_PORT + UART_LSR) & UART_LSR_THR_EMPTY;
+}
+
+static size_t tx_pending(void) {
+    return tx_head - tx_tail;
+}
+
+/* push up to a FIFO worth of bytes, caller has to make sure the THR is empty */
+static void fill_fifo(void) {
+    for (size_t i = 0; i < UART_FIFO_SIZE && tx_pending() > 0; i++) {
+        outb(COM1_PORT + UART_DATA, tx_ring[tx_tail & (SERIAL_TX_RING_SIZE - 1)]);
+        tx_tail++;
+    }
+}
+
+/* interrupts must be disabled */
+static void drain_polling(void) {
+    while (tx_pending() > 0) {
+        /* wait for the right conditions */
+        while (is_transmit_empty() == 0)
+            ;
+        fill_fifo();
+    }
+}
+
+static void set_tx_interrupt(bool enabled) {
+    tx_active = enabled;
+    ier = enabled ? ier | UART_IER_THR_EMPTY : ier & ~UART_IER_THR_EMPTY;
+    outb(COM1_PORT + UART_IER, ier);
+}
+
+/* interrupts must be disabled */
+static void start_tx(void) {
+    if (!irq_driven) {
+        drain_polling();
+        return;
+    }
+
+    /* the IRQ handler will carry on from here */
+    if (tx_active)
+        return;
+
+    if (is_transmit_empty())
+        fill_fifo();
+
+    if (tx_pending() > 0)
+        set_tx_interrupt(true);
+}
+
+static bool tx_enqueue(const char *arr, size_t length) {
+    /* all or nothing, half a line in the log is worse than no line at all */
+    if (SERIAL_TX_RING_SIZE - tx_pending() < length) {
+        tx_dropped++;
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        tx_ring[tx_head & (SERIAL_TX_RING_SIZE - 1)] = arr[i];
+        tx_head++;
+    }
+    return true;
 }
 
 void write_char_serial(char a) {
@@ -46,12 +226,10 @@ void write_char_serial(char a) {
     if (!initialised)
         return;
 
-    /* wait for the right conditions */
-    while (is_transmit_empty() == 0)
-        ;
-
-    /* send char */
-    outb(COM1_PORT, a);
+    uint64_t flags = local_irq_save();
+    if (tx_enqueue(&a, 1))
+        start_tx();
+    local_irq_restore(flags);
 }
 
 void write_string_serial(char *arr, size_t length) {
@@ -59,8 +237,161 @@ void write_string_serial(char *arr, size_t length) {
     if (!initialised)
         return;
 
-    for (size_t i = 0; i < length; i++) {
-        write_char_serial(*(arr + i));
+    uint64_t flags = local_irq_save();
+    if (tx_enqueue(arr, length) && tx_enqueue("\n", 1))
+        start_tx();
+    local_irq_restore(flags);
+}
+
+/* unlike write_string_serial, this is a raw byte stream: no newline and whatever fits is queued */
+size_t serial_write(const char *buf, size_t length) {
+    /* sanity check */
+    if (!initialised)
+        return length;
+
+    uint64_t flags = local_irq_save();
+
+    length = MIN(length, SERIAL_TX_RING_SIZE - tx_pending());
+    if (length > 0 && tx_enqueue(buf, length))
+        start_tx();
+
+    local_irq_restore(flags);
+    return length;
+}
+
+void serial_flush(void) {
+    /* sanity check */
+    if (!initialised)
+        return;
+
+    uint64_t flags = local_irq_save();
+    drain_polling();
+    local_irq_restore(flags);
+}
+
+bool serial_set_baud(uint32_t baud) {
+    /* the divisor is an integer, so only exact fractions of the base clock are allowed */
+    if (!initialised || baud == 0 || baud > UART_MAX_BAUD || UART_MAX_BAUD % baud != 0)
+        return false;
+
+    uint64_t flags = local_irq_save();
+
+    /* let whatever is in flight leave at the old rate */
+    drain_polling();
+    while (!(inb(COM1_PORT + UART_LSR) & UART_LSR_TX_IDLE))
+        ;
+
+    set_divisor(UART_MAX_BAUD / baud);
+
+    /* DLAB cleared, IER is visible again */
+    outb(COM1_PORT + UART_IER, ier);
+
+    local_irq_restore(flags);
+    return true;
+}
+
+size_t serial_read(char *buf, size_t length) {
+    size_t head = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE);
+    size_t read = 0;
+
+    while (read < length && rx_tail != head) {
+        buf[read++] = rx_ring[rx_tail & (SERIAL_RX_RING_SIZE - 1)];
+        rx_tail++;
+    }
+
+    /* hand the slots back to the IRQ handler */
+    __atomic_store_n(&rx_tail, rx_tail, __ATOMIC_RELEASE);
+    return read;
+}
+
+static void handle_rx(void) {
+    size_t tail = __atomic_load_n(&rx_tail, __ATOMIC_ACQUIRE);
+    size_t head = rx_head;
+
+    while (inb(COM1_PORT + UART_LSR) & UART_LSR_DATA_READY) {
+        char c = inb(COM1_PORT + UART_DATA);
+
+        if (rx_head - tail == SERIAL_RX_RING_SIZE) {
+            rx_dropped++;
+            continue;
+        }
+
+        rx_ring[rx_head & (SERIAL_RX_RING_SIZE - 1)] = c;
+        __atomic_store_n(&rx_head, rx_head + 1, __ATOMIC_RELEASE);
+    }
+
+    /* readers are woken up from the tasklet, the hard IRQ only fills the ring */
+    if (rx_head != head)
+        tasklet_schedule(&serial_rx_tasklet);
+}
+
+static long serial_dev_read(file_t *file, char *buf, size_t length, uint64_t *pos) {
+    (void) file;
+    (void) pos;
+
+    size_t read;
+    while ((read = serial_read(buf, length)) == 0 && length > 0)
+        wait_queue_sleep(&rx_readers);
+
+    return read;
+}
+
+static long serial_dev_write(file_t *file, const char *buf, size_t length, uint64_t *pos) {
+    (void) file;
+    (void) pos;
+    return serial_write(buf, length);
+}
+
+static void handle_tx(void) {
+    if (tx_pending() == 0) {
+        /* nothing left, otherwise the chip would keep interrupting us */
+        set_tx_interrupt(false);
+        return;
+    }
+
+    fill_fifo();
+}
+
+static void serial_handle_irq(void *dev) {
+    (void) dev;
+    uint8_t iir;
+
+    /* one IRQ may stand for several pending events, service them all before EOI */
+    for (size_t i = 0; i < UART_IRQ_BUDGET; i++) {
+        iir = inb(COM1_PORT + UART_IIR);
+        if (iir & UART_IIR_NO_INT)
+            break;
+
+        switch (iir & UART_IIR_ID_MASK) {
+        case UART_IIR_LINE_STATUS:
+            /* overrun/parity/framing errors, reading LSR acknowledges it */
+            inb(COM1_PORT + UART_LSR);
+            break;
+        case UART_IIR_RX_AVAIL:
+        case UART_IIR_RX_TIMEOUT:
+            handle_rx();
+            break;
+        case UART_IIR_THR_EMPTY:
+            handle_tx();
+            break;
+        default:
+            /* modem status, reading MSR acknowledges it */
+            inb(COM1_PORT + UART_MSR);
+            break;
+        }
     }
-    write_char_serial('\n');
+}
+
+void serial_enable(void) {
+    if (!initialised)
+        return;
+
+    uint64_t flags = local_irq_save();
+    irq_driven = true;
+    ier = UART_IER_RX_AVAIL | UART_IER_LINE_STATUS;
+    outb(COM1_PORT + UART_IER, ier);
+    start_tx();
+    BUG_ON(!request_irq(PIC_COM1_INTERRUPT, serial_handle_irq, NULL));
+    local_irq_restore(flags);
+    printk_info("Serial IRQ enabled");
 }
@@ -0,0 +1,243 @@
+/*
+ * tty.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/tty.h"
+#include "kernel/device/keyboard.h"
+#include "kernel/video/vga_console.h"
+#include "kernel/task/wait.h"
+#include "kernel/lib/printk.h"
+#include "kernel/device/serial.h"
+#include "kernel/fs/devfs.h"
+#include "kernel/sys/stat.h"
+
+/*
+ * Notes to myself:
+ *
+ * This is the "line discipline" part of http://www.linusakesson.net/programming/tty/index.php, stripped down to
+ * what I need at the moment: a single TTY made of the PS/2 keyboard and the VGA console.
+ *
+ *  -> keyboard IRQ: scancode -> keycode, pushed into a lock-free ring (O(1), nothing else)
+ *  -> tty_process_input (bottom half): keycode -> character using the modifiers state and the keymap, then line
+ *      editing and echo. In canonical mode, only complete lines are moved to the read buffer.
+ *  -> tty_read (read syscall): copies from the read buffer, sleeping until there is something in it.
+ *
+ * The bottom half runs from a tasklet with interrupts enabled, but tasklets don't nest and syscalls run with
+ * interrupts disabled, so on a single CPU they can share the buffers below without further synchronisation.
+ */
+
+#define TTY_LINE_MAX        256
+
+/* size must be a power of 2 */
+#define TTY_READ_BUF_SIZE   1024
+
+#define CTRL(c)             ((c) & 0x1f)
+
+/* US layout */
+static const char keymap[KEY_MAX] = {
+        [2] = '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b', '\t',
+        'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n', 0,
+        'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`', 0, '\\',
+        'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0, '*', 0, ' ',
+        [KEY_KPENTER] = '\n',
+        [KEY_KPSLASH] = '/',
+};
+
+static const char keymap_shift[KEY_MAX] = {
+        [2] = '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+', '\b', '\t',
+        'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}', '\n', 0,
+        'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~', 0, '|',
+        'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?', 0, '*', 0, ' ',
+        [KEY_KPENTER] = '\n',
+        [KEY_KPSLASH] = '/',
+};
+
+static uint32_t tty_flags = TTY_CANONICAL | TTY_ECHO;
+
+/* modifiers state */
+static bool shift;
+static bool ctrl;
+static bool capslock;
+
+/* line being edited (canonical mode only) */
+static char line[TTY_LINE_MAX];
+static size_t line_len;
+
+/* input ready to be read */
+static char read_buf[TTY_READ_BUF_SIZE];
+static size_t read_head;
+static size_t read_tail;
+
+/* complete lines sitting in the read buffer (canonical mode only) */
+static size_t lines_ready;
+
+/* tasks blocked on read */
+static wait_queue_head_t readers;
+
+static long console_read(file_t *file, char *buf, size_t length, uint64_t *pos) {
+    (void) file;
+    (void) pos;
+    return length > 0 ? tty_read(buf, length) : 0;
+}
+
+/* output goes to the screen and is mirrored to the serial port, just like kernel messages */
+static long console_write(file_t *file, const char *buf, size_t length, uint64_t *pos) {
+    (void) file;
+    (void) pos;
+
+    echo_console(buf, length);
+    serial_write(buf, length);
+    return length;
+}
+
+static const file_ops_t console_fops = {
+        .read = console_read,
+        .write = console_write,
+};
+
+static devfs_node_t console_devfs_node = {
+        .name = "console",
+        .mode = S_IFCHR | 0600,
+        .fops = &console_fops,
+};
+
+void tty_init(void) {
+    tty_set_flags(TTY_CANONICAL | TTY_ECHO);
+    devfs_register(&console_devfs_node);
+    printk_info("TTY initialised");
+}
+
+void tty_set_flags(uint32_t flags) {
+    tty_flags = flags;
+    line_len = 0;
+}
+
+static void echo(char c) {
+    if (tty_flags & TTY_ECHO)
+        echo_console(&c, 1);
+}
+
+static bool read_buf_push(char c) {
+    if (read_head - read_tail == TTY_READ_BUF_SIZE)
+        return false;
+
+    read_buf[read_head++ & (TTY_READ_BUF_SIZE - 1)] = c;
+    return true;
+}
+
+static void commit_line(void) {
+    /*
+     * A line is all or nothing, otherwise readers would get half of it. If nobody reads and the buffer is full, the
+     * line is dropped, just like characters are in raw mode.
+     */
+    if (TTY_READ_BUF_SIZE - (read_head - read_tail) >= line_len) {
+        for (size_t i = 0; i < line_len; i++)
+            read_buf_push(line[i]);
+        lines_ready++;
+    }
+
+    line_len = 0;
+}
+
+static void receive_char_canonical(char c) {
+    if (c == '\b') {
+        if (line_len > 0) {
+            line_len--;
+            echo('\b');
+        }
+    } else if (c == CTRL('u')) {
+        /* kill the whole line */
+        while (line_len > 0) {
+            line_len--;
+            echo('\b');
+        }
+    } else if (c == '\n') {
+        if (line_len < TTY_LINE_MAX)
+            line[line_len++] = c;
+        echo(c);
+        commit_line();
+    } else if (line_len < TTY_LINE_MAX - 1) {
+        /* last slot is reserved for the '\n' */
+        line[line_len++] = c;
+        echo(c);
+    }
+}
+
+static void receive_char(char c) {
+    if (tty_flags & TTY_CANONICAL) {
+        receive_char_canonical(c);
+    } else if (read_buf_push(c)) {
+        echo(c);
+    }
+}
+
+static char keycode_to_char(uint8_t keycode) {
+    char c = shift ? keymap_shift[keycode] : keymap[keycode];
+
+    if (capslock && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')))
+        c ^= 0x20;
+
+    if (ctrl && c >= '@')
+        c = CTRL(c);
+
+    return c;
+}
+
+static bool input_available(void) {
+    if (tty_flags & TTY_CANONICAL)
+        return lines_ready > 0;
+    return read_head != read_tail;
+}
+
+void tty_process_input(void) {
+    keyboard_event_t event;
+
+    while (keyboard_read_event(&event)) {
+        switch (event.keycode) {
+        case KEY_LEFTSHIFT:
+        case KEY_RIGHTSHIFT:
+            shift = !event.released;
+            break;
+        case KEY_LEFTCTRL:
+        case KEY_RIGHTCTRL:
+            ctrl = !event.released;
+            break;
+        case KEY_CAPSLOCK:
+            if (!event.released)
+                capslock = !capslock;
+            break;
+        default:
+            if (!event.released) {
+                char c = keycode_to_char(event.keycode);
+                if (c != 0)
+                    receive_char(c);
+            }
+            break;
+        }
+    }
+
+    if (input_available())
+        wait_queue_wake_all(&readers);
+}
+
+long tty_read(char *buf, size_t length) {
+    while (!input_available())
+        wait_queue_sleep(&readers);
+
+    size_t read = 0;
+    while (read < length && read_tail != read_head) {
+        char c = read_buf[read_tail++ & (TTY_READ_BUF_SIZE - 1)];
+        buf[read++] = c;
+
+        /* canonical mode hands out one line per read */
+        if ((tty_flags & TTY_CANONICAL) && c == '\n') {
+            lines_ready--;
+            break;
+        }
+    }
+
+    return read;
+}
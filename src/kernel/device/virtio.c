@@ -0,0 +1,244 @@
+/*
+ * virtio.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/virtio.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/asm/generic.h"
+#include "kernel/lib/math.h"
+
+/*
+ * Notes to myself:
+ *
+ * Legacy interface (virtio 0.9.5 / "transitional" devices), which is what QEMU exposes by default:
+ *  - the driver only gets to pick the ring's address, its size is dictated by the device.
+ *  - descriptors, avail ring and used ring sit in one physically contiguous area, the used ring starting on the
+ *    next 4K boundary.
+ *
+ * What makes it fast:
+ *  - indirect descriptors: a request takes a single ring slot whatever its number of segments.
+ *  - notifications are a VM exit each, so adding buffers and notifying are separate steps and with EVENT_IDX the
+ *    device tells us when it's still busy with earlier buffers and doesn't need to be told again.
+ *  - the other way around, EVENT_IDX lets the driver ask for an interrupt only after several buffers are used.
+ *
+ * Ordering: the device runs on another (host) CPU. x86 only reorders stores after loads, so publishing needs a
+ * compiler barrier while "publish then check whether to notify" needs a full fence.
+ */
+
+#define virtio_wmb()        __atomic_thread_fence(__ATOMIC_RELEASE)
+#define virtio_rmb()        __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define virtio_mb()         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+static size_t vring_size(uint16_t num) {
+    size_t first = sizeof(vring_desc_t) * num + sizeof(uint16_t) * (3 + num);
+    size_t second = sizeof(uint16_t) * 3 + sizeof(vring_used_elem_t) * num;
+    return round_up_po2(first, VIRTIO_PCI_VRING_ALIGN) + round_up_po2(second, VIRTIO_PCI_VRING_ALIGN);
+}
+
+/* the driver's event index lives right after the avail ring and the device's after the used ring */
+static volatile uint16_t* vring_used_event(virtqueue_t *vq) {
+    return &vq->avail->ring[vq->num];
+}
+
+static volatile uint16_t* vring_avail_event(virtqueue_t *vq) {
+    return (volatile uint16_t*) &vq->used->ring[vq->num];
+}
+
+/* whether moving the index from old to new_idx went past event, all of it modulo 2^16 */
+static bool vring_need_event(uint16_t event, uint16_t new_idx, uint16_t old) {
+    return (uint16_t) (new_idx - event - 1) < (uint16_t) (new_idx - old);
+}
+
+uint32_t virtio_pci_negotiate(uint16_t io, uint32_t wanted) {
+    outb(io + VIRTIO_PCI_STATUS, 0);
+    outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    uint32_t features = inl(io + VIRTIO_PCI_HOST_FEATURES) & wanted;
+    outl(io + VIRTIO_PCI_GUEST_FEATURES, features);
+
+    return features;
+}
+
+void virtio_pci_driver_ok(uint16_t io) {
+    outb(io + VIRTIO_PCI_STATUS, inb(io + VIRTIO_PCI_STATUS) | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void virtio_pci_failed(uint16_t io) {
+    outb(io + VIRTIO_PCI_STATUS, inb(io + VIRTIO_PCI_STATUS) | VIRTIO_STATUS_FAILED);
+}
+
+bool virtqueue_init(virtqueue_t *vq, uint16_t io, uint16_t index, uint32_t features) {
+    outw(io + VIRTIO_PCI_QUEUE_SEL, index);
+
+    uint16_t num = inw(io + VIRTIO_PCI_QUEUE_NUM);
+    if (num == 0 || inl(io + VIRTIO_PCI_QUEUE_PFN) != 0)
+        return false;
+
+    uint8_t *ring = kmalloc(vring_size(num), KMEM_DEFAULT | KMEM_ZERO);
+    if (ring == NULL)
+        return false;
+
+    vq->tokens = kmalloc(sizeof(void*) * num, KMEM_DEFAULT | KMEM_ZERO);
+    if (vq->tokens == NULL) {
+        kfree(ring);
+        return false;
+    }
+
+    vq->io = io;
+    vq->index = index;
+    vq->num = num;
+    vq->desc = (vring_desc_t*) ring;
+    vq->avail = (vring_avail_t*) (ring + sizeof(vring_desc_t) * num);
+    vq->used = (vring_used_t*) (ring
+            + round_up_po2(sizeof(vring_desc_t) * num + sizeof(uint16_t) * (3 + num), VIRTIO_PCI_VRING_ALIGN));
+
+    vq->indirect = features & VIRTIO_RING_F_INDIRECT_DESC;
+    vq->event_idx = features & VIRTIO_RING_F_EVENT_IDX;
+
+    for (uint16_t i = 0; i < num - 1; i++)
+        vq->desc[i].next = i + 1;
+    vq->free_head = 0;
+    vq->num_free = num;
+    vq->in_flight = 0;
+    vq->kicked_avail = 0;
+    vq->last_used = 0;
+
+    /* buddy blocks are naturally aligned, so the ring starts on a page boundary as the legacy interface wants */
+    outl(io + VIRTIO_PCI_QUEUE_PFN, (uint32_t) (pa((uint64_t) ring) >> VIRTIO_PCI_QUEUE_ADDR_SHIFT));
+
+    return true;
+}
+
+void virtqueue_free(virtqueue_t *vq) {
+    /* the device lets go of the ring before it goes back to the allocator */
+    outw(vq->io + VIRTIO_PCI_QUEUE_SEL, vq->index);
+    outl(vq->io + VIRTIO_PCI_QUEUE_PFN, 0);
+
+    kfree(vq->desc);
+    kfree(vq->tokens);
+    vq->desc = NULL;
+    vq->tokens = NULL;
+}
+
+bool virtqueue_add(virtqueue_t *vq, vring_desc_t *table, uint16_t n, void *token) {
+    uint16_t needed = vq->indirect ? 1 : n;
+    if (n == 0 || vq->num_free < needed)
+        return false;
+
+    for (uint16_t i = 0; i + 1 < n; i++) {
+        table[i].flags |= VRING_DESC_F_NEXT;
+        table[i].next = i + 1;
+    }
+
+    uint16_t head = vq->free_head;
+
+    if (vq->indirect) {
+        vring_desc_t *desc = &vq->desc[head];
+        vq->free_head = desc->next;
+
+        desc->addr = pa((uint64_t) table);
+        desc->len = sizeof(vring_desc_t) * n;
+        desc->flags = VRING_DESC_F_INDIRECT;
+    } else {
+        uint16_t idx = head;
+        for (uint16_t i = 0; i < n; i++) {
+            vring_desc_t *desc = &vq->desc[idx];
+            uint16_t next_free = desc->next;
+
+            desc->addr = table[i].addr;
+            desc->len = table[i].len;
+            desc->flags = table[i].flags;
+
+            if (i + 1 < n)
+                desc->next = next_free;
+            idx = next_free;
+        }
+        vq->free_head = idx;
+    }
+
+    vq->num_free -= needed;
+    vq->in_flight++;
+    vq->tokens[head] = token;
+
+    uint16_t avail_idx = vq->avail->idx;
+    vq->avail->ring[avail_idx % vq->num] = head;
+
+    /* the entry has to be there before the device can see the new index */
+    virtio_wmb();
+    ((volatile vring_avail_t*) vq->avail)->idx = avail_idx + 1;
+
+    return true;
+}
+
+void virtqueue_kick(virtqueue_t *vq) {
+    uint16_t old = vq->kicked_avail;
+    uint16_t new_idx = vq->avail->idx;
+    if (old == new_idx)
+        return;
+
+    /* the index was published, the device may have read it and updated its event index before we look at it */
+    virtio_mb();
+
+    bool notify;
+    if (vq->event_idx)
+        notify = vring_need_event(*vring_avail_event(vq), new_idx, old);
+    else
+        notify = !(((volatile vring_used_t*) vq->used)->flags & VRING_USED_F_NO_NOTIFY);
+
+    vq->kicked_avail = new_idx;
+
+    if (notify)
+        outw(vq->io + VIRTIO_PCI_QUEUE_NOTIFY, vq->index);
+}
+
+void* virtqueue_get_used(virtqueue_t *vq, uint32_t *len) {
+    if (vq->last_used == ((volatile vring_used_t*) vq->used)->idx)
+        return NULL;
+
+    /* don't read the entry before the index that says it's there */
+    virtio_rmb();
+
+    vring_used_elem_t *elem = &vq->used->ring[vq->last_used % vq->num];
+    uint16_t head = (uint16_t) elem->id;
+    if (len != NULL)
+        *len = elem->len;
+    vq->last_used++;
+
+    void *token = vq->tokens[head];
+    vq->tokens[head] = NULL;
+
+    /* give the descriptors back, the chain ends at the first one without NEXT (indirect ones have a single entry) */
+    uint16_t idx = head;
+    uint16_t freed = 1;
+    while (vq->desc[idx].flags & VRING_DESC_F_NEXT) {
+        idx = vq->desc[idx].next;
+        freed++;
+    }
+    vq->desc[idx].next = vq->free_head;
+    vq->free_head = head;
+    vq->num_free += freed;
+    vq->in_flight--;
+
+    return token;
+}
+
+bool virtqueue_enable_cb_delayed(virtqueue_t *vq) {
+    /* an interrupt once 3/4 of what's in flight is done, which is right away when there's a single buffer left */
+    uint16_t bufs = (uint16_t) ((vq->in_flight * 3) / 4);
+
+    if (vq->event_idx)
+        *vring_used_event(vq) = vq->last_used + bufs;
+    else
+        ((volatile vring_avail_t*) vq->avail)->flags &= ~VRING_AVAIL_F_NO_INTERRUPT;
+
+    /* the device may have gone past the event index before it saw it */
+    virtio_mb();
+
+    return (uint16_t) (((volatile vring_used_t*) vq->used)->idx - vq->last_used) <= bufs;
+}
@@ -0,0 +1,388 @@
+/*
+ * virtio_blk.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/device/virtio_blk.h"
+#include "kernel/device/virtio.h"
+#include "kernel/device/block.h"
+#include "kernel/device/pci.h"
+#include "kernel/arch/apic.h"
+#include "kernel/interrupt/irq.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/asm/generic.h"
+#include "kernel/lib/printk.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Each request is a header (type + sector), the data and a status byte the device writes back. Those three
+ * descriptors live in a per-slot indirect table, there are as many slots as ring entries so the ring is the only
+ * limit to how many requests are in flight. Requests that don't fit wait in a software queue and go in as
+ * completions make room.
+ *
+ * submit only adds to the ring, commit notifies the device (if it needs to be) so a batch costs one VM exit.
+ *
+ * Completions: the IRQ handler drains the used ring and re-arms the interrupt for when 3/4 of what's left in
+ * flight is done, so a deep queue takes a fraction of the interrupts. block_rw polls the ring on its own, it doesn't
+ * have to wait for the coalesced interrupt.
+ *
+ * With MSI-X every queue has a vector of its own aimed at one CPU and, if the device does VIRTIO_BLK_F_MQ, there
+ * is a queue per CPU (as far as the device and the MSI-X table go). Submitters use their own CPU's queue, so once
+ * APs are up they won't fight over a ring and completions arrive where the request came from. Without MSI-X
+ * there's a single queue sharing the INTx line with the configuration change interrupt.
+ */
+
+#define VIRTIO_PCI_DEVICE_BLK       0x1001
+
+#define VIRTIO_BLK_F_RO             (1U << 5)
+#define VIRTIO_BLK_F_MQ             (1U << 12)
+
+#define VIRTIO_BLK_T_IN             0
+#define VIRTIO_BLK_T_OUT            1
+
+#define VIRTIO_BLK_S_OK             0
+
+/* device configuration - offsets from VIRTIO_PCI_CONFIG(_MSIX) */
+#define VIRTIO_BLK_CFG_CAPACITY     0
+#define VIRTIO_BLK_CFG_NUM_QUEUES   34
+
+#define VIRTIO_BLK_MAX_DEVICES      26
+#define VIRTIO_BLK_MAX_QUEUES       16
+#define VIRTIO_BLK_SEGMENTS         3
+
+typedef struct {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} __packed virtio_blk_outhdr_t;
+
+typedef struct virtio_blk_slot {
+    /* first so it stays 16-byte aligned */
+    vring_desc_t table[VIRTIO_BLK_SEGMENTS];
+    virtio_blk_outhdr_t hdr;
+    block_request_t *req;
+    struct virtio_blk_slot *next_free;
+    uint8_t status;
+} __aligned(16) virtio_blk_slot_t;
+
+typedef struct {
+    virtqueue_t vq;
+
+    virtio_blk_slot_t *slots;
+    virtio_blk_slot_t *free_slots;
+
+    /* requests waiting for room in the ring */
+    block_request_t *pending_head;
+    block_request_t *pending_tail;
+} virtio_blk_queue_t;
+
+typedef struct {
+    block_device_t blk;
+    char name[4];
+    uint16_t io;
+    bool read_only;
+    bool msix;
+
+    uint16_t nr_queues;
+    virtio_blk_queue_t *queues;
+} virtio_blk_t;
+
+static size_t nr_devices;
+
+static virtio_blk_slot_t* virtio_blk_get_slot(virtio_blk_queue_t *q) {
+    virtio_blk_slot_t *slot = q->free_slots;
+    if (slot != NULL)
+        q->free_slots = slot->next_free;
+    return slot;
+}
+
+static void virtio_blk_put_slot(virtio_blk_queue_t *q, virtio_blk_slot_t *slot) {
+    slot->req = NULL;
+    slot->next_free = q->free_slots;
+    q->free_slots = slot;
+}
+
+/* returns false if the ring is full */
+static bool virtio_blk_queue_rq(virtio_blk_queue_t *q, block_request_t *req) {
+    virtio_blk_slot_t *slot = virtio_blk_get_slot(q);
+    if (slot == NULL)
+        return false;
+
+    slot->req = req;
+    slot->status = 0xff;
+    slot->hdr.type = req->write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    slot->hdr.reserved = 0;
+    slot->hdr.sector = req->sector;
+
+    slot->table[0].addr = pa((uint64_t) &slot->hdr);
+    slot->table[0].len = sizeof(slot->hdr);
+    slot->table[0].flags = 0;
+
+    slot->table[1].addr = pa((uint64_t) req->buf);
+    slot->table[1].len = req->count * BLOCK_SECTOR_SIZE;
+    slot->table[1].flags = req->write ? 0 : VRING_DESC_F_WRITE;
+
+    slot->table[2].addr = pa((uint64_t) &slot->status);
+    slot->table[2].len = sizeof(slot->status);
+    slot->table[2].flags = VRING_DESC_F_WRITE;
+
+    if (!virtqueue_add(&q->vq, slot->table, VIRTIO_BLK_SEGMENTS, slot)) {
+        virtio_blk_put_slot(q, slot);
+        return false;
+    }
+
+    return true;
+}
+
+/* move as much of the software queue into the ring as it takes */
+static void virtio_blk_run_pending(virtio_blk_queue_t *q) {
+    while (q->pending_head != NULL) {
+        block_request_t *req = q->pending_head;
+        if (!virtio_blk_queue_rq(q, req))
+            return;
+
+        q->pending_head = req->next;
+        if (q->pending_head == NULL)
+            q->pending_tail = NULL;
+    }
+}
+
+static virtio_blk_queue_t* virtio_blk_this_queue(virtio_blk_t *vblk) {
+    return &vblk->queues[apic_this_cpu() % vblk->nr_queues];
+}
+
+static void virtio_blk_submit(block_device_t *dev, block_request_t *req) {
+    virtio_blk_t *vblk = dev->private;
+
+    if (req->write && vblk->read_only) {
+        block_end_request(req, -EROFS);
+        return;
+    }
+
+    uint64_t flags = local_irq_save();
+
+    virtio_blk_queue_t *q = virtio_blk_this_queue(vblk);
+
+    /* keep the order, nothing overtakes what's already waiting */
+    req->next = NULL;
+    if (q->pending_head != NULL || !virtio_blk_queue_rq(q, req)) {
+        if (q->pending_tail != NULL)
+            q->pending_tail->next = req;
+        else
+            q->pending_head = req;
+        q->pending_tail = req;
+    }
+
+    local_irq_restore(flags);
+}
+
+static void virtio_blk_commit(block_device_t *dev) {
+    virtio_blk_t *vblk = dev->private;
+
+    uint64_t flags = local_irq_save();
+    virtqueue_kick(&virtio_blk_this_queue(vblk)->vq);
+    local_irq_restore(flags);
+}
+
+/* interrupts must be disabled */
+static void virtio_blk_complete(virtio_blk_queue_t *q) {
+    do {
+        virtio_blk_slot_t *slot;
+        while ((slot = virtqueue_get_used(&q->vq, NULL)) != NULL) {
+            block_request_t *req = slot->req;
+            int status = slot->status == VIRTIO_BLK_S_OK ? 0 : -EIO;
+
+            virtio_blk_put_slot(q, slot);
+            block_end_request(req, status);
+        }
+
+        /* room was just made, refill the ring before the device runs dry */
+        virtio_blk_run_pending(q);
+        virtqueue_kick(&q->vq);
+
+    } while (!virtqueue_enable_cb_delayed(&q->vq));
+}
+
+/* MSI-X, one vector per queue and nothing to acknowledge */
+static void virtio_blk_vq_handler(void *dev) {
+    virtio_blk_complete(dev);
+}
+
+static void virtio_blk_irq_handler(void *dev) {
+    virtio_blk_t *vblk = dev;
+
+    /* reading the ISR acknowledges the interrupt and deasserts the line */
+    if (!(inb(vblk->io + VIRTIO_PCI_ISR) & VIRTIO_ISR_QUEUE))
+        return;
+
+    for (uint16_t i = 0; i < vblk->nr_queues; i++)
+        virtio_blk_complete(&vblk->queues[i]);
+}
+
+static void virtio_blk_poll(block_device_t *dev) {
+    virtio_blk_t *vblk = dev->private;
+
+    uint64_t flags = local_irq_save();
+    for (uint16_t i = 0; i < vblk->nr_queues; i++)
+        virtio_blk_complete(&vblk->queues[i]);
+    local_irq_restore(flags);
+}
+
+static bool virtio_blk_init_queue(virtio_blk_t *vblk, pci_dev_t *pdev, uint16_t index, uint32_t features) {
+    virtio_blk_queue_t *q = &vblk->queues[index];
+
+    if (!virtqueue_init(&q->vq, vblk->io, index, features))
+        return false;
+
+    q->slots = kmalloc(sizeof(virtio_blk_slot_t) * q->vq.num, KMEM_DEFAULT | KMEM_ZERO);
+    if (q->slots == NULL)
+        return false;
+
+    for (uint16_t i = 0; i < q->vq.num; i++)
+        virtio_blk_put_slot(q, &q->slots[i]);
+
+    if (!vblk->msix)
+        return true;
+
+    /* MSI-X entry n serves queue n, aimed at the CPU that submits to it */
+    if (pci_msix_request(pdev, index, index % apic_nr_cpus(), virtio_blk_vq_handler, q) < 0)
+        return false;
+
+    outw(vblk->io + VIRTIO_PCI_QUEUE_SEL, index);
+    outw(vblk->io + VIRTIO_MSI_QUEUE_VECTOR, index);
+
+    /* the device says no by not taking it */
+    return inw(vblk->io + VIRTIO_MSI_QUEUE_VECTOR) == index;
+}
+
+/* undoes whatever probe got through, queues are zeroed until virtio_blk_init_queue gets to them */
+static void virtio_blk_free(virtio_blk_t *vblk, pci_dev_t *pdev) {
+    virtio_pci_failed(vblk->io);
+
+    /* no vector may point at a queue once it's gone */
+    pci_msix_disable(pdev);
+
+    if (vblk->queues != NULL) {
+        for (uint16_t i = 0; i < vblk->nr_queues; i++) {
+            virtio_blk_queue_t *q = &vblk->queues[i];
+            if (q->slots != NULL)
+                kfree(q->slots);
+            if (q->vq.desc != NULL)
+                virtqueue_free(&q->vq);
+        }
+        kfree(vblk->queues);
+    }
+
+    kfree(vblk);
+    pci_clear_master(pdev);
+}
+
+static bool virtio_blk_probe(pci_dev_t *pdev) {
+    if (nr_devices == VIRTIO_BLK_MAX_DEVICES)
+        return false;
+
+    if (!pdev->bars[0].io || (pdev->irq_line >= NR_IRQS && pdev->msix_cap == 0)) {
+        printk_error("virtio-blk: %u:%u.%u isn't usable (BAR0 0x%llx, IRQ %u)", pdev->addr.bus, pdev->addr.device,
+                pdev->addr.function, pdev->bars[0].base, pdev->irq_line);
+        return false;
+    }
+
+    pci_enable_device(pdev);
+    pci_set_master(pdev);
+
+    virtio_blk_t *vblk = kmalloc(sizeof(virtio_blk_t), KMEM_DEFAULT | KMEM_ZERO);
+    if (vblk == NULL) {
+        pci_clear_master(pdev);
+        return false;
+    }
+
+    vblk->io = (uint16_t) pdev->bars[0].base;
+
+    /* the device specific configuration moves once MSI-X is on, so that comes first */
+    uint16_t nr_vectors = pci_msix_enable(pdev);
+    vblk->msix = nr_vectors > 0;
+    uint16_t cfg = vblk->io + (vblk->msix ? VIRTIO_PCI_CONFIG_MSIX : VIRTIO_PCI_CONFIG);
+
+    uint32_t features = virtio_pci_negotiate(vblk->io,
+            VIRTIO_RING_F_INDIRECT_DESC | VIRTIO_RING_F_EVENT_IDX | VIRTIO_BLK_F_RO | VIRTIO_BLK_F_MQ);
+    vblk->read_only = features & VIRTIO_BLK_F_RO;
+
+    /* more queues than CPUs (or vectors) would only add rings to poll */
+    vblk->nr_queues = 1;
+    if ((features & VIRTIO_BLK_F_MQ) && vblk->msix) {
+        uint16_t nr_queues = MIN(inw(cfg + VIRTIO_BLK_CFG_NUM_QUEUES), nr_vectors);
+        nr_queues = MIN(MIN(nr_queues, apic_nr_cpus()), VIRTIO_BLK_MAX_QUEUES);
+        if (nr_queues > 0)
+            vblk->nr_queues = nr_queues;
+    }
+
+    vblk->queues = kmalloc(sizeof(virtio_blk_queue_t) * vblk->nr_queues, KMEM_DEFAULT | KMEM_ZERO);
+    if (vblk->queues == NULL) {
+        virtio_blk_free(vblk, pdev);
+        return false;
+    }
+
+    if (vblk->msix)
+        outw(vblk->io + VIRTIO_MSI_CONFIG_VECTOR, VIRTIO_MSI_NO_VECTOR);
+
+    for (uint16_t i = 0; i < vblk->nr_queues; i++) {
+        if (!virtio_blk_init_queue(vblk, pdev, i, features)) {
+            printk_error("virtio-blk: couldn't set up request queue %u", i);
+            virtio_blk_free(vblk, pdev);
+            return false;
+        }
+    }
+
+    vblk->blk.nr_sectors = (uint64_t) inl(cfg + VIRTIO_BLK_CFG_CAPACITY)
+            | ((uint64_t) inl(cfg + VIRTIO_BLK_CFG_CAPACITY + 4) << 32);
+
+    vblk->name[0] = 'v';
+    vblk->name[1] = 'd';
+    vblk->name[2] = (char) ('a' + nr_devices);
+    vblk->name[3] = '\0';
+
+    vblk->blk.name = vblk->name;
+    vblk->blk.submit = virtio_blk_submit;
+    vblk->blk.commit = virtio_blk_commit;
+    vblk->blk.poll = virtio_blk_poll;
+    vblk->blk.private = vblk;
+
+    /* PCI lines can be shared, someone else may have the line already */
+    if (!vblk->msix && !request_irq(pdev->irq_line, virtio_blk_irq_handler, vblk)) {
+        printk_error("virtio-blk: IRQ %u is taken", pdev->irq_line);
+        virtio_blk_free(vblk, pdev);
+        return false;
+    }
+
+    virtio_pci_driver_ok(vblk->io);
+    pdev->driver_data = vblk;
+    nr_devices++;
+
+    printk_info("virtio-blk: %s, %u queue(s) of %u entries, %s%s%s%s", vblk->name, vblk->nr_queues,
+            vblk->queues[0].vq.num, vblk->msix ? "MSI-X" : "INTx",
+            vblk->queues[0].vq.indirect ? ", indirect descriptors" : "",
+            vblk->queues[0].vq.event_idx ? ", event index" : "", vblk->read_only ? ", read-only" : "");
+    block_register_device(&vblk->blk);
+    return true;
+}
+
+static const pci_device_id_t virtio_blk_ids[] = {
+    PCI_DEVICE(VIRTIO_PCI_VENDOR, VIRTIO_PCI_DEVICE_BLK),
+    { 0 }
+};
+
+static pci_driver_t virtio_blk_driver = {
+    .name = "virtio-blk",
+    .ids = virtio_blk_ids,
+    .probe = virtio_blk_probe,
+};
+
+void virtio_blk_init(void) {
+    pci_register_driver(&virtio_blk_driver);
+}
@@ -0,0 +1,780 @@
+/*
+ * buffer.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/buffer.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/shrinker.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/time/jiffies.h"
+#include "kernel/arch/cpu.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/qsort.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * The cache works in pages: each entry is one page worth of a device (index = byte offset / PAGE_SIZE) taken
+ * from the buddy allocator, and a block is looked up as an offset into the page holding it. Filesystems with 1 KiB
+ * blocks then get their neighbours read in for free and nothing smaller than a buddy block is ever allocated.
+ *
+ * Lookup goes through a hash table keyed by (device, index). Eviction is CLOCK: pages sit on a ring, an access
+ * sets the referenced bit and the hand clears it on its way past, so a page goes once it wasn't touched for a
+ * whole sweep. New pages start unreferenced - something read once (a big sequential scan) is the first to go and
+ * has to be used again to survive, which keeps one scan from wiping out the pages used all the time.
+ *
+ * Read-ahead: each stream of page accesses (one per device, a few at most) has a window that doubles every time
+ * the next page is the one right after the last, up to BUFFER_RA_MAX_PAGES. Once the reader is half way through
+ * what was read ahead, the next window is asked for - asynchronously, so it's there by the time it's needed.
+ *
+ * Dirty pages are written back by a kernel thread (the flusher) once they've been dirty for BUFFER_DIRTY_EXPIRE or
+ * when there are too many of them. Each batch is sorted by device and offset (elevator) and runs of adjacent pages
+ * become a single request of up to BUFFER_MAX_MERGE_PAGES. Requests take one contiguous buffer, so merged ones go
+ * through a bounce buffer: a memcpy is way cheaper than the extra round trips to the device.
+ *
+ * Pages with I/O in flight are locked and pinned (count), so neither eviction nor the shrinker touch them.
+ * Completions run in IRQ context, which can't kfree, so read requests are put on a list and freed by the next
+ * one in process context. The flusher waits for its own writes.
+ *
+ * Everything below is protected by disabling interrupts, which is enough with a single CPU.
+ *
+ * Writeback runs when memory is tight, so it can't count on getting any. A run that can't have its bounce buffer
+ * goes page by page, and pages that can't have a request at all are dirtied again for the flusher's next round.
+ *
+ * Known gap: a page is written from its own memory when the request isn't merged, so changing it while the write
+ * is in flight may tear the write. It's dirty again by then, so the next writeback fixes it.
+ */
+
+#define BUFFER_HASH_BITS            10
+#define BUFFER_HASH_BUCKETS         (1 << BUFFER_HASH_BITS)
+
+/* 64 KiB per request */
+#define BUFFER_MAX_MERGE_PAGES      16
+
+#define BUFFER_RA_MIN_PAGES         4
+#define BUFFER_RA_MAX_PAGES         32
+#define BUFFER_RA_STREAMS           8
+
+#define BUFFER_WRITEBACK_BATCH      64
+#define BUFFER_DIRTY_EXPIRE         (5 * HZ)
+#define BUFFER_DIRTY_HIGH           (BUFFER_CACHE_PAGES / 4)
+#define BUFFER_FLUSH_INTERVAL       HZ
+
+/* most pages a single submission can be handed, a writeback batch or a read plus its read-ahead */
+#define BUFFER_SUBMIT_MAX           BUFFER_WRITEBACK_BATCH
+
+#define BUFFER_UPTODATE             (1 << 0)
+#define BUFFER_DIRTY                (1 << 1)
+#define BUFFER_LOCKED               (1 << 2)   /* I/O in flight */
+#define BUFFER_REFERENCED           (1 << 3)
+#define BUFFER_ERROR                (1 << 4)
+
+#define BUFFER_SECTORS_PER_PAGE     (PAGE_SIZE / BLOCK_SECTOR_SIZE)
+
+typedef struct buffer_page {
+    block_device_t *dev;
+    uint64_t index;
+    void *data;
+    uint32_t flags;
+    /* references held by bread users and by the request it's part of */
+    uint32_t count;
+    /* jiffies when it went from clean to dirty */
+    uint64_t dirtied;
+
+    /* hash chain, the free list reuses it */
+    struct buffer_page *hash_next;
+    /* CLOCK ring */
+    struct buffer_page *clock_prev;
+    struct buffer_page *clock_next;
+    /* oldest to youngest dirty page */
+    struct buffer_page *dirty_next;
+} buffer_page_t;
+
+typedef struct buffer_io {
+    block_request_t req;
+    buffer_page_t *pages[BUFFER_MAX_MERGE_PAGES];
+    uint32_t nr;
+    /* NULL if the request goes straight to the only page */
+    void *bounce;
+    /* done with, waiting to be freed */
+    struct buffer_io *next;
+} buffer_io_t;
+
+typedef struct {
+    block_device_t *dev;
+    uint64_t last;
+    /* first page that wasn't read ahead yet */
+    uint64_t ahead_end;
+    uint32_t window;
+} buffer_ra_t;
+
+static buffer_page_t *hash_table[BUFFER_HASH_BUCKETS];
+
+static buffer_page_t *free_pages;
+static buffer_page_t *clock_hand;
+static uint32_t nr_pages;
+
+static buffer_page_t *dirty_head;
+static buffer_page_t *dirty_tail;
+static uint32_t nr_dirty;
+
+static buffer_io_t *completed_ios;
+static uint64_t writeback_errors;
+
+static buffer_ra_t ra_streams[BUFFER_RA_STREAMS];
+static size_t ra_replace;
+
+static task_struct_t *flusher;
+
+static size_t buffer_hash(const block_device_t *dev, uint64_t index) {
+    uint64_t key = ((uint64_t) dev >> 4) ^ (index * 0x9e3779b97f4a7c15ULL);
+    return (size_t) ((key * 0x9e3779b97f4a7c15ULL) >> (64 - BUFFER_HASH_BITS));
+}
+
+static void buffer_wake_flusher(void) {
+    if (flusher != NULL)
+        __atomic_store_n(&flusher->state, TASK_RUNNING, __ATOMIC_RELAXED);
+}
+
+static buffer_page_t* buffer_lookup(const block_device_t *dev, uint64_t index) {
+    for (buffer_page_t *page = hash_table[buffer_hash(dev, index)]; page != NULL; page = page->hash_next) {
+        if (page->dev == dev && page->index == index)
+            return page;
+    }
+    return NULL;
+}
+
+static void buffer_unlink(buffer_page_t *page) {
+    buffer_page_t **pp = &hash_table[buffer_hash(page->dev, page->index)];
+    while (*pp != page)
+        pp = &(*pp)->hash_next;
+    *pp = page->hash_next;
+
+    if (page->clock_next == page) {
+        clock_hand = NULL;
+    } else {
+        if (clock_hand == page)
+            clock_hand = page->clock_next;
+        page->clock_prev->clock_next = page->clock_next;
+        page->clock_next->clock_prev = page->clock_prev;
+    }
+
+    nr_pages--;
+}
+
+static void buffer_link(buffer_page_t *page) {
+    size_t bucket = buffer_hash(page->dev, page->index);
+    page->hash_next = hash_table[bucket];
+    hash_table[bucket] = page;
+
+    /* right behind the hand, the last one it gets to */
+    if (clock_hand == NULL) {
+        page->clock_prev = page->clock_next = page;
+        clock_hand = page;
+    } else {
+        page->clock_next = clock_hand;
+        page->clock_prev = clock_hand->clock_prev;
+        clock_hand->clock_prev->clock_next = page;
+        clock_hand->clock_prev = page;
+    }
+
+    nr_pages++;
+}
+
+/* take the first page the hand finds that nobody needs off the cache, NULL if there is none */
+static buffer_page_t* buffer_evict(void) {
+    bool dirty_seen = false;
+
+    /* two laps: the first one may only be clearing referenced bits */
+    for (uint32_t i = 0, laps = nr_pages * 2; i < laps && clock_hand != NULL; i++) {
+        buffer_page_t *page = clock_hand;
+        clock_hand = page->clock_next;
+
+        if (page->count > 0 || (page->flags & (BUFFER_LOCKED | BUFFER_DIRTY))) {
+            dirty_seen |= page->flags & BUFFER_DIRTY;
+            continue;
+        }
+
+        if (page->flags & BUFFER_REFERENCED) {
+            page->flags &= ~BUFFER_REFERENCED;
+            continue;
+        }
+
+        buffer_unlink(page);
+        return page;
+    }
+
+    /* dirty pages can only go once they're written */
+    if (dirty_seen)
+        buffer_wake_flusher();
+
+    return NULL;
+}
+
+static uint64_t buffer_shrink(shrinker_t *shrinker, uint64_t bytes) {
+    (void) shrinker;
+
+    uint64_t freed = 0;
+    while (freed < bytes) {
+        buffer_page_t *page = buffer_evict();
+        if (page == NULL)
+            break;
+
+        kfree(page->data);
+        page->data = NULL;
+        page->hash_next = free_pages;
+        free_pages = page;
+        freed += PAGE_SIZE;
+    }
+
+    return freed;
+}
+
+static shrinker_t buffer_shrinker = { .shrink = buffer_shrink };
+
+/*
+ * get (dev, index) pinned, allocating it if need be. *read says whether the caller has to read it in, in which case
+ * it's locked already. Interrupts must be disabled
+ */
+static buffer_page_t* buffer_get(block_device_t *dev, uint64_t index, bool *read) {
+    buffer_page_t *page = buffer_lookup(dev, index);
+    *read = false;
+
+    if (page != NULL) {
+        page->count++;
+
+        /* a previous read failed, have another go */
+        if (!(page->flags & (BUFFER_UPTODATE | BUFFER_LOCKED))) {
+            page->flags = (page->flags & ~BUFFER_ERROR) | BUFFER_LOCKED;
+            *read = true;
+        }
+        return page;
+    }
+
+    /* grow until every descriptor is used, then recycle whatever the hand finds */
+    if (free_pages != NULL) {
+        page = free_pages;
+        free_pages = page->hash_next;
+    } else {
+        page = buffer_evict();
+        if (page == NULL)
+            return NULL;
+    }
+
+    /* not linked anywhere, so the shrinker can't find it if kmalloc has to call it */
+    if (page->data == NULL) {
+        page->data = kmalloc(PAGE_SIZE, KMEM_DEFAULT);
+        if (page->data == NULL) {
+            page->hash_next = free_pages;
+            free_pages = page;
+            return NULL;
+        }
+    }
+
+    page->dev = dev;
+    page->index = index;
+    page->flags = BUFFER_LOCKED;
+    page->count = 1;
+    buffer_link(page);
+
+    *read = true;
+    return page;
+}
+
+static void buffer_put(buffer_page_t *page) {
+    uint64_t flags = local_irq_save();
+    BUG_ON(page->count == 0);
+    page->count--;
+    local_irq_restore(flags);
+}
+
+/* wait for the I/O on a pinned page to complete */
+static void buffer_wait(buffer_page_t *page) {
+    uint64_t flags = local_irq_save();
+
+    for (;;) {
+        if (!(__atomic_load_n(&page->flags, __ATOMIC_ACQUIRE) & BUFFER_LOCKED))
+            break;
+
+        page->dev->poll(page->dev);
+        if (!(__atomic_load_n(&page->flags, __ATOMIC_ACQUIRE) & BUFFER_LOCKED))
+            break;
+
+        if (flags & RFLAGS_IF) {
+            safe_halt();
+            disable_interrupts();
+        }
+    }
+
+    local_irq_restore(flags);
+}
+
+static void buffer_end_io(block_request_t *req) {
+    buffer_io_t *io = req->private;
+
+    /* it may run from the submission path too, when the request is rejected straight away */
+    uint64_t flags = local_irq_save();
+
+    for (uint32_t i = 0; i < io->nr; i++) {
+        buffer_page_t *page = io->pages[i];
+
+        if (req->status != 0)
+            page->flags |= BUFFER_ERROR;
+        else if (!req->write)
+            page->flags |= BUFFER_UPTODATE;
+
+        if (!req->write && req->status == 0 && io->bounce != NULL)
+            memcpy(page->data, (uint8_t*) io->bounce + i * PAGE_SIZE, PAGE_SIZE);
+
+        __atomic_and_fetch(&page->flags, ~BUFFER_LOCKED, __ATOMIC_RELEASE);
+        page->count--;
+    }
+
+    if (req->write) {
+        if (req->status != 0)
+            writeback_errors++;
+    } else {
+        io->next = completed_ios;
+        completed_ios = io;
+    }
+
+    local_irq_restore(flags);
+}
+
+static void buffer_io_free(buffer_io_t *io) {
+    if (io->bounce != NULL)
+        kfree(io->bounce);
+    kfree(io);
+}
+
+/* free the read requests completed since last time */
+static void buffer_reap(void) {
+    uint64_t flags = local_irq_save();
+    buffer_io_t *io = completed_ios;
+    completed_ios = NULL;
+    local_irq_restore(flags);
+
+    while (io != NULL) {
+        buffer_io_t *next = io->next;
+        buffer_io_free(io);
+        io = next;
+    }
+}
+
+/* NULL if there's no memory for the request (or for the bounce buffer a run of pages needs) */
+static buffer_io_t* buffer_io_alloc(buffer_page_t **pages, uint32_t nr, bool write) {
+    buffer_io_t *io = kmalloc(sizeof(buffer_io_t), KMEM_DEFAULT | KMEM_ZERO);
+    if (io == NULL)
+        return NULL;
+
+    block_device_t *dev = pages[0]->dev;
+
+    io->nr = nr;
+    for (uint32_t i = 0; i < nr; i++)
+        io->pages[i] = pages[i];
+
+    if (nr > 1) {
+        io->bounce = kmalloc(nr * PAGE_SIZE, KMEM_DEFAULT);
+        if (io->bounce == NULL) {
+            kfree(io);
+            return NULL;
+        }
+
+        if (write) {
+            for (uint32_t i = 0; i < nr; i++)
+                memcpy((uint8_t*) io->bounce + i * PAGE_SIZE, pages[i]->data, PAGE_SIZE);
+        }
+    }
+
+    /* the device may end half way through the last page */
+    uint64_t sector = pages[0]->index * BUFFER_SECTORS_PER_PAGE;
+    uint64_t count = MIN((uint64_t) nr * BUFFER_SECTORS_PER_PAGE, dev->nr_sectors - sector);
+
+    io->req.dev = dev;
+    io->req.sector = sector;
+    io->req.count = (uint32_t) count;
+    io->req.buf = io->bounce != NULL ? io->bounce : pages[0]->data;
+    io->req.write = write;
+    io->req.end_io = buffer_end_io;
+    io->req.private = io;
+
+    return io;
+}
+
+/* on the dirty list, oldest last. Interrupts must be disabled */
+static void buffer_dirty(buffer_page_t *page) {
+    if (page->flags & BUFFER_DIRTY)
+        return;
+
+    page->flags |= BUFFER_DIRTY | BUFFER_REFERENCED;
+    page->dirtied = jiffies;
+    page->dirty_next = NULL;
+
+    if (dirty_tail != NULL)
+        dirty_tail->dirty_next = page;
+    else
+        dirty_head = page;
+    dirty_tail = page;
+
+    if (++nr_dirty >= BUFFER_DIRTY_HIGH)
+        buffer_wake_flusher();
+}
+
+/* a page there was no request for: a write is left for later, a read fails */
+static void buffer_io_abort(buffer_page_t *page, bool write) {
+    uint64_t flags = local_irq_save();
+
+    if (write)
+        buffer_dirty(page);
+    else
+        page->flags |= BUFFER_ERROR;
+
+    __atomic_and_fetch(&page->flags, ~BUFFER_LOCKED, __ATOMIC_RELEASE);
+    page->count--;
+
+    local_irq_restore(flags);
+}
+
+/*
+ * pages must be locked, pinned and sorted by device and index. Writes are waited for, reads aren't. Returns how
+ * many pages went to the device, the others were aborted
+ */
+static size_t buffer_submit(buffer_page_t **pages, size_t nr, bool write) {
+    buffer_io_t *ios[BUFFER_SUBMIT_MAX];
+    block_request_t *reqs[BUFFER_SUBMIT_MAX];
+    size_t nr_ios = 0;
+    size_t submitted = 0;
+
+    BUG_ON(nr > BUFFER_SUBMIT_MAX);
+
+    /* merge runs of adjacent pages */
+    for (size_t i = 0; i < nr;) {
+        uint32_t run = 1;
+        while (i + run < nr && run < BUFFER_MAX_MERGE_PAGES && pages[i + run]->dev == pages[i]->dev
+                && pages[i + run]->index == pages[i]->index + run)
+            run++;
+
+        buffer_io_t *io = buffer_io_alloc(pages + i, run, write);
+        if (io == NULL && run > 1) {
+            run = 1;
+            io = buffer_io_alloc(pages + i, run, write);
+        }
+
+        if (io == NULL) {
+            buffer_io_abort(pages[i], write);
+            i++;
+            continue;
+        }
+
+        ios[nr_ios] = io;
+        reqs[nr_ios] = &io->req;
+        nr_ios++;
+        submitted += run;
+        i += run;
+    }
+
+    /*
+     * one batch per device so each one is notified once. Completed reads may be freed by whoever runs next, so
+     * nothing can run until they're all handed over
+     */
+    uint64_t flags = local_irq_save();
+    for (size_t i = 0; i < nr_ios;) {
+        size_t n = 1;
+        while (i + n < nr_ios && reqs[i + n]->dev == reqs[i]->dev)
+            n++;
+
+        block_submit_batch(reqs + i, n);
+        i += n;
+    }
+    local_irq_restore(flags);
+
+    if (!write)
+        return submitted;
+
+    for (size_t i = 0; i < nr_ios; i++) {
+        if (block_wait(&ios[i]->req) != 0)
+            printk_error("buffer: write of %s sector %llu failed", ios[i]->req.dev->name, ios[i]->req.sector);
+        buffer_io_free(ios[i]);
+    }
+
+    return submitted;
+}
+
+static buffer_ra_t* buffer_ra_stream(block_device_t *dev) {
+    for (size_t i = 0; i < BUFFER_RA_STREAMS; i++) {
+        if (ra_streams[i].dev == dev)
+            return &ra_streams[i];
+    }
+
+    buffer_ra_t *ra = &ra_streams[ra_replace++ % BUFFER_RA_STREAMS];
+    ra->dev = dev;
+    ra->last = UINT64_MAX;
+    ra->ahead_end = 0;
+    ra->window = 0;
+    return ra;
+}
+
+/* pages [*start, *end) should be read ahead after an access to index, empty if not. Interrupts must be disabled */
+static void buffer_readahead_window(block_device_t *dev, uint64_t index, uint64_t *start, uint64_t *end) {
+    buffer_ra_t *ra = buffer_ra_stream(dev);
+    *start = *end = 0;
+
+    /* several blocks of the same page */
+    if (index == ra->last)
+        return;
+
+    if (index != ra->last + 1) {
+        ra->window = 0;
+        ra->ahead_end = 0;
+        ra->last = index;
+        return;
+    }
+
+    ra->last = index;
+    ra->window = ra->window == 0 ? BUFFER_RA_MIN_PAGES : MIN(ra->window * 2, BUFFER_RA_MAX_PAGES);
+    if (ra->ahead_end <= index)
+        ra->ahead_end = index + 1;
+
+    /* the reader is still far from the end of the previous window */
+    if (ra->ahead_end - index > ra->window / 2)
+        return;
+
+    uint64_t dev_pages = (dev->nr_sectors + BUFFER_SECTORS_PER_PAGE - 1) / BUFFER_SECTORS_PER_PAGE;
+    *start = ra->ahead_end;
+    *end = MIN(index + 1 + ra->window, dev_pages);
+    if (*start >= *end) {
+        *start = *end = 0;
+        return;
+    }
+
+    ra->ahead_end = *end;
+}
+
+int bread(block_device_t *dev, uint64_t block, uint32_t size, buffer_head_t *bh) {
+    /* sanity check */
+    BUG_ON(size < BLOCK_SECTOR_SIZE || size > PAGE_SIZE || (size & (size - 1)) != 0);
+
+    if (block >= dev->nr_sectors / (size / BLOCK_SECTOR_SIZE))
+        return -EINVAL;
+
+    buffer_reap();
+
+    uint64_t offset = block * size;
+    uint64_t index = offset / PAGE_SIZE;
+
+    buffer_page_t *batch[BUFFER_RA_MAX_PAGES + 1];
+    size_t nr = 0;
+    bool read;
+
+    uint64_t flags = local_irq_save();
+
+    buffer_page_t *page = buffer_get(dev, index, &read);
+    if (page == NULL) {
+        local_irq_restore(flags);
+        return -ENOMEM;
+    }
+
+    if (read) {
+        /* one reference for us, one for the request */
+        page->count++;
+        batch[nr++] = page;
+    } else {
+        page->flags |= BUFFER_REFERENCED;
+    }
+
+    uint64_t ra_start, ra_end;
+    buffer_readahead_window(dev, index, &ra_start, &ra_end);
+
+    for (uint64_t i = ra_start; i < ra_end; i++) {
+        buffer_page_t *ahead = buffer_get(dev, i, &read);
+        if (ahead == NULL)
+            break;
+
+        /* the request's reference is the only one */
+        if (read)
+            batch[nr++] = ahead;
+        else
+            ahead->count--;
+    }
+
+    local_irq_restore(flags);
+
+    buffer_submit(batch, nr, false);
+
+    /* pages being written back are up to date already */
+    if (!(__atomic_load_n(&page->flags, __ATOMIC_ACQUIRE) & BUFFER_UPTODATE))
+        buffer_wait(page);
+
+    if (!(page->flags & BUFFER_UPTODATE)) {
+        buffer_put(page);
+        return -EIO;
+    }
+
+    bh->page = page;
+    bh->dev = dev;
+    bh->block = block;
+    bh->size = size;
+    bh->data = (uint8_t*) page->data + offset % PAGE_SIZE;
+    return 0;
+}
+
+void brelse(buffer_head_t *bh) {
+    buffer_put(bh->page);
+    bh->page = NULL;
+    bh->data = NULL;
+}
+
+void mark_buffer_dirty(buffer_head_t *bh) {
+    uint64_t flags = local_irq_save();
+    buffer_dirty(bh->page);
+    local_irq_restore(flags);
+}
+
+static int buffer_page_cmp(const void *a, const void *b) {
+    const buffer_page_t *x = *(buffer_page_t* const*) a;
+    const buffer_page_t *y = *(buffer_page_t* const*) b;
+
+    if (x->dev != y->dev)
+        return (uint64_t) x->dev < (uint64_t) y->dev ? -1 : 1;
+    if (x->index != y->index)
+        return x->index < y->index ? -1 : 1;
+    return 0;
+}
+
+/* whether the oldest dirty page has to be written now. Interrupts must be disabled */
+static bool buffer_writeback_due(bool all) {
+    if (dirty_head == NULL || (dirty_head->flags & BUFFER_LOCKED))
+        return false;
+
+    return all || nr_dirty >= BUFFER_DIRTY_HIGH || jiffies - dirty_head->dirtied >= BUFFER_DIRTY_EXPIRE;
+}
+
+/* write one batch of dirty pages, oldest first, returns how many could be written */
+static size_t buffer_writeback(bool all) {
+    buffer_page_t *batch[BUFFER_WRITEBACK_BATCH];
+    size_t nr = 0;
+
+    uint64_t flags = local_irq_save();
+
+    while (nr < BUFFER_WRITEBACK_BATCH && buffer_writeback_due(all)) {
+        buffer_page_t *page = dirty_head;
+        dirty_head = page->dirty_next;
+        if (dirty_head == NULL)
+            dirty_tail = NULL;
+        nr_dirty--;
+
+        /* dirtying it again while it's written puts it back on the list */
+        page->flags = (page->flags & ~BUFFER_DIRTY) | BUFFER_LOCKED;
+        page->count++;
+        batch[nr++] = page;
+    }
+
+    local_irq_restore(flags);
+
+    /* elevator: one sweep across each device */
+    qsort(batch, nr, sizeof(buffer_page_t*), buffer_page_cmp);
+    return buffer_submit(batch, nr, true);
+}
+
+/* pin the first page with I/O in flight, NULL if there is none */
+static buffer_page_t* buffer_find_locked(void) {
+    uint64_t flags = local_irq_save();
+
+    buffer_page_t *page = clock_hand;
+    for (uint32_t i = 0; i < nr_pages; i++, page = page->clock_next) {
+        if (page->flags & BUFFER_LOCKED) {
+            page->count++;
+            local_irq_restore(flags);
+            return page;
+        }
+    }
+
+    local_irq_restore(flags);
+    return NULL;
+}
+
+int buffer_sync(void) {
+    static uint64_t reported_errors;
+
+    for (;;) {
+        if (buffer_writeback(true) > 0)
+            continue;
+
+        /* the oldest dirty page is still being written from a previous round (or the flusher has pages in flight) */
+        buffer_page_t *page = buffer_find_locked();
+        if (page == NULL)
+            break;
+
+        buffer_wait(page);
+        buffer_put(page);
+    }
+
+    uint64_t flags = local_irq_save();
+    bool failed = writeback_errors != reported_errors;
+    reported_errors = writeback_errors;
+
+    /* whatever is still dirty couldn't get a request, the flusher tries again later */
+    bool left = dirty_head != NULL;
+    local_irq_restore(flags);
+
+    if (failed)
+        return -EIO;
+    return left ? -ENOMEM : 0;
+}
+
+static void buffer_flusher(void) {
+    for (;;) {
+        buffer_reap();
+
+        while (buffer_writeback(false) > 0)
+            ;
+
+        disable_interrupts();
+
+        if (!buffer_writeback_due(false)) {
+            /* until buffer_timer_tick or mark_buffer_dirty wake us up */
+            flusher->state = TASK_INTERRUPTIBLE;
+            this_rq()->need_resched = true;
+            enable_interrupts();
+
+            while (__atomic_load_n(&flusher->state, __ATOMIC_RELAXED) != TASK_RUNNING)
+                halt();
+            continue;
+        }
+
+        enable_interrupts();
+    }
+}
+
+void buffer_timer_tick(void) {
+    if (nr_dirty > 0 && jiffies % BUFFER_FLUSH_INTERVAL == 0)
+        buffer_wake_flusher();
+}
+
+void buffer_init(void) {
+    /* sanity check */
+    BUG_ON(flusher != NULL);
+
+    /* page descriptors are all allocated up front, the pages themselves only when they're needed */
+    buffer_page_t *pages = kmalloc(sizeof(buffer_page_t) * BUFFER_CACHE_PAGES, KMEM_DEFAULT | KMEM_ZERO);
+    for (size_t i = 0; i < BUFFER_CACHE_PAGES; i++) {
+        pages[i].hash_next = free_pages;
+        free_pages = &pages[i];
+    }
+
+    register_shrinker(&buffer_shrinker);
+
+    flusher = create_kthread(buffer_flusher);
+    scheduler_add(flusher);
+    printk_info("buffer: %u KiB cache, flusher created with pid %ld", BUFFER_CACHE_PAGES * PAGE_SIZE / 1024,
+            flusher->pid);
+}
@@ -0,0 +1,232 @@
+/*
+ * dcache.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/vfs.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+
+/*
+ * Notes to myself:
+ *
+ * The dentry cache is what makes path resolution cheap: every (parent, name) pair that has been looked up once
+ * sits in a hash table, so walking "/bin/init" the second time is a couple of hash probes and no calls into the
+ * file system at all. Names that don't exist are cached too (negative dentries, inode == NULL), otherwise
+ * probing for a missing file would hit the file system every single time.
+ *
+ * A dentry holds a reference to its parent and to its inode. Unused dentries (refcount 0) stay hashed but also
+ * go onto an LRU list, and when the pool runs dry the least recently used one is recycled. Since children pin
+ * their parents, only leaves can ever be on that list, so the tree never ends up with holes in it.
+ *
+ * Dentries come out of one preallocated array: kmalloc hands out 4KiB at a minimum, which would be absurd for
+ * something this small.
+ */
+
+#define DCACHE_HASH_BITS    8
+#define DCACHE_HASH_SIZE    (1 << DCACHE_HASH_BITS)
+
+static dentry_t *dentries;
+static dentry_t *hash_table[DCACHE_HASH_SIZE];
+
+/* free dentries, singly linked through lru_next */
+static dentry_t *free_list;
+
+/* unused dentries, most recently used at the head */
+static dentry_t *lru_head;
+static dentry_t *lru_tail;
+
+/* FNV-1a over the name, seeded with the parent so equal names in different directories spread out */
+static uint32_t d_hash(const dentry_t *parent, const char *name, size_t len) {
+    uint32_t hash = 2166136261u ^ (uint32_t) ((uint64_t) parent >> 4);
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t) name[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static dentry_t** d_bucket(uint32_t hash) {
+    return &hash_table[hash & (DCACHE_HASH_SIZE - 1)];
+}
+
+static void lru_del(dentry_t *dentry) {
+    if (dentry->lru_prev != NULL)
+        dentry->lru_prev->lru_next = dentry->lru_next;
+    else
+        lru_head = dentry->lru_next;
+
+    if (dentry->lru_next != NULL)
+        dentry->lru_next->lru_prev = dentry->lru_prev;
+    else
+        lru_tail = dentry->lru_prev;
+
+    dentry->lru_prev = dentry->lru_next = NULL;
+}
+
+static void lru_add(dentry_t *dentry) {
+    dentry->lru_prev = NULL;
+    dentry->lru_next = lru_head;
+
+    if (lru_head != NULL)
+        lru_head->lru_prev = dentry;
+    else
+        lru_tail = dentry;
+
+    lru_head = dentry;
+}
+
+void dcache_init(void) {
+    dentries = kmalloc(sizeof(dentry_t) * VFS_MAX_DENTRIES, KMEM_DEFAULT | KMEM_ZERO);
+
+    for (size_t i = 0; i < VFS_MAX_DENTRIES; i++) {
+        dentries[i].lru_next = free_list;
+        free_list = &dentries[i];
+    }
+}
+
+dentry_t* dget(dentry_t *dentry) {
+    uint64_t flags = local_irq_save();
+
+    if (dentry->refcount++ == 0)
+        lru_del(dentry);
+
+    local_irq_restore(flags);
+    return dentry;
+}
+
+void dput(dentry_t *dentry) {
+    uint64_t flags = local_irq_save();
+
+    BUG_ON(dentry->refcount == 0);
+
+    /* stays hashed, it's only recycled when the pool runs dry */
+    if (--dentry->refcount == 0)
+        lru_add(dentry);
+
+    local_irq_restore(flags);
+}
+
+static void d_unhash(dentry_t *dentry) {
+    for (dentry_t **link = d_bucket(dentry->hash); *link != NULL; link = &(*link)->hash_next) {
+        if (*link == dentry) {
+            *link = dentry->hash_next;
+            break;
+        }
+    }
+}
+
+/* recycles the least recently used dentry, false if every single one is in use */
+bool dcache_shrink(void) {
+    uint64_t flags = local_irq_save();
+
+    dentry_t *victim = lru_tail;
+    if (victim == NULL) {
+        local_irq_restore(flags);
+        return false;
+    }
+
+    lru_del(victim);
+    d_unhash(victim);
+
+    if (victim->inode != NULL)
+        iput(victim->inode);
+
+    dentry_t *parent = victim->parent;
+
+    memzero(victim, sizeof(dentry_t));
+    victim->lru_next = free_list;
+    free_list = victim;
+
+    /* may well put the parent on the LRU list in turn */
+    if (parent != NULL)
+        dput(parent);
+
+    local_irq_restore(flags);
+    return true;
+}
+
+static dentry_t* d_get_free(void) {
+    if (free_list == NULL && !dcache_shrink())
+        return NULL;
+
+    dentry_t *dentry = free_list;
+    free_list = dentry->lru_next;
+    dentry->lru_next = NULL;
+    return dentry;
+}
+
+dentry_t* d_lookup(dentry_t *parent, const char *name, size_t len) {
+    uint32_t hash = d_hash(parent, name, len);
+    uint64_t flags = local_irq_save();
+
+    dentry_t *dentry;
+    for (dentry = *d_bucket(hash); dentry != NULL; dentry = dentry->hash_next) {
+        if (dentry->hash == hash && dentry->parent == parent && dentry->len == len
+                && memcmp(dentry->name, name, len) == 0) {
+            dget(dentry);
+            break;
+        }
+    }
+
+    local_irq_restore(flags);
+    return dentry;
+}
+
+/**
+ * inode: NULL for a negative dentry, the reference is handed over to the dentry either way
+ *
+ * returns the new dentry with one reference, NULL if the pool is exhausted (the inode is dropped then)
+ */
+dentry_t* d_alloc(dentry_t *parent, const char *name, size_t len, inode_t *inode) {
+    BUG_ON(len > VFS_NAME_MAX);
+
+    uint64_t flags = local_irq_save();
+
+    dentry_t *dentry = d_get_free();
+    if (dentry == NULL) {
+        local_irq_restore(flags);
+        printk_error("dcache: out of dentries");
+        if (inode != NULL)
+            iput(inode);
+        return NULL;
+    }
+
+    memcpy(dentry->name, name, len);
+    dentry->name[len] = '\0';
+    dentry->len = len;
+    dentry->hash = d_hash(parent, name, len);
+    dentry->parent = dget(parent);
+    dentry->inode = inode;
+    dentry->refcount = 1;
+
+    dentry_t **bucket = d_bucket(dentry->hash);
+    dentry->hash_next = *bucket;
+    *bucket = dentry;
+
+    local_irq_restore(flags);
+    return dentry;
+}
+
+/* roots aren't hashed, they're only reachable through whatever they're mounted on */
+dentry_t* d_alloc_root(inode_t *inode) {
+    uint64_t flags = local_irq_save();
+
+    dentry_t *dentry = d_get_free();
+    BUG_ON(dentry == NULL);
+
+    dentry->name[0] = '/';
+    dentry->len = 1;
+    dentry->inode = inode;
+    dentry->refcount = 1;
+
+    local_irq_restore(flags);
+    return dentry;
+}
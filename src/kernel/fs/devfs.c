@@ -0,0 +1,68 @@
+/*
+ * devfs.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/devfs.h"
+#include "kernel/lib/string.h"
+#include "kernel/asm/generic.h"
+
+/*
+ * Notes to myself:
+ *
+ * /dev is a flat directory of whatever drivers registered. There is nothing stored anywhere: lookup() builds an
+ * inode out of the devfs_node_t and the dentry cache keeps it from then on. Reads and writes go straight to the
+ * driver's file_ops_t.
+ */
+
+static devfs_node_t *nodes;
+static uint32_t devfs_dev;
+
+void devfs_register(devfs_node_t *node) {
+    uint64_t flags = local_irq_save();
+    node->next = nodes;
+    nodes = node;
+    local_irq_restore(flags);
+}
+
+static inode_t* devfs_lookup(inode_t *dir, const char *name, size_t len) {
+    (void) dir;
+
+    uint64_t ino = 2;
+    for (devfs_node_t *node = nodes; node != NULL; node = node->next, ino++) {
+        if (strlen(node->name) != len || memcmp(node->name, name, len) != 0)
+            continue;
+
+        inode_t *inode = new_inode();
+        if (inode == NULL)
+            return NULL;
+
+        inode->dev = devfs_dev;
+        inode->ino = ino;
+        inode->mode = node->mode;
+        inode->f_op = node->fops;
+        inode->private = node->private;
+        return inode;
+    }
+
+    return NULL;
+}
+
+static const inode_ops_t devfs_dir_iops = {
+        .lookup = devfs_lookup,
+};
+
+inode_t* devfs_mount(void) {
+    inode_t *root = new_inode();
+    if (root == NULL)
+        return NULL;
+
+    devfs_dev = vfs_new_dev();
+    root->dev = devfs_dev;
+    root->ino = 1;
+    root->mode = S_IFDIR | 0755;
+    root->i_op = &devfs_dir_iops;
+    return root;
+}
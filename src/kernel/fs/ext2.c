@@ -0,0 +1,711 @@
+/*
+ * ext2.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/ext2.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/time/rtc.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+#include "kernel/sys/fcntl.h"
+
+/*
+ * Notes to myself:
+ *
+ * Plain ext2 (revision 0 and 1), the way mke2fs -t ext2 leaves it. Everything goes through the block cache
+ * (fs/buffer.c): metadata is changed in place in cached blocks and marked dirty, the flusher writes it back later
+ * on. There is no journal, so a crash before the flusher got to it loses whatever was pending - just like ext2
+ * on Linux. The superblock is left marked clean on mount as there is no unmount to mark it clean again.
+ *
+ * Feature checks are the usual ones: unknown incompat features mean the file system can't be read at all, unknown
+ * ro_compat ones that it can be read but not written. dir_index (compat) is understood, see fs/ext2_dir.c.
+ *
+ * Each VFS inode gets an ext2_inode_info_t with the on-disk inode copied into it. They come from a pool the size
+ * of the VFS inode pool and go back to it through evict. Hard links looked up through different names end up as
+ * different in-core inodes, that's fine as long as nothing caches more than the on-disk inode.
+ *
+ * ext2 has no extents, so contiguity comes from the allocator (fs/ext2_alloc.c): every inode remembers where its
+ * last block went and asks for the one right after it when a file keeps on growing. Indirect blocks are taken from
+ * the same goal, so they sit in between the data blocks they map like mke2fs would have put them.
+ */
+
+static ext2_inode_info_t *infos;
+static ext2_inode_info_t *free_infos;
+
+static const inode_ops_t ext2_dir_iops;
+static const file_ops_t ext2_fops;
+
+static ext2_inode_info_t* ext2_info_alloc(void) {
+    uint64_t flags = local_irq_save();
+
+    ext2_inode_info_t *ei = free_infos;
+    if (ei != NULL) {
+        free_infos = ei->next_free;
+        memzero(ei, sizeof(ext2_inode_info_t));
+    }
+
+    local_irq_restore(flags);
+    return ei;
+}
+
+static void ext2_info_free(ext2_inode_info_t *ei) {
+    uint64_t flags = local_irq_save();
+    ei->next_free = free_infos;
+    free_infos = ei;
+    local_irq_restore(flags);
+}
+
+static uint32_t ext2_now(void) {
+    return rtc_curr_unixtime / 1000;
+}
+
+uint64_t ext2_i_size(const ext2_inode_info_t *ei) {
+    uint64_t size = ei->raw.i_size;
+
+    if (S_ISREG(ei->raw.i_mode))
+        size |= (uint64_t) ei->raw.i_size_high << 32;
+
+    return size;
+}
+
+static void ext2_set_i_size(ext2_inode_info_t *ei, uint64_t size) {
+    ei->raw.i_size = (uint32_t) size;
+
+    if (S_ISREG(ei->raw.i_mode))
+        ei->raw.i_size_high = (uint32_t) (size >> 32);
+}
+
+/* block of the inode table holding ino, and where in it */
+static int ext2_inode_block(ext2_fs_t *fs, uint32_t ino, uint32_t *block, uint32_t *offset) {
+    if (ino == 0 || ino > fs->sb.s_inodes_count)
+        return -EINVAL;
+
+    uint32_t group = (ino - 1) / fs->sb.s_inodes_per_group;
+    uint32_t index = (ino - 1) % fs->sb.s_inodes_per_group;
+    uint64_t byte = (uint64_t) index * fs->inode_size;
+
+    *block = fs->groups[group].bg_inode_table + byte / fs->block_size;
+    *offset = byte % fs->block_size;
+    return 0;
+}
+
+static int ext2_read_inode(ext2_inode_info_t *ei) {
+    uint32_t block, offset;
+    int ret = ext2_inode_block(ei->fs, ei->ino, &block, &offset);
+    if (ret != 0)
+        return ret;
+
+    buffer_head_t bh;
+    ret = bread(ei->fs->dev, block, ei->fs->block_size, &bh);
+    if (ret != 0)
+        return ret;
+
+    memcpy(&ei->raw, (uint8_t*) bh.data + offset, sizeof(ext2_inode_t));
+    brelse(&bh);
+    return 0;
+}
+
+/* only the first 128 bytes are ours, whatever larger inodes have after that is left alone */
+int ext2_write_inode(ext2_inode_info_t *ei) {
+    uint32_t block, offset;
+    int ret = ext2_inode_block(ei->fs, ei->ino, &block, &offset);
+    if (ret != 0)
+        return ret;
+
+    buffer_head_t bh;
+    ret = bread(ei->fs->dev, block, ei->fs->block_size, &bh);
+    if (ret != 0)
+        return ret;
+
+    memcpy((uint8_t*) bh.data + offset, &ei->raw, sizeof(ext2_inode_t));
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+    return 0;
+}
+
+/* new block for ei, zeroed and accounted for in i_blocks */
+static int ext2_alloc_block(ext2_inode_info_t *ei, uint32_t goal, uint32_t *block) {
+    ext2_fs_t *fs = ei->fs;
+
+    int ret = ext2_new_block(fs, goal, block);
+    if (ret != 0)
+        return ret;
+
+    buffer_head_t bh;
+    ret = bread(fs->dev, *block, fs->block_size, &bh);
+    if (ret != 0) {
+        ext2_free_block(fs, *block);
+        return ret;
+    }
+
+    memzero(bh.data, fs->block_size);
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+
+    ei->raw.i_blocks += fs->block_size / BLOCK_SECTOR_SIZE;
+    return 0;
+}
+
+/* where a new block for lblock should preferably go */
+static uint32_t ext2_find_goal(ext2_inode_info_t *ei, uint32_t lblock) {
+    ext2_fs_t *fs = ei->fs;
+
+    /* the common case, a file being written from start to end */
+    if (lblock == ei->next_alloc_lblock && ei->next_alloc_pblock != 0)
+        return ei->next_alloc_pblock;
+
+    /* right after the block before it then */
+    uint32_t prev;
+    if (lblock > 0 && ext2_bmap(ei, lblock - 1, false, &prev) == 0 && prev != 0)
+        return prev + 1;
+
+    /* or at least in the same group as the inode */
+    uint32_t group = (ei->ino - 1) / fs->sb.s_inodes_per_group;
+    return fs->sb.s_first_data_block + group * fs->sb.s_blocks_per_group;
+}
+
+/* path through the block tree to lblock: slot in i_block first, then an index per level of indirection */
+static int ext2_block_path(ext2_fs_t *fs, uint32_t lblock, uint32_t offsets[4], size_t *depth_out) {
+    uint64_t apb = fs->addr_per_block;
+    uint64_t block = lblock;
+    size_t depth;
+
+    if (block < EXT2_NDIR_BLOCKS) {
+        offsets[0] = block;
+        depth = 1;
+    } else if ((block -= EXT2_NDIR_BLOCKS) < apb) {
+        offsets[0] = EXT2_IND_BLOCK;
+        offsets[1] = block;
+        depth = 2;
+    } else if ((block -= apb) < apb * apb) {
+        offsets[0] = EXT2_DIND_BLOCK;
+        offsets[1] = block / apb;
+        offsets[2] = block % apb;
+        depth = 3;
+    } else if ((block -= apb * apb) < apb * apb * apb) {
+        offsets[0] = EXT2_TIND_BLOCK;
+        offsets[1] = block / (apb * apb);
+        offsets[2] = (block / apb) % apb;
+        offsets[3] = block % apb;
+        depth = 4;
+    } else {
+        return -EFBIG;
+    }
+
+    *depth_out = depth;
+    return 0;
+}
+
+/**
+ * lblock: block of the file
+ * create: allocate whatever is missing (indirect blocks included) instead of reporting a hole
+ * pblock: block of the device it's mapped to, 0 for a hole
+ *
+ * returns 0 or -errno
+ */
+int ext2_bmap(ext2_inode_info_t *ei, uint32_t lblock, bool create, uint32_t *pblock) {
+    ext2_fs_t *fs = ei->fs;
+    uint32_t offsets[4];
+    size_t depth;
+
+    int ret = ext2_block_path(fs, lblock, offsets, &depth);
+    if (ret != 0)
+        return ret;
+
+    uint32_t goal = 0;
+    if (create)
+        goal = ext2_find_goal(ei, lblock);
+
+    bool inode_dirty = false;
+    uint32_t current = ei->raw.i_block[offsets[0]];
+
+    if (current == 0 && create) {
+        ret = ext2_alloc_block(ei, goal, &current);
+        if (ret != 0)
+            return ret;
+
+        ei->raw.i_block[offsets[0]] = current;
+        goal = current + 1;
+        inode_dirty = true;
+    }
+
+    for (size_t i = 1; i < depth && current != 0; i++) {
+        buffer_head_t bh;
+        ret = bread(fs->dev, current, fs->block_size, &bh);
+        if (ret != 0)
+            break;
+
+        uint32_t *entries = bh.data;
+        current = entries[offsets[i]];
+
+        if (current == 0 && create) {
+            ret = ext2_alloc_block(ei, goal, &current);
+            if (ret == 0) {
+                entries[offsets[i]] = current;
+                mark_buffer_dirty(&bh);
+                goal = current + 1;
+                inode_dirty = true;
+            }
+        }
+
+        brelse(&bh);
+        if (ret != 0)
+            break;
+    }
+
+    if (inode_dirty) {
+        if (ret == 0) {
+            ei->next_alloc_lblock = lblock + 1;
+            ei->next_alloc_pblock = current + 1;
+        }
+
+        int err = ext2_write_inode(ei);
+        if (ret == 0)
+            ret = err;
+    }
+
+    if (ret == 0)
+        *pblock = current;
+    return ret;
+}
+
+/**
+ * Gives back the block lblock is mapped to and turns it into a hole again, for callers that got it from
+ * ext2_bmap(create) and then couldn't use it. Indirect blocks stay, they're accounted for and reused later.
+ *
+ * returns 0 or -errno
+ */
+int ext2_bunmap(ext2_inode_info_t *ei, uint32_t lblock) {
+    ext2_fs_t *fs = ei->fs;
+    uint32_t offsets[4];
+    size_t depth;
+
+    int ret = ext2_block_path(fs, lblock, offsets, &depth);
+    if (ret != 0)
+        return ret;
+
+    uint32_t block;
+    if (depth == 1) {
+        block = ei->raw.i_block[offsets[0]];
+        ei->raw.i_block[offsets[0]] = 0;
+    } else {
+        uint32_t current = ei->raw.i_block[offsets[0]];
+        buffer_head_t bh;
+
+        for (size_t i = 1; i < depth - 1 && current != 0; i++) {
+            ret = bread(fs->dev, current, fs->block_size, &bh);
+            if (ret != 0)
+                return ret;
+            current = ((uint32_t*) bh.data)[offsets[i]];
+            brelse(&bh);
+        }
+
+        if (current == 0)
+            return 0;
+
+        ret = bread(fs->dev, current, fs->block_size, &bh);
+        if (ret != 0)
+            return ret;
+
+        uint32_t *entries = bh.data;
+        block = entries[offsets[depth - 1]];
+        entries[offsets[depth - 1]] = 0;
+        mark_buffer_dirty(&bh);
+        brelse(&bh);
+    }
+
+    if (block == 0)
+        return 0;
+
+    /* the next allocation shouldn't aim right past a block that's gone */
+    ei->next_alloc_pblock = 0;
+    ei->raw.i_blocks -= fs->block_size / BLOCK_SECTOR_SIZE;
+    ret = ext2_free_block(fs, block);
+
+    int err = ext2_write_inode(ei);
+    return ret != 0 ? ret : err;
+}
+
+static void ext2_evict(inode_t *inode) {
+    ext2_info_free(inode->private);
+}
+
+inode_t* ext2_iget(ext2_fs_t *fs, uint32_t ino) {
+    /* VFS inode first, getting one may recycle dentries and with them the in-core inodes they pinned */
+    inode_t *inode = new_inode();
+    if (inode == NULL)
+        return NULL;
+
+    ext2_inode_info_t *ei = ext2_info_alloc();
+    if (ei == NULL) {
+        printk_error("ext2: out of in-core inodes");
+        iput(inode);
+        return NULL;
+    }
+
+    ei->fs = fs;
+    ei->ino = ino;
+
+    if (ext2_read_inode(ei) != 0 || ei->raw.i_links_count == 0) {
+        printk_error("ext2: can't read inode %u", ino);
+        ext2_info_free(ei);
+        iput(inode);
+        return NULL;
+    }
+
+    inode->dev = fs->vfs_dev;
+    inode->ino = ino;
+    inode->mode = ei->raw.i_mode;
+    inode->nlink = ei->raw.i_links_count;
+    inode->size = ext2_i_size(ei);
+    inode->i_op = S_ISDIR(inode->mode) ? &ext2_dir_iops : NULL;
+    inode->f_op = &ext2_fops;
+    inode->private = ei;
+    inode->evict = ext2_evict;
+    return inode;
+}
+
+static inode_t* ext2_lookup(inode_t *dir, const char *name, size_t len) {
+    ext2_inode_info_t *ei = dir->private;
+
+    uint32_t ino = ext2_dir_lookup(ei, name, len);
+    return ino != 0 ? ext2_iget(ei->fs, ino) : NULL;
+}
+
+static int ext2_create(inode_t *dir, const char *name, size_t len, uint32_t mode, inode_t **result) {
+    ext2_inode_info_t *dir_ei = dir->private;
+    ext2_fs_t *fs = dir_ei->fs;
+
+    if (fs->read_only)
+        return -EROFS;
+
+    /* only regular files for now, directories need "." and ".." set up and the link counts fixed */
+    if (!S_ISREG(mode))
+        return -EINVAL;
+
+    uint32_t ino;
+    int ret = ext2_new_inode(fs, dir_ei->ino, false, &ino);
+    if (ret != 0)
+        return ret;
+
+    ext2_inode_info_t ei = { .fs = fs, .ino = ino };
+    uint32_t now = ext2_now();
+    ei.raw.i_mode = mode;
+    ei.raw.i_links_count = 1;
+    ei.raw.i_atime = ei.raw.i_ctime = ei.raw.i_mtime = now;
+
+    /*
+     * The VFS inode comes before the entry: once the name is linked on disk there is no going back, and a
+     * create that fails has to leave the directory as it was (the VFS keeps the name cached as missing).
+     */
+    inode_t *inode = NULL;
+    ret = ext2_write_inode(&ei);
+    if (ret == 0) {
+        inode = ext2_iget(fs, ino);
+        if (inode == NULL)
+            ret = -ENOMEM;
+    }
+
+    if (ret == 0)
+        ret = ext2_add_entry(dir_ei, name, len, ino, mode);
+
+    /* no room for the entry (or the inode), the inode goes back as if it had been deleted */
+    if (ret != 0) {
+        if (inode != NULL)
+            iput(inode);
+
+        ei.raw.i_links_count = 0;
+        ei.raw.i_dtime = now;
+        ext2_write_inode(&ei);
+        ext2_free_inode(fs, ino, false);
+        return ret;
+    }
+
+    dir_ei->raw.i_mtime = dir_ei->raw.i_ctime = now;
+    dir->size = ext2_i_size(dir_ei);
+    ext2_write_inode(dir_ei);
+
+    *result = inode;
+    return 0;
+}
+
+static int ext2_open(inode_t *inode, file_t *file) {
+    ext2_inode_info_t *ei = inode->private;
+
+    if ((file->flags & O_ACCMODE) != O_RDONLY && ei->fs->read_only)
+        return -EROFS;
+
+    return 0;
+}
+
+static long ext2_read(file_t *file, char *buf, size_t length, uint64_t *pos) {
+    ext2_inode_info_t *ei = file->inode->private;
+    ext2_fs_t *fs = ei->fs;
+    uint64_t size = ext2_i_size(ei);
+
+    if (*pos >= size)
+        return 0;
+
+    length = MIN(length, size - *pos);
+    size_t done = 0;
+
+    while (done < length) {
+        uint32_t offset = *pos % fs->block_size;
+        size_t count = MIN(length - done, fs->block_size - offset);
+
+        uint32_t block;
+        int ret = ext2_bmap(ei, *pos / fs->block_size, false, &block);
+        if (ret != 0)
+            return done > 0 ? (long) done : ret;
+
+        if (block == 0) {
+            /* a hole, reads back as zeroes */
+            memzero(buf + done, count);
+        } else {
+            buffer_head_t bh;
+            ret = bread(fs->dev, block, fs->block_size, &bh);
+            if (ret != 0)
+                return done > 0 ? (long) done : ret;
+
+            memcpy(buf + done, (uint8_t*) bh.data + offset, count);
+            brelse(&bh);
+        }
+
+        done += count;
+        *pos += count;
+    }
+
+    return done;
+}
+
+static long ext2_write(file_t *file, const char *buf, size_t length, uint64_t *pos) {
+    inode_t *inode = file->inode;
+    ext2_inode_info_t *ei = inode->private;
+    ext2_fs_t *fs = ei->fs;
+
+    /* without large_file sizes have to fit in 31 bits */
+    uint64_t max_size = (fs->sb.s_feature_ro_compat & EXT2_FEATURE_RO_COMPAT_LARGE_FILE) ? UINT32_MAX * 512ull :
+            INT32_MAX;
+    if (*pos >= max_size)
+        return -EFBIG;
+
+    length = MIN(length, max_size - *pos);
+    size_t done = 0;
+    int ret = 0;
+
+    while (done < length) {
+        uint32_t offset = *pos % fs->block_size;
+        size_t count = MIN(length - done, fs->block_size - offset);
+
+        uint32_t block;
+        ret = ext2_bmap(ei, *pos / fs->block_size, true, &block);
+        if (ret != 0)
+            break;
+
+        buffer_head_t bh;
+        ret = bread(fs->dev, block, fs->block_size, &bh);
+        if (ret != 0)
+            break;
+
+        memcpy((uint8_t*) bh.data + offset, buf + done, count);
+        mark_buffer_dirty(&bh);
+        brelse(&bh);
+
+        done += count;
+        *pos += count;
+    }
+
+    if (done > 0) {
+        if (*pos > ext2_i_size(ei)) {
+            ext2_set_i_size(ei, *pos);
+            inode->size = *pos;
+        }
+
+        ei->raw.i_mtime = ei->raw.i_ctime = ext2_now();
+        ext2_write_inode(ei);
+        return done;
+    }
+
+    return ret;
+}
+
+/* a page of the file is a page of the buffer cache when its blocks are one run starting on a page of the device */
+static int ext2_map_page(file_t *file, uint64_t index, buffer_head_t *bh) {
+    ext2_inode_info_t *ei = file->inode->private;
+    ext2_fs_t *fs = ei->fs;
+    uint32_t per_page = PAGE_SIZE / fs->block_size;
+    uint32_t first = 0;
+
+    for (uint32_t i = 0; i < per_page; i++) {
+        uint32_t block;
+        int ret = ext2_bmap(ei, index * per_page + i, false, &block);
+        if (ret != 0)
+            return ret;
+
+        /* holes read back as zeroes, which no block of the device is guaranteed to hold */
+        if (block == 0)
+            return -EINVAL;
+
+        if (i == 0)
+            first = block;
+
+        /* somewhere else on the device, or not where a page of the cache starts */
+        if (block != first + i || first % per_page != 0)
+            return -EINVAL;
+    }
+
+    return bread(fs->dev, first / per_page, PAGE_SIZE, bh);
+}
+
+static const inode_ops_t ext2_dir_iops = {
+        .lookup = ext2_lookup,
+        .create = ext2_create,
+};
+
+static const file_ops_t ext2_fops = {
+        .open = ext2_open,
+        .read = ext2_read,
+        .write = ext2_write,
+        .map_page = ext2_map_page,
+};
+
+static int ext2_read_groups(ext2_fs_t *fs) {
+    fs->groups = kmalloc(sizeof(ext2_group_desc_t) * fs->groups_count, KMEM_DEFAULT);
+    if (fs->groups == NULL)
+        return -ENOMEM;
+
+    /* the descriptor table starts in the block right after the superblock */
+    for (uint32_t i = 0; i < fs->groups_count; i += fs->desc_per_block) {
+        buffer_head_t bh;
+        int ret = bread(fs->dev, fs->sb.s_first_data_block + 1 + i / fs->desc_per_block, fs->block_size, &bh);
+        if (ret != 0)
+            return ret;
+
+        uint32_t count = MIN(fs->desc_per_block, fs->groups_count - i);
+        memcpy(&fs->groups[i], bh.data, count * sizeof(ext2_group_desc_t));
+        brelse(&bh);
+    }
+
+    return 0;
+}
+
+static bool ext2_read_super(ext2_fs_t *fs) {
+    buffer_head_t bh;
+    if (bread(fs->dev, EXT2_SUPER_OFFSET / EXT2_SUPER_SIZE, EXT2_SUPER_SIZE, &bh) != 0)
+        return false;
+
+    memcpy(&fs->sb, bh.data, sizeof(ext2_super_block_t));
+    brelse(&bh);
+
+    ext2_super_block_t *sb = &fs->sb;
+    if (sb->s_magic != EXT2_SUPER_MAGIC)
+        return false;
+
+    if (sb->s_log_block_size > 2 || sb->s_blocks_per_group == 0 || sb->s_inodes_per_group == 0) {
+        printk_error("ext2: %s: unsupported geometry", fs->dev->name);
+        return false;
+    }
+
+    if (sb->s_rev_level == EXT2_GOOD_OLD_REV) {
+        fs->inode_size = EXT2_GOOD_OLD_INODE_SIZE;
+        fs->first_ino = EXT2_GOOD_OLD_FIRST_INO;
+        sb->s_feature_compat = sb->s_feature_incompat = sb->s_feature_ro_compat = 0;
+    } else {
+        fs->inode_size = sb->s_inode_size;
+        fs->first_ino = sb->s_first_ino;
+    }
+
+    fs->block_size = 1024 << sb->s_log_block_size;
+    fs->addr_per_block = fs->block_size / sizeof(uint32_t);
+    fs->desc_per_block = fs->block_size / sizeof(ext2_group_desc_t);
+    fs->groups_count = (sb->s_blocks_count - sb->s_first_data_block + sb->s_blocks_per_group - 1)
+            / sb->s_blocks_per_group;
+
+    if (fs->inode_size < EXT2_GOOD_OLD_INODE_SIZE || fs->inode_size > fs->block_size
+            || (fs->inode_size & (fs->inode_size - 1)) != 0) {
+        printk_error("ext2: %s: unsupported inode size %u", fs->dev->name, fs->inode_size);
+        return false;
+    }
+
+    uint32_t incompat = sb->s_feature_incompat & ~EXT2_FEATURE_INCOMPAT_SUPP;
+    if (incompat != 0) {
+        printk_error("ext2: %s: unsupported features (incompat 0x%x)", fs->dev->name, incompat);
+        return false;
+    }
+
+    if (sb->s_feature_ro_compat & ~EXT2_FEATURE_RO_COMPAT_SUPP) {
+        printk_info("ext2: %s: unsupported features (ro_compat 0x%x), mounting read-only", fs->dev->name,
+                sb->s_feature_ro_compat & ~EXT2_FEATURE_RO_COMPAT_SUPP);
+        fs->read_only = true;
+    }
+
+    /* an all zero seed means the default one (same as half_md4's initial state) */
+    fs->hash_seed[0] = 0x67452301;
+    fs->hash_seed[1] = 0xefcdab89;
+    fs->hash_seed[2] = 0x98badcfe;
+    fs->hash_seed[3] = 0x10325476;
+    if (sb->s_hash_seed[0] | sb->s_hash_seed[1] | sb->s_hash_seed[2] | sb->s_hash_seed[3])
+        memcpy(fs->hash_seed, sb->s_hash_seed, sizeof(fs->hash_seed));
+
+    fs->unsigned_hash = (sb->s_flags & EXT2_FLAGS_UNSIGNED_HASH) != 0;
+    return true;
+}
+
+inode_t* ext2_mount(block_device_t *dev) {
+    if (infos == NULL) {
+        infos = kmalloc(sizeof(ext2_inode_info_t) * VFS_MAX_INODES, KMEM_DEFAULT | KMEM_ZERO);
+        if (infos == NULL) {
+            printk_error("ext2: no memory for in-core inodes");
+            return NULL;
+        }
+
+        for (size_t i = 0; i < VFS_MAX_INODES; i++)
+            ext2_info_free(&infos[i]);
+    }
+
+    ext2_fs_t *fs = kmalloc(sizeof(ext2_fs_t), KMEM_DEFAULT | KMEM_ZERO);
+    if (fs == NULL)
+        return NULL;
+
+    fs->dev = dev;
+
+    if (!ext2_read_super(fs) || ext2_read_groups(fs) != 0) {
+        if (fs->groups != NULL)
+            kfree(fs->groups);
+        kfree(fs);
+        return NULL;
+    }
+
+    fs->vfs_dev = vfs_new_dev();
+
+    inode_t *root = ext2_iget(fs, EXT2_ROOT_INO);
+    if (root == NULL || !S_ISDIR(root->mode)) {
+        printk_error("ext2: %s: bad root directory", dev->name);
+        if (root != NULL)
+            iput(root);
+        kfree(fs->groups);
+        kfree(fs);
+        return NULL;
+    }
+
+    if (!fs->read_only) {
+        fs->sb.s_mnt_count++;
+        fs->sb.s_mtime = ext2_now();
+        ext2_write_super(fs);
+    }
+
+    printk_info("ext2: %s, %u blocks of %u bytes in %u groups, %u/%u inodes free%s", dev->name,
+            fs->sb.s_blocks_count, fs->block_size, fs->groups_count, fs->sb.s_free_inodes_count,
+            fs->sb.s_inodes_count, fs->read_only ? " (read-only)" : "");
+
+    return root;
+}
@@ -0,0 +1,274 @@
+/*
+ * ext2_alloc.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/ext2.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/time/rtc.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Block and inode bitmaps, one block of each per group. Whoever allocates updates the bitmap, the group
+ * descriptor and the superblock counters all at once, so e2fsck finds them in agreement.
+ *
+ * Blocks are allocated around a goal (see ext2_find_goal) in the order Linux's ext2 tries them:
+ *  - the goal itself, which is what keeps a growing file contiguous;
+ *  - a whole free byte of the bitmap after it in the same group, 8 free blocks in a row, so a new run starts
+ *    where it has room to grow rather than in a gap between two files;
+ *  - any free block after the goal in the same group;
+ *  - the first group with free blocks after that, a free byte first then any bit.
+ *
+ * Inodes of new files go in their directory's group (or the next one with room) so a directory and its files
+ * end up close to each other, which together with the block goal keeps their data near the inode table too.
+ */
+
+static uint32_t ext2_blocks_in_group(ext2_fs_t *fs, uint32_t group) {
+    uint32_t first = fs->sb.s_first_data_block + group * fs->sb.s_blocks_per_group;
+    return MIN(fs->sb.s_blocks_per_group, fs->sb.s_blocks_count - first);
+}
+
+static bool test_bit(const uint8_t *bitmap, uint32_t bit) {
+    return (bitmap[bit / 8] >> (bit % 8)) & 1;
+}
+
+static void set_bit(uint8_t *bitmap, uint32_t bit) {
+    bitmap[bit / 8] |= 1 << (bit % 8);
+}
+
+static void clear_bit(uint8_t *bitmap, uint32_t bit) {
+    bitmap[bit / 8] &= ~(1 << (bit % 8));
+}
+
+/* first clear bit in [start, nbits), nbits if there is none */
+static uint32_t find_zero_bit(const uint8_t *bitmap, uint32_t nbits, uint32_t start) {
+    for (uint32_t bit = start; bit < nbits; bit++) {
+        /* skip whole bytes that are in use */
+        if (bit % 8 == 0 && bitmap[bit / 8] == 0xff && bit + 8 <= nbits) {
+            bit += 7;
+            continue;
+        }
+
+        if (!test_bit(bitmap, bit))
+            return bit;
+    }
+
+    return nbits;
+}
+
+/* first byte-aligned run of 8 clear bits in [start, nbits), nbits if there is none */
+static uint32_t find_zero_byte(const uint8_t *bitmap, uint32_t nbits, uint32_t start) {
+    for (uint32_t byte = (start + 7) / 8; byte < nbits / 8; byte++) {
+        if (bitmap[byte] == 0)
+            return byte * 8;
+    }
+
+    return nbits;
+}
+
+int ext2_write_super(ext2_fs_t *fs) {
+    buffer_head_t bh;
+    int ret = bread(fs->dev, EXT2_SUPER_OFFSET / EXT2_SUPER_SIZE, EXT2_SUPER_SIZE, &bh);
+    if (ret != 0)
+        return ret;
+
+    fs->sb.s_wtime = rtc_curr_unixtime / 1000;
+    memcpy(bh.data, &fs->sb, sizeof(ext2_super_block_t));
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+    return 0;
+}
+
+/* only the primary copy, backups are only ever looked at by e2fsck and don't need up to date counters */
+int ext2_write_group_desc(ext2_fs_t *fs, uint32_t group) {
+    buffer_head_t bh;
+    int ret = bread(fs->dev, fs->sb.s_first_data_block + 1 + group / fs->desc_per_block, fs->block_size, &bh);
+    if (ret != 0)
+        return ret;
+
+    ext2_group_desc_t *descs = bh.data;
+    descs[group % fs->desc_per_block] = fs->groups[group];
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+    return 0;
+}
+
+/* claims a clear bit in group's block bitmap, starting from start (-1 when it's not the goal's group) */
+static int ext2_alloc_in_group(ext2_fs_t *fs, uint32_t group, int64_t start, uint32_t *block) {
+    buffer_head_t bh;
+    int ret = bread(fs->dev, fs->groups[group].bg_block_bitmap, fs->block_size, &bh);
+    if (ret != 0)
+        return ret;
+
+    uint8_t *bitmap = bh.data;
+    uint32_t nbits = ext2_blocks_in_group(fs, group);
+    uint32_t bit = nbits;
+
+    if (start >= 0 && start < nbits) {
+        if (!test_bit(bitmap, start))
+            bit = start;
+        if (bit == nbits)
+            bit = find_zero_byte(bitmap, nbits, start);
+        if (bit == nbits)
+            bit = find_zero_bit(bitmap, nbits, start);
+    } else {
+        bit = find_zero_byte(bitmap, nbits, 0);
+        if (bit == nbits)
+            bit = find_zero_bit(bitmap, nbits, 0);
+    }
+
+    if (bit == nbits) {
+        brelse(&bh);
+        return -ENOSPC;
+    }
+
+    set_bit(bitmap, bit);
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+
+    *block = fs->sb.s_first_data_block + group * fs->sb.s_blocks_per_group + bit;
+    return 0;
+}
+
+/**
+ * goal: block the caller would like to have, any block will do if it's taken
+ * block: the block allocated, its contents are whatever was there before
+ *
+ * returns 0 or -errno
+ */
+int ext2_new_block(ext2_fs_t *fs, uint32_t goal, uint32_t *block) {
+    if (fs->read_only)
+        return -EROFS;
+
+    if (fs->sb.s_free_blocks_count == 0)
+        return -ENOSPC;
+
+    if (goal < fs->sb.s_first_data_block || goal >= fs->sb.s_blocks_count)
+        goal = fs->sb.s_first_data_block;
+
+    uint32_t goal_group = (goal - fs->sb.s_first_data_block) / fs->sb.s_blocks_per_group;
+    uint32_t goal_bit = (goal - fs->sb.s_first_data_block) % fs->sb.s_blocks_per_group;
+
+    /* the goal's group a second time at the end, for whatever is before the goal */
+    for (uint32_t i = 0; i <= fs->groups_count; i++) {
+        uint32_t group = (goal_group + i) % fs->groups_count;
+        if (fs->groups[group].bg_free_blocks_count == 0)
+            continue;
+
+        int ret = ext2_alloc_in_group(fs, group, i == 0 ? (int64_t) goal_bit : -1, block);
+        if (ret == -ENOSPC)
+            continue;
+        if (ret != 0)
+            return ret;
+
+        fs->groups[group].bg_free_blocks_count--;
+        fs->sb.s_free_blocks_count--;
+        ext2_write_group_desc(fs, group);
+        ext2_write_super(fs);
+        return 0;
+    }
+
+    return -ENOSPC;
+}
+
+/* gives back a block ext2_new_block handed out that nothing points to (anymore) */
+int ext2_free_block(ext2_fs_t *fs, uint32_t block) {
+    uint32_t group = (block - fs->sb.s_first_data_block) / fs->sb.s_blocks_per_group;
+    uint32_t bit = (block - fs->sb.s_first_data_block) % fs->sb.s_blocks_per_group;
+
+    buffer_head_t bh;
+    int ret = bread(fs->dev, fs->groups[group].bg_block_bitmap, fs->block_size, &bh);
+    if (ret != 0)
+        return ret;
+
+    clear_bit(bh.data, bit);
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+
+    fs->groups[group].bg_free_blocks_count++;
+    fs->sb.s_free_blocks_count++;
+    ext2_write_group_desc(fs, group);
+    return ext2_write_super(fs);
+}
+
+/**
+ * dir_ino: directory the new inode is going to be linked into
+ * ino: the inode number allocated, the caller has to initialise the on-disk inode
+ *
+ * returns 0 or -errno
+ */
+int ext2_new_inode(ext2_fs_t *fs, uint32_t dir_ino, bool is_dir, uint32_t *ino) {
+    if (fs->read_only)
+        return -EROFS;
+
+    if (fs->sb.s_free_inodes_count == 0)
+        return -ENOSPC;
+
+    uint32_t ipg = fs->sb.s_inodes_per_group;
+    uint32_t start = (dir_ino - 1) / ipg;
+
+    for (uint32_t i = 0; i < fs->groups_count; i++) {
+        uint32_t group = (start + i) % fs->groups_count;
+        if (fs->groups[group].bg_free_inodes_count == 0)
+            continue;
+
+        buffer_head_t bh;
+        int ret = bread(fs->dev, fs->groups[group].bg_inode_bitmap, fs->block_size, &bh);
+        if (ret != 0)
+            return ret;
+
+        /* the reserved inodes (root, lost+found's predecessors...) are all in the first group */
+        uint32_t first = group == 0 ? fs->first_ino - 1 : 0;
+        uint32_t bit = find_zero_bit(bh.data, ipg, first);
+
+        if (bit == ipg) {
+            brelse(&bh);
+            continue;
+        }
+
+        set_bit(bh.data, bit);
+        mark_buffer_dirty(&bh);
+        brelse(&bh);
+
+        fs->groups[group].bg_free_inodes_count--;
+        if (is_dir)
+            fs->groups[group].bg_used_dirs_count++;
+        fs->sb.s_free_inodes_count--;
+        ext2_write_group_desc(fs, group);
+        ext2_write_super(fs);
+
+        *ino = group * ipg + bit + 1;
+        return 0;
+    }
+
+    return -ENOSPC;
+}
+
+/* gives back an inode ext2_new_inode handed out, the caller has cleared the on-disk one already */
+int ext2_free_inode(ext2_fs_t *fs, uint32_t ino, bool is_dir) {
+    uint32_t group = (ino - 1) / fs->sb.s_inodes_per_group;
+    uint32_t bit = (ino - 1) % fs->sb.s_inodes_per_group;
+
+    buffer_head_t bh;
+    int ret = bread(fs->dev, fs->groups[group].bg_inode_bitmap, fs->block_size, &bh);
+    if (ret != 0)
+        return ret;
+
+    clear_bit(bh.data, bit);
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+
+    fs->groups[group].bg_free_inodes_count++;
+    if (is_dir)
+        fs->groups[group].bg_used_dirs_count--;
+    fs->sb.s_free_inodes_count++;
+    ext2_write_group_desc(fs, group);
+    return ext2_write_super(fs);
+}
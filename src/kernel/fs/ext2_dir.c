@@ -0,0 +1,846 @@
+/*
+ * ext2_dir.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/ext2.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/qsort.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Directories are files full of variable length entries (ext2_dir_entry_t), none of which crosses a block. A
+ * plain lookup reads every block until the name turns up, which is fine for a few dozen names and terrible for
+ * thousands of them.
+ *
+ * Large directories can be indexed (dir_index, "htree"): block 0 still starts with "." and "..", but ".." spans
+ * the rest of the block and hides a table of (hash, block) pairs sorted by hash in there. Each pair says "names
+ * hashing to this value or more live in that block", so a lookup hashes the name, binary searches the table and
+ * reads a single leaf block. Big directories get one more level of index blocks in between, which look like a
+ * block with one empty entry to anyone that doesn't know about them. Leaves are ordinary directory blocks.
+ *
+ * A name whose hash collides with the first one of the next leaf may have ended up in either, the low bit of that
+ * next hash says so and both are searched then.
+ *
+ * New entries go into the leaf their hash maps to, a full leaf is split in two by hash with the new half appended
+ * to the directory. A full root grows the tree by a level and full index blocks below it are split the same way.
+ * Past two levels the index is dropped (EXT2_INDEX_FL cleared, exactly what a kernel without htree support does)
+ * and entries are appended the old way. Every index block doubles as an empty directory block, so the directory
+ * stays valid and e2fsck -D builds the index again.
+ *
+ * Hashes are the ones from Linux's fs/ext4/hash.c (legacy, half MD4 and TEA), the signed/unsigned char variants
+ * depend on the platform that created the file system, which the superblock records in s_flags.
+ */
+
+#define DX_HTREE_EOF        0x7fffffffu
+#define DX_MAX_LEVELS       2
+
+/* offsets of the index in the root block (after "." and "..") and in an intermediate block (after a fake entry) */
+#define DX_ROOT_INFO_OFFSET 24
+#define DX_NODE_OFFSET      8
+
+/* an index block on the way down: which block, the entry followed and how many there are */
+typedef struct {
+    uint32_t block;
+    uint32_t at;
+    uint32_t count;
+} dx_frame_t;
+
+/* where dx_probe ended up for a name */
+typedef struct {
+    dx_frame_t frames[DX_MAX_LEVELS];
+    /* index levels below the root, 0 or 1 */
+    uint32_t levels;
+    int version;
+    uint32_t hash;
+    uint32_t leaf;
+} dx_path_t;
+
+static uint32_t rol32(uint32_t word, unsigned int shift) {
+    return (word << shift) | (word >> (32 - shift));
+}
+
+static void tea_transform(uint32_t buf[4], const uint32_t in[4]) {
+    uint32_t sum = 0;
+    uint32_t b0 = buf[0], b1 = buf[1];
+
+    for (int n = 0; n < 16; n++) {
+        sum += 0x9e3779b9;
+        b0 += ((b1 << 4) + in[0]) ^ (b1 + sum) ^ ((b1 >> 5) + in[1]);
+        b1 += ((b0 << 4) + in[2]) ^ (b0 + sum) ^ ((b0 >> 5) + in[3]);
+    }
+
+    buf[0] += b0;
+    buf[1] += b1;
+}
+
+#define MD4_F(x, y, z)      ((z) ^ ((x) & ((y) ^ (z))))
+#define MD4_G(x, y, z)      (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define MD4_H(x, y, z)      ((x) ^ (y) ^ (z))
+#define MD4_ROUND(f, a, b, c, d, x, s)  ((a) += f((b), (c), (d)) + (x), (a) = rol32((a), (s)))
+#define MD4_K2              013240474631u
+#define MD4_K3              015666365641u
+
+static void half_md4_transform(uint32_t buf[4], const uint32_t in[8]) {
+    uint32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+    MD4_ROUND(MD4_F, a, b, c, d, in[0], 3);
+    MD4_ROUND(MD4_F, d, a, b, c, in[1], 7);
+    MD4_ROUND(MD4_F, c, d, a, b, in[2], 11);
+    MD4_ROUND(MD4_F, b, c, d, a, in[3], 19);
+    MD4_ROUND(MD4_F, a, b, c, d, in[4], 3);
+    MD4_ROUND(MD4_F, d, a, b, c, in[5], 7);
+    MD4_ROUND(MD4_F, c, d, a, b, in[6], 11);
+    MD4_ROUND(MD4_F, b, c, d, a, in[7], 19);
+
+    MD4_ROUND(MD4_G, a, b, c, d, in[1] + MD4_K2, 3);
+    MD4_ROUND(MD4_G, d, a, b, c, in[3] + MD4_K2, 5);
+    MD4_ROUND(MD4_G, c, d, a, b, in[5] + MD4_K2, 9);
+    MD4_ROUND(MD4_G, b, c, d, a, in[7] + MD4_K2, 13);
+    MD4_ROUND(MD4_G, a, b, c, d, in[0] + MD4_K2, 3);
+    MD4_ROUND(MD4_G, d, a, b, c, in[2] + MD4_K2, 5);
+    MD4_ROUND(MD4_G, c, d, a, b, in[4] + MD4_K2, 9);
+    MD4_ROUND(MD4_G, b, c, d, a, in[6] + MD4_K2, 13);
+
+    MD4_ROUND(MD4_H, a, b, c, d, in[3] + MD4_K3, 3);
+    MD4_ROUND(MD4_H, d, a, b, c, in[7] + MD4_K3, 9);
+    MD4_ROUND(MD4_H, c, d, a, b, in[2] + MD4_K3, 11);
+    MD4_ROUND(MD4_H, b, c, d, a, in[6] + MD4_K3, 15);
+    MD4_ROUND(MD4_H, a, b, c, d, in[1] + MD4_K3, 3);
+    MD4_ROUND(MD4_H, d, a, b, c, in[5] + MD4_K3, 9);
+    MD4_ROUND(MD4_H, c, d, a, b, in[0] + MD4_K3, 11);
+    MD4_ROUND(MD4_H, b, c, d, a, in[4] + MD4_K3, 15);
+
+    buf[0] += a;
+    buf[1] += b;
+    buf[2] += c;
+    buf[3] += d;
+}
+
+/* the original ext3 hash, kept around because older file systems use it */
+static uint32_t dx_hack_hash(const char *name, size_t len, bool unsigned_char) {
+    uint32_t hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+
+    for (size_t i = 0; i < len; i++) {
+        int c = unsigned_char ? (int) (uint8_t) name[i] : (int) (int8_t) name[i];
+
+        hash = hash1 + (hash0 ^ (uint32_t) (c * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+
+        hash1 = hash0;
+        hash0 = hash;
+    }
+
+    return hash0 << 1;
+}
+
+/* packs (at most num words of) the name into buf, padded with its length */
+static void str2hashbuf(const char *msg, size_t len, uint32_t *buf, int num, bool unsigned_char) {
+    uint32_t pad = (uint32_t) len | ((uint32_t) len << 8);
+    pad |= pad << 16;
+
+    uint32_t val = pad;
+    len = MIN(len, (size_t) num * 4);
+
+    for (size_t i = 0; i < len; i++) {
+        int c = unsigned_char ? (int) (uint8_t) msg[i] : (int) (int8_t) msg[i];
+        val = (uint32_t) c + (val << 8);
+
+        if (i % 4 == 3) {
+            *buf++ = val;
+            val = pad;
+            num--;
+        }
+    }
+
+    if (--num >= 0)
+        *buf++ = val;
+    while (--num >= 0)
+        *buf++ = pad;
+}
+
+uint32_t ext2_dx_hash(ext2_fs_t *fs, int version, const char *name, size_t len) {
+    uint32_t buf[4], in[8];
+    uint32_t hash = 0;
+    bool unsigned_char = version >= DX_HASH_LEGACY_UNSIGNED;
+
+    memcpy(buf, fs->hash_seed, sizeof(buf));
+
+    switch (version) {
+    case DX_HASH_LEGACY:
+    case DX_HASH_LEGACY_UNSIGNED:
+        hash = dx_hack_hash(name, len, unsigned_char);
+        break;
+    case DX_HASH_HALF_MD4:
+    case DX_HASH_HALF_MD4_UNSIGNED:
+        for (size_t i = 0; i < len; i += 32) {
+            str2hashbuf(name + i, len - i, in, 8, unsigned_char);
+            half_md4_transform(buf, in);
+        }
+        hash = buf[1];
+        break;
+    case DX_HASH_TEA:
+    case DX_HASH_TEA_UNSIGNED:
+        for (size_t i = 0; i < len; i += 16) {
+            str2hashbuf(name + i, len - i, in, 4, unsigned_char);
+            tea_transform(buf, in);
+        }
+        hash = buf[0];
+        break;
+    }
+
+    /* the low bit is the collision marker in index entries, and the largest value means end of directory */
+    hash &= ~1u;
+    if (hash == (DX_HTREE_EOF << 1))
+        hash = (DX_HTREE_EOF - 1) << 1;
+
+    return hash;
+}
+
+/* block lblock of dir through the cache, holes don't belong in directories */
+static int dir_bread(ext2_inode_info_t *dir, uint32_t lblock, buffer_head_t *bh) {
+    uint32_t block;
+    int ret = ext2_bmap(dir, lblock, false, &block);
+    if (ret != 0)
+        return ret;
+    if (block == 0)
+        return -EIO;
+
+    return bread(dir->fs->dev, block, dir->fs->block_size, bh);
+}
+
+static bool ext2_dirent_ok(ext2_fs_t *fs, const ext2_dir_entry_t *de, uint32_t offset) {
+    return de->rec_len >= EXT2_DIR_REC_LEN(1) && de->rec_len % 4 == 0 && de->rec_len >= EXT2_DIR_REC_LEN(de->name_len)
+            && offset + de->rec_len <= fs->block_size;
+}
+
+/* inode number name is linked to in a directory block, 0 if it isn't there */
+static uint32_t find_in_block(ext2_inode_info_t *dir, const uint8_t *data, uint32_t lblock, const char *name,
+        size_t len) {
+    ext2_fs_t *fs = dir->fs;
+
+    for (uint32_t offset = 0; offset < fs->block_size;) {
+        const ext2_dir_entry_t *de = (const ext2_dir_entry_t*) (data + offset);
+
+        if (!ext2_dirent_ok(fs, de, offset)) {
+            printk_error("ext2: bad entry in directory %u, block %u offset %u", dir->ino, lblock, offset);
+            return 0;
+        }
+
+        if (de->inode != 0 && de->name_len == len && memcmp(de->name, name, len) == 0)
+            return de->inode;
+
+        offset += de->rec_len;
+    }
+
+    return 0;
+}
+
+static uint32_t linear_lookup(ext2_inode_info_t *dir, const char *name, size_t len) {
+    uint32_t nblocks = ext2_i_size(dir) / dir->fs->block_size;
+
+    for (uint32_t lblock = 0; lblock < nblocks; lblock++) {
+        buffer_head_t bh;
+        if (dir_bread(dir, lblock, &bh) != 0)
+            return 0;
+
+        uint32_t ino = find_in_block(dir, bh.data, lblock, name, len);
+        brelse(&bh);
+
+        if (ino != 0)
+            return ino;
+    }
+
+    return 0;
+}
+
+static bool dx_indexed(ext2_inode_info_t *dir) {
+    return (dir->raw.i_flags & EXT2_INDEX_FL) && (dir->fs->sb.s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX);
+}
+
+/**
+ * Reads index block frame->block of dir and returns its entries (frame->count is set), NULL if they don't look
+ * right. bh has to be released by the caller when they're not NULL.
+ */
+static dx_entry_t* dx_read_node(ext2_inode_info_t *dir, dx_frame_t *frame, bool root, buffer_head_t *bh) {
+    ext2_fs_t *fs = dir->fs;
+
+    if (dir_bread(dir, frame->block, bh) != 0)
+        return NULL;
+
+    uint8_t *data = bh->data;
+    uint32_t offset = DX_NODE_OFFSET;
+    if (root)
+        offset = DX_ROOT_INFO_OFFSET + ((dx_root_info_t*) (data + DX_ROOT_INFO_OFFSET))->info_length;
+
+    dx_countlimit_t *countlimit = (dx_countlimit_t*) (data + offset);
+    if (countlimit->limit != (fs->block_size - offset) / sizeof(dx_entry_t) || countlimit->count == 0
+            || countlimit->count > countlimit->limit) {
+        brelse(bh);
+        return NULL;
+    }
+
+    frame->count = countlimit->count;
+    return (dx_entry_t*) countlimit;
+}
+
+/**
+ * Walks the index of dir down to the leaf name should be in.
+ *
+ * returns 0 with path filled in, or -errno when the index is unusable and the directory has to be searched linearly
+ */
+static int dx_probe(ext2_inode_info_t *dir, const char *name, size_t len, dx_path_t *path) {
+    ext2_fs_t *fs = dir->fs;
+
+    buffer_head_t bh;
+    int ret = dir_bread(dir, 0, &bh);
+    if (ret != 0)
+        return ret;
+
+    dx_root_info_t info = *(dx_root_info_t*) ((uint8_t*) bh.data + DX_ROOT_INFO_OFFSET);
+    brelse(&bh);
+
+    if (info.reserved_zero != 0 || info.info_length != sizeof(dx_root_info_t) || info.hash_version > DX_HASH_TEA
+            || info.indirect_levels >= DX_MAX_LEVELS)
+        return -EINVAL;
+
+    path->version = info.hash_version;
+    if (fs->unsigned_hash)
+        path->version += DX_HASH_LEGACY_UNSIGNED;
+
+    path->hash = ext2_dx_hash(fs, path->version, name, len);
+    path->levels = info.indirect_levels;
+
+    uint32_t block = 0;
+    for (uint32_t level = 0; level <= path->levels; level++) {
+        dx_frame_t *frame = &path->frames[level];
+        frame->block = block;
+
+        dx_entry_t *entries = dx_read_node(dir, frame, level == 0, &bh);
+        if (entries == NULL)
+            return -EINVAL;
+
+        /* last entry with a hash <= the name's, the first one (which has no hash) covers everything before */
+        uint32_t lo = 1, hi = frame->count;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (entries[mid].hash > path->hash)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        frame->at = lo - 1;
+        block = entries[frame->at].block;
+        brelse(&bh);
+    }
+
+    path->leaf = block;
+    return 0;
+}
+
+/* moves path on to the next leaf, but only when the name's hash may have spilled over into it */
+static bool dx_next_leaf(ext2_inode_info_t *dir, dx_path_t *path) {
+    dx_frame_t *frames = path->frames;
+
+    int level = path->levels;
+    while (level >= 0 && frames[level].at + 1 >= frames[level].count)
+        level--;
+
+    if (level < 0)
+        return false;
+
+    buffer_head_t bh;
+    dx_entry_t *entries = dx_read_node(dir, &frames[level], level == 0, &bh);
+    if (entries == NULL)
+        return false;
+
+    bool next = ++frames[level].at < frames[level].count;
+    uint32_t entry_hash = entries[frames[level].at].hash;
+    uint32_t block = entries[frames[level].at].block;
+    brelse(&bh);
+
+    if (!next || !(entry_hash & 1) || (entry_hash & ~1u) != path->hash)
+        return false;
+
+    /* leftmost path of the subtree under the new entry */
+    for (level++; level <= (int) path->levels; level++) {
+        frames[level].block = block;
+        frames[level].at = 0;
+
+        entries = dx_read_node(dir, &frames[level], false, &bh);
+        if (entries == NULL)
+            return false;
+
+        block = entries[0].block;
+        brelse(&bh);
+    }
+
+    path->leaf = block;
+    return true;
+}
+
+static int dx_lookup(ext2_inode_info_t *dir, const char *name, size_t len, uint32_t *ino) {
+    dx_path_t path;
+
+    int ret = dx_probe(dir, name, len, &path);
+    if (ret != 0)
+        return ret;
+
+    do {
+        buffer_head_t bh;
+        ret = dir_bread(dir, path.leaf, &bh);
+        if (ret != 0)
+            return ret;
+
+        *ino = find_in_block(dir, bh.data, path.leaf, name, len);
+        brelse(&bh);
+    } while (*ino == 0 && dx_next_leaf(dir, &path));
+
+    return 0;
+}
+
+/* inode number of name in dir, 0 if there is no such entry */
+uint32_t ext2_dir_lookup(ext2_inode_info_t *dir, const char *name, size_t len) {
+    if (dx_indexed(dir)) {
+        uint32_t ino;
+        if (dx_lookup(dir, name, len, &ino) == 0)
+            return ino;
+
+        printk_error("ext2: bad index in directory %u, searching it linearly", dir->ino);
+    }
+
+    return linear_lookup(dir, name, len);
+}
+
+static uint8_t ext2_file_type(ext2_fs_t *fs, uint32_t mode) {
+    if (!(fs->sb.s_feature_incompat & EXT2_FEATURE_INCOMPAT_FILETYPE))
+        return EXT2_FT_UNKNOWN;
+
+    if (S_ISREG(mode))
+        return EXT2_FT_REG_FILE;
+    if (S_ISDIR(mode))
+        return EXT2_FT_DIR;
+    if (S_ISCHR(mode))
+        return EXT2_FT_CHRDEV;
+
+    return EXT2_FT_UNKNOWN;
+}
+
+/* puts the entry into the first gap big enough in a directory block, false if there is none */
+static bool add_to_block(ext2_fs_t *fs, uint8_t *data, const char *name, size_t len, uint32_t ino,
+        uint8_t file_type) {
+    uint32_t needed = EXT2_DIR_REC_LEN(len);
+
+    for (uint32_t offset = 0; offset < fs->block_size;) {
+        ext2_dir_entry_t *de = (ext2_dir_entry_t*) (data + offset);
+        if (!ext2_dirent_ok(fs, de, offset))
+            return false;
+
+        uint32_t used = de->inode != 0 ? EXT2_DIR_REC_LEN(de->name_len) : 0;
+
+        if (de->rec_len - used >= needed) {
+            /* split the free space at the end of an entry off into a new one */
+            if (used != 0) {
+                ext2_dir_entry_t *next = (ext2_dir_entry_t*) (data + offset + used);
+                next->rec_len = de->rec_len - used;
+                de->rec_len = used;
+                de = next;
+            }
+
+            de->inode = ino;
+            de->name_len = len;
+            de->file_type = file_type;
+            memcpy(de->name, name, len);
+            return true;
+        }
+
+        offset += de->rec_len;
+    }
+
+    return false;
+}
+
+/* new empty block at the end of dir, read in through bh */
+static int dir_append_block(ext2_inode_info_t *dir, uint32_t *lblock, buffer_head_t *bh) {
+    ext2_fs_t *fs = dir->fs;
+    *lblock = ext2_i_size(dir) / fs->block_size;
+
+    uint32_t block;
+    int ret = ext2_bmap(dir, *lblock, true, &block);
+    if (ret != 0)
+        return ret;
+
+    ret = bread(fs->dev, block, fs->block_size, bh);
+    if (ret == 0) {
+        dir->raw.i_size += fs->block_size;
+        ret = ext2_write_inode(dir);
+        if (ret != 0) {
+            dir->raw.i_size -= fs->block_size;
+            brelse(bh);
+        }
+    }
+
+    /* nothing past i_size may stay allocated */
+    if (ret != 0)
+        ext2_bunmap(dir, *lblock);
+
+    return ret;
+}
+
+typedef struct {
+    uint32_t hash;
+    uint16_t offset;
+    uint16_t size;
+} dx_map_entry_t;
+
+static int dx_map_cmp(const void *a, const void *b) {
+    uint32_t ha = ((const dx_map_entry_t*) a)->hash;
+    uint32_t hb = ((const dx_map_entry_t*) b)->hash;
+    return ha < hb ? -1 : ha > hb;
+}
+
+/* copies the entries in map into data back to back, the last one takes up what's left of the block */
+static void dx_pack_entries(ext2_fs_t *fs, uint8_t *data, const uint8_t *from, dx_map_entry_t *map, size_t count) {
+    ext2_dir_entry_t *de = NULL;
+    uint32_t offset = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        de = (ext2_dir_entry_t*) (data + offset);
+        memcpy(de, from + map[i].offset, map[i].size);
+        de->rec_len = map[i].size;
+        offset += map[i].size;
+    }
+
+    de->rec_len += fs->block_size - offset;
+}
+
+/* turns a new directory block into an empty index block holding count entries */
+static dx_entry_t* dx_init_node(ext2_fs_t *fs, uint8_t *data, const dx_entry_t *from, uint32_t count) {
+    ext2_dir_entry_t *de = (ext2_dir_entry_t*) data;
+    de->inode = 0;
+    de->rec_len = fs->block_size;
+    de->name_len = 0;
+    de->file_type = 0;
+
+    dx_entry_t *entries = (dx_entry_t*) (data + DX_NODE_OFFSET);
+    memcpy(entries, from, count * sizeof(dx_entry_t));
+    ((dx_countlimit_t*) entries)->limit = (fs->block_size - DX_NODE_OFFSET) / sizeof(dx_entry_t);
+    ((dx_countlimit_t*) entries)->count = count;
+    return entries;
+}
+
+/* a full root without levels below: everything moves into a new index block, the root only points at that */
+static int dx_grow_tree(ext2_inode_info_t *dir, dx_path_t *path) {
+    ext2_fs_t *fs = dir->fs;
+
+    uint32_t lblock;
+    buffer_head_t new_bh;
+    int ret = dir_append_block(dir, &lblock, &new_bh);
+    if (ret != 0)
+        return ret;
+
+    buffer_head_t root_bh;
+    dx_entry_t *entries = dx_read_node(dir, &path->frames[0], true, &root_bh);
+    if (entries == NULL) {
+        brelse(&new_bh);
+        return -EINVAL;
+    }
+
+    dx_init_node(fs, new_bh.data, entries, path->frames[0].count);
+
+    ((dx_countlimit_t*) entries)->count = 1;
+    entries[0].block = lblock;
+    ((dx_root_info_t*) ((uint8_t*) root_bh.data + DX_ROOT_INFO_OFFSET))->indirect_levels = 1;
+
+    mark_buffer_dirty(&new_bh);
+    mark_buffer_dirty(&root_bh);
+    brelse(&new_bh);
+    brelse(&root_bh);
+
+    path->frames[1].block = lblock;
+    path->frames[1].at = path->frames[0].at;
+    path->frames[1].count = path->frames[0].count;
+    path->frames[0].at = 0;
+    path->frames[0].count = 1;
+    path->levels = 1;
+    return 0;
+}
+
+/* a full index block below the root: its upper half goes into a new one, which the root gets an entry for */
+static int dx_split_node(ext2_inode_info_t *dir, dx_path_t *path) {
+    ext2_fs_t *fs = dir->fs;
+    dx_frame_t *root = &path->frames[0];
+    dx_frame_t *node = &path->frames[1];
+
+    buffer_head_t root_bh;
+    dx_entry_t *root_entries = dx_read_node(dir, root, true, &root_bh);
+    if (root_entries == NULL)
+        return -EINVAL;
+
+    bool full = root->count >= ((dx_countlimit_t*) root_entries)->limit;
+    brelse(&root_bh);
+    if (full)
+        return -ENOSPC;
+
+    uint32_t lblock;
+    buffer_head_t new_bh;
+    int ret = dir_append_block(dir, &lblock, &new_bh);
+    if (ret != 0)
+        return ret;
+
+    buffer_head_t node_bh;
+    dx_entry_t *entries = dx_read_node(dir, node, false, &node_bh);
+    root_entries = dx_read_node(dir, root, true, &root_bh);
+    if (entries == NULL || root_entries == NULL) {
+        if (entries != NULL)
+            brelse(&node_bh);
+        if (root_entries != NULL)
+            brelse(&root_bh);
+        brelse(&new_bh);
+        return -EINVAL;
+    }
+
+    /* the first entry of the new block covers from the hash of the entry it was made of */
+    uint32_t half = node->count / 2;
+    uint32_t split_hash = entries[half].hash;
+    dx_init_node(fs, new_bh.data, &entries[half], node->count - half);
+    ((dx_countlimit_t*) entries)->count = half;
+
+    memmove(&root_entries[root->at + 2], &root_entries[root->at + 1],
+            (root->count - root->at - 1) * sizeof(dx_entry_t));
+    root_entries[root->at + 1].hash = split_hash;
+    root_entries[root->at + 1].block = lblock;
+    ((dx_countlimit_t*) root_entries)->count++;
+    root->count++;
+
+    mark_buffer_dirty(&new_bh);
+    mark_buffer_dirty(&node_bh);
+    mark_buffer_dirty(&root_bh);
+    brelse(&new_bh);
+    brelse(&node_bh);
+    brelse(&root_bh);
+
+    if (node->at >= half) {
+        root->at++;
+        node->block = lblock;
+        node->at -= half;
+        node->count -= half;
+    } else {
+        node->count = half;
+    }
+
+    return 0;
+}
+
+/**
+ * Moves the upper half (by hash) of the full leaf path points at into a new block and adds it to the index,
+ * path->leaf is then whichever of the two the name belongs in.
+ *
+ * returns 0 or -errno, -ENOSPC when the index can't take another leaf
+ */
+static int dx_split_leaf(ext2_inode_info_t *dir, dx_path_t *path) {
+    ext2_fs_t *fs = dir->fs;
+    dx_frame_t *frame = &path->frames[path->levels];
+
+    buffer_head_t node_bh;
+    dx_entry_t *entries = dx_read_node(dir, frame, path->levels == 0, &node_bh);
+    if (entries == NULL)
+        return -EINVAL;
+
+    bool full = frame->count >= ((dx_countlimit_t*) entries)->limit;
+    brelse(&node_bh);
+
+    /* make room in the index first, at most two levels like everyone else */
+    int ret = 0;
+    if (full)
+        ret = path->levels == 0 ? dx_grow_tree(dir, path) : dx_split_node(dir, path);
+    if (ret != 0)
+        return ret;
+
+    frame = &path->frames[path->levels];
+
+    buffer_head_t leaf_bh;
+    ret = dir_bread(dir, path->leaf, &leaf_bh);
+    if (ret != 0)
+        return ret;
+
+    /* a copy of the leaf to pack both halves from, and each entry's hash to sort them by */
+    uint8_t *copy = kmalloc(fs->block_size, KMEM_DEFAULT);
+    dx_map_entry_t *map = kmalloc(fs->block_size / EXT2_DIR_REC_LEN(1) * sizeof(dx_map_entry_t), KMEM_DEFAULT);
+    if (copy == NULL || map == NULL) {
+        if (copy != NULL)
+            kfree(copy);
+        if (map != NULL)
+            kfree(map);
+        brelse(&leaf_bh);
+        return -ENOMEM;
+    }
+
+    memcpy(copy, leaf_bh.data, fs->block_size);
+
+    size_t count = 0;
+    for (uint32_t offset = 0; offset < fs->block_size;) {
+        ext2_dir_entry_t *de = (ext2_dir_entry_t*) (copy + offset);
+        if (!ext2_dirent_ok(fs, de, offset)) {
+            ret = -EINVAL;
+            break;
+        }
+
+        if (de->inode != 0) {
+            map[count].hash = ext2_dx_hash(fs, path->version, de->name, de->name_len);
+            map[count].offset = offset;
+            map[count].size = EXT2_DIR_REC_LEN(de->name_len);
+            count++;
+        }
+
+        offset += de->rec_len;
+    }
+
+    if (ret == 0 && count < 2)
+        ret = -ENOSPC;
+
+    uint32_t new_lblock;
+    buffer_head_t new_bh;
+    if (ret == 0)
+        ret = dir_append_block(dir, &new_lblock, &new_bh);
+
+    if (ret != 0) {
+        brelse(&leaf_bh);
+        kfree(map);
+        kfree(copy);
+        return ret;
+    }
+
+    qsort(map, count, sizeof(dx_map_entry_t), dx_map_cmp);
+
+    /* names with the same hash on both sides of the split: the low bit tells lookups to check the next leaf too */
+    size_t split = count / 2;
+    uint32_t split_hash = map[split].hash;
+    bool continued = map[split - 1].hash == split_hash;
+
+    dx_pack_entries(fs, leaf_bh.data, copy, map, split);
+    dx_pack_entries(fs, new_bh.data, copy, map + split, count - split);
+    mark_buffer_dirty(&leaf_bh);
+    mark_buffer_dirty(&new_bh);
+    brelse(&leaf_bh);
+    brelse(&new_bh);
+    kfree(map);
+    kfree(copy);
+
+    /* and the new leaf goes into the index right after the old one */
+    entries = dx_read_node(dir, frame, path->levels == 0, &node_bh);
+    if (entries == NULL)
+        return -EINVAL;
+
+    memmove(&entries[frame->at + 2], &entries[frame->at + 1], (frame->count - frame->at - 1) * sizeof(dx_entry_t));
+    entries[frame->at + 1].hash = split_hash | continued;
+    entries[frame->at + 1].block = new_lblock;
+    ((dx_countlimit_t*) entries)->count++;
+    mark_buffer_dirty(&node_bh);
+    brelse(&node_bh);
+
+    if (path->hash >= split_hash)
+        path->leaf = new_lblock;
+    return 0;
+}
+
+/* adds the entry to the leaf its hash maps to, splitting it when it's full. 0 or -errno */
+static int dx_add_entry(ext2_inode_info_t *dir, const char *name, size_t len, uint32_t ino, uint8_t file_type) {
+    dx_path_t path;
+    int ret = dx_probe(dir, name, len, &path);
+    if (ret != 0)
+        return ret;
+
+    /* leaves aren't sorted, anywhere in the right one is good */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        buffer_head_t bh;
+        ret = dir_bread(dir, path.leaf, &bh);
+        if (ret != 0)
+            return ret;
+
+        bool added = add_to_block(dir->fs, bh.data, name, len, ino, file_type);
+        if (added)
+            mark_buffer_dirty(&bh);
+        brelse(&bh);
+
+        if (added)
+            return 0;
+
+        if (attempt == 0) {
+            ret = dx_split_leaf(dir, &path);
+            if (ret != 0)
+                return ret;
+        }
+    }
+
+    return -ENOSPC;
+}
+
+/**
+ * Links ino into dir as name, the caller makes sure there is no such name in there yet.
+ *
+ * returns 0 or -errno
+ */
+int ext2_add_entry(ext2_inode_info_t *dir, const char *name, size_t len, uint32_t ino, uint32_t mode) {
+    ext2_fs_t *fs = dir->fs;
+    uint8_t file_type = ext2_file_type(fs, mode);
+    buffer_head_t bh;
+    int ret;
+
+    if (dx_indexed(dir)) {
+        ret = dx_add_entry(dir, name, len, ino, file_type);
+
+        /* a full device is just that, a full (or broken) index means carrying on without it */
+        bool unusable = ret == -EINVAL || (ret == -ENOSPC && fs->sb.s_free_blocks_count > 0);
+        if (!unusable)
+            return ret;
+
+        printk_info("ext2: dropping the index of directory %u", dir->ino);
+        dir->raw.i_flags &= ~EXT2_INDEX_FL;
+        ret = ext2_write_inode(dir);
+        if (ret != 0)
+            return ret;
+    }
+
+    uint32_t nblocks = ext2_i_size(dir) / fs->block_size;
+
+    for (uint32_t lblock = 0; lblock < nblocks; lblock++) {
+        ret = dir_bread(dir, lblock, &bh);
+        if (ret != 0)
+            return ret;
+
+        bool added = add_to_block(fs, bh.data, name, len, ino, file_type);
+        if (added)
+            mark_buffer_dirty(&bh);
+        brelse(&bh);
+
+        if (added)
+            return 0;
+    }
+
+    /* every block is full, a new one with a single entry spanning all of it */
+    uint32_t lblock;
+    ret = dir_append_block(dir, &lblock, &bh);
+    if (ret != 0)
+        return ret;
+
+    ext2_dir_entry_t *de = bh.data;
+    de->inode = ino;
+    de->rec_len = fs->block_size;
+    de->name_len = len;
+    de->file_type = file_type;
+    memcpy(de->name, name, len);
+    mark_buffer_dirty(&bh);
+    brelse(&bh);
+    return 0;
+}
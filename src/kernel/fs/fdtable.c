@@ -0,0 +1,71 @@
+/*
+ * fdtable.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/fdtable.h"
+#include "kernel/sys/errno.h"
+#include "kernel/sys/fcntl.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/lib/printk.h"
+
+/* the console is opened once and shared by everyone's standard descriptors */
+static file_t *console;
+
+void files_init(task_struct_t *task) {
+    for (size_t i = 0; i < TASK_MAX_FILES; i++)
+        task->files[i] = NULL;
+
+    if (console == NULL && vfs_open("/dev/console", O_RDWR, &console) != 0) {
+        printk_error("fdtable: can't open /dev/console");
+        console = NULL;
+        return;
+    }
+
+    task->files[STDIN_FILENO] = fget(console);
+    task->files[STDOUT_FILENO] = fget(console);
+    task->files[STDERR_FILENO] = fget(console);
+}
+
+void files_close_all(task_struct_t *task) {
+    for (size_t i = 0; i < TASK_MAX_FILES; i++) {
+        if (task->files[i] != NULL) {
+            fput(task->files[i]);
+            task->files[i] = NULL;
+        }
+    }
+}
+
+/* returns the lowest free descriptor, -EMFILE if the table is full */
+int fd_install(file_t *file) {
+    task_struct_t *task = this_rq()->curr;
+
+    for (int fd = 0; fd < TASK_MAX_FILES; fd++) {
+        if (task->files[fd] == NULL) {
+            task->files[fd] = file;
+            return fd;
+        }
+    }
+
+    return -EMFILE;
+}
+
+/* NULL if fd isn't open, the table keeps its reference */
+file_t* fd_get(int fd) {
+    if (fd < 0 || fd >= TASK_MAX_FILES)
+        return NULL;
+
+    return this_rq()->curr->files[fd];
+}
+
+int fd_close(int fd) {
+    file_t *file = fd_get(fd);
+    if (file == NULL)
+        return -EBADF;
+
+    this_rq()->curr->files[fd] = NULL;
+    fput(file);
+    return 0;
+}
@@ -0,0 +1,372 @@
+/*
+ * ramfs.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/ramfs.h"
+#include "kernel/fs/vfs.h"
+#include "kernel/sys/errno.h"
+#include "kernel/sys/fcntl.h"
+#include "kernel/sys/stat.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/lib/math.h"
+#include "kernel/compiler/macro.h"
+
+/*
+ * Notes to myself:
+ *
+ * The archive is cpio "newc" (what Linux uses for its initramfs): a 110-byte ascii header made of the
+ * magic and 13 8-digit hex fields, followed by the name (namesize bytes including the nul) and then the
+ * data, each of them padded to a 4-byte boundary. A "TRAILER!!!" entry marks the end.
+ *
+ * Nothing is copied out of it: nodes point at the names and contents where they sit in the archive, which
+ * is why the loader's copy has to stay put for good (it lives in the first MB, mm never hands that out).
+ * scripts/mkinitramfs.sh pads names so that every file's data starts on a page boundary, that way elf_load
+ * can map a program straight from the archive pages instead of copying it somewhere else first.
+ *
+ * Nodes are carved out of a single array sized by a counting pass, they're never freed anyway. Missing
+ * parent directories are created on the fly since cpio doesn't guarantee "dir" comes before "dir/file".
+ *
+ * The VFS side is a thin layer on top: inodes are made up on lookup with the node as their private data, and
+ * reads copy straight out of the archive. The archive is read-only, so is this file system.
+ */
+
+#define CPIO_HDR_SIZE       110
+#define CPIO_MAGIC_SIZE     6
+#define CPIO_TRAILER        "TRAILER!!!"
+
+/* field indexes after the magic */
+enum {
+    CPIO_INO,
+    CPIO_MODE,
+    CPIO_UID,
+    CPIO_GID,
+    CPIO_NLINK,
+    CPIO_MTIME,
+    CPIO_FILESIZE,
+    CPIO_DEVMAJOR,
+    CPIO_DEVMINOR,
+    CPIO_RDEVMAJOR,
+    CPIO_RDEVMINOR,
+    CPIO_NAMESIZE,
+    CPIO_CHECK,
+    CPIO_NR_FIELDS
+};
+
+typedef struct {
+    const char *name;
+    size_t name_len;
+    uint32_t mode;
+    uint64_t data_phys;
+    uint64_t size;
+} cpio_entry_t;
+
+static ramfs_node_t root = {
+        .name = "",
+        .mode = S_IFDIR | 0755,
+        .parent = &root,
+};
+
+static ramfs_node_t *nodes;
+static size_t nr_nodes;
+static size_t max_nodes;
+
+static bool parse_hex(const char *str, uint32_t *value) {
+    uint32_t v = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        char c = str[i];
+        v <<= 4;
+
+        if (c >= '0' && c <= '9')
+            v |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v |= c - 'A' + 10;
+        else
+            return false;
+    }
+
+    *value = v;
+    return true;
+}
+
+/* returns the offset of the next header, 0 when it's the trailer and SIZE_MAX if the archive is corrupted */
+static size_t cpio_next(const char *archive, uint64_t phys, size_t size, size_t offset, cpio_entry_t *entry) {
+    if (offset + CPIO_HDR_SIZE > size)
+        return SIZE_MAX;
+
+    const char *hdr = archive + offset;
+    if (memcmp(hdr, "070701", CPIO_MAGIC_SIZE) != 0 && memcmp(hdr, "070702", CPIO_MAGIC_SIZE) != 0)
+        return SIZE_MAX;
+
+    uint32_t fields[CPIO_NR_FIELDS];
+    for (size_t i = 0; i < CPIO_NR_FIELDS; i++) {
+        if (!parse_hex(hdr + CPIO_MAGIC_SIZE + i * 8, &fields[i]))
+            return SIZE_MAX;
+    }
+
+    size_t name_off = offset + CPIO_HDR_SIZE;
+    size_t data_off = round_up_po2(name_off + fields[CPIO_NAMESIZE], 4);
+    size_t next = round_up_po2(data_off + fields[CPIO_FILESIZE], 4);
+
+    /* the name is within the archive from here on, data_off is past it */
+    if (fields[CPIO_NAMESIZE] == 0 || data_off + fields[CPIO_FILESIZE] > size)
+        return SIZE_MAX;
+
+    /* names are nul-terminated within namesize (mkinitramfs pads with extra nuls), nothing past it is looked at */
+    entry->name = archive + name_off;
+    entry->name_len = 0;
+    while (entry->name_len < fields[CPIO_NAMESIZE] && entry->name[entry->name_len] != '\0')
+        entry->name_len++;
+
+    if (entry->name_len == fields[CPIO_NAMESIZE])
+        return SIZE_MAX;
+
+    entry->mode = fields[CPIO_MODE];
+    entry->data_phys = phys + data_off;
+    entry->size = fields[CPIO_FILESIZE];
+
+    if (entry->name_len == sizeof(CPIO_TRAILER) - 1 && memcmp(entry->name, CPIO_TRAILER, entry->name_len) == 0)
+        return 0;
+
+    return next;
+}
+
+ramfs_node_t* ramfs_root(void) {
+    return &root;
+}
+
+ramfs_node_t* ramfs_lookup_child(ramfs_node_t *dir, const char *name, size_t len) {
+    if (len == 1 && name[0] == '.')
+        return dir;
+
+    if (len == 2 && name[0] == '.' && name[1] == '.')
+        return dir->parent;
+
+    for (ramfs_node_t *node = dir->children; node != NULL; node = node->next) {
+        if (strlen(node->name) == len && memcmp(node->name, name, len) == 0)
+            return node;
+    }
+
+    return NULL;
+}
+
+static ramfs_node_t* ramfs_new_node(ramfs_node_t *dir, const char *name, uint32_t mode) {
+    if (nr_nodes == max_nodes)
+        return NULL;
+
+    ramfs_node_t *node = &nodes[nr_nodes++];
+    node->name = name;
+    node->mode = mode;
+    node->data_phys = 0;
+    node->size = 0;
+    node->parent = dir;
+    node->children = NULL;
+    node->next = dir->children;
+    dir->children = node;
+
+    return node;
+}
+
+/* each component is stored nul-terminated, so intermediate ones have to be cut out of the path */
+static const char* ramfs_dup_name(const char *name, size_t len) {
+    char *dup = kmalloc(len + 1, KMEM_DEFAULT);
+    if (dup == NULL)
+        return NULL;
+
+    memcpy(dup, name, len);
+    dup[len] = '\0';
+    return dup;
+}
+
+/* false if there was no memory for it, an entry that doesn't fit in the tree is only skipped */
+static bool ramfs_add(const cpio_entry_t *entry) {
+    const char *path = entry->name;
+    const char *end = path + entry->name_len;
+
+    /* gen_init_cpio uses absolute paths, GNU cpio relative ones ("./bin/init") */
+    while (path < end && (*path == '/' || (*path == '.' && (path + 1 == end || path[1] == '/'))))
+        path++;
+
+    /* "." itself, the root is already there */
+    if (path == end)
+        return true;
+
+    ramfs_node_t *dir = &root;
+    while (true) {
+        const char *sep = path;
+        while (sep < end && *sep != '/')
+            sep++;
+
+        size_t len = sep - path;
+        ramfs_node_t *node = ramfs_lookup_child(dir, path, len);
+
+        if (sep == end) {
+            if (node == NULL)
+                node = ramfs_new_node(dir, path, entry->mode);
+            else
+                node->mode = entry->mode;   /* implicit directory created earlier */
+
+            if (node == NULL)
+                return true;
+
+            node->data_phys = entry->data_phys;
+            node->size = entry->size;
+            return true;
+        }
+
+        if (node == NULL) {
+            const char *name = ramfs_dup_name(path, len);
+            if (name == NULL)
+                return false;
+
+            node = ramfs_new_node(dir, name, S_IFDIR | 0755);
+        }
+
+        if (node == NULL || !S_ISDIR(node->mode)) {
+            printk_info("initramfs: can't add %s", entry->name);
+            return true;
+        }
+
+        dir = node;
+        path = sep + 1;
+    }
+}
+
+bool initramfs_init(uint64_t phys, size_t size) {
+    const char *archive = (const char*) va(phys);
+    cpio_entry_t entry;
+    size_t offset = 0;
+    size_t entries = 0;
+
+    /* first pass: validate and count */
+    while ((offset = cpio_next(archive, phys, size, offset, &entry)) != 0) {
+        if (offset == SIZE_MAX) {
+            printk_error("initramfs: corrupted archive after %llu entries", entries);
+            return false;
+        }
+
+        /* each component of the path may turn into a node of its own */
+        for (size_t i = 0; i < entry.name_len; i++) {
+            if (entry.name[i] == '/')
+                entries++;
+        }
+        entries++;
+    }
+
+    if (entries == 0)
+        return true;
+
+    max_nodes = entries;
+    nodes = kmalloc(sizeof(ramfs_node_t) * max_nodes, KMEM_DEFAULT);
+    if (nodes == NULL) {
+        printk_error("initramfs: no memory for %llu nodes", max_nodes);
+        return false;
+    }
+
+    offset = 0;
+    while ((offset = cpio_next(archive, phys, size, offset, &entry)) != 0) {
+        if (!ramfs_add(&entry)) {
+            printk_error("initramfs: out of memory adding %s", entry.name);
+
+            /* nothing half-built is left behind, the names already duplicated are lost like the nodes */
+            root.children = NULL;
+            nr_nodes = 0;
+            return false;
+        }
+    }
+
+    printk_info("initramfs: %llu nodes", nr_nodes);
+    return true;
+}
+
+ramfs_node_t* ramfs_lookup(const char *path) {
+    ramfs_node_t *node = &root;
+
+    while (node != NULL && *path != '\0') {
+        if (*path == '/') {
+            path++;
+            continue;
+        }
+
+        const char *sep = path;
+        while (*sep != '\0' && *sep != '/')
+            sep++;
+
+        if (!S_ISDIR(node->mode))
+            return NULL;
+
+        node = ramfs_lookup_child(node, path, sep - path);
+        path = sep;
+    }
+
+    return node;
+}
+
+static uint32_t ramfs_dev;
+
+static uint64_t ramfs_ino(const ramfs_node_t *node) {
+    return node == &root ? 1 : (uint64_t) (node - nodes) + 2;
+}
+
+static const inode_ops_t ramfs_dir_iops;
+static const file_ops_t ramfs_fops;
+
+static inode_t* ramfs_inode(ramfs_node_t *node) {
+    inode_t *inode = new_inode();
+    if (inode == NULL)
+        return NULL;
+
+    inode->dev = ramfs_dev;
+    inode->ino = ramfs_ino(node);
+    inode->mode = node->mode;
+    inode->size = node->size;
+    inode->i_op = S_ISDIR(node->mode) ? &ramfs_dir_iops : NULL;
+    inode->f_op = &ramfs_fops;
+    inode->private = node;
+    return inode;
+}
+
+static inode_t* ramfs_vfs_lookup(inode_t *dir, const char *name, size_t len) {
+    ramfs_node_t *node = ramfs_lookup_child(dir->private, name, len);
+    return node != NULL ? ramfs_inode(node) : NULL;
+}
+
+static int ramfs_open(inode_t *inode, file_t *file) {
+    (void) inode;
+    return (file->flags & O_ACCMODE) == O_RDONLY ? 0 : -EROFS;
+}
+
+static long ramfs_read(file_t *file, char *buf, size_t length, uint64_t *pos) {
+    ramfs_node_t *node = file->inode->private;
+
+    if (*pos >= node->size)
+        return 0;
+
+    size_t count = MIN(length, node->size - *pos);
+    memcpy(buf, (void*) va(node->data_phys + *pos), count);
+    *pos += count;
+
+    return count;
+}
+
+static const inode_ops_t ramfs_dir_iops = {
+        .lookup = ramfs_vfs_lookup,
+};
+
+static const file_ops_t ramfs_fops = {
+        .open = ramfs_open,
+        .read = ramfs_read,
+};
+
+inode_t* ramfs_mount(void) {
+    ramfs_dev = vfs_new_dev();
+    return ramfs_inode(&root);
+}
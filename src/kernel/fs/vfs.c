@@ -0,0 +1,464 @@
+/*
+ * vfs.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/fs/vfs.h"
+#include "kernel/sys/errno.h"
+#include "kernel/sys/fcntl.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/uaccess.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+
+/*
+ * Notes to myself:
+ *
+ * Same split as on Linux, just a lot less of it:
+ *
+ *  - inode_t is a file as far as the file system is concerned (type, size, how to look up children, how to
+ *    read/write it). File systems fill them in from their lookup() and the VFS never looks past "private".
+ *
+ *  - dentry_t is a name in the tree pointing at an inode, cached by fs/dcache.c. The path walk below only calls
+ *    into the file system when the dentry cache doesn't know about a name yet.
+ *
+ *  - file_t is an open file: a dentry plus the current position and the flags it was opened with. Descriptors
+ *    in a task's table point at these (see fs/fdtable.c).
+ *
+ * Mounting sets "mounted" on the dentry of the mountpoint, the walk steps over to the mounted root whenever it
+ * lands on one. There is no cwd yet, so every path is taken as absolute.
+ *
+ * Inodes and files come from fixed pools like dentries do. Unused dentries pin their inodes, so when inodes run
+ * out the dentry cache is asked to let go of some.
+ */
+
+static inode_t *inodes;
+static inode_t *free_inodes;
+
+static file_t *files;
+static file_t *free_files;
+
+static dentry_t *root_dentry;
+static uint32_t next_dev = 1;
+
+void vfs_init(void) {
+    inodes = kmalloc(sizeof(inode_t) * VFS_MAX_INODES, KMEM_DEFAULT | KMEM_ZERO);
+    for (size_t i = 0; i < VFS_MAX_INODES; i++) {
+        inodes[i].next_free = free_inodes;
+        free_inodes = &inodes[i];
+    }
+
+    files = kmalloc(sizeof(file_t) * VFS_MAX_FILES, KMEM_DEFAULT | KMEM_ZERO);
+    for (size_t i = 0; i < VFS_MAX_FILES; i++) {
+        files[i].next_free = free_files;
+        free_files = &files[i];
+    }
+
+    dcache_init();
+
+    printk_info("VFS: %u inodes, %u dentries, %u files", VFS_MAX_INODES, VFS_MAX_DENTRIES, VFS_MAX_FILES);
+}
+
+uint32_t vfs_new_dev(void) {
+    return next_dev++;
+}
+
+inode_t* new_inode(void) {
+    uint64_t flags = local_irq_save();
+
+    while (free_inodes == NULL && dcache_shrink())
+        ;
+
+    inode_t *inode = free_inodes;
+    if (inode == NULL) {
+        local_irq_restore(flags);
+        printk_error("VFS: out of inodes");
+        return NULL;
+    }
+
+    free_inodes = inode->next_free;
+    memzero(inode, sizeof(inode_t));
+    inode->nlink = 1;
+    inode->refcount = 1;
+
+    local_irq_restore(flags);
+    return inode;
+}
+
+inode_t* iget(inode_t *inode) {
+    uint64_t flags = local_irq_save();
+    inode->refcount++;
+    local_irq_restore(flags);
+    return inode;
+}
+
+void iput(inode_t *inode) {
+    uint64_t flags = local_irq_save();
+
+    BUG_ON(inode->refcount == 0);
+
+    if (--inode->refcount == 0) {
+        if (inode->evict != NULL)
+            inode->evict(inode);
+
+        inode->next_free = free_inodes;
+        free_inodes = inode;
+    }
+
+    local_irq_restore(flags);
+}
+
+void vfs_mount_root(inode_t *root) {
+    BUG_ON(root == NULL || root_dentry != NULL || !S_ISDIR(root->mode));
+    root_dentry = d_alloc_root(root);
+}
+
+int vfs_mount(const char *path, inode_t *root) {
+    if (root == NULL)
+        return -ENOMEM;
+
+    dentry_t *mountpoint;
+    int ret = vfs_lookup(path, &mountpoint);
+
+    if (ret == 0 && !S_ISDIR(mountpoint->inode->mode)) {
+        dput(mountpoint);
+        ret = -ENOTDIR;
+    }
+
+    if (ret != 0) {
+        iput(root);
+        return ret;
+    }
+
+    /* the reference taken by the lookup keeps the mountpoint from being recycled */
+    dentry_t *dentry = d_alloc_root(root);
+    dentry->mountpoint = mountpoint;
+    mountpoint->mounted = dentry;
+
+    return 0;
+}
+
+static dentry_t* follow_mounts(dentry_t *dentry) {
+    while (dentry->mounted != NULL) {
+        dentry_t *mounted = dget(dentry->mounted);
+        dput(dentry);
+        dentry = mounted;
+    }
+
+    return dentry;
+}
+
+static dentry_t* walk_parent(dentry_t *dentry) {
+    /* ".." of a mounted root is the parent of where it's mounted */
+    while (dentry->mountpoint != NULL)
+        dentry = dentry->mountpoint;
+
+    /* and ".." of "/" is "/" */
+    return dget(dentry->parent != NULL ? dentry->parent : dentry);
+}
+
+static int walk_component(dentry_t *dir, const char *name, size_t len, dentry_t **result) {
+    dentry_t *dentry = d_lookup(dir, name, len);
+
+    /* first time anyone asks for this name, the file system has the last word (negative answers are cached too) */
+    if (dentry == NULL) {
+        inode_t *inode = NULL;
+        if (dir->inode->i_op != NULL && dir->inode->i_op->lookup != NULL)
+            inode = dir->inode->i_op->lookup(dir->inode, name, len);
+
+        dentry = d_alloc(dir, name, len, inode);
+        if (dentry == NULL)
+            return -ENOMEM;
+    }
+
+    *result = dentry;
+    return 0;
+}
+
+int getname(const char *user_path, char *path) {
+    for (size_t i = 0; i < VFS_PATH_MAX; i++) {
+        /* the length isn't known up front, every byte is checked before it's read */
+        if (!access_ok(user_path + i, 1))
+            return -EFAULT;
+
+        path[i] = user_path[i];
+        if (path[i] == '\0')
+            return 0;
+    }
+
+    return -ENAMETOOLONG;
+}
+
+/**
+ * path: absolute path, repeated slashes, "." and ".." are fine
+ * result: dentry with a reference the caller has to dput
+ *
+ * returns 0 or -errno
+ */
+int vfs_lookup(const char *path, dentry_t **result) {
+    if (root_dentry == NULL)
+        return -ENOENT;
+
+    dentry_t *dentry = dget(root_dentry);
+
+    while (true) {
+        while (*path == '/')
+            path++;
+
+        if (*path == '\0')
+            break;
+
+        const char *sep = path;
+        while (*sep != '\0' && *sep != '/')
+            sep++;
+
+        size_t len = sep - path;
+        int ret = 0;
+        dentry_t *next = NULL;
+
+        if (!S_ISDIR(dentry->inode->mode))
+            ret = -ENOTDIR;
+        else if (len > VFS_NAME_MAX)
+            ret = -ENAMETOOLONG;
+        else if (len == 1 && path[0] == '.')
+            next = dget(dentry);
+        else if (len == 2 && path[0] == '.' && path[1] == '.')
+            next = walk_parent(dentry);
+        else
+            ret = walk_component(dentry, path, len, &next);
+
+        dput(dentry);
+        if (ret != 0)
+            return ret;
+
+        if (next->inode == NULL) {
+            dput(next);
+            return -ENOENT;
+        }
+
+        dentry = follow_mounts(next);
+        path = sep;
+    }
+
+    *result = dentry;
+    return 0;
+}
+
+/**
+ * path: absolute path of the new file, whatever comes after the last slash is its name
+ * mode: file type and permissions
+ * result: dentry of the new file (or of the one that was there already), the caller has to dput it
+ *
+ * returns 0 or -errno
+ */
+int vfs_create(const char *path, uint32_t mode, dentry_t **result) {
+    const char *name = path;
+    for (const char *p = path; *p != '\0'; p++) {
+        if (*p == '/')
+            name = p + 1;
+    }
+
+    size_t len = strlen(name);
+    if (len == 0 || (len == 1 && name[0] == '.') || (len == 2 && name[0] == '.' && name[1] == '.'))
+        return -EEXIST;
+    if (len > VFS_NAME_MAX)
+        return -ENAMETOOLONG;
+
+    /* path was validated by getname, so the parent fits too */
+    char parent_path[VFS_PATH_MAX];
+    size_t parent_len = name - path;
+    memcpy(parent_path, path, parent_len);
+    parent_path[parent_len] = '\0';
+
+    dentry_t *parent;
+    int ret = vfs_lookup(parent_path, &parent);
+    if (ret != 0)
+        return ret;
+
+    dentry_t *dentry = NULL;
+    if (!S_ISDIR(parent->inode->mode))
+        ret = -ENOTDIR;
+    else
+        ret = walk_component(parent, name, len, &dentry);
+
+    /* the name is usually cached as a negative dentry by now, creating the file turns it into a positive one */
+    if (ret == 0 && dentry->inode == NULL) {
+        const inode_ops_t *i_op = parent->inode->i_op;
+
+        if (i_op == NULL || i_op->create == NULL)
+            ret = -EROFS;
+        else
+            ret = i_op->create(parent->inode, name, len, mode, &dentry->inode);
+
+        if (ret != 0)
+            dput(dentry);
+    }
+
+    dput(parent);
+
+    if (ret == 0)
+        *result = dentry;
+    return ret;
+}
+
+static file_t* file_alloc(void) {
+    uint64_t flags = local_irq_save();
+
+    file_t *file = free_files;
+    if (file != NULL) {
+        free_files = file->next_free;
+        memzero(file, sizeof(file_t));
+        file->refcount = 1;
+    }
+
+    local_irq_restore(flags);
+    return file;
+}
+
+static void file_free(file_t *file) {
+    uint64_t flags = local_irq_save();
+    file->next_free = free_files;
+    free_files = file;
+    local_irq_restore(flags);
+}
+
+/**
+ * flags: O_* from sys/fcntl.h
+ * result: the open file with one reference, released with fput
+ *
+ * returns 0 or -errno
+ */
+int vfs_open(const char *path, int flags, file_t **result) {
+    int accmode = flags & O_ACCMODE;
+    if (accmode == O_ACCMODE)
+        return -EINVAL;
+
+    dentry_t *dentry;
+    int ret = vfs_lookup(path, &dentry);
+    if (ret == -ENOENT && (flags & O_CREAT))
+        ret = vfs_create(path, S_IFREG | 0644, &dentry);
+    if (ret != 0)
+        return ret;
+
+    inode_t *inode = dentry->inode;
+    if (S_ISDIR(inode->mode) && accmode != O_RDONLY) {
+        dput(dentry);
+        return -EISDIR;
+    }
+
+    file_t *file = file_alloc();
+    if (file == NULL) {
+        dput(dentry);
+        return -ENFILE;
+    }
+
+    /* the dentry keeps the inode around for as long as the file is open */
+    file->dentry = dentry;
+    file->inode = inode;
+    file->f_op = inode->f_op;
+    file->flags = flags;
+
+    if (file->f_op != NULL && file->f_op->open != NULL) {
+        ret = file->f_op->open(inode, file);
+        if (ret != 0) {
+            file_free(file);
+            dput(dentry);
+            return ret;
+        }
+    }
+
+    *result = file;
+    return 0;
+}
+
+file_t* fget(file_t *file) {
+    uint64_t flags = local_irq_save();
+    file->refcount++;
+    local_irq_restore(flags);
+    return file;
+}
+
+void fput(file_t *file) {
+    uint64_t flags = local_irq_save();
+
+    BUG_ON(file->refcount == 0);
+    bool last = --file->refcount == 0;
+
+    local_irq_restore(flags);
+
+    if (!last)
+        return;
+
+    if (file->f_op != NULL && file->f_op->release != NULL)
+        file->f_op->release(file->inode, file);
+
+    dput(file->dentry);
+    file_free(file);
+}
+
+long vfs_read(file_t *file, char *buf, size_t length) {
+    if ((file->flags & O_ACCMODE) == O_WRONLY)
+        return -EBADF;
+
+    if (S_ISDIR(file->inode->mode))
+        return -EISDIR;
+
+    if (file->f_op == NULL || file->f_op->read == NULL)
+        return -EINVAL;
+
+    return file->f_op->read(file, buf, length, &file->pos);
+}
+
+long vfs_write(file_t *file, const char *buf, size_t length) {
+    if ((file->flags & O_ACCMODE) == O_RDONLY)
+        return -EBADF;
+
+    if (file->f_op == NULL || file->f_op->write == NULL)
+        return -EINVAL;
+
+    if (file->flags & O_APPEND)
+        file->pos = file->inode->size;
+
+    return file->f_op->write(file, buf, length, &file->pos);
+}
+
+long vfs_lseek(file_t *file, long offset, int whence) {
+    /* devices are streams, there is nowhere to seek to */
+    if (S_ISCHR(file->inode->mode))
+        return -ESPIPE;
+
+    long pos;
+    switch (whence) {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = (long) file->pos + offset;
+        break;
+    case SEEK_END:
+        pos = (long) file->inode->size + offset;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    if (pos < 0)
+        return -EINVAL;
+
+    file->pos = pos;
+    return pos;
+}
+
+void vfs_stat(inode_t *inode, struct stat *st) {
+    st->st_dev = inode->dev;
+    st->st_ino = inode->ino;
+    st->st_mode = inode->mode;
+    st->st_nlink = inode->nlink;
+    st->st_size = inode->size;
+    st->st_blksize = 4096;
+    st->st_blocks = (inode->size + 511) / 512;
+}
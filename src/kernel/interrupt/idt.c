@@ -10,11 +10,8 @@
 #include "kernel/lib/printk.h"
 #include "kernel/lib/bit.h"
 #include "kernel/debug/coredump.h"
-#include "kernel/device/keyboard.h"
-#include "kernel/arch/pit.h"
-#include "kernel/arch/pic.h"
-#include "kernel/interrupt/spurious.h"
-#include "kernel/task/scheduler.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/interrupt/irq.h"
 
 
 /*
@@ -59,33 +56,11 @@ __aligned(0x10)
 static idt_entry_t idt64_table[256];
 static idt_pointer_t idt64_table_pointer;
 
-// extern functions
-extern void vector0(void);
-extern void vector1(void);
-extern void vector2(void);
-extern void vector3(void);
-extern void vector4(void);
-extern void vector5(void);
-extern void vector6(void);
-extern void vector7(void);
-extern void vector8(void);
-extern void vector10(void);
-extern void vector11(void);
-extern void vector12(void);
-extern void vector13(void);
-extern void vector14(void);
-extern void vector16(void);
-extern void vector17(void);
-extern void vector18(void);
-extern void vector19(void);
-extern void vector20(void);
-extern void vector21(void);
-/* PIT interrupt */
-extern void vector32(void);
-/* keyboard interrupt */
-extern void vector33(void);
-/* Spurious  interrupt */
-extern void vector39(void);
+/* generated in vectors.asm, one entry point per vector */
+extern const uintptr_t vector_table[256];
+
+/* handlers for vectors outside of the IRQ range, NULL means hang the system */
+static exception_handler_t exception_handlers[256];
 
 static const char *exception_strs[] = {
         //  Intel 64 Manual Volume 2 - Table 6-1 -> Exceptions and Interrupts
@@ -139,37 +114,47 @@ void idt_init(void) {
     idt64_table_pointer.addr = (uintptr_t) &idt64_table;
     idt64_table_pointer.limit = sizeof(idt_entry_t) * ARR_SIZE(idt64_table) - 1;
 
-    config_idt_vector(0, (uintptr_t) &vector0);
-    config_idt_vector(1, (uintptr_t) &vector1);
-    config_idt_vector(2, (uintptr_t) &vector2);
-    config_idt_vector(3, (uintptr_t) &vector3);
-    config_idt_vector(4, (uintptr_t) &vector4);
-    config_idt_vector(5, (uintptr_t) &vector5);
-    config_idt_vector(6, (uintptr_t) &vector6);
-    config_idt_vector(7, (uintptr_t) &vector7);
-    config_idt_vector(8, (uintptr_t) &vector8);
-    config_idt_vector(10, (uintptr_t) &vector10);
-    config_idt_vector(11, (uintptr_t) &vector11);
-    config_idt_vector(12, (uintptr_t) &vector12);
-    config_idt_vector(13, (uintptr_t) &vector13);
-    config_idt_vector(14, (uintptr_t) &vector14);
-    config_idt_vector(16, (uintptr_t) &vector16);
-    config_idt_vector(17, (uintptr_t) &vector17);
-    config_idt_vector(18, (uintptr_t) &vector18);
-    config_idt_vector(19, (uintptr_t) &vector19);
-    config_idt_vector(20, (uintptr_t) &vector20);
-    config_idt_vector(21, (uintptr_t) &vector21);
-    // timer
-    config_idt_vector(32, (uintptr_t) &vector32);
-    // keyboard
-    config_idt_vector(33, (uintptr_t) &vector33);
-    // Spurious
-    config_idt_vector(39, (uintptr_t) &vector39);
+    for (size_t i = 0; i < ARR_SIZE(idt64_table); i++)
+        config_idt_vector(i, vector_table[i]);
 
     printk_info("Loading IDT");
     load_idt(&idt64_table_pointer);
 }
 
+void register_exception_handler(uint8_t vector, exception_handler_t handler) {
+    /* sanity check - IRQs have to go through request_irq */
+    BUG_ON(vector >= IRQ_VECTOR_BASE && vector < IRQ_VECTOR_BASE + NR_IRQS);
+    BUG_ON(vector >= MSI_VECTOR_BASE && vector < MSI_VECTOR_BASE + NR_MSI_VECTORS);
+
+    exception_handlers[vector] = handler;
+}
+
+void unhandled_exception(interrupt_stack_frame_t *int_frame) {
+    /* disable interrupts and hang the system */
+    disable_interrupts();
+
+    const char *desc = "Unknown interrupt";
+    if (int_frame->trap_number < ARR_SIZE(exception_strs))
+        desc = exception_strs[int_frame->trap_number];
+
+    /* fast path vectors don't snapshot control registers, by now they're as good as they were back then */
+    if (int_frame->trap_number >= IDT_FIRST_NON_EXCEPTION_VECTOR) {
+        sys_ctrl_regs_t *ctrl_regs = &int_frame->sys_ctrl_regs;
+        asm volatile ("mov %0, cr0" : "=r" (ctrl_regs->cr0));
+        asm volatile ("mov %0, cr2" : "=r" (ctrl_regs->cr2));
+        asm volatile ("mov %0, cr3" : "=r" (ctrl_regs->cr3));
+        asm volatile ("mov %0, cr4" : "=r" (ctrl_regs->cr4));
+        asm volatile ("mov %0, cr8" : "=r" (ctrl_regs->cr8));
+    }
+
+    printk_error("Error: %s (vector %llu), Error Code: 0x%x", desc, int_frame->trap_number, int_frame->error_code);
+    coredump(int_frame, 6);
+
+    for (;;) {
+        halt();
+    }
+}
+
 /*
  * Notes to myself:
  *
@@ -190,40 +175,16 @@ void idt_init(void) {
  *
  */
 void interrupt_handler(interrupt_stack_frame_t *int_frame) {
-    /* spurious interrupt */
-    if (int_frame->trap_number == 39) {
-        /* there is nothing to be done here... let's carry on with our lives */
-        pic_mask_irq(PIC_LPT1_OR_SPURIOUS_INTERRUPT);
-        spurious_handle_irq();
-        pic_unmask_irq(PIC_LPT1_OR_SPURIOUS_INTERRUPT);
-    } else if (int_frame->trap_number == 32) {
-        pic_mask_irq(PIC_PROG_INT_TIMER_INTERRUPT);
-        /* PIT is expected to send EOI */
-        pit_timer_handle_irq();
-    } else if (int_frame->trap_number == 33) {
-        pic_unmask_irq(PIC_KEYBOARD_INTERRUPT);
-        /* keyboard is expected to send EOI */
-        keyboard_handle_irq();
-        pic_unmask_irq(PIC_KEYBOARD_INTERRUPT);
+    uint64_t vector = int_frame->trap_number;
+
+    /* O(1) dispatch - drivers register their handlers via request_irq */
+    if (vector >= IRQ_VECTOR_BASE && vector < IRQ_VECTOR_BASE + NR_IRQS) {
+        handle_irq(int_frame);
+    } else if (vector >= MSI_VECTOR_BASE && vector < MSI_VECTOR_BASE + NR_MSI_VECTORS) {
+        handle_msi(int_frame);
+    } else if (exception_handlers[vector] != NULL) {
+        exception_handlers[vector](int_frame);
     } else {
-        /* disable interrupts and hang the system */
-        disable_interrupts();
-
-        printk_error("Error: %s, Error Code: 0x%x", exception_strs[int_frame->trap_number], int_frame->error_code);
-        coredump(int_frame, 6);
-
-        for (;;) {
-            halt();
-        }
-    }
-
-    /* check if there are peding tasks such as scheduling to be done before returning */
-    if (int_frame->trap_number == 32) {
-        if (this_rq()->need_resched)
-            schedule(int_frame);
-
-        pic_unmask_irq(PIC_PROG_INT_TIMER_INTERRUPT);
+        unhandled_exception(int_frame);
     }
-
 }
-
@@ -0,0 +1,171 @@
+/*
+ * irq.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/interrupt/irq.h"
+#include "kernel/interrupt/softirq.h"
+#include "kernel/arch/pic.h"
+#include "kernel/arch/apic.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/lib/printk.h"
+#include "kernel/task/scheduler.h"
+
+/*
+ * Notes to myself:
+ *
+ * Drivers used to be wired into interrupt_handler() one if/else branch at a time. Now they claim their line with
+ * request_irq() and dispatch is a single table lookup indexed by IRQ number.
+ *
+ * Which controller the lines are wired to is hidden behind irq_chip_t. It starts as the 8259 PIC and apic_init()
+ * swaps it for the IO-APIC when the firmware describes one. Either way the vector stays IRQ_VECTOR_BASE + irq, so
+ * dispatch doesn't care.
+ *
+ * MSI/MSI-X messages go straight to the local APIC, there is no line to mask or chip to talk to. They get vectors of
+ * their own (MSI_VECTOR_BASE onwards) and the EOI goes to the local APIC directly.
+ */
+
+typedef struct {
+    irq_handler_t handler;
+    void *dev;
+} irq_desc_t;
+
+static irq_desc_t irq_desc[NR_IRQS];
+static irq_desc_t msi_desc[NR_MSI_VECTORS];
+
+static const irq_chip_t *irq_chip = &pic_chip;
+
+bool request_irq(uint8_t irq, irq_handler_t handler, void *dev) {
+    /* sanity checks */
+    BUG_ON(irq >= NR_IRQS || handler == NULL);
+
+    /* unmask is a critical path, interrupts must be disabled to avoid stack pointer data corruption */
+    uint64_t flags = local_irq_save();
+
+    if (irq_desc[irq].handler != NULL) {
+        local_irq_restore(flags);
+        return false;
+    }
+
+    irq_desc[irq].handler = handler;
+    irq_desc[irq].dev = dev;
+    irq_chip->unmask(irq);
+
+    local_irq_restore(flags);
+    return true;
+}
+
+void free_irq(uint8_t irq) {
+    /* sanity check */
+    BUG_ON(irq >= NR_IRQS);
+
+    uint64_t flags = local_irq_save();
+    irq_chip->mask(irq);
+    irq_desc[irq].handler = NULL;
+    irq_desc[irq].dev = NULL;
+    local_irq_restore(flags);
+}
+
+int request_msi_vector(irq_handler_t handler, void *dev) {
+    /* sanity check */
+    BUG_ON(handler == NULL);
+
+    uint64_t flags = local_irq_save();
+
+    for (int i = 0; i < NR_MSI_VECTORS; i++) {
+        if (msi_desc[i].handler == NULL) {
+            msi_desc[i].handler = handler;
+            msi_desc[i].dev = dev;
+            local_irq_restore(flags);
+            return MSI_VECTOR_BASE + i;
+        }
+    }
+
+    local_irq_restore(flags);
+    return -1;
+}
+
+void free_msi_vector(int vector) {
+    /* sanity check */
+    BUG_ON(vector < MSI_VECTOR_BASE || vector >= MSI_VECTOR_BASE + NR_MSI_VECTORS);
+
+    uint64_t flags = local_irq_save();
+    msi_desc[vector - MSI_VECTOR_BASE].handler = NULL;
+    msi_desc[vector - MSI_VECTOR_BASE].dev = NULL;
+    local_irq_restore(flags);
+}
+
+void irq_set_chip(const irq_chip_t *chip) {
+    /* sanity check */
+    BUG_ON(chip == NULL);
+
+    uint64_t flags = local_irq_save();
+
+    for (uint8_t irq = 0; irq < NR_IRQS; irq++) {
+        irq_chip->mask(irq);
+        if (irq_desc[irq].handler != NULL)
+            chip->unmask(irq);
+    }
+    irq_chip = chip;
+
+    local_irq_restore(flags);
+    printk_info("IRQs routed through %s", chip->name);
+}
+
+bool irq_set_affinity(uint8_t irq, uint32_t cpu) {
+    /* sanity check */
+    BUG_ON(irq >= NR_IRQS);
+
+    if (irq_chip->set_affinity == NULL || !apic_cpu_online(cpu))
+        return false;
+
+    uint64_t flags = local_irq_save();
+    irq_chip->set_affinity(irq, cpu);
+    local_irq_restore(flags);
+
+    return true;
+}
+
+void handle_irq(interrupt_stack_frame_t *int_frame) {
+    uint8_t irq = int_frame->trap_number - IRQ_VECTOR_BASE;
+    irq_desc_t *desc = &irq_desc[irq];
+
+    /* hard IRQ part: ack the device and defer the rest, interrupts stay disabled until irq_exit */
+    irq_enter();
+
+    if (desc->handler != NULL)
+        desc->handler(desc->dev);
+    else
+        printk_error("Unexpected IRQ %u", irq);
+
+    /* ack before softirqs run so the line can fire again while they do */
+    irq_chip->eoi(irq);
+
+    /* runs softirqs (with interrupts enabled) if this is the outermost interrupt */
+    irq_exit();
+
+    /* check if there are peding tasks such as scheduling to be done before returning */
+    if (!in_interrupt() && this_rq()->need_resched)
+        schedule();
+}
+
+void handle_msi(interrupt_stack_frame_t *int_frame) {
+    irq_desc_t *desc = &msi_desc[int_frame->trap_number - MSI_VECTOR_BASE];
+
+    irq_enter();
+
+    if (desc->handler != NULL)
+        desc->handler(desc->dev);
+    else
+        printk_error("Unexpected MSI vector %llu", int_frame->trap_number);
+
+    lapic_eoi();
+
+    irq_exit();
+
+    if (!in_interrupt() && this_rq()->need_resched)
+        schedule();
+}
@@ -0,0 +1,183 @@
+/*
+ * softirq.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/interrupt/softirq.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/bit.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * From Understanding the Linux kernel (again): "the activities that the kernel needs to perform in response to an
+ * interrupt are divided into a critical urgent part that the kernel executes right away and a deferrable part that
+ * is left for later".
+ *
+ *  -> Hard IRQ: runs with interrupts disabled. Talk to the device, ack it and raise a softirq/schedule a tasklet.
+ *  -> Softirq: runs on the way out of the outermost interrupt with interrupts enabled again, so other IRQs are
+ *      serviced in the meantime. Nested interrupts never run softirqs themselves, they just leave the bits set.
+ *  -> Tasklet: a softirq flavour that can be declared anywhere and never runs concurrently with itself.
+ *  -> Work (kernel/task/workqueue.c): runs in a kernel thread, so it may take as long as it needs.
+ *
+ * State is per-CPU even though there is a single one for now (same approach as this_rq()).
+ */
+
+/* don't starve whoever got interrupted if softirqs keep being raised */
+#define MAX_SOFTIRQ_RESTART     10
+
+typedef struct {
+    /* bitmap of raised softirqs */
+    uint32_t pending;
+
+    /* nesting level of hard IRQs being serviced */
+    uint32_t hardirq_count;
+
+    /* softirqs are running */
+    uint32_t softirq_count;
+
+    /* tasklets waiting to run, one list per tasklet softirq */
+    tasklet_t *tasklet_head[2];
+    tasklet_t **tasklet_tail[2];
+} softirq_cpu_t;
+
+static softirq_action_t softirq_vec[NR_SOFTIRQS];
+static softirq_cpu_t cpu_softirq;
+
+/* making it easier for SMP implementation :-) */
+static softirq_cpu_t* this_softirq(void) {
+    return &cpu_softirq;
+}
+
+static void tasklet_action(unsigned int idx) {
+    softirq_cpu_t *cpu = this_softirq();
+
+    /* grab the whole list so tasklets scheduled from here wait for the next round */
+    disable_interrupts();
+    tasklet_t *list = cpu->tasklet_head[idx];
+    cpu->tasklet_head[idx] = NULL;
+    cpu->tasklet_tail[idx] = &cpu->tasklet_head[idx];
+    enable_interrupts();
+
+    while (list != NULL) {
+        tasklet_t *t = list;
+        list = list->next;
+
+        /* allow it to be scheduled again while it runs */
+        __atomic_store_n(&t->scheduled, false, __ATOMIC_RELEASE);
+        t->func(t->data);
+    }
+}
+
+static void tasklet_hi_softirq(void) {
+    tasklet_action(0);
+}
+
+static void tasklet_softirq(void) {
+    tasklet_action(1);
+}
+
+void softirq_init(void) {
+    softirq_cpu_t *cpu = this_softirq();
+
+    for (size_t i = 0; i < ARR_SIZE(cpu->tasklet_head); i++) {
+        cpu->tasklet_head[i] = NULL;
+        cpu->tasklet_tail[i] = &cpu->tasklet_head[i];
+    }
+
+    open_softirq(HI_SOFTIRQ, tasklet_hi_softirq);
+    open_softirq(TASKLET_SOFTIRQ, tasklet_softirq);
+    printk_info("Softirqs initialised");
+}
+
+void open_softirq(unsigned int nr, softirq_action_t action) {
+    /* sanity check */
+    BUG_ON(nr >= NR_SOFTIRQS);
+
+    softirq_vec[nr] = action;
+}
+
+void raise_softirq(unsigned int nr) {
+    /* sanity check */
+    BUG_ON(nr >= NR_SOFTIRQS);
+
+    /* may be called with interrupts enabled, so it has to be atomic */
+    __atomic_or_fetch(&this_softirq()->pending, 1U << nr, __ATOMIC_RELAXED);
+}
+
+bool in_interrupt(void) {
+    softirq_cpu_t *cpu = this_softirq();
+    return cpu->hardirq_count > 0 || cpu->softirq_count > 0;
+}
+
+void irq_enter(void) {
+    this_softirq()->hardirq_count++;
+}
+
+/* interrupts must be disabled */
+static void do_softirq(void) {
+    softirq_cpu_t *cpu = this_softirq();
+    int restart = MAX_SOFTIRQ_RESTART;
+
+    cpu->softirq_count++;
+
+    uint32_t pending;
+    while ((pending = __atomic_exchange_n(&cpu->pending, 0, __ATOMIC_RELAXED)) != 0) {
+        /* here is where the latency win is: other IRQs can come in from now on */
+        enable_interrupts();
+
+        for (unsigned int nr = 0; nr < NR_SOFTIRQS; nr++) {
+            if (test_bit(nr, pending) && softirq_vec[nr] != NULL)
+                softirq_vec[nr]();
+        }
+
+        disable_interrupts();
+
+        /* whatever is left will be picked up on the next interrupt exit */
+        if (--restart == 0)
+            break;
+    }
+
+    cpu->softirq_count--;
+}
+
+void irq_exit(void) {
+    softirq_cpu_t *cpu = this_softirq();
+
+    /* sanity check */
+    BUG_ON(cpu->hardirq_count == 0);
+
+    cpu->hardirq_count--;
+
+    if (!in_interrupt() && cpu->pending != 0)
+        do_softirq();
+}
+
+static void __tasklet_schedule(tasklet_t *t, unsigned int idx, unsigned int nr) {
+    /* already queued */
+    if (__atomic_exchange_n(&t->scheduled, true, __ATOMIC_ACQUIRE))
+        return;
+
+    softirq_cpu_t *cpu = this_softirq();
+    uint64_t flags = local_irq_save();
+
+    t->next = NULL;
+    *cpu->tasklet_tail[idx] = t;
+    cpu->tasklet_tail[idx] = &t->next;
+    raise_softirq(nr);
+
+    local_irq_restore(flags);
+}
+
+void tasklet_schedule(tasklet_t *t) {
+    __tasklet_schedule(t, 1, TASKLET_SOFTIRQ);
+}
+
+void tasklet_hi_schedule(tasklet_t *t) {
+    __tasklet_schedule(t, 0, HI_SOFTIRQ);
+}
@@ -9,18 +9,17 @@
 #include "kernel/asm/generic.h"
 #include "kernel/arch/pic.h"
 #include "kernel/lib/printk.h"
-#include "kernel/lib/bit.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/interrupt/irq.h"
 
-void spurious_irq_enable(void) {
-    /* PIC unmask is a critical path, interrupts must be disabled to avoid stack pointer data corruption */
-    disable_interrupts();
-    pic_unmask_irq(PIC_LPT1_OR_SPURIOUS_INTERRUPT);
-    enable_interrupts();
-    printk_info("Spurious IRQ enabled");
-}
+static void spurious_handle_irq(void *dev) {
+    (void) dev;
 
-void spurious_handle_irq(void) {
+    /* there is nothing to be done here... let's carry on with our lives (pic_chip knows not to EOI these) */
     printk_info("Spurious irq happened");
-    if (test_bit(7, pic_read_isr()))
-        pic_send_eoi(PIC_LPT1_OR_SPURIOUS_INTERRUPT);
+}
+
+void spurious_irq_enable(void) {
+    BUG_ON(!request_irq(PIC_LPT1_OR_SPURIOUS_INTERRUPT, spurious_handle_irq, NULL));
+    printk_info("Spurious IRQ enabled");
 }
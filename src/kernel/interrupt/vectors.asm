@@ -4,38 +4,30 @@
 extern interrupt_handler
 
 ; Export references to C
-global vector0
-global vector1
-global vector2
-global vector3
-global vector4
-global vector5
-global vector6
-global vector7
-global vector8
-global vector10
-global vector11
-global vector12
-global vector13
-global vector14
-global vector16
-global vector17
-global vector18
-global vector19
-global vector20
-global vector21
-global vector32
-global vector33
-global vector39
+global vector_table
+global interrupt_return
+
+;===============================================================================
+; Every vector pushes its error code (a fake one when the CPU doesn't push any)
+; and its number, then jumps to the common body. Keeping the stubs this small
+; is what makes generating all 256 of them affordable.
+;
+; CPU exceptions (0..31) take the slow path which also snapshots CR0/2/3/4/8
+; for coredump(). Reading control registers is serialising, so IRQs and
+; everything else take the fast path which only saves GPRs and leaves the
+; control register slots of the frame unset.
+;===============================================================================
+
+; vectors below this one are CPU exceptions
+%define FIRST_NON_EXCEPTION_VECTOR 32
+
+; room taken by pushacr, so both paths share the same frame layout
+%define SYS_CTRL_REGS_SIZE 40
 
 ; Error code is pushed onto the stacka already
 %macro  vector_interrupt_errorcode_present_save_state 1
   ; trap number
   push %1
-  ; save general purpose registers
-  pushaq
-  ; save system control registers
-  pushacr
 %endmacro
 
 ; No error code is returned from this vector, so we fake one to ensure we can use a single C struct for simplicity
@@ -44,42 +36,39 @@ global vector39
   push %2
   ; trap number
   push %1
-  ; save general purpose registers
-  pushaq
-  ; save system control registers
-  pushacr
 %endmacro
 
 %macro  vector_interrupt_restore_state 0
   ; pop system control registers off the stack
-  add rsp, 40
+  add rsp, SYS_CTRL_REGS_SIZE
   ; restore general purpose registers
   popaq
   ; pop trap number and errono off the stack
   add rsp, 16
 %endmacro
 
-%macro  vector_interrupt_body_generator 0
-  ; SystemV ABI requires DF to be clear on function entry
-  cld
-  ; RDI is the first parameter according to the System V AMD64 Calling Convention
-  mov rdi, rsp
-  ; call C interrupt_handler function
-  call interrupt_handler
-
-  ; restore general purpose registers
-  vector_interrupt_restore_state
-  ; special return instruction for interrupts
-  iretq
+; Vectors for which the CPU pushes an error code: #DF, #TS, #NP, #SS, #GP, #PF, #AC, #CP, #VC, #SX
+%macro  vector_stub 1
+vector%1:
+%if %1 == 8 || (%1 >= 10 && %1 <= 14) || %1 == 17 || %1 == 21 || %1 == 29 || %1 == 30
+  vector_interrupt_errorcode_present_save_state %1
+%else
+  vector_interrupt_plain_save_state %1,0
+%endif
+%if %1 < FIRST_NON_EXCEPTION_VECTOR
+  jmp vector_common_slow
+%else
+  jmp vector_common
+%endif
 %endmacro
 
 section .text
 
 ;===============================================================================
-; Pre-defined vectors used in the x86-64 IDT (Long mode)
+; Body shared by all vectors in the x86-64 IDT (Long mode)
 ;
 ; Stack state:
-;	-> push all system control registers
+;	-> push all system control registers (slow path) or reserve room for them
 ;   -> push all general purpose registers
 ;   -> push trap number
 ;   -> push error number - not all interrupts have one but this ensure I can use
@@ -87,94 +76,51 @@ section .text
 ; Killed registers:
 ;   None
 ;===============================================================================
-vector0:
-  vector_interrupt_plain_save_state 0,0
-  vector_interrupt_body_generator
-
-vector1:
-  vector_interrupt_plain_save_state 1,0
-  vector_interrupt_body_generator
-
-vector2:
-  vector_interrupt_plain_save_state 2,0
-  vector_interrupt_body_generator
-
-vector3:
-  vector_interrupt_plain_save_state 3,0
-  vector_interrupt_body_generator
-
-vector4:
-  vector_interrupt_plain_save_state 4,0
-  vector_interrupt_body_generator
-
-vector5:
-  vector_interrupt_plain_save_state 5,0
-  vector_interrupt_body_generator
-
-vector6:
-  vector_interrupt_plain_save_state 6,0
-  vector_interrupt_body_generator
-
-vector7:
-  vector_interrupt_plain_save_state 7,0
-  vector_interrupt_body_generator
-
-vector8:
-  vector_interrupt_errorcode_present_save_state 8
-  vector_interrupt_body_generator
-
-vector10:
-  vector_interrupt_errorcode_present_save_state 10
-  vector_interrupt_body_generator
-
-vector11:
-  vector_interrupt_errorcode_present_save_state 11
-  vector_interrupt_body_generator
-
-vector12:
-  vector_interrupt_errorcode_present_save_state 12
-  vector_interrupt_body_generator
-
-vector13:
-  vector_interrupt_errorcode_present_save_state 13
-  vector_interrupt_body_generator
-
-vector14:
-  vector_interrupt_errorcode_present_save_state 14
-  vector_interrupt_body_generator
-
-vector16:
-  vector_interrupt_plain_save_state 16,0
-  vector_interrupt_body_generator
-
-vector17:
-  vector_interrupt_errorcode_present_save_state 17
-  vector_interrupt_body_generator
-
-vector18:
-  vector_interrupt_plain_save_state 18,0
-  vector_interrupt_body_generator
-
-vector19:
-  vector_interrupt_plain_save_state 19,0
-  vector_interrupt_body_generator
+vector_common_slow:
+  ; save general purpose registers
+  pushaq
+  ; save system control registers
+  pushacr
+  jmp vector_dispatch
 
-vector20:
-  vector_interrupt_plain_save_state 20,0
-  vector_interrupt_body_generator
+vector_common:
+  ; save general purpose registers
+  pushaq
+  ; control registers aren't read, just keep the frame layout
+  sub rsp, SYS_CTRL_REGS_SIZE
 
-vector21:
-  vector_interrupt_errorcode_present_save_state 21
-  vector_interrupt_body_generator
+vector_dispatch:
+  ; SystemV ABI requires DF to be clear on function entry
+  cld
+  ; RDI is the first parameter according to the System V AMD64 Calling Convention
+  mov rdi, rsp
+  ; call C interrupt_handler function
+  call interrupt_handler
 
-vector32:
-  vector_interrupt_plain_save_state 32,0
-  vector_interrupt_body_generator
+; tasks that never ran start here too, their kernel stack holds a ready made frame
+interrupt_return:
+  ; restore general purpose registers
+  vector_interrupt_restore_state
+  ; special return instruction for interrupts
+  iretq
 
-vector33:
-  vector_interrupt_plain_save_state 33,0
-  vector_interrupt_body_generator
+;===============================================================================
+; Generated vectors 0..255
+;===============================================================================
+%assign i 0
+%rep 256
+  vector_stub %[i]
+%assign i i+1
+%endrep
 
-vector39:
-  vector_interrupt_plain_save_state 39,0
-  vector_interrupt_body_generator
+;===============================================================================
+; Entry point of every vector, indexed by vector number (used to fill the IDT)
+;===============================================================================
+section .rodata
+
+vector_table:
+%assign i 0
+%rep 256
+  dq vector%[i]
+%assign i i+1
+%endrep
@@ -0,0 +1,83 @@
+/*
+ * logbuf.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/lib/logbuf.h"
+#include "kernel/lib/string.h"
+
+/*
+ * this ring is used by printk, which means that we can't make use of
+ * printk here due to the circular dependency.
+ */
+
+#define LOGBUF_MASK     (LOGBUF_RECORDS - 1)
+
+static logbuf_record_t records[LOGBUF_RECORDS];
+
+/* next position to be handed out to a producer */
+static uint64_t head;
+
+/* next position to be read by the consumer (only the consumer touches it) */
+static uint64_t tail;
+
+logbuf_record_t* logbuf_reserve(uint64_t *pos) {
+    /* a single locked xadd is all it takes to claim a slot */
+    *pos = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+
+    logbuf_record_t *rec = &records[*pos & LOGBUF_MASK];
+
+    /* tell the consumer that this slot is being (re)written */
+    __atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return rec;
+}
+
+void logbuf_commit(logbuf_record_t *rec, uint64_t pos) {
+    /* publish: everything written to rec before this is visible to the consumer */
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+bool logbuf_read(logbuf_record_t *dst, uint64_t *dropped) {
+    uint64_t curr_head = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+    /* producers lapped us, skip whatever got overwritten */
+    if (curr_head - tail > LOGBUF_RECORDS) {
+        *dropped += curr_head - tail - LOGBUF_RECORDS;
+        tail = curr_head - LOGBUF_RECORDS;
+    }
+
+    while (tail != curr_head) {
+        logbuf_record_t *rec = &records[tail & LOGBUF_MASK];
+        uint64_t seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+
+        /* record still being written, try again next time */
+        if (seq < tail + 1)
+            return false;
+
+        /* slot was recycled by a newer record before we got here */
+        if (seq > tail + 1) {
+            (*dropped)++;
+            tail++;
+            continue;
+        }
+
+        memcpy(dst, rec, sizeof(logbuf_record_t));
+
+        /* seqlock-style check: was it overwritten while we were copying it? */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) != seq) {
+            (*dropped)++;
+            tail++;
+            continue;
+        }
+
+        tail++;
+        return true;
+    }
+
+    return false;
+}
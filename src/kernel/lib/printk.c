@@ -11,10 +11,27 @@
 #include "kernel/compiler/macro.h"
 #include "kernel/lib/string.h"
 #include "kernel/lib/vsnprintf.h"
+#include "kernel/lib/logbuf.h"
 #include "kernel/device/serial.h"
+#include "kernel/time/jiffies.h"
+#include "kernel/task/workqueue.h"
+
+/* max amount of records drained per deferred flush, keeps the time spent per tick bounded */
+#define PRINTK_FLUSH_BUDGET     16
+
+/* a record as it goes out: "[seconds.millis] text (N dropped)" */
+#define PRINTK_LINE_SIZE        (LOGBUF_TEXT_SIZE + 64)
 
 static uint8_t logging_level = PRINTK_INFO_LEVEL;
-static char buffer[1024];
+
+/* until the timer is up, nobody would flush records for us */
+static bool deferred = false;
+
+/* single consumer guard - a nested flush (e.g. from an IRQ) simply backs off */
+static bool flushing = false;
+
+/* records that were overwritten before they could reach the console */
+static uint64_t dropped = 0;
 
 void printk_init(const uint8_t level) {
     /* sanity checks */
@@ -26,20 +43,113 @@ void printk_init(const uint8_t level) {
     }
 }
 
+void printk_set_deferred(bool enabled) {
+    deferred = enabled;
+
+    /* don't leave anything behind when going back to synchronous mode */
+    if (!enabled)
+        printk_flush();
+}
+
+static size_t line_append(char *line, size_t len, const char *str) {
+    while (*str != '\0' && len < PRINTK_LINE_SIZE - 1)
+        line[len++] = *str++;
+    line[len] = '\0';
+    return len;
+}
+
+static size_t line_append_num(char *line, size_t len, uint64_t value) {
+    char num[24];
+    ulltoa(value, num, 10);
+    return line_append(line, len, num);
+}
+
+/* both writers end the line themselves, every record gets one of its own */
+static void printk_emit(const logbuf_record_t *rec, uint64_t lost) {
+    char line[PRINTK_LINE_SIZE];
+    uint64_t millis = rec->timestamp * 1000 / HZ;
+
+    size_t len = line_append(line, 0, "[");
+    len = line_append_num(line, len, millis / 1000);
+    len = line_append(line, len, ".");
+    for (uint64_t digit = 100; digit > 1 && millis % 1000 < digit; digit /= 10)
+        len = line_append(line, len, "0");
+    len = line_append_num(line, len, millis % 1000);
+    len = line_append(line, len, "] ");
+    len = line_append(line, len, rec->text);
+
+    /* records overwritten before this one could be read */
+    if (lost > 0) {
+        len = line_append(line, len, " (");
+        len = line_append_num(line, len, lost);
+        len = line_append(line, len, " dropped)");
+    }
+
+    write_console(line, len + 1); // copy nul-terminator too
+    write_string_serial(line, len);
+}
+
+static void printk_drain(size_t budget) {
+    if (__atomic_exchange_n(&flushing, true, __ATOMIC_ACQUIRE))
+        return;
+
+    logbuf_record_t rec;
+    uint64_t last_dropped = dropped;
+
+    for (size_t i = 0; i < budget && logbuf_read(&rec, &dropped); i++) {
+        printk_emit(&rec, dropped - last_dropped);
+        last_dropped = dropped;
+    }
+
+    __atomic_store_n(&flushing, false, __ATOMIC_RELEASE);
+}
+
+void printk_flush(void) {
+    printk_drain(SIZE_MAX);
+}
+
+static void printk_flush_work(work_struct_t *work) {
+    (void) work;
+    printk_flush();
+}
+
+static DECLARE_WORK(flush_work, printk_flush_work);
+
+void printk_flush_deferred(void) {
+    /* once kworker is up, draining happens in process context where it can take as long as it needs */
+    if (workqueue_ready()) {
+        schedule_work(&flush_work);
+        return;
+    }
+
+    printk_drain(PRINTK_FLUSH_BUDGET);
+}
+
 void printk(const uint8_t level, const char *fmt, ...) {
     /* check the configured logging level */
     if (level > logging_level)
         return;
 
-    size_t buffer_size = ARR_SIZE(buffer);
-    memset(buffer, '\0', buffer_size);
+    uint64_t pos;
+    logbuf_record_t *rec = logbuf_reserve(&pos);
 
     va_list args;
     va_start(args, fmt);
-    size_t buf_pointer = vsnprintf(buffer, buffer_size - 1, fmt, args);
+    size_t length = vsnprintf(rec->text, LOGBUF_TEXT_SIZE - 1, fmt, args);
     va_end(args);
 
-    write_console(buffer, buf_pointer + 1); // copy nul-terminator too
-    write_string_serial(buffer, buf_pointer);
-}
+    length = MIN(length, LOGBUF_TEXT_SIZE - 1);
+    rec->text[length] = '\0';
+    rec->length = length;
+    rec->timestamp = jiffies;
+
+    logbuf_commit(rec, pos);
 
+    /* errors usually precede a hang, so they can't wait for the next tick */
+    if (!deferred || level == PRINTK_ERR_LEVEL)
+        printk_flush();
+
+    /* ... and neither can the serial IRQ */
+    if (level == PRINTK_ERR_LEVEL)
+        serial_flush();
+}
@@ -59,6 +59,18 @@ void* memset(void *buf, char value, size_t size) {
     return buf;
 }
 
+int memcmp(const void *s1, const void *s2, size_t size) {
+    const unsigned char *p1 = s1;
+    const unsigned char *p2 = s2;
+
+    for (size_t i = 0; i < size; i++) {
+        if (p1[i] != p2[i])
+            return p1[i] - p2[i];
+    }
+
+    return 0;
+}
+
 void* memzero(void *dst, size_t size) {
     return memset(dst, 0, size);
 }
@@ -68,18 +80,23 @@ void* memmove(void *dst, void *src, size_t size) {
     char *t_src = src;
 
     /* sanity check */
-    if (t_src == t_dst)
+    if (t_src == t_dst || size == 0)
         return dst;
 
-    memcpy(t_dst, t_src, size);
-
-    if ((t_dst > t_src && (t_src + size) < t_dst) || (t_src > t_dst && (t_dst + size) < t_src)) {
-        /* they don't interset */
-        memzero(t_src, size);
-    } else if (t_dst > t_src) {
-        memzero(t_src, size - (t_dst - t_src));
+    if (t_dst < t_src || t_dst >= t_src + size) {
+        /* copying forward is safe when dst is behind src or they don't intersect */
+        memcpy(t_dst, t_src, size);
     } else {
-        memzero(t_src + ((t_src + size) - (t_dst + size)), (t_src + size) - (t_dst + size));
+        /* dst overlaps the tail of src, so copy backwards */
+        long d0, d1, d2;
+        asm volatile(
+                "std \n\t"
+                "rep movsb \n\t"
+                "cld \n\t"
+                : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+                : "0" (size), "1" (t_dst + size - 1), "2" (t_src + size - 1)
+                : "memory"
+        );
     }
 
     return dst;
@@ -174,3 +191,13 @@ size_t strlen(const char *buf) {
     return len;
 }
 
+int strcmp(const char *s1, const char *s2) {
+    const unsigned char *p1 = (const unsigned char*) s1;
+    const unsigned char *p2 = (const unsigned char*) s2;
+
+    for (; *p1 != '\0' && *p1 == *p2; p1++, p2++)
+        ;
+
+    return *p1 - *p2;
+}
+
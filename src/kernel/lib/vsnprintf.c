@@ -103,12 +103,16 @@ size_t vsnprintf(char *buf, size_t buf_size, const char *fmt, va_list args) {
                 break;
         } else if (c == '\t') {
             // yes, tab is 4 spaces... if you don't like you can write your own OS ;)
-            for (size_t i = 0; i < 4; i++) {
+            for (size_t i = 0; i < 4 && read_chars < buf_size; i++) {
                 buf[read_chars++] = ' ';
             }
         } else {
             buf[read_chars++] = c;
         }
+
+        // literals are subject to the buf size as much as formatted content
+        if (read_chars >= buf_size)
+            break;
     }
 
     return read_chars;
@@ -4,6 +4,8 @@
 #include "kernel/lib/printk.h"
 #include "kernel/arch/cpu.h"
 #include "kernel/arch/pic.h"
+#include "kernel/arch/acpi.h"
+#include "kernel/arch/apic.h"
 #include "kernel/device/keyboard.h"
 #include "kernel/interrupt/spurious.h"
 #include "kernel/mm/init.h"
@@ -12,8 +14,22 @@
 #include "kernel/arch/pit.h"
 #include "kernel/syscall/init.h"
 #include "kernel/device/serial.h"
+#include "kernel/device/tty.h"
+#include "kernel/device/pci.h"
+#include "kernel/device/ata.h"
+#include "kernel/device/virtio_blk.h"
 #include "kernel/task/scheduler.h"
 #include "kernel/time/rtc.h"
+#include "kernel/interrupt/softirq.h"
+#include "kernel/task/workqueue.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/fs/ramfs.h"
+#include "kernel/fs/vfs.h"
+#include "kernel/fs/devfs.h"
+#include "kernel/fs/ext2.h"
+#include "kernel/debug/bench.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/sys/stat.h"
 
 void kmain(void) {
     /* disable all IRQs */
@@ -35,6 +51,9 @@ void kmain(void) {
     /* Programmable Interrupt Controller */
     pic_init();
 
+    /* bottom halves must be ready before any IRQ handler raises them */
+    softirq_init();
+
     /* Programmable Interval Timerchip */
     pit_init(HZ);
 
@@ -50,15 +69,48 @@ void kmain(void) {
     /* memory management module init */
     mm_init();
 
+    /* root filesystem, unpacked in place from what the boot loader left in low memory */
+    bool rootfs = initramfs_init(INITRAMFS_PHYS_ADDR, INITRAMFS_MAX_SIZE);
+    BUG_ON(!rootfs);
+
+    /* ... reached through the VFS from here on, with device nodes under /dev */
+    vfs_init();
+    vfs_mount_root(ramfs_mount());
+    if (vfs_mount("/dev", devfs_mount()) != 0)
+        printk_error("Can't mount /dev, is it missing from the initramfs?");
+
+    /* route IRQs through the IO-APIC when the firmware describes one, otherwise the PIC carries on */
+    if (acpi_init())
+        apic_init();
+
+    /* enumerate the buses, drivers registered later get bound to what's found here */
+    pci_init();
+
+    /* keyboard + VGA console terminal */
+    tty_init();
+
     /* enabled IRQs */
     spurious_irq_enable();
     keyboard_enable();
+    serial_enable();
     pit_enable();
 
+    /* IDE disks, storage can be read and written at runtime from here on */
+    ata_init();
+    virtio_blk_init();
+
+    /* from now on the timer drains printk records, so callers don't pay for port I/O */
+    printk_set_deferred(true);
+
     /* Calibrate (x)delay functions */
     calibrate_delay();
     printk_info("Calibrated loops_per_jiffy: %.16llu", loops_per_jiffy);
 
+    /* how much does it cost to get in and out of the kernel through an interrupt gate? */
+    bench_interrupt_entry();
+    bench_context_switch();
+    bench_block_read("vda");
+
     /* enable syscalls */
     syscall_init();
 
@@ -68,18 +120,38 @@ void kmain(void) {
     disable_interrupts();
 
     /* initialise scheduler */
-    task_struct_t *init_proc = create_process(0x1C000);
+    ramfs_node_t *init_bin = ramfs_lookup("/bin/init");
+    BUG_ON(init_bin == NULL || !S_ISREG(init_bin->mode));
+    task_struct_t *init_proc = create_process(init_bin->data_phys, init_bin->size);
+    BUG_ON(init_proc == NULL);
     scheduler_init(init_proc);
 
+    /* kworker for deferred work that is too heavy for softirqs */
+    workqueue_init();
+
+    /* block cache and the flusher writing it back */
+    buffer_init();
+
+    /* the first disk with an ext2 file system on it shows up under /mnt */
+    for (block_device_t *disk = block_first_device(); disk != NULL; disk = disk->next) {
+        inode_t *root = ext2_mount(disk);
+        if (root != NULL) {
+            if (vfs_mount("/mnt", root) != 0)
+                printk_error("Can't mount %s on /mnt, is it missing from the initramfs?", disk->name);
+            break;
+        }
+    }
+
     /* test scheduler's ability to switch between tasks */
     for (size_t i = 2; i <= 99; i++) {
-        scheduler_add(create_process(0x1C000));
+        scheduler_add(create_process(init_bin->data_phys, init_bin->size));
     }
 
     enable_interrupts();
 
     /* don't let kmain finish. Among other things, this ensure that interrupts have to to occur */
     for (;;) {
+        printk_flush_deferred();
         asm("hlt");
     }
 }
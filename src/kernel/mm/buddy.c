@@ -129,7 +129,7 @@ static void insert_child_slot(buddy_ref_t *ref, buddy_slot_t *parent, buddy_slot
     memcpy(idx, child, sizeof(buddy_slot_t));
 }
 
-uintptr_t buddy_alloc(buddy_ref_t *ref, uint64_t bytes) {
+bool buddy_try_alloc(buddy_ref_t *ref, uint64_t bytes, uintptr_t *ptr_out) {
     BUG_ON(bytes == 0 || bytes > ref->content_mem_reg.length);
 
     uint8_t k_order = ilog2(clp2(bytes));
@@ -184,6 +184,15 @@ uintptr_t buddy_alloc(buddy_ref_t *ref, uint64_t bytes) {
         }
     }
 
+    /* blocks are only split once a big enough one is found, so failing leaves the tree untouched */
+    *ptr_out = ptr;
+    return found;
+}
+
+uintptr_t buddy_alloc(buddy_ref_t *ref, uint64_t bytes) {
+    uintptr_t ptr;
+    bool found = buddy_try_alloc(ref, bytes, &ptr);
+
     BUG_ON(!found);
     return ptr;
 }
@@ -0,0 +1,122 @@
+/*
+ * fault.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/fault.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/page.h"
+#include "kernel/mm/tlb.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/mmap.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/interrupt/idt.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/task/exit.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Pages that are meant to be writable but may be shared (ELF data backed by the image, bss backed by the zero
+ * page) are mapped read-only with PAGE_COW_BIT. The first write lands here, the process gets a page of its own
+ * and the shared one is never touched. That's why launching another instance of a program only costs the pages
+ * it actually writes to.
+ *
+ * The kernel can take the same fault when it writes into user memory on behalf of a syscall, as CR0.WP makes
+ * supervisor writes honour read-only entries too.
+ *
+ * The zero page and the pages of the boot image are never freed, so a copy of one of them doesn't have to care
+ * about who else maps it. Private file mappings are the exception: their source is a reference counted page of
+ * mm/filemap.c and the copy gives that reference back (mmap_cow_copied).
+ *
+ * Pages that aren't there at all may belong to an mmap'd area that hasn't been touched yet, mm/mmap.c decides.
+ *
+ * Syscalls only check that user pointers are in the user half (mm/uaccess.c), so the kernel can still fault on
+ * one that isn't mapped. Kernel threads never touch the user half, so such a fault in a process is the syscall's
+ * doing and only takes that process down, the same way a bad access from user space does.
+ */
+
+static uint64_t zero_page;
+
+uint64_t cow_zero_page(void) {
+    return zero_page;
+}
+
+/* 0 once the page is a copy of its own, -EFAULT if it isn't COW at all and -ENOMEM if there's no page for it */
+static int handle_cow_fault(task_struct_t *task, uint64_t fault_addr) {
+    pagetable_t *pgtable = &task->vm_area.pgtable;
+    uint64_t v_addr = fault_addr & ~((uint64_t) PAGE_SIZE - 1);
+
+    pte_t *pte = page_lookup(pgtable, v_addr);
+    if (pte == NULL || !(pte->flags & PAGE_COW_BIT))
+        return -EFAULT;
+
+    uint64_t src_phys = (uint64_t) pte->phys_pg_base_addr << PAGE_SHIFT;
+
+    void *copy = kmalloc(PAGE_SIZE, src_phys == zero_page ? KMEM_DEFAULT | KMEM_ZERO : KMEM_DEFAULT);
+    if (copy == NULL)
+        return -ENOMEM;
+
+    if (src_phys != zero_page)
+        memcpy(copy, (void*) va(src_phys), PAGE_SIZE);
+
+    pte->phys_pg_base_addr = PREP_BASE_ADDR(pa((uint64_t) copy));
+    pte->flags = (pte->flags & ~PAGE_COW_BIT) | PAGE_READ_WRITE_BIT | PAGE_OWNED_BIT;
+
+    /* the read-only translation may be cached by every CPU running this address space */
+    mmu_gather_t tlb;
+    tlb_gather_mmu(&tlb, pgtable);
+    tlb_remove_page(&tlb, v_addr);
+    mmap_cow_copied(task, v_addr, &tlb);
+    tlb_finish_mmu(&tlb);
+
+    return 0;
+}
+
+static void page_fault_handler(interrupt_stack_frame_t *int_frame) {
+    uint64_t fault_addr = int_frame->sys_ctrl_regs.cr2;
+    uint64_t error_code = int_frame->error_code;
+    task_struct_t *curr = this_rq()->curr;
+
+    bool user_addr = fault_addr < USER_SPACE_END_ADDR && curr != NULL;
+
+    if (user_addr && !(error_code & PF_ERR_PRESENT) && mmap_fault(curr, fault_addr, error_code))
+        return;
+
+    /* mprotect may have taken writing away from a page that is still COW */
+    bool cow_candidate = user_addr && (error_code & PF_ERR_PRESENT) && (error_code & PF_ERR_WRITE)
+            && mmap_write_allowed(curr, fault_addr);
+
+    int cow = cow_candidate ? handle_cow_fault(curr, fault_addr) : -EFAULT;
+    if (cow == 0)
+        return;
+
+    if (cow == -ENOMEM) {
+        printk_error("pid %d: out of memory copying the page at 0x%llx", curr->pid, fault_addr);
+        do_exit(-ENOMEM);
+    }
+
+    /* a bad access from user space, or by a syscall on its behalf, only takes the process down */
+    bool user_task = curr != NULL && curr->vm_area.pgtable.phys_root != kernel_pagetable()->phys_root;
+    if (user_task && ((error_code & PF_ERR_USER) || fault_addr < USER_SPACE_END_ADDR)) {
+        printk_error("pid %d: segfault at 0x%llx rip 0x%llx error 0x%llx", curr->pid, fault_addr, int_frame->rip,
+                error_code);
+        do_exit(-EFAULT);
+    }
+
+    unhandled_exception(int_frame);
+}
+
+void page_fault_init(void) {
+    void *page = kmalloc(PAGE_SIZE, KMEM_DEFAULT | KMEM_ZERO);
+    BUG_ON(page == NULL);
+    zero_page = pa((uint64_t) page);
+
+    register_exception_handler(PAGE_FAULT_VECTOR, page_fault_handler);
+}
@@ -0,0 +1,204 @@
+/*
+ * filemap.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/filemap.h"
+#include "kernel/fs/buffer.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/mm/init.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/compiler/macro.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * File mappings need every process (and every mapping within one) to see the same page for the same offset of a
+ * file, so pages are looked up here by (dev, ino, index). Not by inode_t: a file system may hand out a different
+ * one for each name of a file (ext2 does for hard links). A page lives for as long as some page-table entry points
+ * at it, MAP_PRIVATE mappings included: they map it read-only and COW, the first write gets a copy (mm/fault.c)
+ * and gives the reference back.
+ *
+ * Whenever the file system can hand one out (map_page), the page is the buffer cache's own page for those blocks,
+ * pinned while it's mapped. There is no second copy of the data then, and read/write see what the mapping does.
+ * The D bit of the entries is collected on unmap and marks the buffer dirty, the flusher takes it from there.
+ *
+ * Anything else (holes, blocks scattered on the device, ramfs) gets a copy read in through read() and written back
+ * through write() once the last mapping of it goes away, if any had it dirty. read/write don't see those pages
+ * until then.
+ *
+ * Callers are page faults and mm syscalls, both of which run with interrupts off, so nothing is locked here.
+ */
+
+static filemap_page_t *pages;
+static filemap_page_t *free_pages;
+static filemap_page_t *page_hash[FILEMAP_HASH_SIZE];
+
+void filemap_init(void) {
+    pages = kmalloc(sizeof(filemap_page_t) * FILEMAP_MAX_PAGES, KMEM_DEFAULT | KMEM_ZERO);
+    BUG_ON(pages == NULL);
+
+    for (size_t i = 0; i < FILEMAP_MAX_PAGES; i++) {
+        pages[i].next = free_pages;
+        free_pages = &pages[i];
+    }
+}
+
+static filemap_page_t** filemap_bucket(const inode_t *inode, uint64_t index) {
+    uint64_t key = ((inode->ino ^ ((uint64_t) inode->dev << 40)) + index) * 0x9e3779b97f4a7c15ULL;
+    return &page_hash[(key >> 32) % FILEMAP_HASH_SIZE];
+}
+
+static filemap_page_t** filemap_find(const inode_t *inode, uint64_t index) {
+    filemap_page_t **link = filemap_bucket(inode, index);
+    while (*link != NULL && ((*link)->dev != inode->dev || (*link)->ino != inode->ino || (*link)->index != index))
+        link = &(*link)->next;
+    return link;
+}
+
+int filemap_read_page(file_t *file, uint64_t index, void *page) {
+    uint64_t pos = index * PAGE_SIZE;
+
+    /* Linux sends SIGBUS for pages entirely past the end of the file, it's a segfault here */
+    if (pos >= file->inode->size)
+        return -EFAULT;
+
+    size_t done = 0;
+    while (done < PAGE_SIZE) {
+        long ret = file->f_op->read(file, (char*) page + done, PAGE_SIZE - done, &pos);
+        if (ret < 0)
+            return (int) ret;
+        if (ret == 0)
+            break;
+        done += ret;
+    }
+
+    memzero((char*) page + done, PAGE_SIZE - done);
+    return 0;
+}
+
+/* the cache's own page if the file system can hand it out, 0 or -errno. Otherwise page->bh.page stays NULL */
+static int filemap_map_cached(filemap_page_t *page, file_t *file, uint64_t index) {
+    page->bh.page = NULL;
+
+    if (file->f_op->map_page == NULL)
+        return 0;
+
+    int ret = file->f_op->map_page(file, index, &page->bh);
+    if (ret == -EINVAL)
+        return 0;
+    if (ret != 0)
+        return ret;
+
+    page->phys_addr = pa((uint64_t) page->bh.data);
+    return 0;
+}
+
+/* a page of its own with the data read in through read() */
+static int filemap_read_copy(filemap_page_t *page, file_t *file, uint64_t index) {
+    void *data = kmalloc(PAGE_SIZE, KMEM_DEFAULT);
+    if (data == NULL)
+        return -ENOMEM;
+
+    int ret = filemap_read_page(file, index, data);
+    if (ret != 0) {
+        kfree(data);
+        return ret;
+    }
+
+    page->phys_addr = pa((uint64_t) data);
+    return 0;
+}
+
+uint64_t filemap_get(file_t *file, uint64_t index) {
+    filemap_page_t **link = filemap_find(file->inode, index);
+    if (*link != NULL) {
+        (*link)->refcount++;
+        return (*link)->phys_addr;
+    }
+
+    /* same as filemap_read_page, the cache may well have blocks past the end of the file */
+    if (index * PAGE_SIZE >= file->inode->size)
+        return 0;
+
+    if (free_pages == NULL) {
+        printk_error("filemap: out of file pages");
+        return 0;
+    }
+
+    filemap_page_t *page = free_pages;
+
+    if (filemap_map_cached(page, file, index) != 0)
+        return 0;
+
+    if (page->bh.page == NULL && filemap_read_copy(page, file, index) != 0)
+        return 0;
+
+    free_pages = page->next;
+
+    page->dev = file->inode->dev;
+    page->ino = file->inode->ino;
+    page->index = index;
+    page->file = fget(file);
+    page->refcount = 1;
+    page->dirty = false;
+
+    page->next = *filemap_bucket(file->inode, index);
+    *filemap_bucket(file->inode, index) = page;
+
+    return page->phys_addr;
+}
+
+/* the part of the page that is within the file goes back, mappings never make a file any bigger */
+static void filemap_writeback(filemap_page_t *page) {
+    /* any name of the file will do, they all share the same data */
+    uint64_t size = page->file->inode->size;
+    uint64_t pos = page->index * PAGE_SIZE;
+    if (pos >= size || page->file->f_op->write == NULL)
+        return;
+
+    size_t length = MIN(PAGE_SIZE, size - pos);
+    long ret = page->file->f_op->write(page->file, (const char*) va(page->phys_addr), length, &pos);
+    if (ret < 0)
+        printk_error("filemap: writeback of inode %llu page %llu failed: %ld", page->ino, page->index, ret);
+}
+
+void filemap_put(file_t *file, uint64_t index, bool dirty, mmu_gather_t *tlb) {
+    filemap_page_t **link = filemap_find(file->inode, index);
+
+    /* sanity check - whoever mapped it took a reference */
+    BUG_ON(*link == NULL);
+
+    filemap_page_t *page = *link;
+    page->dirty |= dirty;
+
+    if (--page->refcount > 0)
+        return;
+
+    *link = page->next;
+
+    /*
+     * The cache can't reuse the page before tlb is flushed: nothing that allocates from it runs in between, as
+     * whoever unmaps does so with interrupts off
+     */
+    if (page->bh.page != NULL) {
+        if (page->dirty)
+            mark_buffer_dirty(&page->bh);
+        brelse(&page->bh);
+    } else {
+        if (page->dirty)
+            filemap_writeback(page);
+        tlb_remove_frame(tlb, page->phys_addr);
+    }
+
+    fput(page->file);
+
+    page->next = free_pages;
+    free_pages = page;
+}
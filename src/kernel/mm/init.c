@@ -7,6 +7,10 @@
 
 #include "kernel/mm/init.h"
 #include "kernel/mm/page.h"
+#include "kernel/mm/pcid.h"
+#include "kernel/mm/tlb.h"
+#include "kernel/mm/fault.h"
+#include "kernel/mm/mmap.h"
 #include "kernel/mm/pageframe.h"
 #include "kernel/mm/pagetable.h"
 #include "kernel/mm/kmem.h"
@@ -69,6 +73,9 @@ static void paging_setup(uint64_t total_kern_space) {
     /* Calculate space required to hold page table struct to accomodate the entire kernel space */
     uint64_t paging_mem = paging_calc_space_needed(total_kern_space);
 
+    /* plus one PDPT per kernel-half PML4 entry (see paging_populate_kernel_half) */
+    paging_mem += (PML4_ENTRIES - PML4_KERNEL_FIRST_ENTRY) * PAGE_SIZE;
+
     /* linked list that store references of free/used pages */
     uint64_t pfdb_mem = pageframe_calc_space_needed(paging_mem);
 
@@ -85,6 +92,7 @@ static void paging_setup(uint64_t total_kern_space) {
     print_mem_alloc("K_PFDB_STR", &k_pfdb_struct_rg);
 
     paging_init(kernel_pagetable(), k_pages_struct_rg, k_pfdb_struct_rg);
+    paging_populate_kernel_half(kernel_pagetable());
 
     /* identity-map all the way to the end kernel text */
     paging_contiguous_map(kernel_pagetable(),
@@ -134,5 +142,17 @@ void mm_init(void) {
 
     /* Reload CR3 with new Paging structure */
     paging_reload_cr3(kernel_pagetable());
+
+    /* tag TLB entries per address space from now on, CR3 must hold PCID 0 when this is turned on */
+    pcid_init();
+
+    /* batched TLB invalidation, including the IPI other CPUs get to flush theirs */
+    tlb_init();
+
+    /* copy-on-write and the shared zero page behind user bss */
+    page_fault_init();
+
+    /* areas and shared file pages behind mmap */
+    mmap_init();
 }
 
@@ -0,0 +1,37 @@
+/*
+ * ioremap.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/ioremap.h"
+#include "kernel/mm/page.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/mm/init.h"
+
+/*
+ * Notes to myself:
+ *
+ * The kernel page table only maps what the kernel image and kmalloc use, so things like the IO-APIC registers
+ * (0xfec00000) or the ACPI tables at the top of RAM would page fault. These end up at the same spot they would
+ * have in the higher-half direct map (va(phys)), which keeps pa()/va() valid for them.
+ */
+
+static void* remap(uint64_t phys_addr, uint64_t length, uint16_t flags) {
+    uint64_t start = phys_addr & ~((uint64_t) PAGE_SIZE - 1);
+    uint64_t end = phys_addr + length - 1;
+
+    paging_contiguous_map(kernel_pagetable(), start, end, va(start), flags);
+
+    return (void*) va(phys_addr);
+}
+
+void* ioremap(uint64_t phys_addr, uint64_t length) {
+    /* device registers have side effects, they must never be cached */
+    return remap(phys_addr, length, PAGE_STD_BITS | PAGE_PL_CACHEDIS_BIT | PAGE_PL_WRITETHR_BIT);
+}
+
+void* memremap(uint64_t phys_addr, uint64_t length) {
+    return remap(phys_addr, length, PAGE_STD_BITS);
+}
@@ -8,10 +8,12 @@
 #include "kernel/mm/kmem.h"
 #include "kernel/mm/init.h"
 #include "kernel/mm/buddy.h"
+#include "kernel/mm/shrinker.h"
 #include "kernel/mm/page.h"
 #include "kernel/mm/addressconv.h"
 #include "kernel/arch/mem.h"
 #include "kernel/lib/string.h"
+#include "kernel/compiler/bug.h"
 
 static buddy_ref_t k_mem_alloc;
 
@@ -35,7 +37,14 @@ void kmem_init(mem_map_region_t k_mem_header_rg, mem_map_region_t k_mem_content_
 }
 
 void* kmalloc(uint64_t bytes, int flags) {
-    uintptr_t phy_addr = buddy_alloc(&k_mem_alloc, bytes);
+    uintptr_t phy_addr;
+
+    /* out of memory, ask caches to give some back before giving up */
+    while (!buddy_try_alloc(&k_mem_alloc, bytes, &phy_addr)) {
+        uint64_t freed = shrink_memory(bytes);
+        BUG_ON(freed == 0);
+    }
+
     uintptr_t va_addr = va(phy_addr);
 
     if (!(flags & KMEM_RAW_ALLOC)) {
@@ -0,0 +1,532 @@
+/*
+ * mmap.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/mmap.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/page.h"
+#include "kernel/mm/tlb.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/fault.h"
+#include "kernel/mm/filemap.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/arch/cpu.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/lib/math.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/sys/mman.h"
+#include "kernel/sys/fcntl.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * mmap only records a vma_t in the task's sorted list, nothing is mapped until the page is touched and the page
+ * fault comes here (mmap_fault). So reserving a big range costs one vma_t and the pages actually used:
+ *
+ *  - anonymous memory: a read maps the zero page COW (see mm/fault.c), a write gets a zeroed page of its own;
+ *  - MAP_SHARED files: the page every mapping of that offset shares (see mm/filemap.c), which is the buffer
+ *    cache's own page whenever the file system allows it. Dirty ones are written back to the file;
+ *  - MAP_PRIVATE files: a read maps that same page COW, a write gets a copy of its own and changes never make it
+ *    back.
+ *
+ * Every page a mapping gets for itself is PAGE_OWNED_BIT, so munmap hands it to the gather and paging_teardown
+ * frees whatever is left on exit. File pages are reference counted instead, which is why mmap_exit has to unmap
+ * file areas before the page table goes, and why a COW copy gives its reference back (mmap_cow_copied).
+ *
+ * Areas sit at USER_MMAP_BASE and above, the executable, its stack and heap are all below it. MAP_FIXED can't go
+ * lower either, otherwise it could unmap pages of the executable that don't belong to any area.
+ *
+ * The heap is an anonymous area like any other, it just starts right after the executable and brk grows or shrinks
+ * it from the top (where it merges with what was there already).
+ *
+ * mprotect changes the entries already there too. COW entries stay read-only whatever the protection is, the
+ * fault handler asks mmap_write_allowed before giving them a copy. PROT_NONE clears the present bit and leaves the
+ * rest of the entry alone, so the page survives until the protection is changed back.
+ */
+
+#define PAGE_MASK           (~((uint64_t) PAGE_SIZE - 1))
+
+static vma_t *areas;
+static vma_t *free_areas;
+
+void mmap_init(void) {
+    areas = kmalloc(sizeof(vma_t) * MMAP_MAX_AREAS, KMEM_DEFAULT | KMEM_ZERO);
+    BUG_ON(areas == NULL);
+
+    for (size_t i = 0; i < MMAP_MAX_AREAS; i++) {
+        areas[i].next = free_areas;
+        free_areas = &areas[i];
+    }
+
+    filemap_init();
+}
+
+static vma_t* vma_alloc(void) {
+    vma_t *vma = free_areas;
+    if (vma != NULL)
+        free_areas = vma->next;
+    return vma;
+}
+
+static void vma_free(vma_t *vma) {
+    if (vma->file != NULL)
+        fput(vma->file);
+
+    vma->next = free_areas;
+    free_areas = vma;
+}
+
+static mm_vm_area_t* current_mm(void) {
+    task_struct_t *curr = this_rq()->curr;
+
+    /* sanity check */
+    BUG_ON(curr == NULL);
+
+    return &curr->vm_area;
+}
+
+static vma_t* vma_find(mm_vm_area_t *mm, uint64_t addr) {
+    for (vma_t *vma = mm->mmap; vma != NULL && vma->start <= addr; vma = vma->next) {
+        if (addr < vma->end)
+            return vma;
+    }
+
+    return NULL;
+}
+
+/* page of the file v_addr maps */
+static uint64_t vma_index(const vma_t *vma, uint64_t v_addr) {
+    return (vma->offset + (v_addr - vma->start)) / PAGE_SIZE;
+}
+
+/* vma keeps [start, addr) and the new area after it gets [addr, end). NULL if there are no areas left */
+static vma_t* vma_split(vma_t *vma, uint64_t addr) {
+    vma_t *upper = vma_alloc();
+    if (upper == NULL)
+        return NULL;
+
+    *upper = *vma;
+    upper->start = addr;
+    upper->offset += addr - vma->start;
+    if (upper->file != NULL)
+        fget(upper->file);
+
+    vma->end = addr;
+    vma->next = upper;
+    return upper;
+}
+
+static bool vma_can_merge(const vma_t *prev, const vma_t *next) {
+    return prev->end == next->start && prev->prot == next->prot && prev->flags == next->flags
+            && prev->file == next->file
+            && (prev->file == NULL || prev->offset + (prev->end - prev->start) == next->offset);
+}
+
+/* a malloc calling mmap over and over ends up with a single area rather than one per call */
+static void vma_merge(vma_t *prev, vma_t *vma) {
+    vma_t *next = vma->next;
+    if (next != NULL && vma_can_merge(vma, next)) {
+        vma->end = next->end;
+        vma->next = next->next;
+        vma_free(next);
+    }
+
+    if (prev != NULL && vma_can_merge(prev, vma)) {
+        prev->end = vma->end;
+        prev->next = vma->next;
+        vma_free(vma);
+    }
+}
+
+static bool vma_range_free(mm_vm_area_t *mm, uint64_t start, uint64_t end) {
+    for (vma_t *vma = mm->mmap; vma != NULL && vma->start < end; vma = vma->next) {
+        if (start < vma->end)
+            return false;
+    }
+
+    return true;
+}
+
+/* first gap of length bytes from USER_MMAP_BASE up, 0 if there is none */
+static uint64_t vma_find_gap(mm_vm_area_t *mm, uint64_t length) {
+    uint64_t addr = USER_MMAP_BASE;
+
+    for (vma_t *vma = mm->mmap; vma != NULL; vma = vma->next) {
+        if (vma->end <= addr)
+            continue;
+        if (vma->start >= addr + length)
+            break;
+        addr = vma->end;
+    }
+
+    if (length > USER_SPACE_END_ADDR - addr)
+        return 0;
+
+    return addr;
+}
+
+static void vma_unmap_pages(pagetable_t *pgtable, vma_t *vma, mmu_gather_t *tlb) {
+    for (uint64_t v_addr = vma->start; v_addr < vma->end; v_addr += PAGE_SIZE) {
+        pte_t *pte = page_lookup(pgtable, v_addr);
+        if (pte == NULL)
+            continue;
+
+        uint64_t phys_addr = (uint64_t) pte->phys_pg_base_addr << PAGE_SHIFT;
+        uint16_t flags = pte->flags;
+        page_unmap(tlb, v_addr);
+
+        if (flags & PAGE_OWNED_BIT)
+            tlb_remove_frame(tlb, phys_addr);
+        else if (vma->file != NULL)
+            filemap_put(vma->file, vma_index(vma, v_addr), flags & PAGE_DIRTY_BIT, tlb);
+    }
+}
+
+static void vma_set_pte_prot(pte_t *pte, int prot) {
+    uint16_t flags = pte->flags & ~(PAGE_PRESENT_BIT | PAGE_READ_WRITE_BIT);
+
+    if (prot != PROT_NONE)
+        flags |= PAGE_PRESENT_BIT;
+
+    /* COW pages stay read-only, the fault gives them a copy once writing is allowed */
+    if ((prot & PROT_WRITE) && !(flags & PAGE_COW_BIT))
+        flags |= PAGE_READ_WRITE_BIT;
+
+    pte->flags = flags;
+    pte->no_execute_bit = !(prot & PROT_EXEC) && cpu_nx_enabled();
+}
+
+/* [addr, addr + length) has to be free, false if there are no areas left */
+static bool vma_insert(mm_vm_area_t *mm, uint64_t addr, uint64_t length, int prot, int flags, file_t *file,
+        uint64_t offset) {
+    vma_t *vma = vma_alloc();
+    if (vma == NULL)
+        return false;
+
+    vma->start = addr;
+    vma->end = addr + length;
+    vma->prot = prot;
+    vma->flags = flags;
+    vma->file = file != NULL ? fget(file) : NULL;
+    vma->offset = offset;
+
+    vma_t *prev = NULL;
+    vma_t **link = &mm->mmap;
+    while (*link != NULL && (*link)->start < addr) {
+        prev = *link;
+        link = &prev->next;
+    }
+
+    vma->next = *link;
+    *link = vma;
+    vma_merge(prev, vma);
+
+    return true;
+}
+
+/**
+ * addr: where the caller would like the mapping, only taken as a hint unless flags has MAP_FIXED
+ * file: ignored for MAP_ANONYMOUS, the mapping takes a reference of its own
+ * offset: where in the file the mapping starts, page aligned
+ *
+ * returns the address of the mapping or -errno
+ */
+long do_mmap(uint64_t addr, size_t length, int prot, int flags, file_t *file, uint64_t offset) {
+    mm_vm_area_t *mm = current_mm();
+
+    int type = flags & (MAP_SHARED | MAP_PRIVATE);
+    if (length == 0 || type == 0 || type == (MAP_SHARED | MAP_PRIVATE) || (offset & ~PAGE_MASK))
+        return -EINVAL;
+
+    if (prot & ~(PROT_READ | PROT_WRITE | PROT_EXEC))
+        return -EINVAL;
+
+    if (length > USER_SPACE_END_ADDR - USER_MMAP_BASE)
+        return -ENOMEM;
+    length = round_up_po2(length, PAGE_SIZE);
+
+    if (flags & MAP_ANONYMOUS) {
+        file = NULL;
+        offset = 0;
+    } else {
+        if (file == NULL)
+            return -EBADF;
+
+        if (!S_ISREG(file->inode->mode) || file->f_op == NULL || file->f_op->read == NULL)
+            return -ENODEV;
+
+        int accmode = file->flags & O_ACCMODE;
+        if (accmode == O_WRONLY || (type == MAP_SHARED && (prot & PROT_WRITE) && accmode != O_RDWR))
+            return -EACCES;
+    }
+
+    if (flags & MAP_FIXED) {
+        if ((addr & ~PAGE_MASK) || addr < USER_MMAP_BASE || length > USER_SPACE_END_ADDR - addr)
+            return -EINVAL;
+
+        /* whatever was there is replaced */
+        long ret = do_munmap(addr, length);
+        if (ret != 0)
+            return ret;
+    } else if ((addr & ~PAGE_MASK) || addr < USER_MMAP_BASE || length > USER_SPACE_END_ADDR - addr
+            || !vma_range_free(mm, addr, addr + length)) {
+        addr = vma_find_gap(mm, length);
+        if (addr == 0)
+            return -ENOMEM;
+    }
+
+    if (!vma_insert(mm, addr, length, prot, type | (flags & MAP_ANONYMOUS), file, offset))
+        return -ENOMEM;
+
+    return (long) addr;
+}
+
+/**
+ * addr: page aligned, length is rounded up to whole pages. Parts of the range that aren't mapped are fine
+ *
+ * returns 0 or -errno
+ */
+long do_munmap(uint64_t addr, size_t length) {
+    mm_vm_area_t *mm = current_mm();
+
+    if ((addr & ~PAGE_MASK) || length == 0 || addr >= USER_SPACE_END_ADDR || length > USER_SPACE_END_ADDR - addr)
+        return -EINVAL;
+
+    uint64_t end = addr + round_up_po2(length, PAGE_SIZE);
+    long ret = 0;
+
+    mmu_gather_t tlb;
+    tlb_gather_mmu(&tlb, &mm->pgtable);
+
+    vma_t **link = &mm->mmap;
+    while (*link != NULL && (*link)->start < end) {
+        vma_t *vma = *link;
+
+        if (vma->end <= addr) {
+            link = &vma->next;
+            continue;
+        }
+
+        /* only the upper part goes, it's the next one to look at */
+        if (vma->start < addr) {
+            if (vma_split(vma, addr) == NULL) {
+                ret = -ENOMEM;
+                break;
+            }
+            link = &vma->next;
+            continue;
+        }
+
+        if (vma->end > end && vma_split(vma, end) == NULL) {
+            ret = -ENOMEM;
+            break;
+        }
+
+        vma_unmap_pages(&mm->pgtable, vma, &tlb);
+        *link = vma->next;
+        vma_free(vma);
+    }
+
+    tlb_finish_mmu(&tlb);
+    return ret;
+}
+
+/**
+ * addr: page aligned, length is rounded up to whole pages. All of the range has to be mapped
+ *
+ * returns 0 or -errno
+ */
+long do_mprotect(uint64_t addr, size_t length, int prot) {
+    mm_vm_area_t *mm = current_mm();
+
+    if ((addr & ~PAGE_MASK) || addr >= USER_SPACE_END_ADDR || length > USER_SPACE_END_ADDR - addr)
+        return -EINVAL;
+
+    if (prot & ~(PROT_READ | PROT_WRITE | PROT_EXEC))
+        return -EINVAL;
+
+    if (length == 0)
+        return 0;
+
+    uint64_t end = addr + round_up_po2(length, PAGE_SIZE);
+
+    /* checked before anything changes, so a failure leaves the range as it was */
+    uint64_t mapped = addr;
+    for (vma_t *vma = vma_find(mm, addr); vma != NULL && vma->start <= mapped && mapped < end; vma = vma->next) {
+        if ((prot & PROT_WRITE) && vma->file != NULL && (vma->flags & MAP_SHARED)
+                && (vma->file->flags & O_ACCMODE) != O_RDWR)
+            return -EACCES;
+
+        mapped = vma->end;
+    }
+
+    if (mapped < end)
+        return -ENOMEM;
+
+    long ret = 0;
+
+    mmu_gather_t tlb;
+    tlb_gather_mmu(&tlb, &mm->pgtable);
+
+    for (vma_t *vma = vma_find(mm, addr); vma != NULL && vma->start < end; vma = vma->next) {
+        /* the upper part is the next one */
+        if (vma->start < addr) {
+            if (vma_split(vma, addr) == NULL) {
+                ret = -ENOMEM;
+                break;
+            }
+            continue;
+        }
+
+        if (vma->end > end && vma_split(vma, end) == NULL) {
+            ret = -ENOMEM;
+            break;
+        }
+
+        vma->prot = prot;
+
+        for (uint64_t v_addr = vma->start; v_addr < vma->end; v_addr += PAGE_SIZE) {
+            pte_t *pte = page_lookup(&mm->pgtable, v_addr);
+            if (pte == NULL)
+                continue;
+
+            vma_set_pte_prot(pte, prot);
+            tlb_remove_page(&tlb, v_addr);
+        }
+    }
+
+    tlb_finish_mmu(&tlb);
+    return ret;
+}
+
+/**
+ * brk: new program break, anywhere from the end of the executable up to USER_MMAP_BASE
+ *
+ * returns the program break, which is the old one if it couldn't be moved (same as Linux)
+ */
+long do_brk(uint64_t brk) {
+    mm_vm_area_t *mm = current_mm();
+
+    if (brk < mm->brk_start || brk > USER_MMAP_BASE)
+        return (long) mm->brk;
+
+    /* the heap is an anonymous area of whole pages, only the break itself can be anywhere */
+    uint64_t old_end = round_up_po2(mm->brk, PAGE_SIZE);
+    uint64_t new_end = round_up_po2(brk, PAGE_SIZE);
+
+    if (new_end < old_end && do_munmap(new_end, old_end - new_end) != 0)
+        return (long) mm->brk;
+
+    if (new_end > old_end) {
+        if (!vma_range_free(mm, old_end, new_end))
+            return (long) mm->brk;
+
+        if (!vma_insert(mm, old_end, new_end - old_end, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, NULL, 0))
+            return (long) mm->brk;
+    }
+
+    mm->brk = brk;
+    return (long) brk;
+}
+
+static bool vma_access_ok(const vma_t *vma, uint64_t error_code) {
+    if (error_code & PF_ERR_WRITE)
+        return vma->prot & PROT_WRITE;
+
+    if (error_code & PF_ERR_INSTR)
+        return vma->prot & PROT_EXEC;
+
+    /* x86 can't map anything write or execute only, both imply read */
+    return vma->prot != PROT_NONE;
+}
+
+bool mmap_fault(task_struct_t *task, uint64_t fault_addr, uint64_t error_code) {
+    mm_vm_area_t *mm = &task->vm_area;
+
+    vma_t *vma = vma_find(mm, fault_addr);
+    if (vma == NULL || !vma_access_ok(vma, error_code))
+        return false;
+
+    /* only PROT_NONE leaves an entry that isn't present, and that never gets this far */
+    uint64_t v_addr = fault_addr & PAGE_MASK;
+    if (page_lookup(&mm->pgtable, v_addr) != NULL)
+        return false;
+
+    uint16_t flags = PAGE_PRESENT_BIT | PAGE_USER_SUPERVISOR_BIT;
+    if (!(vma->prot & PROT_EXEC))
+        flags |= PAGE_NO_EXEC_BIT;
+
+    uint64_t phys_addr;
+    if (vma->file != NULL && ((vma->flags & MAP_SHARED) || !(error_code & PF_ERR_WRITE))) {
+        phys_addr = filemap_get(vma->file, vma_index(vma, v_addr));
+        if (phys_addr == 0)
+            return false;
+
+        /* private mappings share it until they write to it */
+        if (vma->flags & MAP_PRIVATE)
+            flags |= PAGE_COW_BIT;
+        else if (vma->prot & PROT_WRITE)
+            flags |= PAGE_READ_WRITE_BIT;
+
+    } else if (vma->file == NULL && !(error_code & PF_ERR_WRITE)) {
+        /* nobody wrote to it yet, the zero page will do until someone does */
+        phys_addr = cow_zero_page();
+        flags |= PAGE_COW_BIT;
+
+    } else {
+        void *page = kmalloc(PAGE_SIZE, vma->file != NULL ? KMEM_DEFAULT : KMEM_DEFAULT | KMEM_ZERO);
+        if (page == NULL)
+            return false;
+
+        if (vma->file != NULL && filemap_read_page(vma->file, vma_index(vma, v_addr), page) != 0) {
+            kfree(page);
+            return false;
+        }
+
+        phys_addr = pa((uint64_t) page);
+        flags |= PAGE_OWNED_BIT;
+        if (vma->prot & PROT_WRITE)
+            flags |= PAGE_READ_WRITE_BIT;
+    }
+
+    /* a not-present entry is never cached by the TLB, there is nothing to invalidate */
+    page_alloc(&mm->pgtable, v_addr, phys_addr, flags);
+    return true;
+}
+
+void mmap_cow_copied(task_struct_t *task, uint64_t v_addr, mmu_gather_t *tlb) {
+    vma_t *vma = vma_find(&task->vm_area, v_addr);
+
+    /* the zero page and the pages of the executable aren't reference counted, file pages are */
+    if (vma != NULL && vma->file != NULL)
+        filemap_put(vma->file, vma_index(vma, v_addr), false, tlb);
+}
+
+bool mmap_write_allowed(task_struct_t *task, uint64_t fault_addr) {
+    vma_t *vma = vma_find(&task->vm_area, fault_addr);
+    return vma == NULL || (vma->prot & PROT_WRITE);
+}
+
+void mmap_exit(task_struct_t *task) {
+    mm_vm_area_t *mm = &task->vm_area;
+
+    mmu_gather_t tlb;
+    tlb_gather_mmu(&tlb, &mm->pgtable);
+
+    while (mm->mmap != NULL) {
+        vma_t *vma = mm->mmap;
+        mm->mmap = vma->next;
+
+        /* anonymous pages belong to the page table, paging_teardown frees them all in one walk */
+        if (vma->file != NULL)
+            vma_unmap_pages(&mm->pgtable, vma, &tlb);
+
+        vma_free(vma);
+    }
+
+    tlb_finish_mmu(&tlb);
+}
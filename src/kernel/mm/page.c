@@ -8,17 +8,18 @@
 #include "kernel/mm/page.h"
 #include "kernel/compiler/bug.h"
 #include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
 #include "kernel/mm/pageframe.h"
+#include "kernel/mm/pcid.h"
+#include "kernel/mm/tlb.h"
 #include "kernel/mm/addressconv.h"
 #include "kernel/asm/generic.h"
+#include "kernel/arch/cpu.h"
 #include "kernel/lib/string.h"
 #include "kernel/lib/math.h"
 #include "kernel/lib/bit.h"
 #include "kernel/lib/printk.h"
 
-#define PAGE_SHIFT                  12
-#define PREP_BASE_ADDR(addr)        (((addr) >> PAGE_SHIFT) & (UINT64_MAX >> (sizeof(uint64_t) * CHAR_BIT - (64-36))))
-
 #define PML4E(a)                    (extract_bit_chunk(39, 47, a))
 #define PDPTE(a)                    (extract_bit_chunk(30, 38, a))
 #define PDE(a)                      (extract_bit_chunk(21, 29, a))
@@ -69,12 +70,34 @@ void paging_init(pagetable_t *pgtable, mem_map_region_t k_pages_struct_rg, mem_m
     /* allocate the root page table that will be used across the OS */
     pgtable->phys_root = pageframe_alloc(&pgtable->pfdb);
     pgtable->virt_root = va(pgtable->phys_root);
+
+    /* gets a PCID the first time it's loaded */
+    pgtable->pcid = 0;
+    pgtable->pcid_gen = 0;
+    pgtable->cpumask = 0;
 }
 
 __force_inline static bool is_page_entry_empty(void *entry) {
     return *((uint64_t*) entry) == 0;
 }
 
+void paging_populate_kernel_half(pagetable_t *pgtable) {
+    pml4e_t *pml4_pgtable = (pml4e_t*) pgtable->virt_root;
+
+    for (size_t i = PML4_KERNEL_FIRST_ENTRY; i < PML4_ENTRIES; i++) {
+        if (!is_page_entry_empty(&pml4_pgtable[i]))
+            continue;
+
+        pml4e_t entry = {
+                .no_execute_bit = 0,
+                .available_guardhole = 0,
+                .pdpe_base_addr = PREP_BASE_ADDR(pageframe_alloc(&pgtable->pfdb)),
+                .flags = PAGE_STD_BITS
+        };
+        pml4_pgtable[i] = entry;
+    }
+}
+
 void page_alloc(pagetable_t *pgtable, uint64_t v_addr, uint64_t p_dest_addr, uint16_t flags) {
 
     /* decompose virtual address into pagetable indexes */
@@ -83,77 +106,106 @@ void page_alloc(pagetable_t *pgtable, uint64_t v_addr, uint64_t p_dest_addr, uin
     uint16_t pd_idx = PDE(v_addr);
     uint16_t pt_idx = PTE(v_addr);
 
+    /*
+     * the most restrictive of all levels wins, so tables stay as permissive as possible and the leaf entry
+     * alone decides on R/W and NX. Otherwise whatever got mapped first would dictate it for the other 511 entries
+     */
+    uint16_t table_flags = PAGE_PRESENT_BIT | PAGE_READ_WRITE_BIT | (flags & PAGE_USER_SUPERVISOR_BIT);
+
     /* Alloc PML4if needed */
     pml4e_t *pml4_pgtable = (pml4e_t*) pgtable->virt_root;
     if (is_page_entry_empty(&pml4_pgtable[pm4l_idx])) {
-        uintptr_t pdp_pgtable_addr = pageframe_alloc(&pgtable->pfdb);
+        uintptr_t pdp_pgtable_addr = pagetable_alloc_table(pgtable);
 
         pml4e_t hh_pml4_entry = {
                 .no_execute_bit = 0,
                 .available_guardhole = 0,
                 .pdpe_base_addr = PREP_BASE_ADDR(pdp_pgtable_addr),
-                .flags = flags
+                .flags = table_flags
         };
 
         pml4_pgtable[pm4l_idx] = hh_pml4_entry;
+    } else {
+        pml4_pgtable[pm4l_idx].flags |= table_flags;
     }
 
     /* Alloc PDP if needed */
     pdpe_t *pdp_pgtable = (pdpe_t*) va(pml4_pgtable[pm4l_idx].pdpe_base_addr << PAGE_SHIFT);
     if (is_page_entry_empty(&pdp_pgtable[pdp_idx])) {
-        uintptr_t pd_pgtable_addr = pageframe_alloc(&pgtable->pfdb);
+        uintptr_t pd_pgtable_addr = pagetable_alloc_table(pgtable);
 
         pdpe_t hh_pdpe_entry = {
                 .no_execute_bit = 0,
                 .available_guardhole = 0,
                 .pde_base_addr = PREP_BASE_ADDR(pd_pgtable_addr),
-                .flags = flags
+                .flags = table_flags
         };
 
         pdp_pgtable[pdp_idx] = hh_pdpe_entry;
+    } else {
+        pdp_pgtable[pdp_idx].flags |= table_flags;
     }
 
     /* Alloc PD if needed */
     pde_t *pd_pgtable = (pde_t*) va(pdp_pgtable[pdp_idx].pde_base_addr << PAGE_SHIFT);
     if (is_page_entry_empty(&pd_pgtable[pd_idx])) {
-        uintptr_t pt_pgtable_addr = pageframe_alloc(&pgtable->pfdb);
+        uintptr_t pt_pgtable_addr = pagetable_alloc_table(pgtable);
 
         pde_t hh_pde_entry = {
                 .no_execute_bit = 0,
                 .available_guardhole = 0,
                 .pte_base_addr = PREP_BASE_ADDR(pt_pgtable_addr),
-                .flags = flags
+                .flags = table_flags
         };
         pd_pgtable[pd_idx] = hh_pde_entry;
+    } else {
+        pd_pgtable[pd_idx].flags |= table_flags;
     }
 
     /* Alloc PT if needed */
     pte_t *pt_pgtable = (pte_t*) va(pd_pgtable[pd_idx].pte_base_addr << PAGE_SHIFT);
     if (is_page_entry_empty(&pt_pgtable[pt_idx])) {
         pte_t hh_pte_entry = {
-                .no_execute_bit = 0,
+                .no_execute_bit = (flags & PAGE_NO_EXEC_BIT) && cpu_nx_enabled(),
                 .available_guardhole = 0,
                 .phys_pg_base_addr = PREP_BASE_ADDR(p_dest_addr),
-                .flags = flags
+                .flags = flags & ~PAGE_NO_EXEC_BIT
         };
         pt_pgtable[pt_idx] = hh_pte_entry;
     }
 
 }
 
+pte_t* page_lookup(pagetable_t *pgtable, uint64_t v_addr) {
+    pml4e_t *pml4_pgtable = (pml4e_t*) pgtable->virt_root;
+    if (is_page_entry_empty(&pml4_pgtable[PML4E(v_addr)]))
+        return NULL;
+
+    pdpe_t *pdp_pgtable = (pdpe_t*) va(pml4_pgtable[PML4E(v_addr)].pdpe_base_addr << PAGE_SHIFT);
+    if (is_page_entry_empty(&pdp_pgtable[PDPTE(v_addr)]))
+        return NULL;
+
+    pde_t *pd_pgtable = (pde_t*) va(pdp_pgtable[PDPTE(v_addr)].pde_base_addr << PAGE_SHIFT);
+    if (is_page_entry_empty(&pd_pgtable[PDE(v_addr)]))
+        return NULL;
+
+    pte_t *pt_pgtable = (pte_t*) va(pd_pgtable[PDE(v_addr)].pte_base_addr << PAGE_SHIFT);
+    if (is_page_entry_empty(&pt_pgtable[PTE(v_addr)]))
+        return NULL;
+
+    return &pt_pgtable[PTE(v_addr)];
+}
+
 static bool is_pagetable_empty(const void *pgtable) {
-    bool ret = true;
-    const char *src = (const char*) pgtable;
-    for (size_t i = 0; i < 512; i++) {
-        if (*src != 0) {
-            ret = false;
-            break;
-        }
+    const uint64_t *entries = (const uint64_t*) pgtable;
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+        if (entries[i] != 0)
+            return false;
     }
-    return ret;
+    return true;
 }
 
-static bool page_free_resources(pagetable_t *pgtable, uint64_t pgt_phy_addr, uint64_t v_addr, int level) {
+static bool page_free_resources(mmu_gather_t *tlb, uint64_t pgt_phy_addr, uint64_t v_addr, int level) {
 
     if (level <= 0)
         return true;
@@ -173,15 +225,27 @@ static bool page_free_resources(pagetable_t *pgtable, uint64_t pgt_phy_addr, uin
         fatal();
 
     uintptr_t *page_entry = (uintptr_t*) va((pgt_phy_addr + (idx * sizeof(uint64_t))));
+
+    /* nothing mapped down this path */
+    if (is_page_entry_empty(page_entry))
+        return false;
+
     uint64_t lpgt_phy_base_addr = extract_bit_chunk(12, 51, *page_entry) << PAGE_SHIFT;
 
-    if (page_free_resources(pgtable, lpgt_phy_base_addr, v_addr, level - 1)) {
+    if (page_free_resources(tlb, lpgt_phy_base_addr, v_addr, level - 1)) {
         /* zero-out entry that is about to be freed */
         memzero(page_entry, sizeof(uint64_t));
 
-        /* delete pageframe if possible */
+        /*
+         * the root goes away with its address space and kernel-half PDPTs are shared by every root, so neither
+         * is ever freed here
+         */
+        if (level == 4 || (level == 3 && PML4E(v_addr) >= PML4_KERNEL_FIRST_ENTRY))
+            return false;
+
+        /* delete pageframe if possible - only once nobody's TLB can walk through it anymore */
         if (is_pagetable_empty(pgt_virt_addr)) {
-            pageframe_free(&pgtable->pfdb, pgt_phy_addr);
+            tlb_remove_table(tlb, pgt_phy_addr);
             return true;
         }
     }
@@ -190,12 +254,18 @@ static bool page_free_resources(pagetable_t *pgtable, uint64_t pgt_phy_addr, uin
 
 }
 
-void page_free(pagetable_t *pgtable, uint64_t v_addr) {
+void page_unmap(mmu_gather_t *tlb, uint64_t v_addr) {
+    tlb_remove_page(tlb, v_addr);
+
     /* free pagetables and pageframes where possible */
-    page_free_resources(pgtable, pgtable->phys_root, v_addr, 4);
+    page_free_resources(tlb, tlb->pgtable->phys_root, v_addr, 4);
+}
 
-    /* invalidate entry */
-    invalidate_page(v_addr);
+void page_free(pagetable_t *pgtable, uint64_t v_addr) {
+    mmu_gather_t tlb;
+    tlb_gather_mmu(&tlb, pgtable);
+    page_unmap(&tlb, v_addr);
+    tlb_finish_mmu(&tlb);
 }
 
 void paging_contiguous_map(pagetable_t *pgtable, uint64_t p_start_addr, uint64_t p_end_addr, uint64_t v_base_start_addr,
@@ -211,6 +281,62 @@ void paging_contiguous_map(pagetable_t *pgtable, uint64_t p_start_addr, uint64_t
     }
 }
 
+void paging_contiguous_unmap(pagetable_t *pgtable, uint64_t v_start_addr, uint64_t v_end_addr) {
+    /* one TLB flush (and shootdown) for the whole range rather than one per page */
+    mmu_gather_t tlb;
+    tlb_gather_mmu(&tlb, pgtable);
+
+    while (v_start_addr <= v_end_addr) {
+        page_unmap(&tlb, v_start_addr);
+        v_start_addr += PAGE_SIZE;
+    }
+
+    tlb_finish_mmu(&tlb);
+}
+
+static void paging_free_table(uint64_t pgt_phy_addr, int level) {
+    const uint64_t *entries = (const uint64_t*) va(pgt_phy_addr);
+
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+        if (entries[i] == 0)
+            continue;
+
+        uint64_t next_phy_addr = extract_bit_chunk(12, 51, entries[i]) << PAGE_SHIFT;
+
+        if (level > 1) {
+            paging_free_table(next_phy_addr, level - 1);
+            pgtable_page_free(next_phy_addr);
+        } else if (entries[i] & PAGE_OWNED_BIT) {
+            kfree((void*) va(next_phy_addr));
+        }
+    }
+}
+
+void paging_teardown(pagetable_t *pgtable) {
+    /* sanity check - the kernel half is shared by every address space */
+    BUG_ON(pgtable->phys_root == kernel_pagetable()->phys_root);
+
+    /*
+     * once nobody has it loaded and its PCID got flushed, no TLB or paging-structure cache can reach the tables
+     * anymore. From then on, frames and tables can go straight back without a gather or a flush per page.
+     */
+    pcid_release(pgtable);
+
+    uint64_t *root = (uint64_t*) pgtable->virt_root;
+    for (size_t i = 0; i < PML4_KERNEL_FIRST_ENTRY; i++) {
+        if (root[i] == 0)
+            continue;
+
+        uint64_t pdp_phy_addr = extract_bit_chunk(12, 51, root[i]) << PAGE_SHIFT;
+        paging_free_table(pdp_phy_addr, 3);
+        pgtable_page_free(pdp_phy_addr);
+    }
+
+    pgtable_page_free(pgtable->phys_root);
+    pgtable->phys_root = 0;
+    pgtable->virt_root = 0;
+}
+
 void paging_reload_cr3(pagetable_t *pgtable) {
-    load_cr3(pgtable->phys_root);
+    pcid_load_cr3(pgtable);
 }
@@ -6,10 +6,93 @@
  */
 
 #include "kernel/mm/pagetable.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/lib/string.h"
+
+/*
+ * Notes to myself:
+ *
+ * On 19/10/2026:
+ *
+ * Processes used to kmalloc page-table space for their whole VM up front and memcpy the kernel's PML4 entries
+ * into it. Any PML4 entry the kernel added afterwards was never seen by the processes that already existed.
+ * Now every kernel-half PML4 entry points to a PDPT allocated at boot (paging_populate_kernel_half) and those
+ * entries never change, so copying them once is all it takes to share the kernel half by reference.
+ *
+ * Roots (and user page-table pages in general) come from here. Freed pages are kept in a small cache so
+ * address spaces coming and going don't hammer the buddy allocator.
+ *
+ * User page tables don't reserve anything up front anymore: page_alloc() asks for a table as it descends into
+ * an empty entry and page_free() hands it back once it's empty, so what a process pays for scales with what
+ * it maps. The kernel page table keeps its pageframe database, which is sized for all of physical memory at
+ * boot - it can't come from kmalloc as kmalloc itself maps through it.
+ */
+
+/* freed page-table pages that are kept around rather than given back to kmalloc */
+#define PGTABLE_CACHE_MAX       64
 
 /* kernel space pagetable */
 static pagetable_t k_root_pgt;
 
+static uint64_t pgtable_cache[PGTABLE_CACHE_MAX];
+static size_t pgtable_cached;
+
 pagetable_t* kernel_pagetable(void){
     return &k_root_pgt;
 }
+
+uint64_t pgtable_page_alloc(void) {
+    if (pgtable_cached > 0) {
+        uint64_t phys_addr = pgtable_cache[--pgtable_cached];
+        memzero((void*) va(phys_addr), PAGE_SIZE);
+        return phys_addr;
+    }
+
+    /* the buddy allocator's smallest block is a page, so it's always page aligned */
+    return pa((uint64_t) kmalloc(PAGE_SIZE, KMEM_DEFAULT | KMEM_ZERO));
+}
+
+void pgtable_page_free(uint64_t phys_addr) {
+    if (pgtable_cached < PGTABLE_CACHE_MAX) {
+        pgtable_cache[pgtable_cached++] = phys_addr;
+        return;
+    }
+
+    kfree((void*) va(phys_addr));
+}
+
+static bool is_kernel_pagetable(const pagetable_t *pgtable) {
+    return pgtable->phys_root == k_root_pgt.phys_root;
+}
+
+uint64_t pagetable_alloc_table(pagetable_t *pgtable) {
+    if (is_kernel_pagetable(pgtable))
+        return pageframe_alloc(&pgtable->pfdb);
+    return pgtable_page_alloc();
+}
+
+void pagetable_free_table(pagetable_t *pgtable, uint64_t phys_addr) {
+    if (is_kernel_pagetable(pgtable))
+        pageframe_free(&pgtable->pfdb, phys_addr);
+    else
+        pgtable_page_free(phys_addr);
+}
+
+void pagetable_create(pagetable_t *pgtable) {
+    pgtable->phys_root = pgtable_page_alloc();
+    pgtable->virt_root = va(pgtable->phys_root);
+    pgtable->pfdb.free = NULL;
+    pgtable->pfdb.used = NULL;
+
+    /* kernel half by reference: same PDPTs as the kernel page table */
+    memcpy((uint64_t*) pgtable->virt_root + PML4_KERNEL_FIRST_ENTRY,
+            (uint64_t*) k_root_pgt.virt_root + PML4_KERNEL_FIRST_ENTRY,
+            (PML4_ENTRIES - PML4_KERNEL_FIRST_ENTRY) * sizeof(uint64_t));
+
+    /* gets a PCID the first time it's loaded */
+    pgtable->pcid = 0;
+    pgtable->pcid_gen = 0;
+    pgtable->cpumask = 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * pcid.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/pcid.h"
+#include "kernel/mm/init.h"
+#include "kernel/arch/apic.h"
+#include "kernel/asm/generic.h"
+#include "kernel/lib/bit.h"
+#include "kernel/lib/printk.h"
+#include "kernel/compiler/bug.h"
+
+/*
+ * Notes to myself:
+ *
+ * Intel SDM Vol 3 - 4.10.1. With CR4.PCIDE set, TLB entries are tagged with the 12-bit PCID held in CR3[11:0] and
+ * writing CR3 with bit 63 set doesn't flush anything, so a task's translations survive being switched out.
+ *
+ * There are way more address spaces than PCIDs over time, so they're handed out Linux-style (ASIDs with a
+ * generation): a page table keeps its PCID for as long as the generation it got it in is current. Running out
+ * starts a new generation, which invalidates every assignment at once. The trick is that the first CR3 load after
+ * getting a PCID is done *with* a flush, so whatever an older owner of that PCID left behind is gone before it can
+ * be used - no need to flush everything when a generation ends.
+ *
+ * The kernel page table always uses PCID 0.
+ */
+
+#define CR4_PGE                     (1ULL << 7)
+#define CR4_PCIDE                   (1ULL << 17)
+#define CR3_NOFLUSH                 (1ULL << 63)
+#define CR3_ADDR_MASK               (~((uint64_t) PAGE_SIZE - 1))
+
+#define CPUID_01_ECX_PCID           17
+#define CPUID_07_EBX_INVPCID        10
+
+#define PCID_KERNEL                 0
+#define PCID_MAX                    4095
+
+#define INVPCID_TYPE_ADDR           0
+#define INVPCID_TYPE_SINGLE_CONTEXT 1
+#define INVPCID_TYPE_ALL            2
+#define INVPCID_TYPE_ALL_NON_GLOBAL 3
+
+static bool pcid_enabled;
+static bool invpcid_supported;
+
+static uint64_t pcid_generation = 1;
+static uint16_t next_pcid = PCID_KERNEL + 1;
+
+/* what each CPU has in CR3, so pgtable->cpumask can be kept up to date */
+static pagetable_t *loaded_pgtable[APIC_MAX_CPUS];
+
+static void invpcid(uint64_t type, uint16_t pcid, uint64_t v_addr) {
+    struct {
+        uint64_t pcid;
+        uint64_t addr;
+    } __packed desc = { .pcid = pcid, .addr = v_addr };
+
+    asm volatile ("invpcid %0, [%1]" :: "r" (type), "r" (&desc) : "memory");
+}
+
+void pcid_init(void) {
+    uint32_t eax = 0x1, ebx = 0, ecx = 0, edx = 0;
+    cpuid(&eax, &ebx, &ecx, &edx);
+    bool has_pcid = test_bit(CPUID_01_ECX_PCID, ecx);
+
+    eax = 0x7, ecx = 0;
+    cpuid(&eax, &ebx, &ecx, &edx);
+    invpcid_supported = test_bit(CPUID_07_EBX_INVPCID, ebx);
+
+    if (!has_pcid) {
+        printk_info("PCID: not supported, every address space switch flushes the TLB");
+        return;
+    }
+
+    write_cr4(read_cr4() | CR4_PCIDE);
+    pcid_enabled = true;
+
+    printk_info("PCID: enabled%s", invpcid_supported ? " with INVPCID" : "");
+}
+
+/* returns true if pgtable got a new PCID, whose stale entries must be flushed on load */
+static bool pcid_assign(pagetable_t *pgtable) {
+    if (pgtable->pcid_gen == pcid_generation)
+        return false;
+
+    if (next_pcid > PCID_MAX) {
+        pcid_generation++;
+        next_pcid = PCID_KERNEL + 1;
+    }
+
+    pgtable->pcid = next_pcid++;
+    pgtable->pcid_gen = pcid_generation;
+
+    return true;
+}
+
+static bool is_kernel_pagetable(pagetable_t *pgtable) {
+    return pgtable->phys_root == kernel_pagetable()->phys_root;
+}
+
+static void pcid_track_cpu(pagetable_t *pgtable) {
+    uint32_t cpu = apic_this_cpu();
+    pagetable_t *prev = loaded_pgtable[cpu];
+
+    if (prev == pgtable)
+        return;
+
+    if (prev != NULL)
+        __atomic_and_fetch(&prev->cpumask, ~(1ULL << cpu), __ATOMIC_RELEASE);
+    __atomic_or_fetch(&pgtable->cpumask, 1ULL << cpu, __ATOMIC_RELEASE);
+
+    loaded_pgtable[cpu] = pgtable;
+}
+
+void pcid_load_cr3(pagetable_t *pgtable) {
+    pcid_track_cpu(pgtable);
+
+    if (!pcid_enabled || is_kernel_pagetable(pgtable)) {
+        load_cr3(pgtable->phys_root);
+        return;
+    }
+
+    bool fresh = pcid_assign(pgtable);
+    load_cr3(pgtable->phys_root | pgtable->pcid | (fresh ? 0 : CR3_NOFLUSH));
+}
+
+void pcid_invalidate_page(pagetable_t *pgtable, uint64_t v_addr) {
+    bool kernel = is_kernel_pagetable(pgtable);
+    bool loaded = (read_cr3() & CR3_ADDR_MASK) == pgtable->phys_root;
+
+    /* invlpg takes care of the current PCID plus global entries, the kernel half is mapped in every context */
+    if (loaded || kernel || !pcid_enabled)
+        invalidate_page(v_addr);
+
+    if (!pcid_enabled)
+        return;
+
+    if (kernel) {
+        /* the kernel half is shared, so the entry may be cached under any PCID */
+        if (invpcid_supported) {
+            invpcid(INVPCID_TYPE_ALL_NON_GLOBAL, 0, 0);
+        } else {
+            /* nobody keeps their PCID, each first load from now on flushes */
+            pcid_generation++;
+            next_pcid = PCID_KERNEL + 1;
+        }
+    } else if (!loaded && pgtable->pcid_gen == pcid_generation) {
+        if (invpcid_supported) {
+            invpcid(INVPCID_TYPE_ADDR, pgtable->pcid, v_addr);
+        } else {
+            /* give up its PCID, it gets a fresh (flushed) one next time it's loaded */
+            pgtable->pcid_gen = 0;
+        }
+    }
+}
+
+void pcid_flush(pagetable_t *pgtable) {
+    if (is_kernel_pagetable(pgtable)) {
+        /* global entries only go away with INVPCID (all contexts) or by toggling CR4.PGE, which hits every PCID */
+        if (pcid_enabled && invpcid_supported) {
+            invpcid(INVPCID_TYPE_ALL, 0, 0);
+        } else {
+            uint64_t cr4 = read_cr4();
+            write_cr4(cr4 ^ CR4_PGE);
+            write_cr4(cr4);
+        }
+        return;
+    }
+
+    bool loaded = (read_cr3() & CR3_ADDR_MASK) == pgtable->phys_root;
+
+    if (!pcid_enabled) {
+        /* entries of an address space that isn't loaded are gone already */
+        if (loaded)
+            load_cr3(pgtable->phys_root);
+        return;
+    }
+
+    if (loaded) {
+        /* same PCID without the no-flush bit drops everything (non-global) tagged with it */
+        load_cr3(pgtable->phys_root | pgtable->pcid);
+    } else if (pgtable->pcid_gen == pcid_generation) {
+        if (invpcid_supported)
+            invpcid(INVPCID_TYPE_SINGLE_CONTEXT, pgtable->pcid, 0);
+        else
+            pgtable->pcid_gen = 0;
+    }
+}
+
+void pcid_release(pagetable_t *pgtable) {
+    uint32_t cpu = apic_this_cpu();
+
+    /* kernel threads borrow whatever is in CR3, so it may be loaded even if the tracking says otherwise */
+    if (loaded_pgtable[cpu] == pgtable || (read_cr3() & CR3_ADDR_MASK) == pgtable->phys_root)
+        pcid_load_cr3(kernel_pagetable());
+
+    /* only the boot CPU runs for now, nobody else can have it loaded */
+    BUG_ON(pgtable->cpumask != 0);
+
+    pcid_flush(pgtable);
+    pgtable->pcid_gen = 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * shrinker.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/shrinker.h"
+#include "kernel/asm/generic.h"
+
+/*
+ * Notes to myself:
+ *
+ * Caches are allowed to keep as much memory as they like while it's free anyway, kmalloc calls shrink_memory when
+ * the buddy allocator comes back empty handed and only gives up if nobody could free anything. Shrinkers run in
+ * whatever context kmalloc was called from, so they must not allocate themselves and must leave alone anything
+ * that is in use (or in flight).
+ *
+ * Freeing N bytes doesn't guarantee a block of N bytes, the buddies may not be adjacent. kmalloc just asks again.
+ */
+
+static shrinker_t *shrinkers;
+
+/* a shrinker calling kmalloc would otherwise recurse forever */
+static bool shrinking;
+
+void register_shrinker(shrinker_t *shrinker) {
+    uint64_t flags = local_irq_save();
+    shrinker->next = shrinkers;
+    shrinkers = shrinker;
+    local_irq_restore(flags);
+}
+
+uint64_t shrink_memory(uint64_t bytes) {
+    uint64_t flags = local_irq_save();
+    uint64_t freed = 0;
+
+    if (!shrinking) {
+        shrinking = true;
+
+        for (shrinker_t *s = shrinkers; s != NULL && freed < bytes; s = s->next)
+            freed += s->shrink(s, bytes - freed);
+
+        shrinking = false;
+    }
+
+    local_irq_restore(flags);
+    return freed;
+}
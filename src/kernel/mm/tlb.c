@@ -0,0 +1,160 @@
+/*
+ * tlb.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/tlb.h"
+#include "kernel/mm/pcid.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/arch/apic.h"
+#include "kernel/interrupt/idt.h"
+#include "kernel/asm/generic.h"
+
+/*
+ * Notes to myself:
+ *
+ * Same idea as Linux's mmu_gather: unmapping goes through tlb_remove_page()/tlb_remove_table() and nothing
+ * is invalidated until tlb_flush_mmu(). That turns N invlpgs (and, once APs are up, N rounds of IPIs) into a
+ * single pass, and if more than TLB_GATHER_PAGES pages were unmapped the whole address space is flushed instead.
+ *
+ * Page-table frames are only given back after the flush: until then the paging-structure caches of any CPU
+ * may still walk through them, so reusing them earlier could have a CPU pick up garbage translations.
+ *
+ * Remote CPUs are only interrupted if they have the page table loaded (pgtable->cpumask), with the kernel
+ * half being the exception as it's mapped everywhere. Only the boot CPU is online for now, so the IPI path
+ * never actually fires yet.
+ */
+
+static struct {
+    const mmu_gather_t *tlb;
+    uint32_t pending;
+} shootdown;
+
+static void tlb_flush_local(const mmu_gather_t *tlb) {
+    if (tlb->full_flush) {
+        pcid_flush(tlb->pgtable);
+        return;
+    }
+
+    for (size_t i = 0; i < tlb->nr_pages; i++)
+        pcid_invalidate_page(tlb->pgtable, tlb->pages[i]);
+}
+
+static void tlb_shootdown_handler(interrupt_stack_frame_t *int_frame) {
+    (void) int_frame;
+
+    tlb_flush_local(shootdown.tlb);
+    lapic_eoi();
+
+    __atomic_sub_fetch(&shootdown.pending, 1, __ATOMIC_RELEASE);
+}
+
+void tlb_init(void) {
+    register_exception_handler(TLB_SHOOTDOWN_VECTOR, tlb_shootdown_handler);
+}
+
+static uint64_t tlb_shootdown_mask(const mmu_gather_t *tlb) {
+    uint64_t mask = 0;
+
+    if (tlb->pgtable->phys_root == kernel_pagetable()->phys_root) {
+        for (uint32_t cpu = 0; cpu < apic_nr_cpus(); cpu++) {
+            if (apic_cpu_online(cpu))
+                mask |= 1ULL << cpu;
+        }
+    } else {
+        mask = __atomic_load_n(&tlb->pgtable->cpumask, __ATOMIC_ACQUIRE);
+    }
+
+    /* we take care of our own TLB */
+    return mask & ~(1ULL << apic_this_cpu());
+}
+
+static void tlb_shootdown(const mmu_gather_t *tlb) {
+    uint64_t mask = tlb_shootdown_mask(tlb);
+    if (mask == 0)
+        return;
+
+    uint32_t targets = 0;
+    for (uint32_t cpu = 0; cpu < APIC_MAX_CPUS; cpu++) {
+        if (mask & (1ULL << cpu))
+            targets++;
+    }
+
+    shootdown.tlb = tlb;
+    __atomic_store_n(&shootdown.pending, targets, __ATOMIC_RELEASE);
+
+    for (uint32_t cpu = 0; cpu < APIC_MAX_CPUS; cpu++) {
+        if (mask & (1ULL << cpu))
+            lapic_send_ipi(apic_cpu_apic_id(cpu), TLB_SHOOTDOWN_VECTOR);
+    }
+
+    /* the gather (and the frames it holds) must outlive every remote flush */
+    while (__atomic_load_n(&shootdown.pending, __ATOMIC_ACQUIRE) != 0)
+        cpu_relax();
+}
+
+void tlb_gather_mmu(mmu_gather_t *tlb, pagetable_t *pgtable) {
+    tlb->pgtable = pgtable;
+    tlb->nr_pages = 0;
+    tlb->full_flush = false;
+    tlb->nr_tables = 0;
+    tlb->nr_frames = 0;
+}
+
+void tlb_remove_page(mmu_gather_t *tlb, uint64_t v_addr) {
+    if (tlb->full_flush)
+        return;
+
+    if (tlb->nr_pages == TLB_GATHER_PAGES) {
+        tlb->full_flush = true;
+        return;
+    }
+
+    tlb->pages[tlb->nr_pages++] = v_addr;
+}
+
+void tlb_remove_table(mmu_gather_t *tlb, uint64_t phys_addr) {
+    if (tlb->nr_tables == TLB_GATHER_TABLES)
+        tlb_flush_mmu(tlb);
+
+    tlb->tables[tlb->nr_tables++] = phys_addr;
+}
+
+void tlb_remove_frame(mmu_gather_t *tlb, uint64_t phys_addr) {
+    if (tlb->nr_frames == TLB_GATHER_FRAMES)
+        tlb_flush_mmu(tlb);
+
+    tlb->frames[tlb->nr_frames++] = phys_addr;
+}
+
+void tlb_flush_mmu(mmu_gather_t *tlb) {
+    if (tlb->nr_pages == 0 && !tlb->full_flush && tlb->nr_tables == 0 && tlb->nr_frames == 0)
+        return;
+
+    /* a table was torn down, so every translation that went through it has to go */
+    if (tlb->nr_tables > 0 && tlb->nr_pages == 0)
+        tlb->full_flush = true;
+
+    tlb_flush_local(tlb);
+    tlb_shootdown(tlb);
+
+    for (size_t i = 0; i < tlb->nr_tables; i++)
+        pagetable_free_table(tlb->pgtable, tlb->tables[i]);
+
+    for (size_t i = 0; i < tlb->nr_frames; i++)
+        kfree((void*) va(tlb->frames[i]));
+
+    tlb->nr_pages = 0;
+    tlb->full_flush = false;
+    tlb->nr_tables = 0;
+    tlb->nr_frames = 0;
+}
+
+void tlb_finish_mmu(mmu_gather_t *tlb) {
+    tlb_flush_mmu(tlb);
+    tlb->pgtable = NULL;
+}
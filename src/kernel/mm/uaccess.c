@@ -0,0 +1,28 @@
+/*
+ * uaccess.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/mm/uaccess.h"
+#include "kernel/mm/pagetable.h"
+
+/*
+ * Notes to myself:
+ *
+ * Every pointer a syscall gets from user space goes through access_ok before the kernel reads or writes through
+ * it, otherwise read(fd, <kernel address>, n) would have the file system write wherever the caller liked.
+ *
+ * Only the range is checked, not whether it's mapped. A user address that isn't (or is read-only) faults in ring 0
+ * and mm/fault.c takes the process down with -EFAULT rather than the whole kernel.
+ */
+
+bool access_ok(const void *ptr, size_t length) {
+    uint64_t addr = (uint64_t) ptr;
+
+    if (ptr == NULL || addr >= USER_SPACE_END_ADDR)
+        return false;
+
+    return length <= USER_SPACE_END_ADDR - addr;
+}
@@ -0,0 +1,13 @@
+/*
+ * close.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/close.h"
+#include "kernel/fs/fdtable.h"
+
+long sys_close(int fd) {
+    return fd_close(fd);
+}
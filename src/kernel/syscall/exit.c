@@ -0,0 +1,13 @@
+/*
+ * exit.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/exit.h"
+#include "kernel/task/exit.h"
+
+long sys_exit(int code) {
+    do_exit(code);
+}
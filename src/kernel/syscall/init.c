@@ -14,9 +14,17 @@
 #include "kernel/arch/msr.h"
 #include "kernel/arch/gdt_segments.h"
 #include "kernel/arch/cpu_registers.h"
+#include "kernel/syscall/read.h"
 #include "kernel/syscall/write.h"
+#include "kernel/syscall/open.h"
+#include "kernel/syscall/close.h"
+#include "kernel/syscall/stat.h"
+#include "kernel/syscall/lseek.h"
+#include "kernel/syscall/mmap.h"
 #include "kernel/syscall/getpid.h"
 #include "kernel/syscall/time.h"
+#include "kernel/syscall/exit.h"
+#include "kernel/syscall/wait.h"
 #include "kernel/arch/cpu.h"
 
 /*
@@ -98,10 +106,34 @@ long syscall_handler(registers_64_t regs) {
     printk_fine("syscall_handler called");
 
     switch (regs.rax) {
+    case __NR_read:
+        return sys_read((int) regs.rdi, (char*) regs.rsi, (size_t) regs.rdx);
     case __NR_write:
-        return sys_write((const char*) regs.rdi, (size_t) regs.rsi);
+        return sys_write((int) regs.rdi, (const char*) regs.rsi, (size_t) regs.rdx);
+    case __NR_open:
+        return sys_open((const char*) regs.rdi, (int) regs.rsi);
+    case __NR_close:
+        return sys_close((int) regs.rdi);
+    case __NR_stat:
+        return sys_stat((const char*) regs.rdi, (struct stat*) regs.rsi);
+    case __NR_fstat:
+        return sys_fstat((int) regs.rdi, (struct stat*) regs.rsi);
+    case __NR_lseek:
+        return sys_lseek((int) regs.rdi, (long) regs.rsi, (int) regs.rdx);
+    case __NR_mmap:
+        return sys_mmap(regs.rdi, (size_t) regs.rsi, (int) regs.rdx, (int) regs.r10, (int) regs.r8, regs.r9);
+    case __NR_mprotect:
+        return sys_mprotect(regs.rdi, (size_t) regs.rsi, (int) regs.rdx);
+    case __NR_munmap:
+        return sys_munmap(regs.rdi, (size_t) regs.rsi);
+    case __NR_brk:
+        return sys_brk(regs.rdi);
     case __NR_getpid:
         return sys_getpid();
+    case __NR_exit:
+        return sys_exit((int) regs.rdi);
+    case __NR_wait4:
+        return sys_wait4((pid_t) regs.rdi, (int*) regs.rsi);
     case __NR_time:
             return sys_time();
     default:
@@ -0,0 +1,18 @@
+/*
+ * lseek.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/lseek.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/sys/errno.h"
+
+long sys_lseek(int fd, long offset, int whence) {
+    file_t *file = fd_get(fd);
+    if (file == NULL)
+        return -EBADF;
+
+    return vfs_lseek(file, offset, whence);
+}
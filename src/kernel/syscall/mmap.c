@@ -0,0 +1,37 @@
+/*
+ * mmap.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/mmap.h"
+#include "kernel/mm/mmap.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/sys/mman.h"
+#include "kernel/sys/errno.h"
+
+long sys_mmap(uint64_t addr, size_t length, int prot, int flags, int fd, uint64_t offset) {
+    file_t *file = NULL;
+
+    if (!(flags & MAP_ANONYMOUS)) {
+        file = fd_get(fd);
+        if (file == NULL)
+            return -EBADF;
+    }
+
+    /* the mapping holds a reference of its own, closing fd afterwards doesn't affect it */
+    return do_mmap(addr, length, prot, flags, file, offset);
+}
+
+long sys_munmap(uint64_t addr, size_t length) {
+    return do_munmap(addr, length);
+}
+
+long sys_mprotect(uint64_t addr, size_t length, int prot) {
+    return do_mprotect(addr, length, prot);
+}
+
+long sys_brk(uint64_t brk) {
+    return do_brk(brk);
+}
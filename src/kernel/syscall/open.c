@@ -0,0 +1,27 @@
+/*
+ * open.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/open.h"
+#include "kernel/fs/fdtable.h"
+
+long sys_open(const char *user_path, int flags) {
+    char path[VFS_PATH_MAX];
+    int ret = getname(user_path, path);
+    if (ret != 0)
+        return ret;
+
+    file_t *file;
+    ret = vfs_open(path, flags, &file);
+    if (ret != 0)
+        return ret;
+
+    int fd = fd_install(file);
+    if (fd < 0)
+        fput(file);
+
+    return fd;
+}
@@ -0,0 +1,28 @@
+/*
+ * read.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/read.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/mm/uaccess.h"
+#include "kernel/sys/errno.h"
+
+long sys_read(int fd, char *buf, size_t length) {
+    file_t *file = fd_get(fd);
+
+    /* sanity checks */
+    if (file == NULL)
+        return -EBADF;
+
+    if (!access_ok(buf, length))
+        return -EFAULT;
+
+    if (length == 0)
+        return 0;
+
+    /* devices with nothing to read put us to sleep until there is */
+    return vfs_read(file, buf, length);
+}
@@ -0,0 +1,43 @@
+/*
+ * stat.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/stat.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/mm/uaccess.h"
+#include "kernel/sys/errno.h"
+
+long sys_stat(const char *user_path, struct stat *st) {
+    if (!access_ok(st, sizeof(struct stat)))
+        return -EFAULT;
+
+    char path[VFS_PATH_MAX];
+    int ret = getname(user_path, path);
+    if (ret != 0)
+        return ret;
+
+    /* served from the dentry cache after the first time, the file system is never involved */
+    dentry_t *dentry;
+    ret = vfs_lookup(path, &dentry);
+    if (ret != 0)
+        return ret;
+
+    vfs_stat(dentry->inode, st);
+    dput(dentry);
+    return 0;
+}
+
+long sys_fstat(int fd, struct stat *st) {
+    file_t *file = fd_get(fd);
+    if (file == NULL)
+        return -EBADF;
+
+    if (!access_ok(st, sizeof(struct stat)))
+        return -EFAULT;
+
+    vfs_stat(file->inode, st);
+    return 0;
+}
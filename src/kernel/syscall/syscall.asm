@@ -9,17 +9,26 @@
 global syscall_entry
 
 extern syscall_handler
+extern TSS64_Segment
+
+; TSS64_Segment.rsp0, the top of the running task's kernel stack (see launch_process)
+TSS64.RSP0.Offset	equ		4
+
+section .bss
+
+; SYSCALL leaves rsp alone and every other register is taken, so the user rsp is parked here until it can be pushed.
+; Interrupts are masked on entry (IA32_FMASK) and there is a single CPU, so nobody else can get in between.
+syscall_user_rsp:	resq	1
 
 ; create elf section that is always placed first when linking asm and c files
 section .text
 
 syscall_entry:
-	; TODO: read from TSS
-	; Ideally we should point this to the kernel stack in the TSS.rsp0. For some reason I'm having trouble accessing it correctly
-	; Right now we are not dealing with preemtable kernel so pointing it to the original
-	; kernel stack will work.
-	push rsp
-	mov rsp, Kernel.New.Start.VirtualAddress
+	; Each task has a kernel stack of its own, so a syscall can sleep (schedule) half way through without the
+	; next task's syscalls walking all over its frame
+	mov [rel syscall_user_rsp], rsp
+	mov rsp, [rel TSS64_Segment + TSS64.RSP0.Offset]
+	push qword [rel syscall_user_rsp]
 
 	; preserve all values so we can access them from C
 	;  and know where to go back to (RCX, r11)
@@ -0,0 +1,23 @@
+/*
+ * wait.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/syscall/wait.h"
+#include "kernel/task/exit.h"
+#include "kernel/mm/uaccess.h"
+#include "kernel/sys/errno.h"
+
+long sys_wait4(pid_t pid, int *status) {
+    /* sanity checks */
+    if (pid == 0 || pid < -1)
+        return -EINVAL;
+
+    /* checked before a child is reaped, so a bad pointer doesn't lose its exit code */
+    if (status != NULL && !access_ok(status, sizeof(int)))
+        return -EFAULT;
+
+    return do_wait(pid, status);
+}
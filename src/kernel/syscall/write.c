@@ -6,25 +6,22 @@
  */
 
 #include "kernel/syscall/write.h"
-#include "kernel/lib/printk.h"
-#include "kernel/lib/string.h"
-#include "kernel/mm/kmem.h"
-#include "kernel/compiler/bug.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/mm/uaccess.h"
+#include "kernel/sys/errno.h"
 
-size_t sys_write(const char *string, size_t length){
-    /* sanity checks */
-    BUG_ON(length == 0 || string == NULL);
+long sys_write(int fd, const char *buf, size_t length) {
+    file_t *file = fd_get(fd);
 
-    /* copy from user space (I should probably turn this into a routine) */
-    char* content = kmalloc(length, KMEM_DEFAULT);
-    memcpy(content, string, length);
+    /* sanity checks */
+    if (file == NULL)
+        return -EBADF;
 
-    /* serve syscall */
-    printk_info(content);
+    if (!access_ok(buf, length))
+        return -EFAULT;
 
-    /* dealloc resources */
-    kfree(content);
+    if (length == 0)
+        return 0;
 
-    return length;
+    return vfs_write(file, buf, length);
 }
-
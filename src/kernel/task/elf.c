@@ -0,0 +1,143 @@
+/*
+ * elf.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/task/elf.h"
+#include "kernel/mm/init.h"
+#include "kernel/mm/page.h"
+#include "kernel/mm/fault.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/addressconv.h"
+#include "kernel/lib/string.h"
+#include "kernel/lib/printk.h"
+
+#define PAGE_MASK           (~((uint64_t) PAGE_SIZE - 1))
+
+/*
+ * Notes to myself:
+ *
+ * Nothing is copied for the most part, the image the boot loader left in memory is what gets mapped:
+ *  - read-only segments (text, rodata) map the image pages as they are, so every instance shares them.
+ *  - writable segments map them read-only + COW, a process only pays for the pages it writes to.
+ *  - bss pages map the zero page + COW.
+ *  - the one page where file data ends and bss begins is the exception, it needs a zeroed tail so it gets a
+ *    private copy right away. Same goes for a page that would run past the end of the image.
+ *
+ * Segments must not share pages (the user linker script aligns them to 4K), otherwise one of them would end up
+ * with the other's permissions.
+ */
+
+static bool elf_check_header(const elf64_ehdr_t *ehdr, size_t image_size) {
+    if (image_size < sizeof(elf64_ehdr_t))
+        return false;
+
+    if (ehdr->e_ident[0] != ELF_MAG0 || ehdr->e_ident[1] != ELF_MAG1 || ehdr->e_ident[2] != ELF_MAG2
+            || ehdr->e_ident[3] != ELF_MAG3)
+        return false;
+
+    if (ehdr->e_ident[4] != ELF_CLASS64 || ehdr->e_ident[5] != ELF_DATA2LSB)
+        return false;
+
+    if (ehdr->e_type != ELF_ET_EXEC || ehdr->e_machine != ELF_EM_X86_64)
+        return false;
+
+    if (ehdr->e_phentsize != sizeof(elf64_phdr_t) || ehdr->e_phoff > image_size
+            || ehdr->e_phnum > (image_size - ehdr->e_phoff) / sizeof(elf64_phdr_t))
+        return false;
+
+    return ehdr->e_entry < USER_SPACE_END_ADDR;
+}
+
+static bool elf_check_segment(const elf64_phdr_t *phdr, size_t image_size) {
+    if (phdr->p_filesz > phdr->p_memsz)
+        return false;
+
+    if (phdr->p_offset > image_size || phdr->p_filesz > image_size - phdr->p_offset)
+        return false;
+
+    if (phdr->p_vaddr >= USER_SPACE_END_ADDR || phdr->p_memsz > USER_SPACE_END_ADDR - phdr->p_vaddr)
+        return false;
+
+    /* image pages can only be mapped as they are if the file and memory layouts agree on the page offset */
+    return (phdr->p_vaddr & ~PAGE_MASK) == (phdr->p_offset & ~PAGE_MASK);
+}
+
+static bool elf_map_segment(pagetable_t *pgtable, const elf64_phdr_t *phdr, uint64_t image_phys, size_t image_size) {
+    bool writable = phdr->p_flags & ELF_PF_W;
+
+    uint16_t flags = PAGE_PRESENT_BIT | PAGE_USER_SUPERVISOR_BIT;
+    if (!(phdr->p_flags & ELF_PF_X))
+        flags |= PAGE_NO_EXEC_BIT;
+
+    uint64_t file_end = phdr->p_vaddr + phdr->p_filesz;
+    uint64_t mem_end = phdr->p_vaddr + phdr->p_memsz;
+
+    /* where the page holding p_vaddr starts in the image, with vaddr and offset congruent it's page aligned */
+    uint64_t first_page = phdr->p_vaddr & PAGE_MASK;
+    uint64_t image_first_page = phdr->p_offset & PAGE_MASK;
+
+    for (uint64_t v_addr = first_page; v_addr < mem_end; v_addr += PAGE_SIZE) {
+        if (page_lookup(pgtable, v_addr) != NULL) {
+            printk_error("elf: segments overlap at 0x%llx", v_addr);
+            return false;
+        }
+
+        uint64_t image_off = image_first_page + (v_addr - first_page);
+
+        if (v_addr >= file_end) {
+            /* bss only */
+            page_alloc(pgtable, v_addr, cow_zero_page(), flags | (writable ? PAGE_COW_BIT : 0));
+        } else if ((file_end >= v_addr + PAGE_SIZE || file_end == mem_end) && image_off + PAGE_SIZE <= image_size) {
+            /* backed by the image from start to end */
+            page_alloc(pgtable, v_addr, image_phys + image_off, flags | (writable ? PAGE_COW_BIT : 0));
+        } else {
+            /* file data followed by bss (or by the end of the image) */
+            void *page = kmalloc(PAGE_SIZE, KMEM_DEFAULT | KMEM_ZERO);
+            if (page == NULL) {
+                printk_error("elf: out of memory mapping 0x%llx", v_addr);
+                return false;
+            }
+
+            memcpy(page, (void*) va(image_phys + image_off), MIN(file_end - v_addr, image_size - image_off));
+            page_alloc(pgtable, v_addr, pa((uint64_t) page),
+                    flags | PAGE_OWNED_BIT | (writable ? PAGE_READ_WRITE_BIT : 0));
+        }
+    }
+
+    return true;
+}
+
+bool elf_load(pagetable_t *pgtable, uint64_t image_phys, size_t image_size, uint64_t *entry, uint64_t *image_end) {
+    const elf64_ehdr_t *ehdr = (const elf64_ehdr_t*) va(image_phys);
+
+    if ((image_phys & ~PAGE_MASK) != 0 || !elf_check_header(ehdr, image_size)) {
+        printk_error("elf: image at 0x%llx isn't a valid x86-64 executable", image_phys);
+        return false;
+    }
+
+    const elf64_phdr_t *phdrs = (const elf64_phdr_t*) (va(image_phys) + ehdr->e_phoff);
+    uint64_t end = 0;
+
+    for (size_t i = 0; i < ehdr->e_phnum; i++) {
+        if (phdrs[i].p_type != ELF_PT_LOAD || phdrs[i].p_memsz == 0)
+            continue;
+
+        if (!elf_check_segment(&phdrs[i], image_size)) {
+            printk_error("elf: malformed segment %llu", (uint64_t) i);
+            return false;
+        }
+
+        if (!elf_map_segment(pgtable, &phdrs[i], image_phys, image_size))
+            return false;
+
+        if (phdrs[i].p_vaddr + phdrs[i].p_memsz > end)
+            end = phdrs[i].p_vaddr + phdrs[i].p_memsz;
+    }
+
+    *entry = ehdr->e_entry;
+    *image_end = (end + PAGE_SIZE - 1) & PAGE_MASK;
+    return true;
+}
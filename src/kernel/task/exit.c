@@ -0,0 +1,170 @@
+/*
+ * exit.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/task/exit.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/task/wait.h"
+#include "kernel/task/workqueue.h"
+#include "kernel/task/pid.h"
+#include "kernel/mm/page.h"
+#include "kernel/mm/kmem.h"
+#include "kernel/mm/mmap.h"
+#include "kernel/arch/fpu.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/sys/errno.h"
+
+/*
+ * Notes to myself:
+ *
+ * Exiting happens in two steps, like on any other Unix:
+ *
+ *  - do_exit() gets rid of everything the task won't need anymore right away: the address space (one walk over
+ *    the page tables, see paging_teardown), the user stack and the FPU state. The task becomes a zombie and
+ *    leaves the run queue.
+ *
+ *  - The kernel stack, pid and task_struct_t stay until the parent collects the exit code with wait. do_exit()
+ *    is running on that very kernel stack and switch_to saves rsp into the task_struct_t on the way out, so they
+ *    can't go any earlier anyway.
+ *
+ * Tasks nobody is going to wait for (created by the kernel, or whose parent exited first) are reaped by kworker.
+ * Scheduling that work also guarantees there is something runnable to switch to.
+ */
+
+/* exited tasks whose exit code hasn't been collected yet, chained through zombie_next */
+static task_struct_t *zombies;
+
+/* parents sleeping in wait */
+static wait_queue_head_t child_exit_wq;
+
+static void release_task(task_struct_t *task) {
+    kfree((void*) task->kernel_stack_area.virt_addr);
+    release_pid(task->pid);
+    kfree(task);
+}
+
+static task_struct_t* unlink_zombie(pid_t ppid, pid_t pid) {
+    for (task_struct_t **link = &zombies; *link != NULL; link = &(*link)->zombie_next) {
+        task_struct_t *task = *link;
+
+        if (task->ppid != ppid || (pid != -1 && task->pid != pid))
+            continue;
+
+        *link = task->zombie_next;
+        task->zombie_next = NULL;
+        return task;
+    }
+
+    return NULL;
+}
+
+static void reap_orphans(work_struct_t *work) {
+    (void) work;
+
+    uint64_t flags = local_irq_save();
+
+    task_struct_t *task;
+    while ((task = unlink_zombie(0, -1)) != NULL)
+        release_task(task);
+
+    local_irq_restore(flags);
+}
+
+static DECLARE_WORK(reap_work, reap_orphans);
+
+static void reparent_children(pid_t pid) {
+    for (struct task_list_t *node = this_rq()->tasks; node != NULL; node = node->next) {
+        if (node->val->ppid == pid)
+            node->val->ppid = 0;
+    }
+
+    for (task_struct_t *zombie = zombies; zombie != NULL; zombie = zombie->zombie_next) {
+        if (zombie->ppid == pid)
+            zombie->ppid = 0;
+    }
+}
+
+void do_exit(int code) {
+    disable_interrupts();
+
+    task_struct_t *task = this_rq()->curr;
+
+    /* sanity check */
+    BUG_ON(task == NULL);
+
+    fpu_release(task);
+    files_close_all(task);
+
+    /* kernel threads run on the kernel page table, there is no address space of their own to free */
+    if (task->vm_area.pgtable.phys_root != kernel_pagetable()->phys_root) {
+        mmap_exit(task);
+        paging_teardown(&task->vm_area.pgtable);
+    }
+
+    if (task->task_stack_area.virt_addr != 0) {
+        kfree((void*) task->task_stack_area.virt_addr);
+        task->task_stack_area.virt_addr = 0;
+    }
+
+    task->exit_code = code;
+    task->state = TASK_ZOMBIE;
+    scheduler_remove(task);
+    reparent_children(task->pid);
+
+    /* no allocation here, do_exit may well be running because memory ran out */
+    task->zombie_next = zombies;
+    zombies = task;
+
+    /* parents look for their children again once woken up, orphans (this one included, maybe) are kworker's */
+    wait_queue_wake_all(&child_exit_wq);
+    schedule_work(&reap_work);
+
+    schedule();
+
+    /* a zombie is never picked again */
+    BUG_ON(true);
+    for (;;)
+        halt();
+}
+
+/* whether parent has a child (pid, or any if -1) that hasn't exited yet */
+static bool has_live_child(task_struct_t *parent, pid_t pid) {
+    for (struct task_list_t *node = this_rq()->tasks; node != NULL; node = node->next) {
+        if (node->val->ppid == parent->pid && (pid == -1 || node->val->pid == pid))
+            return true;
+    }
+
+    return false;
+}
+
+long do_wait(pid_t pid, int *status) {
+    task_struct_t *curr = this_rq()->curr;
+
+    /* sanity check */
+    BUG_ON(curr == NULL);
+
+    for (;;) {
+        task_struct_t *child = unlink_zombie(curr->pid, pid);
+        if (child != NULL) {
+            pid_t child_pid = child->pid;
+
+            if (status != NULL)
+                *status = child->exit_code;
+
+            release_task(child);
+            return child_pid;
+        }
+
+        /* nobody left that could ever exit */
+        if (!has_live_child(curr, pid))
+            return -ECHILD;
+
+        /* every exit wakes the queue up, the child we're after may not be the one that exited */
+        wait_queue_sleep(&child_exit_wq);
+    }
+}
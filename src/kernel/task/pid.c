@@ -33,3 +33,9 @@ pid_t find_free_pid(void) {
     return ret;
 }
 
+void release_pid(pid_t pid) {
+    /* sanity check */
+    BUG_ON(pid <= 0 || pid >= PID_MAX || !pid_map[pid]);
+
+    pid_map[pid] = false;
+}
@@ -13,17 +13,62 @@
 #include "kernel/mm/addressconv.h"
 #include "kernel/arch/tss.h"
 #include "kernel/task/pid.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/task/elf.h"
 #include "kernel/syscall/init.h"
-#include "kernel/lib/printk.h"
 #include "kernel/arch/gdt_segments.h"
+#include "kernel/arch/fpu.h"
+#include "kernel/fs/fdtable.h"
+#include "kernel/asm/generic.h"
 
 extern tss_t TSS64_Segment;
 
+/* vectors.asm - pops an interrupt_stack_frame_t and iretq's */
+extern void interrupt_return(void);
+
+/* what switch_to pops off a kernel stack: callee-saved registers and where to return to */
+typedef struct {
+    uint64_t r15;
+    uint64_t r14;
+    uint64_t r13;
+    uint64_t r12;
+    uint64_t rbx;
+    uint64_t rbp;
+    uint64_t ret_addr;
+} __packed switch_frame_t;
+
+/*
+ * A task that never ran is given the same kernel stack it would have if it had been interrupted right before its
+ * first instruction, so the first switch_to into it goes through interrupt_return like any other.
+ */
+static void setup_kernel_stack(task_struct_t *task, uint64_t rip, uint64_t cs, uint64_t rsp, uint64_t ss) {
+    uint64_t top = task->kernel_stack_area.virt_addr + task->kernel_stack_area.length;
+
+    interrupt_stack_frame_t *frame = (interrupt_stack_frame_t*) (top - sizeof(interrupt_stack_frame_t));
+    memzero(frame, sizeof(interrupt_stack_frame_t));
+    frame->rip = rip;
+    frame->cs = cs;
+    frame->rflags = 0x202;
+    frame->rsp = rsp;
+    frame->ss = ss;
+
+    switch_frame_t *switch_frame = (switch_frame_t*) ((uint64_t) frame - sizeof(switch_frame_t));
+    memzero(switch_frame, sizeof(switch_frame_t));
+    switch_frame->ret_addr = (uint64_t) interrupt_return;
+
+    task->kernel_rsp = (uint64_t) switch_frame;
+}
+
+/* user stack sits right below the lowest address the user linker script hands out */
+#define USER_STACK_TOP      0x40000
+
 /**
- * text_phy_addr: should container the address of the start of the text section
- *          of the executable to be launched
+ * elf_phy_addr: physical address of the executable image, which must stay in memory as processes map its pages
+ * elf_size: size of the image in bytes
+ *
+ * returns NULL if the image can't be loaded
  */
-task_struct_t* create_process(uint64_t text_phy_addr) {
+task_struct_t* create_process(uint64_t elf_phy_addr, size_t elf_size) {
     /**
      * Notes to myself:
      *
@@ -38,107 +83,111 @@ task_struct_t* create_process(uint64_t text_phy_addr) {
      *              In the case of a new file, we need to allocate the space dynamically and then load it from the filesystem/disk
      *              (Most likely the right way of doing things but it requires implementing a FS and interfacing with the HD)
      *
+     * On 19/10/2026:
+     *
+     *  The image is an ELF executable now and elf_load maps it segment by segment, sharing its pages among every
+     *  process created from it (see task/elf.c).
      */
 
     task_struct_t *task = kmalloc(sizeof(task_struct_t), KMEM_DEFAULT);
     task->pid = find_free_pid();
+    task->ppid = this_rq()->curr != NULL ? this_rq()->curr->pid : 0;
     task->state = TASK_RUNNING;
+    task->exit_code = 0;
     task->vm_area.ini_addr = 0x0;
     task->vm_area.fini_addr = 0x100000 * 10;
-
-    /* calculate space required to accomodate user's process memory area */
-    uint64_t pgt_spc_req = paging_calc_space_needed(task->vm_area.fini_addr - task->vm_area.ini_addr);
-    uint64_t pfdb_spc_req = pageframe_calc_space_needed(pgt_spc_req);
-
-    /* init pagetable and pageframe database structures */
-    mem_map_region_t u_pages_struct_rg = {
-            .base_addr = pa((uint64_t) kmalloc(pgt_spc_req, KMEM_DEFAULT)),
-            .length = pgt_spc_req
-    };
-    mem_map_region_t u_pfdb_struct_rg = {
-            .base_addr = pa((uint64_t) kmalloc(pfdb_spc_req, KMEM_DEFAULT)),
-            .length = pfdb_spc_req
-    };
-
-    /* init paging structure for the process */
-    printk_fine("u_pages_struct_rg: %.16llx u_pfdb_struct_rg: %.16llx", u_pages_struct_rg.base_addr, u_pfdb_struct_rg.base_addr);
-    paging_init(&task->vm_area.pgtable, u_pages_struct_rg, u_pfdb_struct_rg);
-
-    // TODO: this should be dynamic once we start loading files from disk
-    uint64_t elf_prog_size = 0x8000;
-
-    /* mapping program's physical location to process' pgtable */
-    paging_contiguous_map(&task->vm_area.pgtable,
-            text_phy_addr,
-            text_phy_addr + elf_prog_size,
-            0x40000,
-            PAGE_STD_BITS | PAGE_USER_SUPERVISOR_BIT);
+    task->vm_area.mmap = NULL;
+    task->wait_next = NULL;
+    task->zombie_next = NULL;
+
+    /* root comes from the page-table allocator, kernel half included. Lower levels show up as pages get mapped */
+    pagetable_create(&task->vm_area.pgtable);
+
+    uint64_t entry;
+    if (!elf_load(&task->vm_area.pgtable, elf_phy_addr, elf_size, &entry, &task->vm_area.brk_start)) {
+        paging_teardown(&task->vm_area.pgtable);
+        release_pid(task->pid);
+        kfree(task);
+        return NULL;
+    }
+    task->vm_area.brk = task->vm_area.brk_start;
 
     /* mapping process' stack physical location to process' pgtable */
     task->task_stack_area.length = STACK_SIZE;
     task->task_stack_area.virt_addr = (uint64_t) kmalloc(task->task_stack_area.length, KMEM_DEFAULT | KMEM_ZERO);
     task->task_stack_area.phys_addr = pa(task->task_stack_area.virt_addr);
 
+    /* the end address is inclusive, it's the last page that gets mapped */
     paging_contiguous_map(&task->vm_area.pgtable,
             task->task_stack_area.phys_addr,
-            task->task_stack_area.phys_addr + task->task_stack_area.length,
-            0x3e000,
-            PAGE_STD_BITS | PAGE_USER_SUPERVISOR_BIT);
+            task->task_stack_area.phys_addr + task->task_stack_area.length - PAGE_SIZE,
+            USER_STACK_TOP - task->task_stack_area.length,
+            PAGE_STD_BITS | PAGE_USER_SUPERVISOR_BIT | PAGE_NO_EXEC_BIT);
 
     /* allocate stack for kernel  */
     task->kernel_stack_area.length = STACK_SIZE;
     task->kernel_stack_area.virt_addr = (uint64_t) kmalloc(task->kernel_stack_area.length, KMEM_DEFAULT | KMEM_ZERO);
     task->kernel_stack_area.phys_addr = pa(task->kernel_stack_area.virt_addr);
 
-    /* in the future we should read this info from the ELF headers */
-    task->rip = 0x41000;
-    task->rsp = 0x40000;
-    task->rflags = 0x202;
-    task->cs = GDT64_SEGMENT_SELECTOR_USER_CODE | DPL_RING_3;
-    task->ss = GDT64_SEGMENT_SELECTOR_USER_DATA | DPL_RING_3;
-    memzero(&task->regs, sizeof(registers_64_t));
+    setup_kernel_stack(task, entry, GDT64_SEGMENT_SELECTOR_USER_CODE | DPL_RING_3, USER_STACK_TOP,
+            GDT64_SEGMENT_SELECTOR_USER_DATA | DPL_RING_3);
+    task->fpu_state = NULL;
+
+    files_init(task);
+
+    return task;
+}
+
+/**
+ * fn: entry point of the kernel thread, it must never return
+ */
+task_struct_t* create_kthread(void (*fn)(void)) {
+    task_struct_t *task = kmalloc(sizeof(task_struct_t), KMEM_DEFAULT | KMEM_ZERO);
+    task->pid = find_free_pid();
+    task->state = TASK_RUNNING;
+
+    /* kernel threads have no user space, the kernel page table is all they need */
+    task->vm_area.pgtable.phys_root = kernel_pagetable()->phys_root;
+    task->vm_area.pgtable.virt_root = kernel_pagetable()->virt_root;
 
-    /* Copy PML4  entries for kernel space (higher-half entries) to this process' page table */
-    memcpy((uintptr_t*) (task->vm_area.pgtable.virt_root + (256 * sizeof(uint64_t))),
-            (uintptr_t*) (kernel_pagetable()->virt_root + (256 * sizeof(uint64_t))),
-            256 * sizeof(uint64_t));
+    /* interrupts don't change privilege level here, so this is the stack they land on as well */
+    task->kernel_stack_area.length = STACK_SIZE;
+    task->kernel_stack_area.virt_addr = (uint64_t) kmalloc(task->kernel_stack_area.length, KMEM_DEFAULT | KMEM_ZERO);
+    task->kernel_stack_area.phys_addr = pa(task->kernel_stack_area.virt_addr);
+
+    /*
+     * fn starts on the very same stack, the initial frame is gone by then. The -8 is where the return address of a
+     * call would be, which is what the ABI expects rsp to account for on function entry
+     */
+    setup_kernel_stack(task, (uint64_t) fn, GDT64_SEGMENT_SELECTOR_KERNEL_CODE,
+            task->kernel_stack_area.virt_addr + task->kernel_stack_area.length - sizeof(uint64_t),
+            GDT64_SEGMENT_SELECTOR_KERNEL_DATA);
 
     return task;
 }
 
 void launch_process(task_struct_t *task) {
     TSS64_Segment.rsp0 = task->kernel_stack_area.virt_addr + STACK_SIZE;
+
+    /*
+     * Kernel threads only touch the kernel half, which every page table shares, so they borrow whatever is loaded.
+     * Reloading CR3 flushes every non-global TLB entry, so it's only done when the address space really changes.
+     */
+    uint64_t root = task->vm_area.pgtable.phys_root;
+    if (root == kernel_pagetable()->phys_root || root == (read_cr3() & ~((uint64_t) PAGE_SIZE - 1)))
+        return;
+
     paging_reload_cr3(&task->vm_area.pgtable);
 }
 
-void process_context_swtich(interrupt_stack_frame_t *int_frame, task_struct_t *curr, task_struct_t *next) {
-    /* software context - save current task's context and load next task's context*/
-    if (curr == NULL) {
-        int_frame->regs = next->regs;
-
-        int_frame->ss = next->ss;
-        int_frame->cs = next->cs;
-        int_frame->rflags = next->rflags;
-        int_frame->rsp = next->rsp;
-        int_frame->rip = next->rip;
-
-        launch_process(next);
-    } else {
-        curr->rsp = int_frame->rsp;
-        curr->rip = int_frame->rip;
-        curr->ss = int_frame->ss;
-        curr->cs = int_frame->cs;
-        curr->regs = int_frame->regs;
-        curr->rflags = int_frame->rflags;
-
-        int_frame->rsp = next->rsp;
-        int_frame->rip = next->rip;
-        int_frame->regs = next->regs;
-        int_frame->ss = next->ss;
-        int_frame->cs = next->cs;
-        int_frame->rflags = next->rflags;
-
-        launch_process(next);
-    }
-}
+void process_context_swtich(task_struct_t *curr, task_struct_t *next) {
+    /* the boot context (kmain) is never coming back, its stack pointer is saved nowhere in particular */
+    static uint64_t boot_rsp;
+    uint64_t *prev_rsp = curr != NULL ? &curr->kernel_rsp : &boot_rsp;
 
+    /* FPU/SSE registers are left alone, the first FPU instruction next runs will trap if they aren't next's */
+    fpu_switch(next);
+
+    launch_process(next);
+    switch_to(prev_rsp, next->kernel_rsp);
+}
@@ -76,31 +76,63 @@ void scheduler_add(task_struct_t *task) {
     move_end_of_list(node);
 }
 
-void schedule(interrupt_stack_frame_t *int_frame) {
+void scheduler_remove(task_struct_t *task) {
+    struct task_list_t **link = &this_rq()->tasks;
+
+    while (*link != NULL && (*link)->val != task)
+        link = &(*link)->next;
+
+    /* sanity check */
+    BUG_ON(*link == NULL);
+
+    struct task_list_t *node = *link;
+    *link = node->next;
+    kfree(node);
+}
+
+void schedule(void) {
     /* sanity check */
     BUG_ON(!initialised);
 
     struct task_list_t *head = this_rq()->tasks;
 
-    /* fail-fast if there is nothing else to run */
-    if (!head || (this_rq()->curr && !head->next))
+    /* fail-fast if there is nothing else to run (an exiting task is no longer in the list) */
+    if (!head || (head->val == this_rq()->curr && !head->next))
         return;
 
     task_struct_t *curr = this_rq()->curr;
-    task_struct_t *next = head->val;
+    task_struct_t *next = NULL;
 
-    /* puts current process at the end of list to
-     * give a change for the other tasks to run */
-    if (head->next) {
+    /* walk the list once at most, sleeping tasks are rotated out of the way too */
+    for (struct task_list_t *tmp = head; tmp != NULL; tmp = tmp->next) {
+        if (tmp->val->state == TASK_RUNNING) {
+            next = tmp->val;
+            break;
+        }
+    }
+
+    /* everybody is sleeping, let the current task carry on (it will keep retrying) */
+    if (next == NULL) {
+        this_rq()->need_resched = false;
+        return;
+    }
+
+    /* puts processes at the end of list to give a change for the other tasks to run */
+    while (head->next) {
         this_rq()->tasks = head->next;
         move_end_of_list(head);
+
+        if (head->val == next)
+            break;
+        head = this_rq()->tasks;
     }
 
     /* select process to be executed */
     this_rq()->curr = next;
     this_rq()->need_resched = false;
 
-    /* switch context */
-    process_context_swtich(int_frame, curr, next);
+    /* switch context - returns once curr gets picked again */
+    if (next != curr)
+        process_context_swtich(curr, next);
 
 }
@@ -0,0 +1,40 @@
+; Export references to C
+global switch_to
+
+section .text
+
+;===============================================================================
+; switch_to
+;
+; void switch_to(uint64_t *prev_rsp, uint64_t next_rsp)
+;
+; Only callee-saved registers have to survive a call according to the System V
+; AMD64 ABI, so that's all there is to save. Everything the interrupted code
+; was using already sits on its kernel stack (interrupt frame included), so
+; swapping kernel stacks is the whole context switch.
+;
+; Tasks that never ran have a fake frame whose return address points to
+; interrupt_return (vectors.asm), which iretq's into their entry point.
+;
+; Killed registers:
+;   caller-saved ones, as with any other call
+;===============================================================================
+switch_to:
+  push rbp
+  push rbx
+  push r12
+  push r13
+  push r14
+  push r15
+
+  ; RDI = &prev->kernel_rsp, RSI = next->kernel_rsp
+  mov [rdi], rsp
+  mov rsp, rsi
+
+  pop r15
+  pop r14
+  pop r13
+  pop r12
+  pop rbx
+  pop rbp
+  ret
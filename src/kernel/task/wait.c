@@ -0,0 +1,64 @@
+/*
+ * wait.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/task/wait.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/asm/generic.h"
+
+/*
+ * Notes to myself:
+ *
+ * Syscalls run on the task's own kernel stack, so a task can sleep halfway through one: it goes on the wait queue,
+ * is marked TASK_INTERRUPTIBLE and calls schedule(), which only picks it again once it has been woken up. When
+ * nobody else can run, schedule() leaves it on the CPU and it halts with interrupts enabled until the interrupt
+ * that wakes it up arrives. Callers check their condition again after waking up and go back to sleep if somebody
+ * else got there first, so user space never sees the wait.
+ *
+ * A task sleeps on one queue at most, so the link lives in task_struct_t itself. Going to sleep can't fail for
+ * lack of memory that way.
+ */
+
+void wait_queue_sleep(wait_queue_head_t *wq) {
+    task_struct_t *curr = this_rq()->curr;
+
+    /* sanity checks */
+    BUG_ON(curr == NULL);
+    BUG_ON(curr->state != TASK_RUNNING);
+
+    uint64_t flags = local_irq_save();
+
+    curr->wait_next = wq->tasks;
+    wq->tasks = curr;
+    curr->state = TASK_INTERRUPTIBLE;
+
+    while (__atomic_load_n(&curr->state, __ATOMIC_RELAXED) != TASK_RUNNING) {
+        schedule();
+
+        /* nothing else was runnable, wait for the interrupt that wakes us up */
+        if (__atomic_load_n(&curr->state, __ATOMIC_RELAXED) != TASK_RUNNING) {
+            safe_halt();
+            disable_interrupts();
+        }
+    }
+
+    local_irq_restore(flags);
+}
+
+void wait_queue_wake_all(wait_queue_head_t *wq) {
+    task_struct_t *task = wq->tasks;
+
+    while (task != NULL) {
+        task_struct_t *next = task->wait_next;
+
+        task->state = TASK_RUNNING;
+        task->wait_next = NULL;
+
+        task = next;
+    }
+
+    wq->tasks = NULL;
+}
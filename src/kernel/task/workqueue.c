@@ -0,0 +1,97 @@
+/*
+ * workqueue.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "kernel/task/workqueue.h"
+#include "kernel/task/scheduler.h"
+#include "kernel/asm/generic.h"
+#include "kernel/compiler/bug.h"
+#include "kernel/lib/printk.h"
+
+/*
+ * Notes to myself:
+ *
+ * Work items run in a kernel thread (kworker) with interrupts enabled and can be preempted by the timer like any
+ * other task. That's where anything too slow for a softirq should go.
+ *
+ * Until there is a proper way of blocking in kernel mode, kworker marks itself TASK_INTERRUPTIBLE and halts until
+ * schedule_work() makes it runnable again. If every other task is sleeping too, the scheduler leaves kworker on
+ * the CPU which makes it the idle loop as a bonus.
+ */
+
+static task_struct_t *worker;
+
+static work_struct_t *work_head;
+static work_struct_t **work_tail = &work_head;
+
+static work_struct_t* dequeue_work(void) {
+    work_struct_t *work = work_head;
+
+    if (work != NULL) {
+        work_head = work->next;
+        if (work_head == NULL)
+            work_tail = &work_head;
+
+        /* allow it to be scheduled again while it runs */
+        work->pending = false;
+    }
+
+    return work;
+}
+
+static void worker_thread(void) {
+    for (;;) {
+        disable_interrupts();
+        work_struct_t *work = dequeue_work();
+
+        if (work == NULL) {
+            /* nothing to do, sleep until schedule_work wakes us up */
+            worker->state = TASK_INTERRUPTIBLE;
+            this_rq()->need_resched = true;
+            enable_interrupts();
+
+            while (__atomic_load_n(&worker->state, __ATOMIC_RELAXED) != TASK_RUNNING)
+                halt();
+            continue;
+        }
+
+        enable_interrupts();
+        work->func(work);
+    }
+}
+
+void workqueue_init(void) {
+    /* sanity check */
+    BUG_ON(worker != NULL);
+
+    worker = create_kthread(worker_thread);
+    scheduler_add(worker);
+    printk_info("kworker created with pid %ld", worker->pid);
+}
+
+bool workqueue_ready(void) {
+    return worker != NULL;
+}
+
+bool schedule_work(work_struct_t *work) {
+    uint64_t flags = local_irq_save();
+
+    if (work->pending) {
+        local_irq_restore(flags);
+        return false;
+    }
+
+    work->pending = true;
+    work->next = NULL;
+    *work_tail = work;
+    work_tail = &work->next;
+
+    if (worker != NULL)
+        __atomic_store_n(&worker->state, TASK_RUNNING, __ATOMIC_RELAXED);
+
+    local_irq_restore(flags);
+    return true;
+}
@@ -7,7 +7,6 @@
 
 #include "kernel/video/vga_console.h"
 #include "kernel/asm/generic.h"
-#include "kernel/lib/ringbuffer.h"
 #include "kernel/lib/string.h"
 #include "kernel/compiler/macro.h"
 #include "kernel/mm/addressconv.h"
@@ -17,8 +16,15 @@
 #define VGA_MAX_COLS 	80
 #define VGA_MAX_ROWS 	25
 
-/* Controls cursor caret and soft-wrap functionality */
-static int row = 0;
+/* leave the last the row empty for typing */
+#define VGA_TEXT_ROWS   (VGA_MAX_ROWS - 1)
+/* soft-wrap column */
+#define VGA_LINE_COLS   (VGA_MAX_COLS - 1)
+
+/* white on black */
+#define VGA_DEFAULT_ATTR    0x0f
+#define VGA_CELL(c)         ((uint16_t) ((VGA_DEFAULT_ATTR << 8) | (uint8_t) (c)))
+#define VGA_BLANK_CELL      VGA_CELL(' ')
 
 /*
  * Notes:
@@ -37,20 +43,33 @@ static int row = 0;
  * purposes as the mm/init.c is very critical. This creates a cyclic dependecy
  * in which I'm not willing to give up my only debugging method (printk) just to
  * not have this struct sitting on the stack.
+ *
+ * On 19/10/2026:
+ *
+ * Repainting every row from the ringbuffer on each printk made console output
+ * O(screen). Video memory itself is the scrollback now: new text is written
+ * in place with one 16-bit store per cell, scrolling is a single memmove of
+ * the text rows and only the cells left over from an older, longer line get
+ * blanked. The printk log buffer keeps the history for crash analysis.
  */
 
-static ringbuffer_tp msg_buffer = { 
-	/* leave the last the row empty for typing */
-	.size = VGA_MAX_ROWS - 1  
-};
+static volatile uint16_t *const video_mem = (volatile uint16_t*) VIDEO_MEM_ADDR;
+
+/* Controls cursor caret and soft-wrap functionality */
+static int row = 0;
+static int col = 0;
+
+/* cells in use on each row, so only stale cells have to be blanked (dirty tracking) */
+static uint8_t line_len[VGA_TEXT_ROWS];
+
+/* last position programmed into the CRT controller */
+static uint16_t cursor_pos = UINT16_MAX;
 
 void vga_console_init() {
-    // init ring buffer
-    ringbuffer_init(&msg_buffer);
     clear_console();
 }
 
-void update_cursor(int row, int col) {
+static void update_cursor(int row, int col) {
     // ensures that caret position is always visible even on certain edge cases
     if (row == VGA_MAX_ROWS)
         row--;
@@ -59,6 +78,11 @@ void update_cursor(int row, int col) {
 
     uint16_t pos = row * VGA_MAX_COLS + col;
 
+    /* port I/O is slow, so don't reprogram the caret if it didn't move */
+    if (pos == cursor_pos)
+        return;
+    cursor_pos = pos;
+
     outb(UNSAFE_VA(0x3D4), 0x0F);
     outb(UNSAFE_VA(0x3D5), (uint8_t) (pos & 0xFF));
     outb(UNSAFE_VA(0x3D4), 0x0E);
@@ -66,70 +90,104 @@ void update_cursor(int row, int col) {
 }
 
 void clear_console() {
-    int nchars = VGA_MAX_COLS * VGA_MAX_ROWS;
-    volatile char *video_address = (volatile char*) VIDEO_MEM_ADDR;
-    for (int i = 0; i < nchars; i++) {
-        video_address[0] = ' ';
-        video_address[1] = 0xf;
-        video_address += 2;
-    }
+    for (int i = 0; i < VGA_MAX_COLS * VGA_MAX_ROWS; i++)
+        video_mem[i] = VGA_BLANK_CELL;
 
-    row = 0;
+    memzero(line_len, sizeof(line_len));
+    row = col = 0;
     update_cursor(row, 0);
 }
 
-void write_line_to_dma(const char *buf) {
-    volatile char *video_address = (volatile char*) VIDEO_MEM_ADDR;
-    video_address += row * VGA_MAX_COLS * 2;
+static void scroll_up(void) {
+    /* move text rows 1..N up by one row in a single pass */
+    memmove((void*) video_mem, (void*) (video_mem + VGA_MAX_COLS),
+            (VGA_TEXT_ROWS - 1) * VGA_MAX_COLS * sizeof(uint16_t));
 
-    uint8_t idx = 0;
-    char c = *buf;
-    /* write new content */
-	do {
-		video_address[0] = c;
-		video_address[1] = 0xf;
-		video_address += 2;
-		idx++;
-	} while ((c = *(++buf)) != '\0');
+    /*
+     * the last text row still holds its old content, which is exactly what
+     * line_len[VGA_TEXT_ROWS - 1] says after shifting, so it gets blanked
+     * lazily as new text is written over it.
+     */
+    memmove(line_len, line_len + 1, VGA_TEXT_ROWS - 1);
+
+    row = VGA_TEXT_ROWS - 1;
+}
+
+static void new_line(void) {
+    if (row == VGA_TEXT_ROWS)
+        scroll_up();
 
     /* previous content could've been bigger so clean up the rest of the line */
-    for(; idx < VGA_MAX_COLS - 1; idx++) {
-        video_address[0] = ' ';
-        video_address[1] = 0xf;
-        video_address += 2;
-    }
+    volatile uint16_t *line = video_mem + row * VGA_MAX_COLS;
+    for (int i = col; i < line_len[row]; i++)
+        line[i] = VGA_BLANK_CELL;
+
+    line_len[row] = col;
+    col = 0;
     row++;
 }
 
+static void put_char(char c) {
+    if (row == VGA_TEXT_ROWS)
+        scroll_up();
+
+    video_mem[row * VGA_MAX_COLS + col] = VGA_CELL(c);
+
+    if (++col == VGA_LINE_COLS)
+        new_line();
+}
+
 void write_console(const char *buf, size_t buf_size) {
     /*
      * Notes for myself:
-     *  I'm pretty sure that once we start dealing with SMP, the ringbuffer will before a source of problems..
+     *  I'm pretty sure that once we start dealing with SMP, this will before a source of problems..
      *  I need to come up with some sorting of spinlock or other locking mechanisms to avoid chaos.
      */
-    char line[VGA_MAX_COLS + 1];
-    size_t line_p = 0;
+
+    /* printk (kworker) and TTY echo (tasklet) can interrupt one another */
+    uint64_t flags = local_irq_save();
+
+    /* don't glue the message to whatever the TTY echoed so far */
+    if (col > 0)
+        new_line();
 
     for (size_t i = 0; i < buf_size - 1; i++) {
         char c = *(buf + i);
 
-        if (c != '\n')
-            line[line_p++] = c;
+        if (c == '\n')
+            new_line();
+        else
+            put_char(c);
+    }
+
+    /* every message starts on a line of its own */
+    if (col > 0)
+        new_line();
 
-        if (c == '\n' || line_p == VGA_MAX_COLS - 1) {
-            line[line_p++] = '\0';
-            ringbuffer_put(&msg_buffer, line, line_p);
-            memset(line, '\0', line_p);
-            line_p = 0;
+    /* one caret update per message rather than per line */
+    update_cursor(row, 0);
+
+    local_irq_restore(flags);
+}
+
+void echo_console(const char *buf, size_t length) {
+    uint64_t flags = local_irq_save();
+
+    /* unlike write_console, partial lines are left open so the next echo carries on from there */
+    for (size_t i = 0; i < length; i++) {
+        char c = buf[i];
+
+        if (c == '\n') {
+            new_line();
+        } else if (c == '\b') {
+            if (col > 0)
+                video_mem[row * VGA_MAX_COLS + --col] = VGA_BLANK_CELL;
+        } else {
+            put_char(c);
         }
     }
 
-    if (line_p > 0) {
-        line[line_p++] = '\0';
-        ringbuffer_put(&msg_buffer, line, line_p);
-    }
+    update_cursor(row, col);
 
-    row = 0;
-    ringbuffer_for_each(&msg_buffer, &write_line_to_dma);
-    update_cursor(row, 0);
+    local_irq_restore(flags);
 }
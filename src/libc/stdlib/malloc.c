@@ -0,0 +1,355 @@
+/*
+ * malloc.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/stdlib.h"
+#include "libc/string.h"
+#include "libc/unistd.h"
+#include "libc/sys/mman.h"
+
+/*
+ * Notes to myself:
+ *
+ * Same layout as jemalloc/mimalloc, scaled down:
+ *
+ *  - Requests up to MALLOC_SMALL_MAX are rounded up to one of MALLOC_NR_CLASSES size classes: multiples of 16 up
+ *    to 128, then 4 classes per power of two, so no more than 25% is ever wasted to rounding (and mostly less).
+ *
+ *  - Small objects live in spans: MALLOC_SPAN_SIZE aligned chunks of the brk heap holding objects of a single
+ *    class. free() finds the span (and thereby the class) by masking the pointer, so objects carry no header at
+ *    all. Objects are carved out of a span lazily (bump pointer) and come back to its free list, a span that has
+ *    nothing handed out anymore goes to a list of free spans any class can take.
+ *
+ *  - malloc/free go through a cache of free objects per class first: popping from/pushing to a list, no span is
+ *    touched. It's refilled from (or flushed to) the spans in batches of half its size, which is what the spans
+ *    and the arena ever see.
+ *
+ *  - Anything bigger than MALLOC_SMALL_MAX gets an mmap of its own with the length in a 16-byte header, and goes
+ *    straight back to the kernel on free. Those mappings are above USER_MMAP_BASE, the brk heap is below it, which
+ *    is how free() tells the two apart.
+ *
+ * The object cache is what jemalloc and mimalloc keep per thread so the fast path never needs a lock. There are no
+ * threads (nor TLS) yet, so there is exactly one of them and nothing is locked. tcache_get() is where a thread
+ * would find its own once that changes, at which point the arena (partial and free spans) needs a lock.
+ */
+
+#define MALLOC_ALIGN            16
+#define MALLOC_SMALL_MAX        8192
+#define MALLOC_NR_CLASSES       32
+
+#define MALLOC_SPAN_SIZE        (64 * 1024)
+/* the heap is grown this much at a time, pages only cost something once they are touched */
+#define MALLOC_HEAP_GROW        (1024 * 1024)
+
+/* objects a cache can hold per class: as many as fit in this many bytes, within the bounds below */
+#define TCACHE_CLASS_BYTES      (32 * 1024)
+#define TCACHE_MIN_COUNT        4
+#define TCACHE_MAX_COUNT        64
+
+#define MALLOC_PAGE_SIZE        4096
+#define LARGE_HEADER_SIZE       MALLOC_ALIGN
+
+#define ALIGN_UP(value, align)  (((value) + (align) - 1) & ~((uintptr_t) (align) - 1))
+
+typedef struct free_obj {
+    struct free_obj *next;
+} free_obj_t;
+
+typedef struct span {
+    /* partial list of its class, or the list of free spans */
+    struct span *prev;
+    struct span *next;
+
+    /* objects given back, then whatever was never handed out from bump to the end of the span */
+    free_obj_t *free;
+    char *bump;
+
+    uint32_t class;
+    /* objects handed out, those sitting in a cache included */
+    uint32_t used;
+} span_t;
+
+#define SPAN_HEADER_SIZE        ALIGN_UP(sizeof(span_t), MALLOC_ALIGN)
+
+typedef struct {
+    free_obj_t *head[MALLOC_NR_CLASSES];
+    uint32_t count[MALLOC_NR_CLASSES];
+} tcache_t;
+
+static const uint32_t class_size[MALLOC_NR_CLASSES] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+    1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096,
+    5120, 6144, 7168, 8192
+};
+
+static struct {
+    /* [start, top) is carved into spans, [top, end) is heap nobody uses yet */
+    char *start;
+    char *top;
+    char *end;
+
+    /* spans with objects left, per class */
+    span_t *partial[MALLOC_NR_CLASSES];
+    span_t *free_spans;
+
+    uint32_t tcache_limit[MALLOC_NR_CLASSES];
+} arena;
+
+static tcache_t main_tcache;
+
+static tcache_t* tcache_get(void) {
+    return &main_tcache;
+}
+
+static void arena_init(void) {
+    char *brk_now = sbrk(0);
+
+    arena.start = (char*) ALIGN_UP((uintptr_t) brk_now, MALLOC_SPAN_SIZE);
+    arena.top = arena.start;
+    arena.end = brk_now;
+
+    for (size_t i = 0; i < MALLOC_NR_CLASSES; i++) {
+        uint32_t count = TCACHE_CLASS_BYTES / class_size[i];
+        if (count < TCACHE_MIN_COUNT)
+            count = TCACHE_MIN_COUNT;
+        if (count > TCACHE_MAX_COUNT)
+            count = TCACHE_MAX_COUNT;
+        arena.tcache_limit[i] = count;
+    }
+}
+
+/* size has to be within 1 and MALLOC_SMALL_MAX */
+static uint32_t size_class(size_t size) {
+    if (size <= 128)
+        return (size + 15) / 16 - 1;
+
+    /* size is in (2^b, 2^(b+1)], split into 4 classes of 2^(b-2) each */
+    uint32_t b = 63 - __builtin_clzl(size - 1);
+    return 8 + (b - 7) * 4 + ((size - 1 - (1UL << b)) >> (b - 2));
+}
+
+static bool is_small(const void *ptr) {
+    return (const char*) ptr >= arena.start && (const char*) ptr < arena.top;
+}
+
+static span_t* span_of(const void *ptr) {
+    return (span_t*) ((uintptr_t) ptr & ~((uintptr_t) MALLOC_SPAN_SIZE - 1));
+}
+
+static void span_list_add(span_t **list, span_t *span) {
+    span->prev = NULL;
+    span->next = *list;
+    if (*list != NULL)
+        (*list)->prev = span;
+    *list = span;
+}
+
+static void span_list_remove(span_t **list, span_t *span) {
+    if (span->prev != NULL)
+        span->prev->next = span->next;
+    else
+        *list = span->next;
+
+    if (span->next != NULL)
+        span->next->prev = span->prev;
+}
+
+static bool span_full(const span_t *span) {
+    return span->free == NULL && span->bump + class_size[span->class] > (const char*) span + MALLOC_SPAN_SIZE;
+}
+
+static span_t* span_alloc(uint32_t class) {
+    span_t *span = arena.free_spans;
+
+    if (span != NULL) {
+        span_list_remove(&arena.free_spans, span);
+    } else {
+        while (arena.top + MALLOC_SPAN_SIZE > arena.end) {
+            size_t grow = ALIGN_UP((uintptr_t) (arena.top + MALLOC_SPAN_SIZE - arena.end), MALLOC_HEAP_GROW);
+            char *old = sbrk(grow);
+            if (old == (void*) -1)
+                return NULL;
+
+            /* someone else moved the break, spans start over from there */
+            if (old != arena.end)
+                arena.top = (char*) ALIGN_UP((uintptr_t) old, MALLOC_SPAN_SIZE);
+            arena.end = old + grow;
+        }
+
+        span = (span_t*) arena.top;
+        arena.top += MALLOC_SPAN_SIZE;
+    }
+
+    span->free = NULL;
+    span->bump = (char*) span + SPAN_HEADER_SIZE;
+    span->class = class;
+    span->used = 0;
+    return span;
+}
+
+/* fills the cache up to half its limit, false if there is no memory left for even one object */
+static bool tcache_refill(tcache_t *tc, uint32_t class) {
+    if (arena.start == NULL)
+        arena_init();
+
+    uint32_t batch = arena.tcache_limit[class] / 2;
+
+    for (uint32_t i = 0; i < batch; i++) {
+        span_t *span = arena.partial[class];
+        if (span == NULL) {
+            span = span_alloc(class);
+            if (span == NULL)
+                break;
+            span_list_add(&arena.partial[class], span);
+        }
+
+        free_obj_t *obj = span->free;
+        if (obj != NULL) {
+            span->free = obj->next;
+        } else {
+            obj = (free_obj_t*) span->bump;
+            span->bump += class_size[class];
+        }
+        span->used++;
+
+        if (span_full(span))
+            span_list_remove(&arena.partial[class], span);
+
+        obj->next = tc->head[class];
+        tc->head[class] = obj;
+        tc->count[class]++;
+    }
+
+    return tc->head[class] != NULL;
+}
+
+static void span_free_obj(span_t *span, free_obj_t *obj) {
+    bool was_full = span_full(span);
+
+    obj->next = span->free;
+    span->free = obj;
+    span->used--;
+
+    if (span->used == 0) {
+        if (!was_full)
+            span_list_remove(&arena.partial[span->class], span);
+        span_list_add(&arena.free_spans, span);
+    } else if (was_full) {
+        span_list_add(&arena.partial[span->class], span);
+    }
+}
+
+/* gives count objects of the cache back to their spans */
+static void tcache_flush(tcache_t *tc, uint32_t class, uint32_t count) {
+    while (count-- > 0 && tc->head[class] != NULL) {
+        free_obj_t *obj = tc->head[class];
+        tc->head[class] = obj->next;
+        tc->count[class]--;
+        span_free_obj(span_of(obj), obj);
+    }
+}
+
+static void* large_alloc(size_t size) {
+    if (size > SIZE_MAX - LARGE_HEADER_SIZE - MALLOC_PAGE_SIZE)
+        return NULL;
+
+    size_t length = ALIGN_UP(size + LARGE_HEADER_SIZE, MALLOC_PAGE_SIZE);
+    char *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return NULL;
+
+    *(size_t*) mapping = length;
+    return mapping + LARGE_HEADER_SIZE;
+}
+
+/* bytes ptr can really hold, which may be more than were asked for */
+static size_t usable_size(const void *ptr) {
+    if (is_small(ptr))
+        return class_size[span_of(ptr)->class];
+
+    return *(const size_t*) ((const char*) ptr - LARGE_HEADER_SIZE) - LARGE_HEADER_SIZE;
+}
+
+void* malloc(size_t size) {
+    if (size > MALLOC_SMALL_MAX)
+        return large_alloc(size);
+
+    /* every call gets a pointer of its own, even for nothing */
+    if (size == 0)
+        size = 1;
+
+    uint32_t class = size_class(size);
+    tcache_t *tc = tcache_get();
+
+    if (tc->head[class] == NULL && !tcache_refill(tc, class))
+        return NULL;
+
+    free_obj_t *obj = tc->head[class];
+    tc->head[class] = obj->next;
+    tc->count[class]--;
+    return obj;
+}
+
+void free(void *ptr) {
+    if (ptr == NULL)
+        return;
+
+    if (!is_small(ptr)) {
+        char *mapping = (char*) ptr - LARGE_HEADER_SIZE;
+        munmap(mapping, *(size_t*) mapping);
+        return;
+    }
+
+    uint32_t class = span_of(ptr)->class;
+    tcache_t *tc = tcache_get();
+
+    free_obj_t *obj = ptr;
+    obj->next = tc->head[class];
+    tc->head[class] = obj;
+
+    if (++tc->count[class] > arena.tcache_limit[class])
+        tcache_flush(tc, class, arena.tcache_limit[class] / 2);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+    if (size != 0 && nmemb > SIZE_MAX / size)
+        return NULL;
+
+    size_t total = nmemb * size;
+    void *ptr = malloc(total);
+
+    /* large allocations are fresh anonymous mappings, the kernel zeroed them already */
+    if (ptr != NULL && is_small(ptr))
+        memset(ptr, 0, total);
+
+    return ptr;
+}
+
+void* realloc(void *ptr, size_t size) {
+    if (ptr == NULL)
+        return malloc(size);
+
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+
+    size_t usable = usable_size(ptr);
+    if (size <= usable)
+        return ptr;
+
+    void *new_ptr = malloc(size);
+    if (new_ptr == NULL)
+        return NULL;
+
+    memcpy(new_ptr, ptr, usable);
+    free(ptr);
+    return new_ptr;
+}
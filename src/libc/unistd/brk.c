@@ -0,0 +1,26 @@
+/*
+ * brk.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+/* the kernel answers with the break as it stands afterwards, which is the old one if it couldn't be moved */
+int brk(void *addr) {
+    long curr = syscall1(__NR_brk, addr);
+    return curr == (long) addr ? 0 : -1;
+}
+
+void* sbrk(intptr_t increment) {
+    long curr = syscall1(__NR_brk, 0);
+    if (increment == 0)
+        return (void*) curr;
+
+    if (brk((void*) (curr + increment)) != 0)
+        return (void*) -1;
+
+    return (void*) curr;
+}
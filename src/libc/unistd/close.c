@@ -0,0 +1,13 @@
+/*
+ * close.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+int close(int fd) {
+    return (int) syscall1(__NR_close, fd);
+}
@@ -0,0 +1,17 @@
+/*
+ * exit.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+void exit(int code) {
+    syscall1(__NR_exit, code);
+
+    /* the kernel never comes back here, but just in case... */
+    for (;;)
+        ;
+}
@@ -0,0 +1,13 @@
+/*
+ * lseek.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+long lseek(int fd, long offset, int whence) {
+    return syscall3(__NR_lseek, fd, offset, whence);
+}
@@ -0,0 +1,27 @@
+/*
+ * mmap.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/sys/mman.h"
+#include "libc/internals/syscall.h"
+
+void* mmap(void *addr, size_t length, int prot, int flags, int fd, long offset) {
+    long ret = syscall6(__NR_mmap, addr, length, prot, flags, fd, offset);
+
+    /* -errno, anything else is an address in the lower half */
+    if (ret < 0)
+        return MAP_FAILED;
+
+    return (void*) ret;
+}
+
+int munmap(void *addr, size_t length) {
+    return (int) syscall2(__NR_munmap, addr, length);
+}
+
+int mprotect(void *addr, size_t length, int prot) {
+    return (int) syscall3(__NR_mprotect, addr, length, prot);
+}
@@ -0,0 +1,13 @@
+/*
+ * open.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+int open(const char *path, int flags) {
+    return (int) syscall2(__NR_open, path, flags);
+}
@@ -0,0 +1,14 @@
+/*
+ * read.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+/* blocks in the kernel until there is something to read */
+long read(int fd, char *buf, size_t length) {
+    return syscall3(__NR_read, fd, buf, length);
+}
@@ -0,0 +1,17 @@
+/*
+ * stat.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/sys/stat.h"
+#include "libc/internals/syscall.h"
+
+int stat(const char *path, struct stat *st) {
+    return (int) syscall2(__NR_stat, path, st);
+}
+
+int fstat(int fd, struct stat *st) {
+    return (int) syscall2(__NR_fstat, fd, st);
+}
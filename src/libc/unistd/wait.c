@@ -0,0 +1,18 @@
+/*
+ * wait.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "libc/unistd.h"
+#include "libc/internals/syscall.h"
+
+/* blocks in the kernel until a child has exited */
+pid_t waitpid(pid_t pid, int *status) {
+    return (pid_t) syscall2(__NR_wait4, pid, status);
+}
+
+pid_t wait(int *status) {
+    return waitpid(-1, status);
+}
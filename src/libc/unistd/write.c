@@ -8,6 +8,6 @@
 #include "libc/unistd.h"
 #include "libc/internals/syscall.h"
 
-long write(const char *string, size_t length) {
-    return syscall2(__NR_write, string, length);
+long write(int fd, const char *buf, size_t length) {
+    return syscall3(__NR_write, fd, buf, length);
 }
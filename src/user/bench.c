@@ -0,0 +1,133 @@
+/*
+ * bench.c
+ *
+ *  Created on: 19/10/2026
+ *      Author: Paulo Almeida
+ */
+
+#include "user/bench.h"
+#include "libc/stdlib.h"
+#include "libc/string.h"
+#include "libc/unistd.h"
+
+/*
+ * Notes to myself:
+ *
+ * Same idea as the kernel's debug/bench.c: rdtsc based, results in TSC ticks and only meaningful compared to one
+ * another on the same machine. The timer isn't masked in user space, so numbers include whatever interrupts
+ * happen to land in the middle. Every benchmark runs once to warm up before it's measured.
+ */
+
+#define BENCH_ITERATIONS        4096
+
+/* live objects at once in the batch benchmark, and how many times it's repeated */
+#define BENCH_BATCH             1024
+#define BENCH_BATCH_ROUNDS      16
+
+/* direct mappings cost a syscall and a page fault each, far fewer of them */
+#define BENCH_LARGE_SIZE        (64 * 1024)
+#define BENCH_LARGE_ITERATIONS  64
+
+#define BENCH_REALLOC_MAX       (256 * 1024)
+#define BENCH_REALLOC_ROUNDS    16
+
+static void *batch[BENCH_BATCH];
+
+/* lfence keeps rdtsc from being executed ahead of the code being measured */
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile (
+            "lfence \n"
+            "rdtsc \n"
+            : "=a" (lo), "=d" (hi)
+            :
+            : "memory"
+    );
+    return ((uint64_t) hi << 32) | lo;
+}
+
+static void bench_print(const char *what, uint64_t ticks) {
+    char msg[128];
+    memset(msg, '\0', sizeof(msg));
+
+    memcpy(msg, "bench: ", 7);
+    memcpy(msg + strlen(msg), what, strlen(what));
+    memcpy(msg + strlen(msg), " ", 1);
+    ltoa((long) ticks, msg + strlen(msg), 10);
+    memcpy(msg + strlen(msg), " ticks\n", 7);
+
+    write(STDOUT_FILENO, msg, strlen(msg));
+}
+
+/* the same size over and over: served by the thread cache without ever reaching a span */
+static uint64_t bench_fast_path(void) {
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        void *ptr = malloc(64);
+        /* keep the pair from being optimised away */
+        asm volatile ("" :: "r" (ptr) : "memory");
+        free(ptr);
+    }
+    return (rdtsc() - start) / BENCH_ITERATIONS;
+}
+
+/* many live objects of mixed small sizes: caches are refilled from and flushed to the spans */
+static uint64_t bench_batch(void) {
+    uint64_t start = rdtsc();
+    for (size_t round = 0; round < BENCH_BATCH_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_BATCH; i++)
+            batch[i] = malloc(rand() % 1024 + 1);
+
+        for (size_t i = 0; i < BENCH_BATCH; i++)
+            free(batch[i]);
+    }
+    return (rdtsc() - start) / (BENCH_BATCH_ROUNDS * BENCH_BATCH);
+}
+
+static uint64_t bench_large(void) {
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < BENCH_LARGE_ITERATIONS; i++) {
+        char *ptr = malloc(BENCH_LARGE_SIZE);
+        if (ptr == NULL)
+            return 0;
+
+        /* the page is only there once it's touched */
+        ptr[0] = 1;
+        free(ptr);
+    }
+    return (rdtsc() - start) / BENCH_LARGE_ITERATIONS;
+}
+
+/* growing a buffer by doubling it, from the smallest class all the way to a direct mapping */
+static uint64_t bench_realloc(void) {
+    size_t calls = 0;
+
+    uint64_t start = rdtsc();
+    for (size_t round = 0; round < BENCH_REALLOC_ROUNDS; round++) {
+        char *ptr = NULL;
+        for (size_t size = 16; size <= BENCH_REALLOC_MAX; size *= 2) {
+            ptr = realloc(ptr, size);
+            if (ptr == NULL)
+                return 0;
+
+            ptr[size - 1] = 1;
+            calls++;
+        }
+        free(ptr);
+    }
+    return (rdtsc() - start) / calls;
+}
+
+void bench_malloc(void) {
+    bench_fast_path();
+    bench_print("malloc/free 64 B (thread cache)", bench_fast_path());
+
+    bench_batch();
+    bench_print("malloc/free 1-1024 B, 1024 live (spans)", bench_batch());
+
+    bench_large();
+    bench_print("malloc/free 64 KiB (mmap)", bench_large());
+
+    bench_realloc();
+    bench_print("realloc 16 B to 256 KiB by doubling", bench_realloc());
+}
@@ -15,17 +15,13 @@ section .head.text
   ; Export references to C
   global user_entry
 
-  ; Linker-generated symbols
-  extern _BSS_START
-  extern _BSS_SIZE
-
 user_entry:
 
   ; The System V ABI requires the direction flag to be clear on function entry.
   cld
 
 
-  ; ELF specification dictates that we must clean BSS area before init
+  ; ELF specification dictates that BSS is zeroed before init
   ;
   ; .bss: This section holds uninitialized data that contribute to the program's
   ; memory image. By definition, the system initializes the data with zeros
@@ -33,9 +29,9 @@ user_entry:
   ; indicated by the section type, SHT_NOBITS.
   ;
   ; https://refspecs.linuxfoundation.org/elf/elf.pdf - Page 29
-  mov rdi, _BSS_START
-  mov rcx, _BSS_SIZE
-  call memzero
+  ;
+  ; The kernel's ELF loader maps it to a zero page, only pages that actually
+  ; get written to are ever allocated - so there's nothing to do here.
 
 
   ; Set %ebp to NULL. This sets a stopping point for coredump functionality when
@@ -49,33 +45,3 @@ user_entry:
   ; reason, hang the cpu
   .endless_loop:
     jmp .endless_loop
-
-;===============================================================================
-; memzero
-;
-; Fill memory region with zero
-;
-; Inputs:
-;   RDI ->  Buffer address
-;   RCX ->  Amount of bytes to fill
-;
-; Killed registers:
-;   None
-;===============================================================================
-
-memzero:
-  ; preserve all registers
-  pushaq
-
-  ; clear direction flag
-  cld
-
-  ; Define vale to be stored
-  xor   rax,   rax
-
-  ; repeat until ecx is 0
-  rep stosb
-
-  ; restore registers
-  popaq
-  ret